@@ -33,6 +33,7 @@ return {
   -- IMAGE PREPROCESSING
   "binarization_filter",
   "image_cleaning",
+  "image_pipeline",
   "interest_points",
   --   --"libtiff",
   
@@ -41,6 +41,8 @@ void pushHashTableInLuaStack(lua_State *L,
 //BIND_HEADER_H
 #include "ann_component.h"
 #include "dot_product_component.h"
+#include "factored_softmax_component.h"
+#include "sampled_output_component.h"
 #include "bias_component.h"
 #include "hyperplane_component.h"
 #include "stack_component.h"
@@ -59,6 +61,7 @@ void pushHashTableInLuaStack(lua_State *L,
 #include "hardtanh_actf_component.h"
 #include "sin_actf_component.h"
 #include "linear_actf_component.h"
+#include "connections_arena.h"
 
 using namespace ANN;
 
@@ -202,6 +205,67 @@ using namespace ANN;
 }
 //BIND_END
 
+//BIND_METHOD Connections set_precision
+{
+  const char *precision;
+  LUABIND_CHECK_ARGN(==, 1);
+  LUABIND_GET_PARAMETER(1, string, precision);
+  if (strcmp(precision, "fp32") == 0) obj->toFullPrecision();
+  else if (strcmp(precision, "fp16") == 0)
+    obj->toHalfPrecision(april_utils::HALF_FP16);
+  else if (strcmp(precision, "bf16") == 0)
+    obj->toHalfPrecision(april_utils::HALF_BF16);
+  else LUABIND_FERROR1("Incorrect precision '%s', expected fp32, fp16 or "
+		       "bf16\n", precision);
+}
+//BIND_END
+
+//BIND_METHOD Connections get_precision
+{
+  if (!obj->isHalfPrecision()) LUABIND_RETURN(string, "fp32");
+  else if (obj->getHalfFormat() == april_utils::HALF_FP16)
+    LUABIND_RETURN(string, "fp16");
+  else LUABIND_RETURN(string, "bf16");
+}
+//BIND_END
+
+/////////////////////////////////////////////////////
+//                ConnectionsArena                 //
+/////////////////////////////////////////////////////
+
+//BIND_LUACLASSNAME ConnectionsArena ann.connections_arena
+//BIND_CPP_CLASS    ConnectionsArena
+
+//BIND_CONSTRUCTOR ConnectionsArena
+{
+  LUABIND_CHECK_ARGN(==,1);
+  LUABIND_CHECK_PARAMETER(1, table);
+#ifdef USE_CUDA
+  // arena views are only available for CPU memory blocks
+  LUABIND_ERROR("ann.connections_arena is not available in CUDA builds");
+#endif
+  unsigned int n;
+  LUABIND_TABLE_GETN(1, n);
+  Connections **connections = new Connections*[n];
+  LUABIND_TABLE_TO_VECTOR(1, Connections, connections, n);
+  obj = new ConnectionsArena(connections, n);
+  delete[] connections;
+  LUABIND_RETURN(ConnectionsArena, obj);
+}
+//BIND_END
+
+//BIND_METHOD ConnectionsArena size
+{
+  LUABIND_RETURN(uint, obj->size());
+}
+//BIND_END
+
+//BIND_METHOD ConnectionsArena get_num_connections
+{
+  LUABIND_RETURN(uint, obj->getNumConnections());
+}
+//BIND_END
+
 /////////////////////////////////////////////////////
 //                  ANNComponent                   //
 /////////////////////////////////////////////////////
@@ -370,6 +434,21 @@ using namespace ANN;
 }
 //BIND_END
 
+//BIND_METHOD ANNComponent set_target
+{
+  Token *target;
+  LUABIND_CHECK_ARGN(==, 1);
+  LUABIND_GET_PARAMETER(1, Token, target);
+  obj->setTarget(target);
+}
+//BIND_END
+
+//BIND_METHOD ANNComponent needs_target_for_gradient
+{
+  LUABIND_RETURN(bool, obj->needsTargetForGradient());
+}
+//BIND_END
+
 //BIND_METHOD ANNComponent forward
 {
   Token *input;
@@ -395,6 +474,15 @@ using namespace ANN;
 
 //BIND_METHOD ANNComponent update
 {
+  // half precision weights are only for inference, they are refused here as
+  // a Lua error, before any weights are changed
+  hash<string,Connections*> weights_dict;
+  obj->copyWeights(weights_dict);
+  for (hash<string,Connections*>::iterator it = weights_dict.begin();
+       it != weights_dict.end(); ++it)
+    if (it->second->isHalfPrecision())
+      LUABIND_FERROR1("weights %s are stored in half precision, they are not "
+		      "trainable", it->first.c_str());
   obj->doUpdate();
 }
 //BIND_END
@@ -420,6 +508,33 @@ using namespace ANN;
 }
 //BIND_END
 
+//BIND_METHOD ANNComponent set_quantized
+{
+  bool quantized;
+  LUABIND_CHECK_ARGN(==, 1);
+  LUABIND_GET_PARAMETER(1, bool, quantized);
+  obj->setQuantized(quantized);
+}
+//BIND_END
+
+//BIND_METHOD ANNComponent get_quantized
+{
+  LUABIND_RETURN(bool, obj->getQuantized());
+}
+//BIND_END
+
+//BIND_METHOD ANNComponent begin_calibration
+{
+  obj->beginCalibration();
+}
+//BIND_END
+
+//BIND_METHOD ANNComponent end_calibration
+{
+  obj->endCalibration();
+}
+//BIND_END
+
 //BIND_METHOD ANNComponent build
 {
   LUABIND_CHECK_ARGN(<=, 1);
@@ -536,6 +651,126 @@ using namespace ANN;
 }
 //BIND_END
 
+/////////////////////////////////////////////////////
+//           FactoredSoftmaxANNComponent           //
+/////////////////////////////////////////////////////
+
+//BIND_LUACLASSNAME FactoredSoftmaxANNComponent ann.components.factored_softmax
+//BIND_CPP_CLASS    FactoredSoftmaxANNComponent
+//BIND_SUBCLASS_OF  FactoredSoftmaxANNComponent ANNComponent
+
+//BIND_CONSTRUCTOR FactoredSoftmaxANNComponent
+{
+  LUABIND_CHECK_ARGN(==, 1);
+  LUABIND_CHECK_PARAMETER(1, table);
+  const char *name=0, *weights_name=0;
+  unsigned int input_size=0;
+  int num_words;
+  check_table_fields(L, 1, "name", "weights", "input", "word_classes", 0);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, name, string, name, 0);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, weights, string, weights_name, 0);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, input, uint, input_size, 0);
+  // word_classes contains the class of each word, from 1 to num_classes
+  lua_getfield(L, 1, "word_classes");
+  if (!lua_istable(L, -1))
+    LUABIND_ERROR("word_classes field is mandatory, and must be a table\n");
+  LUABIND_TABLE_GETN(-1, num_words);
+  if (num_words == 0) LUABIND_ERROR("word_classes table is empty\n");
+  int *word_classes = new int[num_words];
+  LUABIND_TABLE_TO_VECTOR(-1, int, word_classes, num_words);
+  lua_pop(L, 1);
+  // all the classes are validated before releasing the vector
+  int wrong_word = 0, num_classes = 0;
+  for (int w=0; w<num_words && wrong_word == 0; ++w) {
+    if (word_classes[w] < 1) wrong_word = w+1;
+    else if (word_classes[w] > num_classes) num_classes = word_classes[w];
+  }
+  if (wrong_word > 0) {
+    delete[] word_classes;
+    LUABIND_FERROR1("Incorrect class of word %d\n", wrong_word);
+  }
+  // every class from 1 to the maximum one has words
+  bool *has_words = new bool[num_classes];
+  for (int k=0; k<num_classes; ++k) has_words[k] = false;
+  for (int w=0; w<num_words; ++w) has_words[word_classes[w]-1] = true;
+  int empty_class = 0;
+  for (int k=0; k<num_classes && empty_class == 0; ++k)
+    if (!has_words[k]) empty_class = k+1;
+  delete[] has_words;
+  if (empty_class > 0) {
+    delete[] word_classes;
+    LUABIND_FERROR1("Class %d has not words\n", empty_class);
+  }
+  for (int w=0; w<num_words; ++w) --word_classes[w];
+  obj = new FactoredSoftmaxANNComponent(name, weights_name,
+					input_size, num_words,
+					word_classes);
+  delete[] word_classes;
+  LUABIND_RETURN(FactoredSoftmaxANNComponent, obj);
+}
+//BIND_END
+
+//BIND_METHOD FactoredSoftmaxANNComponent get_num_classes
+{
+  LUABIND_RETURN(uint, obj->getNumClasses());
+}
+//BIND_END
+
+//BIND_METHOD FactoredSoftmaxANNComponent clone
+{
+  LUABIND_RETURN(FactoredSoftmaxANNComponent,
+		 dynamic_cast<FactoredSoftmaxANNComponent*>(obj->clone()));
+}
+//BIND_END
+
+/////////////////////////////////////////////////////
+//            SampledOutputANNComponent            //
+/////////////////////////////////////////////////////
+
+//BIND_LUACLASSNAME SampledOutputANNComponent ann.components.sampled_output
+//BIND_CPP_CLASS    SampledOutputANNComponent
+//BIND_SUBCLASS_OF  SampledOutputANNComponent ANNComponent
+
+//BIND_CONSTRUCTOR SampledOutputANNComponent
+{
+  LUABIND_CHECK_ARGN(==, 1);
+  LUABIND_CHECK_PARAMETER(1, table);
+  const char *name=0, *weights_name=0;
+  unsigned int input_size=0, output_size, num_samples;
+  dice *noise;
+  MTRand *random;
+  check_table_fields(L, 1, "name", "weights", "input", "output",
+		     "num_samples", "noise", "random", 0);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, name, string, name, 0);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, weights, string, weights_name, 0);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, input, uint, input_size, 0);
+  LUABIND_GET_TABLE_PARAMETER(1, output, uint, output_size);
+  LUABIND_GET_TABLE_PARAMETER(1, num_samples, uint, num_samples);
+  LUABIND_GET_TABLE_PARAMETER(1, noise, dice, noise);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, random, MTRand, random, 0);
+  if (noise->get_outcomes() != static_cast<int>(output_size))
+    LUABIND_FERROR1("The noise dice must have %d outcomes\n", output_size);
+  if (random == 0) random = new MTRand();
+  obj = new SampledOutputANNComponent(name, weights_name,
+				      input_size, output_size,
+				      num_samples, noise, random);
+  LUABIND_RETURN(SampledOutputANNComponent, obj);
+}
+//BIND_END
+
+//BIND_METHOD SampledOutputANNComponent get_num_samples
+{
+  LUABIND_RETURN(uint, obj->getNumSamples());
+}
+//BIND_END
+
+//BIND_METHOD SampledOutputANNComponent clone
+{
+  LUABIND_RETURN(SampledOutputANNComponent,
+		 dynamic_cast<SampledOutputANNComponent*>(obj->clone()));
+}
+//BIND_END
+
 /////////////////////////////////////////////////////
 //                BiasANNComponent                 //
 /////////////////////////////////////////////////////
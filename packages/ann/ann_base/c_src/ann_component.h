@@ -112,6 +112,18 @@ namespace ANN {
     virtual Token *getErrorInput() { return 0; }
     virtual Token *getErrorOutput() { return 0; }
     
+    /// Virtual method which receives the target of the next forward step
+    /// during training, before doForward. Output components could use it to
+    /// compute only the outputs needed by the loss (see
+    /// FactoredSoftmaxANNComponent). The target is forgotten by reset().
+    virtual void setTarget(Token *target) { }
+    
+    /// Virtual method which indicates if the training outputs and gradients
+    /// of the component depend on the target given by setTarget (see
+    /// FactoredSoftmaxANNComponent and SampledOutputANNComponent), so only
+    /// the loss functions designed for it could be used.
+    virtual bool needsTargetForGradient() const { return false; }
+    
     /// Virtual method that executes the set of operations required for each
     /// block of connections when performing the forward step of the
     /// Backpropagation algorithm, and returns its output Token
@@ -163,6 +175,17 @@ namespace ANN {
       return 0.0f;
     }
     
+    /// Virtual method to enable int8 quantized weights for inference (forward
+    /// with during_training=false). Components without weights ignore it.
+    virtual void setQuantized(bool v) { }
+    virtual bool getQuantized() const { return false; }
+    
+    /// Virtual methods to calibrate the input range used by quantized
+    /// inference. Between begin and end, forward steps collect statistics of
+    /// the input values. Components without weights ignore them.
+    virtual void beginCalibration() { }
+    virtual void endCalibration() { }
+    
     /// Abstract method to finish building of component hierarchy and set
     /// weights objects pointers. All childs which rewrite this method must call
     /// parent method before do anything.
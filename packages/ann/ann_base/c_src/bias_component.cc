@@ -59,7 +59,9 @@ namespace ANN {
     // get memory blocks for tokens and weights
     FloatGPUMirroredMemoryBlock *input_ptr       = input->getMemBlock();
     FloatGPUMirroredMemoryBlock *output_ptr      = output->getMemBlock();
-    FloatGPUMirroredMemoryBlock *bias_vector_ptr = bias_vector->getPtr();
+    FloatGPUMirroredMemoryBlock *bias_copy;
+    FloatGPUMirroredMemoryBlock *bias_vector_ptr =
+      bias_vector->getPtrForRead(bias_copy);
     // linear transfer of input to output
     doScopy(output_size*bunch_size,
 	    input_ptr, 0, 1,
@@ -72,6 +74,7 @@ namespace ANN {
 		bunch_size,
 		0, 1,
 		use_cuda);
+    delete bias_copy;
     return output;
   }
 
@@ -100,8 +103,8 @@ namespace ANN {
     if (bias_vector->isFirstUpdateCall()) {
       if (momentum > 0.0f) {
 	// prev_w[i,j] = momentum * (w[i,j] - prev_w[i,j])
-	bias_vector->computeMomentumOnPrevVector(momentum, use_cuda);
-	bias_vector->computeWeightDecayOnPrevVector(1.0f,  use_cuda);
+	bias_vector->computeMomentumAndWeightDecayOnPrevVector(momentum, 1.0f,
+							       use_cuda);
       }
       else bias_vector->copyToPrevVector(use_cuda);
     } // if (bias_vector->needsToComputeMomentum()) {
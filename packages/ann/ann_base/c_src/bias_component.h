@@ -69,6 +69,20 @@ namespace ANN {
     }
 
     virtual char *toLuaString();
+    
+    Connections *getBiasVector() { return bias_vector; }
+    
+    /// For fused forward steps (quantized hyperplane) the bias is added by the
+    /// previous component, and the result is stored as input and output of
+    /// this component
+    void setFusedOutput(TokenMemoryBlock *fused_output) {
+      IncRef(fused_output);
+      if (input)  DecRef(input);
+      if (output) DecRef(output);
+      input  = fused_output;
+      output = fused_output;
+      IncRef(fused_output);
+    }
   };
 }
 
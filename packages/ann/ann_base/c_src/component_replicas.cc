@@ -0,0 +1,69 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include "component_replicas.h"
+#include "connection.h"
+#include "error_print.h"
+
+namespace ANN {
+
+  ComponentReplicas::ComponentReplicas(ANNComponent *component,
+				       unsigned int num_replicas) {
+    if (!component->getIsBuilt())
+      ERROR_EXIT(128, "Component replicas need a built component\n");
+    hash<string,Connections*> weights_dict;
+    component->copyWeights(weights_dict);
+    april_utils::vector<Connections*> weights;
+    april_utils::vector<unsigned int> num_references;
+    for (hash<string,Connections*>::iterator it = weights_dict.begin();
+	 it != weights_dict.end(); ++it) {
+      weights.push_back(it->second);
+      num_references.push_back(it->second->getNumReferences());
+    }
+    components.push_back(component);
+    IncRef(component);
+    for (unsigned int i=1; i<num_replicas; ++i) {
+      hash<string,ANNComponent*> components_dict;
+      ANNComponent *clone = component->clone();
+      IncRef(clone);
+      clone->build(component->getInputSize(), component->getOutputSize(),
+		   weights_dict, components_dict);
+      components.push_back(clone);
+    }
+    for (unsigned int i=0; i<weights.size(); ++i)
+      while (weights[i]->getNumReferences() > num_references[i])
+	weights[i]->discountReference();
+  }
+
+  ComponentReplicas::~ComponentReplicas() {
+    for (unsigned int i=0; i<components.size(); ++i) DecRef(components[i]);
+  }
+
+  bool ComponentReplicas::isQuantized(ANNComponent *component) {
+    hash<string,ANNComponent*> components_dict;
+    component->copyComponents(components_dict);
+    for (hash<string,ANNComponent*>::iterator it = components_dict.begin();
+	 it != components_dict.end(); ++it)
+      if (it->second->getQuantized()) return true;
+    return false;
+  }
+
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef COMPONENT_REPLICAS_H
+#define COMPONENT_REPLICAS_H
+
+#include "vector.h"
+#include "ann_component.h"
+
+namespace ANN {
+
+  /// Replicas of a built component to be used concurrently by several
+  /// threads during inference (forward without training). Replica 0 is the
+  /// given component, the others are clones built with the same Connections,
+  /// which are read-only during inference. The reference counts of the
+  /// Connections are restored after building the clones, so training of the
+  /// given component is not affected.
+  class ComponentReplicas {
+    april_utils::vector<ANNComponent*> components;
+  public:
+    ComponentReplicas(ANNComponent *component, unsigned int num_replicas);
+    ~ComponentReplicas();
+    unsigned int size() const { return components.size(); }
+    ANNComponent *get(unsigned int i) { return components[i]; }
+    /// Returns true if any component of the hierarchy uses quantized
+    /// weights, which are not safe to be shared among replicas
+    static bool isQuantized(ANNComponent *component);
+  };
+}
+
+#endif // COMPONENT_REPLICAS_H
@@ -32,7 +32,8 @@ namespace ANN {
     weights(0), prev_weights(0),
     total_size(num_inputs*num_outputs),
     num_inputs(num_inputs), num_outputs(num_outputs),
-    num_references(0), update_weights_calls(0) {
+    num_references(0), update_weights_calls(0),
+    half_weights(0), half_format(april_utils::HALF_FP16) {
     weights      = new FloatGPUMirroredMemoryBlock(total_size);
     prev_weights = new FloatGPUMirroredMemoryBlock(total_size);
     if (weights == 0 || prev_weights == 0)
@@ -42,6 +43,7 @@ namespace ANN {
   Connections::~Connections() {
     delete weights;
     delete prev_weights;
+    delete half_weights;
   }
 
   bool Connections::checkInputOutputSizes(unsigned int input_size,
@@ -61,12 +63,20 @@ namespace ANN {
   void Connections::countReference() {
     ++num_references;
   }
+
+  void Connections::discountReference() {
+    if (num_references == 0)
+      ERROR_EXIT(128, "Impossible to discount a reference of "
+		 "unreferenced connections\n");
+    --num_references;
+  }
     
   unsigned int Connections::getNumReferences() const {
     return num_references;
   }
     
   void Connections::beginUpdate() {
+    checkFullPrecision("Training");
     ++update_weights_calls;
   }
     
@@ -117,6 +127,18 @@ namespace ANN {
 	    use_cuda);
   }
 
+  void Connections::
+  computeMomentumAndWeightDecayOnPrevVector(float momentum,
+					    float c_weight_decay,
+					    bool use_cuda) {
+    // prev_w[i,j] = momentum * (w[i,j] - prev_w[i,j]) + c_weight_decay * w[i,j]
+    doComputeMomentumAndWeightDecay(total_size,
+				    momentum, c_weight_decay,
+				    weights, 0,
+				    prev_weights, 0,
+				    use_cuda);
+  }
+
   unsigned int Connections::size() const {
     return total_size;
   }
@@ -136,17 +158,123 @@ namespace ANN {
     }
   }
 
+  void Connections::pruneSubnormalAndApplyMaxNorm(float max_norm,
+						  unsigned int input_size,
+						  unsigned int output_size,
+						  bool  check_normal,
+						  bool  use_cuda) {
+    if (input_size*output_size != total_size)
+      ERROR_EXIT2(128, "Incorrect sizes for max norm, expected %u weights, "
+		  "found %u\n", total_size, input_size*output_size);
+#ifdef USE_CUDA
+    if (use_cuda) {
+      if (check_normal) pruneSubnormalAndCheckNormal();
+      if (max_norm > 0.0f) {
+	for (unsigned int j=0; j<output_size; ++j) {
+	  float norm2 = doSnrm2(input_size, weights, j, output_size, use_cuda);
+	  if (norm2 > max_norm)
+	    doSscal(input_size, max_norm/norm2, weights, j, output_size,
+		    use_cuda);
+	}
+      }
+      return;
+    }
+#endif
+    if (!check_normal && max_norm <= 0.0f) return;
+    FloatGPUMirroredMemoryBlock *norms2 = 0;
+    if (max_norm > 0.0f) norms2 = new FloatGPUMirroredMemoryBlock(output_size);
+    bool ok = doPruneSubnormalAndMaxNorm(input_size, output_size, max_norm,
+					 weights, 0,
+					 check_normal,
+					 norms2);
+    delete norms2;
+    if (!ok) {
+      assert("No finite numbers at weights matrix!!!" && false);
+      ERROR_EXIT(128, "No finite numbers at weights matrix!!!\n");
+    }
+  }
+
+  void Connections::setMemoryBlocks(FloatGPUMirroredMemoryBlock *w,
+				    FloatGPUMirroredMemoryBlock *prev_w) {
+    checkFullPrecision("setMemoryBlocks");
+    if (w->getSize() != total_size || prev_w->getSize() != total_size)
+      ERROR_EXIT2(128, "Incorrect memory block sizes, expected %u, found %u\n",
+		  total_size, w->getSize());
+    doScopy(total_size, weights, 0, 1, w, 0, 1, false);
+    doScopy(total_size, prev_weights, 0, 1, prev_w, 0, 1, false);
+    delete weights;
+    delete prev_weights;
+    weights      = w;
+    prev_weights = prev_w;
+  }
+
   FloatGPUMirroredMemoryBlock *Connections::getPtr() {
+    checkFullPrecision("getPtr");
     return weights;
   }
 
+  FloatGPUMirroredMemoryBlock *Connections::
+  getPtrForRead(FloatGPUMirroredMemoryBlock *&copy) {
+    if (half_weights == 0) {
+      copy = 0;
+      return weights;
+    }
+    copy = new FloatGPUMirroredMemoryBlock(total_size);
+    unpackWeights(0, 1, total_size, copy->getPPALForWrite());
+    return copy;
+  }
+
   FloatGPUMirroredMemoryBlock *Connections::getPrevPtr() {
+    checkFullPrecision("getPrevPtr");
     return prev_weights;
   }
 
+  void Connections::toHalfPrecision(april_utils::HalfFloatFormat format) {
+    if (half_weights != 0) {
+      if (format == half_format) return;
+      toFullPrecision();
+    }
+    if (update_weights_calls != 0)
+      ERROR_EXIT(128, "Impossible to convert connections during update\n");
+    half_weights = new GPUMirroredMemoryBlock<uint16_t>(total_size);
+    half_format  = format;
+    april_utils::packHalfFloat(format, weights->getPPALForRead(), 1,
+			       half_weights->getPPALForWrite(), total_size);
+    delete weights;
+    delete prev_weights;
+    weights      = 0;
+    prev_weights = 0;
+  }
+
+  void Connections::toFullPrecision() {
+    if (half_weights == 0) return;
+    weights = new FloatGPUMirroredMemoryBlock(total_size);
+    unpackWeights(0, 1, total_size, weights->getPPALForWrite());
+    prev_weights = new FloatGPUMirroredMemoryBlock(total_size);
+    doScopy(total_size,
+	    weights, 0, 1,
+	    prev_weights, 0, 1,
+	    false);
+    delete half_weights;
+    half_weights = 0;
+  }
+
+  void Connections::unpackWeights(unsigned int shift, unsigned int inc,
+				  unsigned int sz, float *dest) const {
+    if (half_weights != 0)
+      april_utils::unpackHalfFloat(half_format,
+				   half_weights->getPPALForRead() + shift, inc,
+				   dest, sz);
+    else {
+      const float *w = weights->getPPALForRead() + shift;
+      for (unsigned int i=0; i<sz; ++i, w+=inc) dest[i] = *w;
+    }
+  }
+
   // Crea de forma aleatoria el conjunto de pesos con valores en el
   // rango [low, high]
   void Connections::randomizeWeights(MTRand *rnd, float low, float high) {
+    checkFullPrecision("randomizeWeights");
     double dinf = low;
     double dsup = high;
 
@@ -169,6 +297,7 @@ namespace ANN {
   void Connections::randomizeWeightsAtColumn(unsigned int col,
 					     MTRand *rnd,
 					     float low, float high) {
+    checkFullPrecision("randomizeWeightsAtColumn");
     double dinf = low;
     double dsup = high;
 
@@ -202,6 +331,9 @@ namespace ANN {
       ERROR_EXIT(128, "Matrices need to be simple (not sub-matrix "
 		 "and in row-major)\n");
     
+    // half precision connections are loaded in fp32 and converted again
+    bool half = isHalfPrecision();
+    if (half) toFullPrecision();
     unsigned int current_w_pos = first_weight_pos;
     float *w                   = weights->getPPALForReadAndWrite();
     float *prev_w              = prev_weights->getPPALForReadAndWrite();
@@ -216,6 +348,7 @@ namespace ANN {
       }
       current_w_pos += column_size;
     }
+    if (half) toHalfPrecision(half_format);
     return current_w_pos;
   }
 
@@ -235,10 +368,21 @@ namespace ANN {
 		 "and in row-major)\n");
     
     unsigned int current_w_pos = first_weight_pos;
-    const float *w             = weights->getPPALForRead();
-    const float *prev_w        = prev_weights->getPPALForRead();
     float *data_ptr = data->getRawDataAccess()->getPPALForWrite();
     float *old_data_ptr = old_data->getRawDataAccess()->getPPALForWrite();
+    if (half_weights != 0) {
+      // prev_weights are not stored in half precision, they are equal to
+      // weights
+      for (unsigned int j=0; j<num_outputs; ++j) {
+	unpackWeights(j, num_outputs, num_inputs, data_ptr + current_w_pos);
+	for (unsigned int i=0; i<num_inputs; ++i)
+	  old_data_ptr[current_w_pos+i] = data_ptr[current_w_pos+i];
+	current_w_pos += column_size;
+      }
+      return current_w_pos;
+    }
+    const float *w             = weights->getPPALForRead();
+    const float *prev_w        = prev_weights->getPPALForRead();
     for (unsigned int j=0; j<num_outputs; ++j) {
       unsigned int k = j;
       for (unsigned int i=0; i<num_inputs; ++i) {
@@ -254,6 +398,18 @@ namespace ANN {
   // para hacer copias
   Connections *Connections::clone() {
     Connections *conn = new Connections(num_inputs, num_outputs);
+    if (half_weights != 0) {
+      delete conn->weights;
+      delete conn->prev_weights;
+      conn->weights      = 0;
+      conn->prev_weights = 0;
+      conn->half_format  = half_format;
+      conn->half_weights = new GPUMirroredMemoryBlock<uint16_t>(total_size);
+      memcpy(conn->half_weights->getPPALForWrite(),
+	     half_weights->getPPALForRead(),
+	     sizeof(uint16_t)*total_size);
+      return conn;
+    }
 
     doScopy(total_size,
 	    weights, 0, 1,
@@ -269,6 +425,7 @@ namespace ANN {
   }
 
   void Connections::scale(float alpha) {
+    checkFullPrecision("scale");
     doSscal(total_size, alpha, weights, 0, 1,
 	    weights->getCudaFlag());
     doSscal(total_size, alpha, prev_weights, 0, 1,
@@ -279,6 +436,15 @@ namespace ANN {
     printf ("Connections %p, input=%d, output=%d, num_refs=%d, calls=%d\n",
 	    this, num_inputs, num_outputs, num_references,
 	    update_weights_calls);
+    if (half_weights != 0) {
+      float *w = new float[total_size];
+      unpackWeights(0, 1, total_size, w);
+      for (unsigned int i=0; i<total_size; ++i)
+	printf("%f ", w[i]);
+      printf("\n");
+      delete[] w;
+      return;
+    }
     const float *w = weights->getPPALForRead();
     const float *prevw = prev_weights->getPPALForRead();
     for (unsigned int i=0; i<total_size; ++i)
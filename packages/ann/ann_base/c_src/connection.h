@@ -32,6 +32,7 @@
 #include "matrixFloat.h"
 #include "error_print.h"
 #include "maxmin.h"
+#include "half_float.h"
 
 using april_utils::max;
 
@@ -64,6 +65,16 @@ namespace ANN {
     /// update_weights_call, se inicia a 0 cuando este valor llega a
     /// getNumReferences()
     unsigned int update_weights_calls;
+    /// 16 bits storage of weights for inference-only models, it is NULL when
+    /// weights are stored in fp32
+    GPUMirroredMemoryBlock<uint16_t> *half_weights;
+    april_utils::HalfFloatFormat      half_format;
+    
+    void checkFullPrecision(const char *method) const {
+      if (half_weights != 0)
+	ERROR_EXIT1(128, "%s is not available with half precision "
+		    "connections\n", method);
+    }
     
   public:
     static const double weightnearzero;
@@ -79,6 +90,9 @@ namespace ANN {
     // contamos el numero de veces que nos referencian, asi sabemos si
     // la conexion es compartida por mas de una accion
     void         countReference();
+    /// Undoes one countReference, for components which share these weights
+    /// but never update them (as inference clones)
+    void         discountReference();
     unsigned int getNumReferences() const;
     unsigned int getInputSize()  const { return num_inputs; }
     unsigned int getNumInputs()  const { return num_inputs; }
@@ -93,11 +107,39 @@ namespace ANN {
 					     bool  use_cuda);
     void         computeWeightDecayOnPrevVector(float c_weight_decay,
 						bool  use_cuda);
+    /// Fused version of computeMomentumOnPrevVector followed by
+    /// computeWeightDecayOnPrevVector, in one memory pass
+    void         computeMomentumAndWeightDecayOnPrevVector(float momentum,
+							   float c_weight_decay,
+							   bool  use_cuda);
     void         copyToPrevVector(bool use_cuda);
     unsigned int size() const;
     void         pruneSubnormalAndCheckNormal();
+    /// Applies max norm penalty (if max_norm > 0) and, if check_normal is
+    /// true, prunes subnormal weights checking finiteness, everything in one
+    /// memory pass. The norms are computed as DotProductANNComponent does,
+    /// over weights traversed as a col-major output_size x input_size matrix
+    /// with the sizes of the component (for transposed components they are
+    /// swapped with respect to the connections sizes).
+    void         pruneSubnormalAndApplyMaxNorm(float max_norm,
+					       unsigned int input_size,
+					       unsigned int output_size,
+					       bool  check_normal,
+					       bool  use_cuda);
+    /// Replaces weights and prev_weights memory blocks by the given ones
+    /// (with the same size), copying their content. Used to place weights
+    /// into a contiguous arena (see ConnectionsArena)
+    void         setMemoryBlocks(FloatGPUMirroredMemoryBlock *w,
+				 FloatGPUMirroredMemoryBlock *prev_w);
+    /// fp32 weights, not available with half precision storage (see
+    /// getPtrForRead and unpackWeights)
     FloatGPUMirroredMemoryBlock *getPtr();
     FloatGPUMirroredMemoryBlock *getPrevPtr();
+    /// fp32 weights for reading. With half precision storage they are
+    /// converted into a new block, which is returned also at copy and must be
+    /// deleted by the caller after use (copy is 0 with fp32 storage). Nothing
+    /// is cached, so concurrent readers don't modify the connections.
+    FloatGPUMirroredMemoryBlock *getPtrForRead(FloatGPUMirroredMemoryBlock *&copy);
     
     // INTERFAZ A IMPLEMENTAR
     bool checkInputOutputSizes(unsigned int input_size,
@@ -127,6 +169,20 @@ namespace ANN {
     }
     
     void scale(float alpha);
+    
+    /// Converts weights to 16 bits storage (fp16 or bf16), releasing fp32
+    /// weights and prev_weights. The connections are only usable for
+    /// inference after this conversion.
+    void toHalfPrecision(april_utils::HalfFloatFormat format);
+    /// Converts back 16 bits weights to fp32 (prev_weights = weights)
+    void toFullPrecision();
+    bool isHalfPrecision() const { return half_weights != 0; }
+    april_utils::HalfFloatFormat getHalfFormat() const { return half_format; }
+    /// Writes sz fp32 weights at dest, starting at position shift and
+    /// stepping inc positions. Works with fp32 and 16 bits storage, so it is
+    /// the way to read weights without a full fp32 copy.
+    void unpackWeights(unsigned int shift, unsigned int inc, unsigned int sz,
+		       float *dest) const;
 
     void printDebug();
   };
@@ -0,0 +1,57 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include "connections_arena.h"
+#include "error_print.h"
+
+namespace ANN {
+  
+  ConnectionsArena::ConnectionsArena(Connections **connections,
+				     unsigned int n) : Referenced(),
+						       total_size(0) {
+    for (unsigned int i=0; i<n; ++i) {
+      IncRef(connections[i]);
+      this->connections.push_back(connections[i]);
+      unsigned int sz = connections[i]->size();
+      total_size += ( (sz + ALIGNMENT - 1) / ALIGNMENT ) * ALIGNMENT;
+    }
+    weights_arena      = new FloatGPUMirroredMemoryBlock(total_size, true);
+    prev_weights_arena = new FloatGPUMirroredMemoryBlock(total_size, true);
+    IncRef(weights_arena);
+    IncRef(prev_weights_arena);
+    unsigned int pos = 0;
+    for (unsigned int i=0; i<n; ++i) {
+      unsigned int sz = connections[i]->size();
+      connections[i]->
+	setMemoryBlocks(new FloatGPUMirroredMemoryBlock(weights_arena, pos, sz),
+			new FloatGPUMirroredMemoryBlock(prev_weights_arena,
+							pos, sz));
+      pos += ( (sz + ALIGNMENT - 1) / ALIGNMENT ) * ALIGNMENT;
+    }
+  }
+  
+  ConnectionsArena::~ConnectionsArena() {
+    for (unsigned int i=0; i<connections.size(); ++i)
+      DecRef(connections[i]);
+    DecRef(weights_arena);
+    DecRef(prev_weights_arena);
+  }
+}
@@ -0,0 +1,52 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef CONNECTIONS_ARENA_H
+#define CONNECTIONS_ARENA_H
+
+#include "referenced.h"
+#include "vector.h"
+#include "connection.h"
+
+namespace ANN {
+  
+  /// Places the weights of a set of Connections objects into two contiguous
+  /// and aligned memory blocks (one for weights and one for prev_weights).
+  /// Each Connections object keeps working as before, using views of the
+  /// arena blocks, so components are not aware of the arena and updates are
+  /// done connection by connection; the arena only changes the memory
+  /// layout. Views are only available for CPU memory.
+  class ConnectionsArena : public Referenced {
+    /// Each connection starts at a position multiple of ALIGNMENT floats
+    static const unsigned int ALIGNMENT = 16;
+    FloatGPUMirroredMemoryBlock *weights_arena, *prev_weights_arena;
+    april_utils::vector<Connections*> connections;
+    unsigned int total_size;
+  public:
+    ConnectionsArena(Connections **connections, unsigned int n);
+    virtual ~ConnectionsArena();
+    /// Number of floats of each arena block (including alignment padding)
+    unsigned int size() const { return total_size; }
+    unsigned int getNumConnections() const { return connections.size(); }
+  };
+}
+
+#endif // CONNECTIONS_ARENA_H
@@ -19,6 +19,7 @@
  * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  *
  */
+#include <cmath>
 #include "swap.h"
 #include "dot_product_component.h"
 #include "wrapper.h"
@@ -28,6 +29,11 @@
 #include "table_of_token_codes.h"
 
 using april_utils::swap;
+using april_utils::min;
+
+// Size (number of floats) of the weights panels for half precision
+// connections, which are converted to fp32 on the fly before each sgemm
+#define HALF_PRECISION_PANEL_SIZE 65536
 
 namespace ANN {
 
@@ -51,7 +57,13 @@ namespace ANN {
     momentum(0.0f),
     weight_decay(0.0f),
     c_weight_decay(1.0f),
-    max_norm_penalty(-1.0f) {
+    max_norm_penalty(-1.0f),
+    quantized(false),
+    calibrating(false),
+    quantized_weights(0),
+    quantized_scales(0),
+    input_scale(-1.0f),
+    calibration_max_abs(0.0f) {
     if (weights_name == 0) generateDefaultWeightsName("w");
     this->transpose_weights = (transpose_weights) ? CblasTrans : CblasNoTrans;
   }
@@ -62,12 +74,60 @@ namespace ANN {
     if (error_input) DecRef(error_input);
     if (output) DecRef(output);
     if (error_output) DecRef(error_output);
+    releaseQuantizedWeights();
   }
   
   // The DotProductANNComponent
+  void DotProductANNComponent::
+  halfPrecisionProduct(FloatGPUMirroredMemoryBlock *input_ptr,
+		       FloatGPUMirroredMemoryBlock *output_ptr,
+		       bool backprop) {
+    // each panel is a set of consecutive columns of the col-major weights
+    // matrix, which are contiguous in memory
+    const unsigned int ld       = weights_matrix->getOutputSize();
+    const unsigned int num_cols = weights_matrix->getInputSize();
+    // size of the rows of input and output bunches
+    const unsigned int in_size  = (backprop) ? output_size : input_size;
+    const unsigned int out_size = (backprop) ? input_size  : output_size;
+    // panel columns index the rows of the input (partial sums are
+    // accumulated), or they index the rows of the output
+    const bool accumulate = (transpose_weights == CblasNoTrans) != backprop;
+    unsigned int cols_per_panel = max(1u, HALF_PRECISION_PANEL_SIZE / ld);
+    cols_per_panel = min(cols_per_panel, num_cols);
+    FloatGPUMirroredMemoryBlock *panel =
+      new FloatGPUMirroredMemoryBlock(cols_per_panel * ld);
+    for (unsigned int c0=0; c0<num_cols; c0+=cols_per_panel) {
+      unsigned int ncols = min(cols_per_panel, num_cols - c0);
+      weights_matrix->unpackWeights(c0*ld, 1, ncols*ld,
+				    panel->getPPALForWrite());
+      if (accumulate)
+	doSgemm(CblasColMajor, CblasNoTrans, CblasTrans,
+		bunch_size, out_size, ncols,
+		1.0f, input_ptr, bunch_size,
+		panel, ld,
+		(c0 == 0) ? 0.0f : 1.0f, output_ptr, bunch_size,
+		c0*bunch_size, 0, 0,
+		use_cuda);
+      else
+	doSgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
+		bunch_size, ncols, in_size,
+		1.0f, input_ptr, bunch_size,
+		panel, ld,
+		0.0f, output_ptr, bunch_size,
+		0, 0, c0*bunch_size,
+		use_cuda);
+    }
+    delete panel;
+  }
+  
   Token *DotProductANNComponent::doForward(Token *_input, bool during_training) {
     assert(weights_matrix != 0);
-    FloatGPUMirroredMemoryBlock *weights_mat_ptr = weights_matrix->getPtr();
+    if (quantized && !during_training && !calibrating && _input != 0 &&
+	_input->getTokenCode() == table_of_token_codes::token_mem_block)
+      return doQuantizedForward(_input, 0);
+    const bool half_precision = weights_matrix->isHalfPrecision();
+    FloatGPUMirroredMemoryBlock *weights_mat_ptr = 0;
+    if (!half_precision) weights_mat_ptr = weights_matrix->getPtr();
     // error checking
     if (_input == 0)
       ERROR_EXIT(129,"Null Token received!\n");
@@ -87,8 +147,16 @@ namespace ANN {
       // get memory blocks for tokens and weights
       FloatGPUMirroredMemoryBlock *input_ptr       = input_mem_token->getMemBlock();
       FloatGPUMirroredMemoryBlock *output_ptr      = output->getMemBlock();
+      if (calibrating) {
+	const float *input_data = input_ptr->getPPALForRead();
+	for (unsigned int i=0; i<bunch_size*input_size; ++i) {
+	  float v = fabsf(input_data[i]);
+	  if (v > calibration_max_abs) calibration_max_abs = v;
+	}
+      }
       //
-      if (bunch_size == 1) {
+      if (half_precision) halfPrecisionProduct(input_ptr, output_ptr, false);
+      else if (bunch_size == 1) {
 	// vector x matrix product
 	doSgemv(CblasColMajor, transpose_weights,
 		weights_matrix->getOutputSize(), weights_matrix->getInputSize(),
@@ -138,6 +206,12 @@ namespace ANN {
 	w_lda  = 1;
 	w_step = output_size;
       }
+      // with half precision, each used row is converted to fp32
+      FloatGPUMirroredMemoryBlock *w_row = 0;
+      if (half_precision) {
+	w_row = new FloatGPUMirroredMemoryBlock(output_size);
+	weights_mat_ptr = w_row;
+      }
       for (unsigned int b=0; b<bunch_size; ++b) {
 	Token *current = (*input_vector_token)[b];
 	if (current->getTokenCode()!=table_of_token_codes::vector_float_sparse)
@@ -150,12 +224,22 @@ namespace ANN {
 	  unsigned int w_shift = pos*w_lda;
 	  if (pos >= input_size)
 	    ERROR_EXIT(128, "Overflow at sparse vector input pos\n");
-	  doSaxpy(output_size,
-		  value,
-		  weights_mat_ptr, w_shift, w_step,
-		  output_ptr, b, bunch_size, use_cuda);
+	  if (half_precision) {
+	    weights_matrix->unpackWeights(w_shift, w_step, output_size,
+					  w_row->getPPALForWrite());
+	    doSaxpy(output_size,
+		    value,
+		    w_row, 0, 1,
+		    output_ptr, b, bunch_size, use_cuda);
+	  }
+	  else
+	    doSaxpy(output_size,
+		    value,
+		    weights_mat_ptr, w_shift, w_step,
+		    output_ptr, b, bunch_size, use_cuda);
 	}
       }
+      delete w_row;
       break;
     }
     default:
@@ -164,6 +248,87 @@ namespace ANN {
     return output;
   }
   
+  TokenMemoryBlock *DotProductANNComponent::
+  doQuantizedForward(Token *_input, FloatGPUMirroredMemoryBlock *bias) {
+    if (_input == 0 ||
+	_input->getTokenCode() != table_of_token_codes::token_mem_block)
+      ERROR_EXIT(129,"Incorrect input Token type, expected token_mem_block!\n");
+    if (quantized_weights == 0) quantizeWeights();
+    AssignRef(input,_input);
+    sparse_input = false;
+    TokenMemoryBlock *input_mem_token=input->convertTo<TokenMemoryBlock*>();
+    bunch_size = input_mem_token->getUsedSize() / input_size;
+    if (input_mem_token->getUsedSize() % input_size != 0)
+      ERROR_EXIT2(128, "Input memory block (size %d) is not multiple of %d\n",
+		  input_mem_token->getUsedSize(), input_size);
+    AssignRef(output,new TokenMemoryBlock(bunch_size * output_size));
+    // quantization of input patterns, one row for each pattern of the bunch
+    Int8GPUMirroredMemoryBlock  *quantized_input =
+      new Int8GPUMirroredMemoryBlock(bunch_size * input_size);
+    FloatGPUMirroredMemoryBlock *quantized_input_scales =
+      new FloatGPUMirroredMemoryBlock(bunch_size);
+    IncRef(quantized_input);
+    IncRef(quantized_input_scales);
+    doQuantizeInt8(input_mem_token->getMemBlock(), 0,
+		   1, bunch_size,
+		   bunch_size, input_size,
+		   quantized_input, quantized_input_scales,
+		   input_scale);
+    doInt8Gemm(bunch_size, output_size, input_size,
+	       quantized_input, quantized_input_scales,
+	       quantized_weights, quantized_scales,
+	       bias,
+	       output->getMemBlock(), bunch_size);
+    DecRef(quantized_input);
+    DecRef(quantized_input_scales);
+    return output;
+  }
+  
+  void DotProductANNComponent::quantizeWeights() {
+    releaseQuantizedWeights();
+    quantized_weights = new Int8GPUMirroredMemoryBlock(output_size*input_size);
+    quantized_scales  = new FloatGPUMirroredMemoryBlock(output_size);
+    IncRef(quantized_weights);
+    IncRef(quantized_scales);
+    // row j of quantized matrix contains the weights of output neuron j
+    unsigned int row_inc = 1, col_inc = output_size;
+    if (transpose_weights == CblasTrans) {
+      row_inc = input_size;
+      col_inc = 1;
+    }
+    FloatGPUMirroredMemoryBlock *weights_copy;
+    doQuantizeInt8(weights_matrix->getPtrForRead(weights_copy), 0,
+		   row_inc, col_inc,
+		   output_size, input_size,
+		   quantized_weights, quantized_scales,
+		   -1.0f);
+    delete weights_copy;
+  }
+  
+  void DotProductANNComponent::releaseQuantizedWeights() {
+    if (quantized_weights) DecRef(quantized_weights);
+    if (quantized_scales)  DecRef(quantized_scales);
+    quantized_weights = 0;
+    quantized_scales  = 0;
+  }
+  
+  void DotProductANNComponent::setQuantized(bool v) {
+    quantized = v;
+    // the int8 copy is computed lazily at the first quantized forward
+    releaseQuantizedWeights();
+  }
+  
+  void DotProductANNComponent::beginCalibration() {
+    calibrating         = true;
+    calibration_max_abs = 0.0f;
+  }
+  
+  void DotProductANNComponent::endCalibration() {
+    calibrating = false;
+    if (calibration_max_abs > 0.0f) input_scale = calibration_max_abs/127.0f;
+    else input_scale = -1.0f;
+  }
+  
   Token *DotProductANNComponent::doBackprop(Token *_error_input) {
     // error checking
     if ( (_error_input == 0) ||
@@ -188,6 +353,10 @@ namespace ANN {
     //
     FloatGPUMirroredMemoryBlock *error_input_ptr  = error_input->getMemBlock();
     FloatGPUMirroredMemoryBlock *error_output_ptr = error_output->getMemBlock();
+    if (weights_matrix->isHalfPrecision()) {
+      halfPrecisionProduct(error_input_ptr, error_output_ptr, true);
+      return error_output;
+    }
     FloatGPUMirroredMemoryBlock *weights_mat_ptr  = weights_matrix->getPtr();
     if (bunch_size > 1) {
       // C = alpha * A * B + beta * C
@@ -306,11 +475,10 @@ namespace ANN {
     if (weights_matrix->isFirstUpdateCall()) {
       // Momentum computation
       if (momentum > 0.0f) {
-	// prev_w[i,j] = momentum * (w[i,j] - prev_w[i,j])
-	weights_matrix->computeMomentumOnPrevVector(momentum,
-						    use_cuda);
-	weights_matrix->computeWeightDecayOnPrevVector(c_weight_decay,
-						       use_cuda);
+	// prev_w[i,j] = momentum * (w[i,j] - prev_w[i,j]) + c_weight_decay*w[i,j]
+	weights_matrix->computeMomentumAndWeightDecayOnPrevVector(momentum,
+								  c_weight_decay,
+								  use_cuda);
       }
       else {
 	weights_matrix->copyToPrevVector(use_cuda);
@@ -326,24 +494,19 @@ namespace ANN {
     // Forces to update counts and swap vectors if necessary at this backward
     // step
     if (weights_matrix->endUpdate()) {
+      // the int8 copy is not valid after an update
+      releaseQuantizedWeights();
       ++num_updates_from_last_prune;
+      bool check_normal = false;
       if (num_updates_from_last_prune > MAX_UPDATES_WITHOUT_PRUNE) {
 	num_updates_from_last_prune = 0;
-	weights_matrix->pruneSubnormalAndCheckNormal();
+	check_normal = true;
       }
-      if (max_norm_penalty > 0.0) {
-	for (unsigned int i=0; i<output_size; ++i) {
-	  float norm2 = doSnrm2(input_size,
-				weights_matrix->getPtr(), i, output_size,
-				use_cuda);
-	  if (norm2 > max_norm_penalty) {
-	    float scal = max_norm_penalty/norm2;
-	    doSscal(input_size, scal,
-		    weights_matrix->getPtr(), i, output_size,
-		    use_cuda);
-	  } // if norm2 > max_norm_penalty
-	} // for (i=0; i<output_size; ++i)
-      } // if max_norm_penalty > 0.0
+      // pruning and max norm penalty share the same pass over weights
+      weights_matrix->pruneSubnormalAndApplyMaxNorm(max_norm_penalty,
+						    input_size, output_size,
+						    check_normal,
+						    use_cuda);
     }
   }
   
@@ -370,6 +533,8 @@ namespace ANN {
     component->weight_decay   = weight_decay;
     component->c_weight_decay = c_weight_decay;
     component->max_norm_penalty = max_norm_penalty;
+    component->quantized        = quantized;
+    component->input_scale      = input_scale;
     return component;
   }
 
@@ -438,6 +603,7 @@ namespace ANN {
       // else printf("USING PREVIOUS WEIGHTS %s\n", weights_name.c_str());
       w = weights_matrix;
     }
+    releaseQuantizedWeights();
     // TODO: compute fan-in
     // outputs->increaseFanIn(inputs->numNeurons());
     weights_matrix->countReference();
@@ -456,7 +622,7 @@ namespace ANN {
 
   char *DotProductANNComponent::toLuaString() {
     buffer_list buffer;
-    buffer.printf("ann.components.copy{ name='%s',weights='%s',"
+    buffer.printf("ann.components.dot_product{ name='%s',weights='%s',"
 		  "input=%d,output=%d,transpose=%s }",
 		  name.c_str(), weights_name.c_str(),
 		  input_size, output_size,
@@ -39,6 +39,23 @@ namespace ANN {
     float learning_rate, momentum, weight_decay, c_weight_decay;
     float max_norm_penalty;
     CBLAS_TRANSPOSE transpose_weights;
+    
+    /// int8 quantized inference, weights are stored as output_size rows of
+    /// input_size int8 values with one scale per row
+    bool quantized, calibrating;
+    Int8GPUMirroredMemoryBlock  *quantized_weights;
+    FloatGPUMirroredMemoryBlock *quantized_scales;
+    /// input scale computed by calibration, if <= 0 it is computed
+    /// dynamically for each pattern
+    float input_scale, calibration_max_abs;
+    
+    /// Product of a dense bunch by the half precision weights (forward), or
+    /// by their transpose (backprop), converting them to fp32 by panels
+    void halfPrecisionProduct(FloatGPUMirroredMemoryBlock *input_ptr,
+			      FloatGPUMirroredMemoryBlock *output_ptr,
+			      bool backprop);
+    void quantizeWeights();
+    void releaseQuantizedWeights();
 
     void
     backpropagateErrors(FloatGPUMirroredMemoryBlock *weights_mat_ptr,
@@ -82,6 +99,17 @@ namespace ANN {
 
     virtual char *toLuaString();
     
+    virtual void setQuantized(bool v);
+    virtual bool getQuantized() const { return quantized; }
+    virtual void beginCalibration();
+    virtual void endCalibration();
+    bool getCalibrating() const { return calibrating; }
+    
+    /// Forward step using int8 quantized weights, the given bias vector (it
+    /// could be NULL) is added at the dequantization step
+    TokenMemoryBlock *doQuantizedForward(Token *input,
+					 FloatGPUMirroredMemoryBlock *bias);
+    
     bool transposed() { return transpose_weights == CblasTrans; }
   };
 }
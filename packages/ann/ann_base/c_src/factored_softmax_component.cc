@@ -0,0 +1,592 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include <cmath>
+#include "factored_softmax_component.h"
+#include "wrapper.h"
+#include "token_memory_block.h"
+#include "table_of_token_codes.h"
+#include "target_words.h"
+
+namespace ANN {
+
+  /// Returns the log of the sum of the exponentials of the row r of a
+  /// col-major matrix of the given number of rows
+  static float rowLogSumExp(const float *m, unsigned int rows,
+			    unsigned int cols, unsigned int r) {
+    float max = m[r];
+    for (unsigned int c=1; c<cols; ++c)
+      if (m[c*rows + r] > max) max = m[c*rows + r];
+    double sum = 0.0;
+    for (unsigned int c=0; c<cols; ++c) sum += exp(m[c*rows + r] - max);
+    return max + static_cast<float>(log(sum));
+  }
+  
+  /// Replaces the row r of a col-major matrix by its softmax, being norm its
+  /// log-sum-exp
+  static void rowSoftmax(float *m, unsigned int rows, unsigned int cols,
+			 unsigned int r, float norm) {
+    for (unsigned int c=0; c<cols; ++c)
+      m[c*rows + r] = expf(m[c*rows + r] - norm);
+  }
+
+  ////////////////////////////////////////////////
+  // FactoredSoftmaxANNComponent implementation //
+  ////////////////////////////////////////////////
+  
+  FactoredSoftmaxANNComponent::
+  FactoredSoftmaxANNComponent(const char *name, const char *weights_name,
+			      unsigned int input_size,
+			      unsigned int output_size,
+			      const int *word_classes) :
+    ANNComponent(name, weights_name, input_size, output_size),
+    input(0), target(0),
+    error_input(0),
+    output(0),
+    error_output(0),
+    weights_matrix(0),
+    bunch_size(0), num_classes(0),
+    num_updates_from_last_prune(0),
+    buffers_bunch_size(0),
+    word_class(0), word_pos(0), class_start(0), class_size(0),
+    sparse_output(false),
+    target_words(0), target_weights(0),
+    sorted_patterns(0), class_first(0),
+    sorted_inputs(0), sorted_errors(0),
+    class_probs(0), block_probs(0), block_probs_first(0),
+    learning_rate(-1.0f),
+    momentum(0.0f),
+    weight_decay(0.0f),
+    c_weight_decay(1.0f) {
+    if (weights_name == 0) generateDefaultWeightsName("w");
+    if (output_size == 0)
+      ERROR_EXIT(128, "The output size of factored softmax is mandatory\n");
+    setWordClasses(word_classes);
+  }
+  
+  FactoredSoftmaxANNComponent::~FactoredSoftmaxANNComponent() {
+    if (weights_matrix) DecRef(weights_matrix);
+    if (input) DecRef(input);
+    if (target) DecRef(target);
+    if (error_input) DecRef(error_input);
+    if (output) DecRef(output);
+    if (error_output) DecRef(error_output);
+    releaseBunchBuffers();
+    delete[] word_class;
+    delete[] word_pos;
+    delete[] class_start;
+    delete[] class_size;
+  }
+  
+  void FactoredSoftmaxANNComponent::setWordClasses(const int *word_classes) {
+    num_classes = 0;
+    for (unsigned int w=0; w<output_size; ++w) {
+      if (word_classes[w] < 0)
+	ERROR_EXIT1(128, "Incorrect class of word %u\n", w);
+      if (static_cast<unsigned int>(word_classes[w]) >= num_classes)
+	num_classes = word_classes[w] + 1;
+    }
+    word_class  = new int[output_size];
+    word_pos    = new int[output_size];
+    class_start = new int[num_classes];
+    class_size  = new int[num_classes];
+    for (unsigned int k=0; k<num_classes; ++k) class_size[k] = 0;
+    for (unsigned int w=0; w<output_size; ++w) {
+      word_class[w] = word_classes[w];
+      ++class_size[word_class[w]];
+    }
+    for (unsigned int k=0; k<num_classes; ++k) {
+      if (class_size[k] == 0)
+	ERROR_EXIT1(128, "Class %u has not words\n", k);
+      class_start[k] = (k == 0) ? 0 : class_start[k-1] + class_size[k-1];
+    }
+    // words keep their relative order inside its class block
+    int *next_pos = new int[num_classes];
+    for (unsigned int k=0; k<num_classes; ++k) next_pos[k] = class_start[k];
+    for (unsigned int w=0; w<output_size; ++w)
+      word_pos[w] = next_pos[word_class[w]]++;
+    delete[] next_pos;
+  }
+  
+  void FactoredSoftmaxANNComponent::releaseBunchBuffers() {
+    delete[] target_words;
+    delete[] target_weights;
+    delete[] sorted_patterns;
+    delete[] class_first;
+    delete[] block_probs_first;
+    delete sorted_inputs;
+    delete sorted_errors;
+    delete class_probs;
+    delete block_probs;
+    target_words      = 0;
+    target_weights    = 0;
+    sorted_patterns   = 0;
+    class_first       = 0;
+    block_probs_first = 0;
+    sorted_inputs     = 0;
+    sorted_errors     = 0;
+    class_probs       = 0;
+    block_probs       = 0;
+    buffers_bunch_size = 0;
+  }
+  
+  void FactoredSoftmaxANNComponent::allocateBunchBuffers(unsigned int bunch_size) {
+    if (bunch_size == buffers_bunch_size) return;
+    releaseBunchBuffers();
+    target_words      = new int[bunch_size];
+    target_weights    = new float[bunch_size];
+    sorted_patterns   = new int[bunch_size];
+    class_first       = new int[num_classes + 1];
+    block_probs_first = new unsigned int[num_classes];
+    sorted_inputs     = new FloatGPUMirroredMemoryBlock(bunch_size*input_size);
+    sorted_errors     = new FloatGPUMirroredMemoryBlock(bunch_size*input_size);
+    class_probs       = new FloatGPUMirroredMemoryBlock(bunch_size*num_classes);
+    buffers_bunch_size = bunch_size;
+  }
+  
+  void FactoredSoftmaxANNComponent::setTarget(Token *_target) {
+    AssignRef(target, _target);
+  }
+  
+  void FactoredSoftmaxANNComponent::
+  computeClassLogits(FloatGPUMirroredMemoryBlock *input_ptr) {
+    const unsigned int ld = weights_matrix->getOutputSize();
+    FloatGPUMirroredMemoryBlock *weights_ptr = weights_matrix->getPtr();
+    doSgemm(CblasColMajor, CblasNoTrans, CblasTrans,
+	    bunch_size, num_classes, input_size,
+	    1.0f, input_ptr, bunch_size,
+	    weights_ptr, ld,
+	    0.0f, class_probs, bunch_size,
+	    0, 0, 0,
+	    false);
+    const float *bias = weights_ptr->getPPALForRead() + input_size*ld;
+    float *logits     = class_probs->getPPALForReadAndWrite();
+    for (unsigned int k=0; k<num_classes; ++k)
+      for (unsigned int b=0; b<bunch_size; ++b)
+	logits[k*bunch_size + b] += bias[k];
+  }
+  
+  void FactoredSoftmaxANNComponent::
+  forwardTargetBlocks(FloatGPUMirroredMemoryBlock *input_ptr,
+		      float *output_ptr) {
+    const unsigned int ld = weights_matrix->getOutputSize();
+    // counting sort of the patterns by the class of their target
+    for (unsigned int k=0; k<=num_classes; ++k) class_first[k] = 0;
+    for (unsigned int b=0; b<bunch_size; ++b)
+      ++class_first[word_class[target_words[b]] + 1];
+    for (unsigned int k=0; k<num_classes; ++k)
+      class_first[k+1] += class_first[k];
+    unsigned int total_probs = 0;
+    for (unsigned int k=0; k<num_classes; ++k) {
+      block_probs_first[k] = total_probs;
+      total_probs += (class_first[k+1] - class_first[k]) * class_size[k];
+    }
+    int *next = new int[num_classes];
+    for (unsigned int k=0; k<num_classes; ++k) next[k] = class_first[k];
+    for (unsigned int b=0; b<bunch_size; ++b)
+      sorted_patterns[next[word_class[target_words[b]]]++] = b;
+    delete[] next;
+    if (block_probs == 0 ||
+	block_probs->getSize() < total_probs) {
+      delete block_probs;
+      block_probs = new FloatGPUMirroredMemoryBlock(total_probs);
+    }
+    // gather of the inputs following the sorted order
+    const float *x = input_ptr->getPPALForRead();
+    float *xs      = sorted_inputs->getPPALForWrite();
+    for (unsigned int h=0; h<input_size; ++h)
+      for (unsigned int i=0; i<bunch_size; ++i)
+	xs[h*bunch_size + i] = x[h*bunch_size + sorted_patterns[i]];
+    // classes layer
+    computeClassLogits(sorted_inputs);
+    float *cp = class_probs->getPPALForReadAndWrite();
+    float *log_class_prob = new float[bunch_size];
+    for (unsigned int i=0; i<bunch_size; ++i) {
+      int k = word_class[target_words[sorted_patterns[i]]];
+      float norm = rowLogSumExp(cp, bunch_size, num_classes, i);
+      log_class_prob[i] = cp[k*bunch_size + i] - norm;
+      rowSoftmax(cp, bunch_size, num_classes, i, norm);
+    }
+    // word block of each class, for its patterns
+    FloatGPUMirroredMemoryBlock *weights_ptr = weights_matrix->getPtr();
+    const float *bias = weights_ptr->getPPALForRead() + input_size*ld;
+    for (unsigned int k=0; k<num_classes; ++k) {
+      unsigned int n = class_first[k+1] - class_first[k];
+      if (n == 0) continue;
+      unsigned int first_word = num_classes + class_start[k];
+      doSgemm(CblasColMajor, CblasNoTrans, CblasTrans,
+	      n, class_size[k], input_size,
+	      1.0f, sorted_inputs, bunch_size,
+	      weights_ptr, ld,
+	      0.0f, block_probs, n,
+	      class_first[k], first_word, block_probs_first[k],
+	      false);
+      float *bp = block_probs->getPPALForReadAndWrite() + block_probs_first[k];
+      for (int j=0; j<class_size[k]; ++j)
+	for (unsigned int r=0; r<n; ++r)
+	  bp[j*n + r] += bias[first_word + j];
+      for (unsigned int r=0; r<n; ++r) {
+	unsigned int i = class_first[k] + r;
+	int b = sorted_patterns[i];
+	int w = target_words[b];
+	float norm = rowLogSumExp(bp, n, class_size[k], r);
+	output_ptr[w*bunch_size + b] =
+	  log_class_prob[i] + bp[(word_pos[w] - class_start[k])*n + r] - norm;
+	rowSoftmax(bp, n, class_size[k], r, norm);
+      }
+    }
+    delete[] log_class_prob;
+  }
+  
+  void FactoredSoftmaxANNComponent::
+  forwardAllWords(FloatGPUMirroredMemoryBlock *input_ptr,
+		  float *output_ptr) {
+    const unsigned int ld = weights_matrix->getOutputSize();
+    // classes layer, its log-softmax is kept at class_probs
+    computeClassLogits(input_ptr);
+    float *lcp = class_probs->getPPALForReadAndWrite();
+    for (unsigned int b=0; b<bunch_size; ++b) {
+      float norm = rowLogSumExp(lcp, bunch_size, num_classes, b);
+      for (unsigned int k=0; k<num_classes; ++k) lcp[k*bunch_size + b] -= norm;
+    }
+    // all the words, and log-softmax of each class block
+    if (block_probs == 0 ||
+	block_probs->getSize() < bunch_size*output_size) {
+      delete block_probs;
+      block_probs = new FloatGPUMirroredMemoryBlock(bunch_size*output_size);
+    }
+    FloatGPUMirroredMemoryBlock *weights_ptr = weights_matrix->getPtr();
+    doSgemm(CblasColMajor, CblasNoTrans, CblasTrans,
+	    bunch_size, output_size, input_size,
+	    1.0f, input_ptr, bunch_size,
+	    weights_ptr, ld,
+	    0.0f, block_probs, bunch_size,
+	    0, num_classes, 0,
+	    false);
+    const float *bias = weights_ptr->getPPALForRead() + input_size*ld;
+    float *z = block_probs->getPPALForReadAndWrite();
+    for (unsigned int p=0; p<output_size; ++p)
+      for (unsigned int b=0; b<bunch_size; ++b)
+	z[p*bunch_size + b] += bias[num_classes + p];
+    for (unsigned int k=0; k<num_classes; ++k) {
+      float *zk = z + class_start[k]*bunch_size;
+      for (unsigned int b=0; b<bunch_size; ++b) {
+	float norm = rowLogSumExp(zk, bunch_size, class_size[k], b);
+	for (int j=0; j<class_size[k]; ++j) zk[j*bunch_size + b] -= norm;
+      }
+    }
+    for (unsigned int w=0; w<output_size; ++w) {
+      const float *zw  = z + word_pos[w]*bunch_size;
+      const float *lcw = lcp + word_class[w]*bunch_size;
+      for (unsigned int b=0; b<bunch_size; ++b)
+	output_ptr[w*bunch_size + b] = lcw[b] + zw[b];
+    }
+  }
+  
+  Token *FactoredSoftmaxANNComponent::doForward(Token *_input,
+						bool during_training) {
+    assert(weights_matrix != 0);
+    if (weights_matrix->isHalfPrecision())
+      ERROR_EXIT(128, "Half precision weights are not supported by "
+		 "factored softmax\n");
+    if (_input == 0 ||
+	_input->getTokenCode() != table_of_token_codes::token_mem_block)
+      ERROR_EXIT(129,"Incorrect input Token type, expected token_mem_block!\n");
+    AssignRef(input,_input);
+    TokenMemoryBlock *input_mem_token=input->convertTo<TokenMemoryBlock*>();
+    bunch_size = input_mem_token->getUsedSize() / input_size;
+    if (input_mem_token->getUsedSize() % input_size != 0)
+      ERROR_EXIT2(128, "Input memory block (size %d) is not multiple of %d\n",
+		  input_mem_token->getUsedSize(), input_size);
+    allocateBunchBuffers(bunch_size);
+    AssignRef(output,new TokenMemoryBlock(bunch_size * output_size));
+    float *output_ptr = output->getMemBlock()->getPPALForWrite();
+    sparse_output = during_training && target != 0;
+    if (sparse_output) {
+      loadTargetWords(target, bunch_size, output_size,
+		      target_words, target_weights);
+      for (unsigned int i=0; i<bunch_size*output_size; ++i)
+	output_ptr[i] = LOG_ZERO_PROBABILITY;
+      forwardTargetBlocks(input_mem_token->getMemBlock(), output_ptr);
+    }
+    else forwardAllWords(input_mem_token->getMemBlock(), output_ptr);
+    return output;
+  }
+  
+  Token *FactoredSoftmaxANNComponent::doBackprop(Token *_error_input) {
+    if ( (_error_input == 0) ||
+	 (_error_input->getTokenCode() != table_of_token_codes::token_mem_block))
+      ERROR_EXIT(129,"Incorrect input error Token type, expected token_mem_block!\n");
+    if (!sparse_output)
+      ERROR_EXIT(128, "Factored softmax needs the target (see setTarget) "
+		 "of the forward step to compute the gradients\n");
+    AssignRef(error_input,_error_input->convertTo<TokenMemoryBlock*>());
+    if (error_input->getUsedSize() != bunch_size*output_size)
+      ERROR_EXIT(129, "Different bunches found at doForward and doBackprop\n");
+    const unsigned int ld = weights_matrix->getOutputSize();
+    // softmax gradients (probabilities minus the target), multiplied by the
+    // weight of each pattern
+    float *cp = class_probs->getPPALForReadAndWrite();
+    float *bp = block_probs->getPPALForReadAndWrite();
+    for (unsigned int k=0; k<num_classes; ++k) {
+      unsigned int n = class_first[k+1] - class_first[k];
+      float *bpk = bp + block_probs_first[k];
+      for (unsigned int r=0; r<n; ++r) {
+	unsigned int i = class_first[k] + r;
+	int w = target_words[sorted_patterns[i]];
+	float weight = target_weights[sorted_patterns[i]];
+	cp[k*bunch_size + i] -= 1.0f;
+	bpk[(word_pos[w] - class_start[k])*n + r] -= 1.0f;
+	if (weight != 1.0f) {
+	  for (unsigned int c=0; c<num_classes; ++c)
+	    cp[c*bunch_size + i] *= weight;
+	  for (int j=0; j<class_size[k]; ++j) bpk[j*n + r] *= weight;
+	}
+      }
+    }
+    // gradients of the sorted inputs, first the words blocks, and after the
+    // classes layer
+    FloatGPUMirroredMemoryBlock *weights_ptr = weights_matrix->getPtr();
+    for (unsigned int k=0; k<num_classes; ++k) {
+      unsigned int n = class_first[k+1] - class_first[k];
+      if (n == 0) continue;
+      doSgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
+	      n, input_size, class_size[k],
+	      1.0f, block_probs, n,
+	      weights_ptr, ld,
+	      0.0f, sorted_errors, bunch_size,
+	      block_probs_first[k], num_classes + class_start[k], class_first[k],
+	      false);
+    }
+    doSgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
+	    bunch_size, input_size, num_classes,
+	    1.0f, class_probs, bunch_size,
+	    weights_ptr, ld,
+	    1.0f, sorted_errors, bunch_size,
+	    0, 0, 0,
+	    false);
+    AssignRef(error_output,new TokenMemoryBlock(bunch_size * input_size));
+    const float *es = sorted_errors->getPPALForRead();
+    float *e = error_output->getMemBlock()->getPPALForWrite();
+    for (unsigned int h=0; h<input_size; ++h)
+      for (unsigned int i=0; i<bunch_size; ++i)
+	e[h*bunch_size + sorted_patterns[i]] = es[h*bunch_size + i];
+    return error_output;
+  }
+  
+  void FactoredSoftmaxANNComponent::
+  computeBPUpdate(FloatGPUMirroredMemoryBlock *weights_ptr, float alpha) {
+    const unsigned int ld = weights_matrix->getOutputSize();
+    // classes layer
+    doSgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+	    num_classes, input_size, bunch_size,
+	    alpha, class_probs, bunch_size,
+	    sorted_inputs, bunch_size,
+	    1.0f, weights_ptr, ld,
+	    0, 0, 0,
+	    false);
+    // computed words blocks
+    for (unsigned int k=0; k<num_classes; ++k) {
+      unsigned int n = class_first[k+1] - class_first[k];
+      if (n == 0) continue;
+      doSgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+	      class_size[k], input_size, n,
+	      alpha, block_probs, n,
+	      sorted_inputs, bunch_size,
+	      1.0f, weights_ptr, ld,
+	      block_probs_first[k], class_first[k], num_classes + class_start[k],
+	      false);
+    }
+    // biases
+    const float *cp = class_probs->getPPALForRead();
+    const float *bp = block_probs->getPPALForRead();
+    float *bias     = weights_ptr->getPPALForReadAndWrite() + input_size*ld;
+    for (unsigned int k=0; k<num_classes; ++k) {
+      float sum = 0.0f;
+      for (unsigned int i=0; i<bunch_size; ++i) sum += cp[k*bunch_size + i];
+      bias[k] += alpha*sum;
+      unsigned int n = class_first[k+1] - class_first[k];
+      const float *bpk = bp + block_probs_first[k];
+      for (int j=0; n>0 && j<class_size[k]; ++j) {
+	sum = 0.0f;
+	for (unsigned int r=0; r<n; ++r) sum += bpk[j*n + r];
+	bias[num_classes + class_start[k] + j] += alpha*sum;
+      }
+    }
+  }
+  
+  void FactoredSoftmaxANNComponent::doUpdate() {
+    assert(learning_rate > 0.0f &&
+	   "Learning rate needs to be fixed with setOption method!!!");
+    if (!sparse_output)
+      ERROR_EXIT(128, "Factored softmax needs the target (see setTarget) "
+		 "of the forward step to update the weights\n");
+    const unsigned int references = weights_matrix->getNumReferences();
+    assert(references > 0 && "Found 0 references of weights matrix");
+    const float norm_learn_rate =
+      -(1.0f/sqrtf(static_cast<float>(references*bunch_size))) *
+      learning_rate;
+    if (momentum == 0.0f && weight_decay == 0.0f && references == 1) {
+      // plain SGD, only the computed blocks are modified
+      computeBPUpdate(weights_matrix->getPtr(), norm_learn_rate);
+      return;
+    }
+    // same protocol as DotProductANNComponent, all the weights are traversed
+    weights_matrix->beginUpdate();
+    FloatGPUMirroredMemoryBlock *prev_weights_mat_ptr =
+      weights_matrix->getPrevPtr();
+    if (weights_matrix->isFirstUpdateCall()) {
+      if (momentum > 0.0f)
+	weights_matrix->computeMomentumAndWeightDecayOnPrevVector(momentum,
+								  c_weight_decay,
+								  false);
+      else {
+	weights_matrix->copyToPrevVector(false);
+	if (c_weight_decay < 1.0f)
+	  doSscal(weights_matrix->getNumWeights(),
+		  c_weight_decay, prev_weights_mat_ptr, 0, 1,
+		  false);
+      }
+    }
+    computeBPUpdate(prev_weights_mat_ptr, norm_learn_rate);
+    if (weights_matrix->endUpdate()) {
+      ++num_updates_from_last_prune;
+      bool check_normal = false;
+      if (num_updates_from_last_prune > MAX_UPDATES_WITHOUT_PRUNE) {
+	num_updates_from_last_prune = 0;
+	check_normal = true;
+      }
+      weights_matrix->pruneSubnormalAndApplyMaxNorm(-1.0f,
+						    weights_matrix->getNumInputs(),
+						    weights_matrix->getNumOutputs(),
+						    check_normal, false);
+    }
+  }
+  
+  void FactoredSoftmaxANNComponent::reset() {
+    if (input)        DecRef(input);
+    if (target)       DecRef(target);
+    if (error_input)  DecRef(error_input);
+    if (output)       DecRef(output);
+    if (error_output) DecRef(error_output);
+    input	 = 0;
+    target       = 0;
+    error_input	 = 0;
+    output	 = 0;
+    error_output = 0;
+  }
+  
+  ANNComponent *FactoredSoftmaxANNComponent::clone() {
+    FactoredSoftmaxANNComponent *component = new
+      FactoredSoftmaxANNComponent(name.c_str(), weights_name.c_str(),
+				  input_size, output_size, word_class);
+    component->learning_rate  = learning_rate;
+    component->momentum       = momentum;
+    component->weight_decay   = weight_decay;
+    component->c_weight_decay = c_weight_decay;
+    return component;
+  }
+
+  void FactoredSoftmaxANNComponent::setOption(const char *name, double value) {
+    mSetOption(LEARNING_RATE_STRING, learning_rate);
+    mSetOption(MOMENTUM_STRING,      momentum);
+    if (strcmp(WEIGHT_DECAY_STRING, name) == 0) {
+      weight_decay   = static_cast<float>(value);
+      c_weight_decay = 1.0f - weight_decay;
+      return;
+    }
+    ANNComponent::setOption(name, value);
+  }
+  
+  bool FactoredSoftmaxANNComponent::hasOption(const char *name) {
+    mHasOption(LEARNING_RATE_STRING);
+    mHasOption(MOMENTUM_STRING);
+    mHasOption(WEIGHT_DECAY_STRING);
+    return false;
+  }
+  
+  double FactoredSoftmaxANNComponent::getOption(const char *name) {
+    mGetOption(LEARNING_RATE_STRING, learning_rate);
+    mGetOption(MOMENTUM_STRING, momentum);
+    mGetOption(WEIGHT_DECAY_STRING, weight_decay);
+    return ANNComponent::getOption(name);
+  }
+  
+  void FactoredSoftmaxANNComponent::build(unsigned int _input_size,
+					  unsigned int _output_size,
+					  hash<string,Connections*> &weights_dict,
+					  hash<string,ANNComponent*> &components_dict) {
+    unsigned int num_words = output_size;
+    ANNComponent::build(_input_size, _output_size,
+			weights_dict, components_dict);
+    if (input_size == 0)
+      ERROR_EXIT(141, "Impossible to compute input/output "
+		 "sizes for this component\n");
+    if (output_size != num_words)
+      ERROR_EXIT2(141, "Incorrect output size, expected %u, found %u\n",
+		  num_words, output_size);
+    // the last input is the bias
+    unsigned int weights_input_size  = input_size + 1;
+    unsigned int weights_output_size = num_classes + output_size;
+    Connections *&w = weights_dict[weights_name];
+    if (w != 0) {
+      AssignRef(weights_matrix, w);
+      if (!weights_matrix->checkInputOutputSizes(weights_input_size,
+						 weights_output_size))
+	ERROR_EXIT2(256,"The weights matrix input/output sizes are not correct, "
+		    "expected %d,%d.\n",
+		    weights_input_size, weights_output_size);
+    }
+    else {
+      if (weights_matrix == 0) {
+	weights_matrix = new Connections(weights_input_size,
+					 weights_output_size);
+	IncRef(weights_matrix);
+      }
+      w = weights_matrix;
+    }
+    weights_matrix->countReference();
+    releaseBunchBuffers();
+  }
+
+  void FactoredSoftmaxANNComponent::copyWeights(hash<string,Connections*> &weights_dict) {
+    if (weights_matrix == 0)
+      ERROR_EXIT(100, "Component not built, impossible execute copyWeights\n");
+    Connections *&w = weights_dict[weights_name];
+    if (w != 0 && w != weights_matrix)
+      ERROR_EXIT1(101, "Weights dictionary contains %s weights name which is "
+		  "not shared with weights_matrix attribute\n",
+		  weights_name.c_str());
+    else if (w == 0) w = weights_matrix;
+  }  
+
+  char *FactoredSoftmaxANNComponent::toLuaString() {
+    buffer_list buffer;
+    buffer.printf("ann.components.factored_softmax{ name='%s',weights='%s',"
+		  "input=%d,word_classes={",
+		  name.c_str(), weights_name.c_str(), input_size);
+    for (unsigned int w=0; w<output_size; ++w)
+      buffer.printf("%s%d", (w>0)?",":"", word_class[w]+1);
+    buffer.printf("} }");
+    return buffer.to_string(buffer_list::NULL_TERMINATED);
+  }
+  //////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,137 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef FACTOREDSOFTMAXANNCOMPONENT_H
+#define FACTOREDSOFTMAXANNCOMPONENT_H
+
+#include "token_memory_block.h"
+#include "ann_component.h"
+#include "connection.h"
+
+namespace ANN {
+
+  /// Class-factored (two-level) softmax output layer for large vocabularies,
+  /// P(w|h) = P(class(w)|h) * P(w|class(w),h). Its output is the log
+  /// probability of each word, so it replaces a hyperplane followed by a
+  /// log_softmax, and as log_softmax, it could only be used with multi-class
+  /// cross-entropy loss function (the gradient received by doBackprop is
+  /// ignored, it is computed from the target).
+  /**
+     The weights are one Connections object of (input_size+1) inputs (the
+     last one is the bias) and (num_classes + output_size) outputs: first the
+     classes, and after them the words, grouped by class, so the words of a
+     class are a contiguous block of outputs.
+
+     When setTarget has been called before a forward step with
+     during_training=true, only the classes layer and the word block of the
+     target class of each pattern are computed, and the output contains the
+     log probability of the target word (the rest of words have a very small
+     value). Otherwise, the output contains the exact normalized log
+     probabilities of all the words. The target could be a TokenClassIndices
+     (with optional weights for the patterns) or a one-hot memory block.
+
+     With momentum and weight decay equal to 0, the update only modifies the
+     weights of the classes and of the computed word blocks. Otherwise, it
+     follows the Connections protocol as DotProductANNComponent, which
+     traverses all the weights.
+  */
+  class FactoredSoftmaxANNComponent : public ANNComponent {
+    Token            *input, *target;
+    TokenMemoryBlock *error_input, *output, *error_output;
+    Connections      *weights_matrix;
+    unsigned int bunch_size, num_classes, num_updates_from_last_prune;
+    /// bunch size of the allocated buffers
+    unsigned int buffers_bunch_size;
+    /// class of each word, position of each word at the words block of the
+    /// weights, and first position and number of words of each class
+    int *word_class, *word_pos, *class_start, *class_size;
+    /// true when the last forward computes only the target blocks
+    bool sparse_output;
+    /// target word and weight of each pattern of the bunch
+    int   *target_words;
+    float *target_weights;
+    /// patterns of the bunch sorted by class, and first position of each
+    /// class in the sorted list (num_classes+1 values)
+    int *sorted_patterns, *class_first;
+    /// inputs and gradients of the inputs of the sorted patterns (bunch_size x
+    /// input_size, col-major), so the patterns of a class are consecutive rows
+    FloatGPUMirroredMemoryBlock *sorted_inputs, *sorted_errors;
+    /// class probabilities of the sorted patterns (bunch_size x num_classes,
+    /// col-major), replaced by its gradients at doBackprop
+    FloatGPUMirroredMemoryBlock *class_probs;
+    /// for each class, the probabilities of its words for its n patterns (n x
+    /// class_size, col-major), replaced by its gradients at doBackprop, and
+    /// position of the block of each class
+    FloatGPUMirroredMemoryBlock *block_probs;
+    unsigned int *block_probs_first;
+    /// learning parameters
+    float learning_rate, momentum, weight_decay, c_weight_decay;
+
+    void releaseBunchBuffers();
+    void allocateBunchBuffers(unsigned int bunch_size);
+    void setWordClasses(const int *word_classes);
+    void computeClassLogits(FloatGPUMirroredMemoryBlock *input_ptr);
+    void forwardTargetBlocks(FloatGPUMirroredMemoryBlock *input_ptr,
+			     float *output_ptr);
+    void forwardAllWords(FloatGPUMirroredMemoryBlock *input_ptr,
+			 float *output_ptr);
+    void computeBPUpdate(FloatGPUMirroredMemoryBlock *weights_ptr,
+			 float alpha);
+
+  public:
+    /// word_classes contains the class of each word, from 0 to
+    /// num_classes-1, it has output_size elements
+    FactoredSoftmaxANNComponent(const char *name, const char *weights_name,
+				unsigned int input_size,
+				unsigned int output_size,
+				const int *word_classes);
+    virtual ~FactoredSoftmaxANNComponent();
+    virtual Token *getInput() { return input; }
+    virtual Token *getOutput() { return output; }
+    virtual Token *getErrorInput() { return error_input; }
+    virtual Token *getErrorOutput() { return error_output; }
+    virtual void   setTarget(Token *target);
+    virtual bool   needsTargetForGradient() const { return true; }
+    virtual Token *doForward(Token* input, bool during_training);
+    virtual Token *doBackprop(Token *input_error);
+    virtual void   doUpdate();
+    virtual void   reset();
+    virtual ANNComponent *clone();
+    virtual void setOption(const char *name, double value);
+    virtual bool hasOption(const char *name);
+    virtual double getOption(const char *name);
+    virtual void build(unsigned int input_size,
+		       unsigned int output_size,
+		       hash<string,Connections*> &weights_dict,
+		       hash<string,ANNComponent*> &components_dict);
+    virtual void copyWeights(hash<string,Connections*> &weights_dict);
+    virtual void resetConnections() {
+      if (weights_matrix) weights_matrix->reset();
+    }
+    virtual char *toLuaString();
+
+    unsigned int getNumClasses() const { return num_classes; }
+    /// Class of the given word (from 0 to num_classes-1)
+    int getWordClass(unsigned int word) const { return word_class[word]; }
+  };
+}
+
+#endif // FACTOREDSOFTMAXANNCOMPONENT_H
@@ -19,6 +19,7 @@
  *
  */
 #include "hyperplane_component.h"
+#include "table_of_token_codes.h"
 
 namespace ANN {
 
@@ -66,6 +67,19 @@ namespace ANN {
   }
     
   Token *HyperplaneANNComponent::doForward(Token* input, bool during_training) {
+    if (!during_training && dot_product->getQuantized() &&
+	!dot_product->getCalibrating() && input != 0 &&
+	input->getTokenCode() == table_of_token_codes::token_mem_block) {
+      // int8 dot product with fused bias addition
+      TokenMemoryBlock *output;
+      FloatGPUMirroredMemoryBlock *bias_copy;
+      FloatGPUMirroredMemoryBlock *bias_ptr =
+	bias->getBiasVector()->getPtrForRead(bias_copy);
+      output = dot_product->doQuantizedForward(input, bias_ptr);
+      delete bias_copy;
+      bias->setFusedOutput(output);
+      return output;
+    }
     Token *output = dot_product->doForward(input, during_training);
     output = bias->doForward(output, during_training);
     return output;
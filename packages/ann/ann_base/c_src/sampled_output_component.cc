@@ -0,0 +1,443 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include <cmath>
+#include "sampled_output_component.h"
+#include "wrapper.h"
+#include "token_memory_block.h"
+#include "table_of_token_codes.h"
+#include "target_words.h"
+
+namespace ANN {
+
+  //////////////////////////////////////////////
+  // SampledOutputANNComponent implementation //
+  //////////////////////////////////////////////
+  
+  SampledOutputANNComponent::
+  SampledOutputANNComponent(const char *name, const char *weights_name,
+			    unsigned int input_size,
+			    unsigned int output_size,
+			    unsigned int num_samples,
+			    dice *noise, MTRand *random) :
+    ANNComponent(name, weights_name, input_size, output_size),
+    input(0), target(0),
+    error_input(0),
+    output(0),
+    error_output(0),
+    weights_matrix(0),
+    bunch_size(0), num_samples(num_samples),
+    num_updates_from_last_prune(0),
+    noise(noise), random(random),
+    sparse_output(false),
+    target_words(0), samples(0), used_words(0), word_col(0),
+    num_used(0),
+    used_weights(0), used_logits(0),
+    learning_rate(-1.0f),
+    momentum(0.0f),
+    weight_decay(0.0f),
+    c_weight_decay(1.0f) {
+    if (weights_name == 0) generateDefaultWeightsName("w");
+    if (output_size == 0)
+      ERROR_EXIT(128, "The output size of sampled output is mandatory\n");
+    if (num_samples == 0)
+      ERROR_EXIT(128, "The number of samples must be > 0\n");
+    if (static_cast<unsigned int>(noise->get_outcomes()) != output_size)
+      ERROR_EXIT2(128, "Incorrect noise distribution, expected %u outcomes, "
+		  "found %d\n", output_size, noise->get_outcomes());
+    IncRef(noise);
+    IncRef(random);
+    log_noise = new float[output_size];
+    word_col  = new int[output_size];
+    for (unsigned int w=0; w<output_size; ++w) {
+      if (noise->probability(w) <= 0.0)
+	ERROR_EXIT1(128, "The noise probability of every output must be > 0, "
+		    "found 0 at output %u\n", w+1);
+      log_noise[w] = logf(num_samples * noise->probability(w));
+      word_col[w]  = -1;
+    }
+    samples = new int[num_samples];
+  }
+  
+  SampledOutputANNComponent::~SampledOutputANNComponent() {
+    if (weights_matrix) DecRef(weights_matrix);
+    if (input) DecRef(input);
+    if (target) DecRef(target);
+    if (error_input) DecRef(error_input);
+    if (output) DecRef(output);
+    if (error_output) DecRef(error_output);
+    DecRef(noise);
+    DecRef(random);
+    delete[] log_noise;
+    delete[] word_col;
+    delete[] samples;
+    delete[] target_words;
+    delete[] used_words;
+    delete used_weights;
+    delete used_logits;
+  }
+  
+  void SampledOutputANNComponent::setTarget(Token *_target) {
+    AssignRef(target, _target);
+  }
+  
+  void SampledOutputANNComponent::
+  forwardSampled(FloatGPUMirroredMemoryBlock *input_ptr) {
+    const unsigned int ld = input_size + 1;
+    loadTargetWords(target, bunch_size, output_size, target_words, 0);
+    noise->sample(random, num_samples, samples);
+    // list of different outputs, targets and samples
+    for (unsigned int c=0; c<num_used; ++c) word_col[used_words[c]] = -1;
+    num_used = 0;
+    for (unsigned int b=0; b<bunch_size; ++b)
+      if (word_col[target_words[b]] < 0) {
+	word_col[target_words[b]] = num_used;
+	used_words[num_used++]    = target_words[b];
+      }
+    for (unsigned int j=0; j<num_samples; ++j)
+      if (word_col[samples[j]] < 0) {
+	word_col[samples[j]]   = num_used;
+	used_words[num_used++] = samples[j];
+      }
+    // gather of the weights of the used outputs
+    FloatGPUMirroredMemoryBlock *weights_ptr = weights_matrix->getPtr();
+    for (unsigned int c=0; c<num_used; ++c)
+      doScopy(ld,
+	      weights_ptr, used_words[c]*ld, 1,
+	      used_weights, c*ld, 1,
+	      false);
+    doSgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
+	    bunch_size, num_used, input_size,
+	    1.0f, input_ptr, bunch_size,
+	    used_weights, ld,
+	    0.0f, used_logits, bunch_size,
+	    0, 0, 0,
+	    false);
+    const float *uw = used_weights->getPPALForRead();
+    float *logits   = used_logits->getPPALForReadAndWrite();
+    for (unsigned int c=0; c<num_used; ++c)
+      for (unsigned int b=0; b<bunch_size; ++b)
+	logits[c*bunch_size + b] += uw[c*ld + input_size];
+    // scores of the target and the samples of each pattern
+    float *output_ptr = output->getMemBlock()->getPPALForWrite();
+    for (unsigned int b=0; b<bunch_size; ++b) {
+      int t = target_words[b];
+      output_ptr[b] = logits[word_col[t]*bunch_size + b] - log_noise[t];
+    }
+    for (unsigned int j=0; j<num_samples; ++j) {
+      int s = samples[j];
+      const float *ls = logits + word_col[s]*bunch_size;
+      float *out      = output_ptr + (j+1)*bunch_size;
+      for (unsigned int b=0; b<bunch_size; ++b)
+	out[b] = (s == target_words[b]) ? LOG_ZERO_PROBABILITY :
+	  ls[b] - log_noise[s];
+    }
+  }
+  
+  void SampledOutputANNComponent::
+  forwardAllOutputs(FloatGPUMirroredMemoryBlock *input_ptr) {
+    const unsigned int ld = input_size + 1;
+    FloatGPUMirroredMemoryBlock *weights_ptr = weights_matrix->getPtr();
+    FloatGPUMirroredMemoryBlock *logits =
+      new FloatGPUMirroredMemoryBlock(bunch_size*output_size);
+    doSgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
+	    bunch_size, output_size, input_size,
+	    1.0f, input_ptr, bunch_size,
+	    weights_ptr, ld,
+	    0.0f, logits, bunch_size,
+	    0, 0, 0,
+	    false);
+    const float *w = weights_ptr->getPPALForRead();
+    float *logits_ptr = logits->getPPALForReadAndWrite();
+    for (unsigned int o=0; o<output_size; ++o)
+      for (unsigned int b=0; b<bunch_size; ++b)
+	logits_ptr[o*bunch_size + b] += w[o*ld + input_size];
+    doApplyLogSoftmaxActivation(logits, output->getMemBlock(),
+				0, 0, 0,
+				output_size, bunch_size,
+				false);
+    delete logits;
+  }
+  
+  Token *SampledOutputANNComponent::doForward(Token *_input,
+					      bool during_training) {
+    assert(weights_matrix != 0);
+    if (weights_matrix->isHalfPrecision())
+      ERROR_EXIT(128, "Half precision weights are not supported by "
+		 "sampled output\n");
+    if (_input == 0 ||
+	_input->getTokenCode() != table_of_token_codes::token_mem_block)
+      ERROR_EXIT(129,"Incorrect input Token type, expected token_mem_block!\n");
+    AssignRef(input,_input);
+    TokenMemoryBlock *input_mem_token=input->convertTo<TokenMemoryBlock*>();
+    bunch_size = input_mem_token->getUsedSize() / input_size;
+    if (input_mem_token->getUsedSize() % input_size != 0)
+      ERROR_EXIT2(128, "Input memory block (size %d) is not multiple of %d\n",
+		  input_mem_token->getUsedSize(), input_size);
+    sparse_output = during_training && target != 0;
+    if (sparse_output) {
+      if (used_logits == 0 ||
+	  used_logits->getSize() != (bunch_size + num_samples)*bunch_size ||
+	  used_weights->getSize() != (bunch_size + num_samples)*(input_size + 1)) {
+	// buffers for the worst case, all targets and samples are different
+	for (unsigned int c=0; c<num_used; ++c) word_col[used_words[c]] = -1;
+	num_used = 0;
+	delete[] target_words;
+	delete[] used_words;
+	delete used_weights;
+	delete used_logits;
+	target_words = new int[bunch_size];
+	used_words   = new int[bunch_size + num_samples];
+	used_weights = new FloatGPUMirroredMemoryBlock((bunch_size + num_samples)*
+						       (input_size + 1));
+	used_logits  = new FloatGPUMirroredMemoryBlock((bunch_size + num_samples)*
+						       bunch_size);
+      }
+      AssignRef(output,new TokenMemoryBlock(bunch_size * (num_samples + 1)));
+      forwardSampled(input_mem_token->getMemBlock());
+    }
+    else {
+      AssignRef(output,new TokenMemoryBlock(bunch_size * output_size));
+      forwardAllOutputs(input_mem_token->getMemBlock());
+    }
+    return output;
+  }
+  
+  Token *SampledOutputANNComponent::doBackprop(Token *_error_input) {
+    if ( (_error_input == 0) ||
+	 (_error_input->getTokenCode() != table_of_token_codes::token_mem_block))
+      ERROR_EXIT(129,"Incorrect input error Token type, expected token_mem_block!\n");
+    if (!sparse_output)
+      ERROR_EXIT(128, "Sampled output needs the target (see setTarget) "
+		 "of the forward step to compute the gradients\n");
+    AssignRef(error_input,_error_input->convertTo<TokenMemoryBlock*>());
+    if (error_input->getUsedSize() != bunch_size*(num_samples + 1))
+      ERROR_EXIT(129, "Different bunches found at doForward and doBackprop\n");
+    const unsigned int ld = input_size + 1;
+    // gradients of the linear outputs of the used outputs
+    const float *g = error_input->getMemBlock()->getPPALForRead();
+    float *dlogits = used_logits->getPPALForWrite();
+    for (unsigned int i=0; i<num_used*bunch_size; ++i) dlogits[i] = 0.0f;
+    for (unsigned int b=0; b<bunch_size; ++b)
+      dlogits[word_col[target_words[b]]*bunch_size + b] += g[b];
+    for (unsigned int j=0; j<num_samples; ++j) {
+      int s = samples[j];
+      float *ds      = dlogits + word_col[s]*bunch_size;
+      const float *gs = g + (j+1)*bunch_size;
+      for (unsigned int b=0; b<bunch_size; ++b)
+	if (s != target_words[b]) ds[b] += gs[b];
+    }
+    AssignRef(error_output,new TokenMemoryBlock(bunch_size * input_size));
+    doSgemm(CblasColMajor, CblasNoTrans, CblasTrans,
+	    bunch_size, input_size, num_used,
+	    1.0f, used_logits, bunch_size,
+	    used_weights, ld,
+	    0.0f, error_output->getMemBlock(), bunch_size,
+	    0, 0, 0,
+	    false);
+    return error_output;
+  }
+  
+  void SampledOutputANNComponent::
+  computeBPUpdate(FloatGPUMirroredMemoryBlock *weights_ptr, float alpha) {
+    const unsigned int ld = input_size + 1;
+    // the gathered weights are not needed after doBackprop, they are replaced
+    // by the updates of the used outputs
+    TokenMemoryBlock *input_mem_token = input->convertTo<TokenMemoryBlock*>();
+    doSgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+	    input_size, num_used, bunch_size,
+	    alpha, input_mem_token->getMemBlock(), bunch_size,
+	    used_logits, bunch_size,
+	    0.0f, used_weights, ld,
+	    0, 0, 0,
+	    false);
+    const float *dlogits = used_logits->getPPALForRead();
+    float *uw = used_weights->getPPALForReadAndWrite();
+    for (unsigned int c=0; c<num_used; ++c) {
+      float sum = 0.0f;
+      for (unsigned int b=0; b<bunch_size; ++b) sum += dlogits[c*bunch_size + b];
+      uw[c*ld + input_size] = alpha*sum;
+    }
+    for (unsigned int c=0; c<num_used; ++c)
+      doSaxpy(ld, 1.0f,
+	      used_weights, c*ld, 1,
+	      weights_ptr, used_words[c]*ld, 1,
+	      false);
+  }
+  
+  void SampledOutputANNComponent::doUpdate() {
+    assert(learning_rate > 0.0f &&
+	   "Learning rate needs to be fixed with setOption method!!!");
+    if (!sparse_output)
+      ERROR_EXIT(128, "Sampled output needs the target (see setTarget) "
+		 "of the forward step to update the weights\n");
+    const unsigned int references = weights_matrix->getNumReferences();
+    assert(references > 0 && "Found 0 references of weights matrix");
+    const float norm_learn_rate =
+      -(1.0f/sqrtf(static_cast<float>(references*bunch_size))) *
+      learning_rate;
+    if (momentum == 0.0f && weight_decay == 0.0f && references == 1) {
+      // plain SGD, only the used rows are modified
+      computeBPUpdate(weights_matrix->getPtr(), norm_learn_rate);
+      return;
+    }
+    // same protocol as DotProductANNComponent, all the weights are traversed
+    weights_matrix->beginUpdate();
+    FloatGPUMirroredMemoryBlock *prev_weights_mat_ptr =
+      weights_matrix->getPrevPtr();
+    if (weights_matrix->isFirstUpdateCall()) {
+      if (momentum > 0.0f)
+	weights_matrix->computeMomentumAndWeightDecayOnPrevVector(momentum,
+								  c_weight_decay,
+								  false);
+      else {
+	weights_matrix->copyToPrevVector(false);
+	if (c_weight_decay < 1.0f)
+	  doSscal(weights_matrix->getNumWeights(),
+		  c_weight_decay, prev_weights_mat_ptr, 0, 1,
+		  false);
+      }
+    }
+    computeBPUpdate(prev_weights_mat_ptr, norm_learn_rate);
+    if (weights_matrix->endUpdate()) {
+      ++num_updates_from_last_prune;
+      bool check_normal = false;
+      if (num_updates_from_last_prune > MAX_UPDATES_WITHOUT_PRUNE) {
+	num_updates_from_last_prune = 0;
+	check_normal = true;
+      }
+      weights_matrix->pruneSubnormalAndApplyMaxNorm(-1.0f,
+						    weights_matrix->getNumInputs(),
+						    weights_matrix->getNumOutputs(),
+						    check_normal, false);
+    }
+  }
+  
+  void SampledOutputANNComponent::reset() {
+    if (input)        DecRef(input);
+    if (target)       DecRef(target);
+    if (error_input)  DecRef(error_input);
+    if (output)       DecRef(output);
+    if (error_output) DecRef(error_output);
+    input	 = 0;
+    target       = 0;
+    error_input	 = 0;
+    output	 = 0;
+    error_output = 0;
+  }
+  
+  ANNComponent *SampledOutputANNComponent::clone() {
+    SampledOutputANNComponent *component = new
+      SampledOutputANNComponent(name.c_str(), weights_name.c_str(),
+				input_size, output_size, num_samples,
+				noise, new MTRand(*random));
+    component->learning_rate  = learning_rate;
+    component->momentum       = momentum;
+    component->weight_decay   = weight_decay;
+    component->c_weight_decay = c_weight_decay;
+    return component;
+  }
+
+  void SampledOutputANNComponent::setOption(const char *name, double value) {
+    mSetOption(LEARNING_RATE_STRING, learning_rate);
+    mSetOption(MOMENTUM_STRING,      momentum);
+    if (strcmp(WEIGHT_DECAY_STRING, name) == 0) {
+      weight_decay   = static_cast<float>(value);
+      c_weight_decay = 1.0f - weight_decay;
+      return;
+    }
+    ANNComponent::setOption(name, value);
+  }
+  
+  bool SampledOutputANNComponent::hasOption(const char *name) {
+    mHasOption(LEARNING_RATE_STRING);
+    mHasOption(MOMENTUM_STRING);
+    mHasOption(WEIGHT_DECAY_STRING);
+    return false;
+  }
+  
+  double SampledOutputANNComponent::getOption(const char *name) {
+    mGetOption(LEARNING_RATE_STRING, learning_rate);
+    mGetOption(MOMENTUM_STRING, momentum);
+    mGetOption(WEIGHT_DECAY_STRING, weight_decay);
+    return ANNComponent::getOption(name);
+  }
+  
+  void SampledOutputANNComponent::build(unsigned int _input_size,
+					unsigned int _output_size,
+					hash<string,Connections*> &weights_dict,
+					hash<string,ANNComponent*> &components_dict) {
+    unsigned int num_outputs = output_size;
+    ANNComponent::build(_input_size, _output_size,
+			weights_dict, components_dict);
+    if (input_size == 0)
+      ERROR_EXIT(141, "Impossible to compute input/output "
+		 "sizes for this component\n");
+    if (output_size != num_outputs)
+      ERROR_EXIT2(141, "Incorrect output size, expected %u, found %u\n",
+		  num_outputs, output_size);
+    // the weights of each output are contiguous, the last one is the bias
+    unsigned int weights_input_size  = output_size;
+    unsigned int weights_output_size = input_size + 1;
+    Connections *&w = weights_dict[weights_name];
+    if (w != 0) {
+      AssignRef(weights_matrix, w);
+      if (!weights_matrix->checkInputOutputSizes(weights_input_size,
+						 weights_output_size))
+	ERROR_EXIT2(256,"The weights matrix input/output sizes are not correct, "
+		    "expected %d,%d.\n",
+		    weights_input_size, weights_output_size);
+    }
+    else {
+      if (weights_matrix == 0) {
+	weights_matrix = new Connections(weights_input_size,
+					 weights_output_size);
+	IncRef(weights_matrix);
+      }
+      w = weights_matrix;
+    }
+    weights_matrix->countReference();
+  }
+
+  void SampledOutputANNComponent::copyWeights(hash<string,Connections*> &weights_dict) {
+    if (weights_matrix == 0)
+      ERROR_EXIT(100, "Component not built, impossible execute copyWeights\n");
+    Connections *&w = weights_dict[weights_name];
+    if (w != 0 && w != weights_matrix)
+      ERROR_EXIT1(101, "Weights dictionary contains %s weights name which is "
+		  "not shared with weights_matrix attribute\n",
+		  weights_name.c_str());
+    else if (w == 0) w = weights_matrix;
+  }  
+
+  char *SampledOutputANNComponent::toLuaString() {
+    buffer_list buffer;
+    buffer.printf("ann.components.sampled_output{ name='%s',weights='%s',"
+		  "input=%d,output=%d,num_samples=%d,noise=random.dice{",
+		  name.c_str(), weights_name.c_str(),
+		  input_size, output_size, num_samples);
+    for (unsigned int w=0; w<output_size; ++w)
+      buffer.printf("%s%g", (w>0)?",":"", noise->probability(w));
+    buffer.printf("} }");
+    return buffer.to_string(buffer_list::NULL_TERMINATED);
+  }
+  //////////////////////////////////////////////////////////////////////////
+}
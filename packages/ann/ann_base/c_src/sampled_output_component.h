@@ -0,0 +1,125 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef SAMPLEDOUTPUTANNCOMPONENT_H
+#define SAMPLEDOUTPUTANNCOMPONENT_H
+
+#include "token_memory_block.h"
+#include "ann_component.h"
+#include "connection.h"
+#include "dice.h"
+#include "MersenneTwister.h"
+
+namespace ANN {
+
+  /// Output layer for training with sampled outputs (noise-contrastive
+  /// estimation or importance sampled softmax), with a cost independent of
+  /// the number of outputs.
+  /**
+     When setTarget has been called before a forward step with
+     during_training=true, num_samples outputs are sampled for the whole
+     bunch following the noise distribution (a dice, usually the unigram
+     distribution of the words). The output is a (num_samples+1) x bunch_size
+     memory block with the scores z(w) - log(num_samples*Q(w)) of the target
+     of each pattern (first row) and of the samples, being z(w) the linear
+     output (with bias) and Q(w) the noise probability. Samples equal to the
+     target of a pattern have a very small score for that pattern. Only the
+     rows of the weights of the targets and the samples are computed and
+     updated, and the loss function (SampledOutputLossFunction) applies NCE
+     or softmax to these scores.
+
+     Otherwise, the output contains the exact normalized log probabilities
+     of all the outputs (log_softmax).
+
+     The weights are one Connections object of output_size inputs and
+     input_size+1 outputs, so the weights of each output (the last one is
+     its bias) are contiguous.
+
+     With momentum and weight decay equal to 0, the update only modifies the
+     computed rows. Otherwise, it follows the Connections protocol as
+     DotProductANNComponent, which traverses all the weights.
+  */
+  class SampledOutputANNComponent : public ANNComponent {
+    Token            *input, *target;
+    TokenMemoryBlock *error_input, *output, *error_output;
+    Connections      *weights_matrix;
+    unsigned int bunch_size, num_samples, num_updates_from_last_prune;
+    dice   *noise;
+    MTRand *random;
+    /// log(num_samples*Q(w)) for each output
+    float *log_noise;
+    /// true when the last forward computes only the sampled outputs
+    bool sparse_output;
+    /// target of each pattern, and the sampled outputs
+    int *target_words, *samples;
+    /// different outputs computed at the last forward (targets and samples),
+    /// their position in this list is its column, -1 if not computed
+    int *used_words, *word_col;
+    unsigned int num_used;
+    /// weights of the used outputs ((input_size+1) x num_used, col-major)
+    FloatGPUMirroredMemoryBlock *used_weights;
+    /// linear outputs of the used outputs, replaced by its gradients at
+    /// doBackprop (bunch_size x num_used, col-major)
+    FloatGPUMirroredMemoryBlock *used_logits;
+    /// learning parameters
+    float learning_rate, momentum, weight_decay, c_weight_decay;
+
+    void forwardSampled(FloatGPUMirroredMemoryBlock *input_ptr);
+    void forwardAllOutputs(FloatGPUMirroredMemoryBlock *input_ptr);
+    void computeBPUpdate(FloatGPUMirroredMemoryBlock *weights_ptr,
+			 float alpha);
+
+  public:
+    SampledOutputANNComponent(const char *name, const char *weights_name,
+			      unsigned int input_size,
+			      unsigned int output_size,
+			      unsigned int num_samples,
+			      dice *noise, MTRand *random);
+    virtual ~SampledOutputANNComponent();
+    virtual Token *getInput() { return input; }
+    virtual Token *getOutput() { return output; }
+    virtual Token *getErrorInput() { return error_input; }
+    virtual Token *getErrorOutput() { return error_output; }
+    virtual void   setTarget(Token *target);
+    virtual bool   needsTargetForGradient() const { return true; }
+    virtual Token *doForward(Token* input, bool during_training);
+    virtual Token *doBackprop(Token *input_error);
+    virtual void   doUpdate();
+    virtual void   reset();
+    virtual ANNComponent *clone();
+    virtual void setOption(const char *name, double value);
+    virtual bool hasOption(const char *name);
+    virtual double getOption(const char *name);
+    virtual void build(unsigned int input_size,
+		       unsigned int output_size,
+		       hash<string,Connections*> &weights_dict,
+		       hash<string,ANNComponent*> &components_dict);
+    virtual void copyWeights(hash<string,Connections*> &weights_dict);
+    virtual void resetConnections() {
+      if (weights_matrix) weights_matrix->reset();
+    }
+    virtual char *toLuaString();
+
+    unsigned int getNumSamples() const { return num_samples; }
+  };
+}
+
+#endif // SAMPLEDOUTPUTANNCOMPONENT_H
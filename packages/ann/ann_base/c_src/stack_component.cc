@@ -81,6 +81,15 @@ namespace ANN {
       components[c-1]->doUpdate();
   }
 
+  void StackANNComponent::setTarget(Token *target) {
+    if (components.size() > 0) components.back()->setTarget(target);
+  }
+
+  bool StackANNComponent::needsTargetForGradient() const {
+    return (components.size() > 0 &&
+	    components.back()->needsTargetForGradient());
+  }
+
   void StackANNComponent::reset() {
     for (unsigned int c=0; c<components.size(); ++c)
       components[c]->reset();
@@ -41,6 +41,10 @@ namespace ANN {
     virtual Token *getErrorInput();
     virtual Token *getErrorOutput();
     
+    /// The target is given to the last component of the stack
+    virtual void setTarget(Token *target);
+    virtual bool needsTargetForGradient() const;
+
     virtual Token *doForward(Token* input, bool during_training);
 
     virtual Token *doBackprop(Token *input_error);
@@ -0,0 +1,77 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include "target_words.h"
+#include "token_memory_block.h"
+#include "token_class_indices.h"
+#include "table_of_token_codes.h"
+#include "error_print.h"
+
+namespace ANN {
+
+  void loadTargetWords(Token *target, unsigned int bunch_size,
+		       unsigned int num_words,
+		       int *target_words, float *target_weights) {
+    switch(target->getTokenCode()) {
+    case table_of_token_codes::token_class_indices: {
+      TokenClassIndices *target_indices = target->convertTo<TokenClassIndices*>();
+      if (target_indices->getNumClasses() != num_words)
+	ERROR_EXIT2(128, "Incorrect number of classes, expected %u, found %u\n",
+		    num_words, target_indices->getNumClasses());
+      if (target_indices->getUsedSize() != bunch_size)
+	ERROR_EXIT(128, "Different bunches found at target and input\n");
+      const int *indices = target_indices->getIndices()->getPPALForRead();
+      const float *weights = 0;
+      if (target_indices->getWeights() != 0)
+	weights = target_indices->getWeights()->getPPALForRead();
+      for (unsigned int b=0; b<bunch_size; ++b) {
+	if (indices[b] < 0 || static_cast<unsigned int>(indices[b]) >= num_words)
+	  ERROR_EXIT1(128, "Incorrect target index %d\n", indices[b]);
+	target_words[b] = indices[b];
+	if (target_weights != 0)
+	  target_weights[b] = (weights != 0) ? weights[b] : 1.0f;
+      }
+      break;
+    }
+    case table_of_token_codes::token_mem_block: {
+      // one-hot targets, the weight is the value of the target word
+      TokenMemoryBlock *target_mem_token = target->convertTo<TokenMemoryBlock*>();
+      if (target_mem_token->getUsedSize() != bunch_size*num_words)
+	ERROR_EXIT(128, "Different bunches found at target and input\n");
+      const float *target_ptr = target_mem_token->getMemBlock()->getPPALForRead();
+      for (unsigned int b=0; b<bunch_size; ++b) {
+	unsigned int best = 0;
+	for (unsigned int w=1; w<num_words; ++w)
+	  if (target_ptr[w*bunch_size + b] > target_ptr[best*bunch_size + b])
+	    best = w;
+	target_words[b] = best;
+	if (target_weights != 0)
+	  target_weights[b] = target_ptr[best*bunch_size + b];
+      }
+      break;
+    }
+    default:
+      ERROR_EXIT1(128, "Incorrect target token type: %d\n",
+		  target->getTokenCode());
+    }
+  }
+
+}
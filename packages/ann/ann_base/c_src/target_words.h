@@ -0,0 +1,43 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef TARGET_WORDS_H
+#define TARGET_WORDS_H
+
+#include "token_base.h"
+
+/// Log probability (or score) given to the words which are not computed
+#define LOG_ZERO_PROBABILITY -1e30f
+
+namespace ANN {
+
+  /// Reads the target word of each pattern of a bunch, used by the output
+  /// components which only compute the target words during training. The
+  /// target could be a TokenClassIndices (with optional weights for the
+  /// patterns) or a one-hot memory block (the weight is the value of the
+  /// target word). target_weights could be NULL.
+  void loadTargetWords(Token *target, unsigned int bunch_size,
+		       unsigned int num_words,
+		       int *target_words, float *target_weights);
+
+}
+
+#endif // TARGET_WORDS_H
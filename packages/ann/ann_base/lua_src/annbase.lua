@@ -129,7 +129,8 @@ april_set_doc("ann.mlp.all_all.save",
 		},
 		params= {
 		  { "The model object (not the trainer)" },
-		  { "A filename string" },
+		  { "A filename string, the file is compressed with gzip",
+		    "when it finishes with .gz" },
 		  { "Matrix save mode [optional], by default 'binary'" },
 		},
 	      })
@@ -164,17 +165,16 @@ function ann.mlp.all_all.save(model, filename, mode, old)
       column_size = colsize }
     pos = pos - 1
   end
-  local f = io.open(filename,"w")
-  f:write("return {\n\""..model.description.."\",\nmatrix.fromString[["..
-	    wmatrix:toString(mode).."]],")
+  local f = { "return {\n\""..model.description.."\",\nmatrix.fromString[["..
+		wmatrix:toString(mode).."]]," }
   if old == "old" then 
-    f:write("\nmatrix.fromString[[\n"..
-	      oldwmatrix:toString(mode).."]],\n")
+    table.insert(f, "\nmatrix.fromString[[\n"..
+		   oldwmatrix:toString(mode).."]],\n")
   end
-  f:write("first_count=" .. model.first_count .. ",\n")
-  f:write("prefix='" .. model.prefix .. "',\n")
-  f:write("}\n")
-  f:close()
+  table.insert(f, "first_count=" .. model.first_count .. ",\n")
+  table.insert(f, "prefix='" .. model.prefix .. "',\n")
+  table.insert(f, "}\n")
+  util.write_file(filename, f)
 end
 
 -------------------------------------------------------------------
@@ -197,7 +197,8 @@ april_set_doc("ann.mlp.all_all.load",
 	      })
 
 function ann.mlp.all_all.load(filename)
-  local c     = loadfile(filename)
+  local str   = util.read_file(filename) or error("Unable to open " .. filename)
+  local c     = loadstring(str, "@" .. filename)
   local data  = c()
   local model = ann.mlp.all_all.generate(data[1], data.first_count, data.prefix)
   local w     = data[2]
@@ -620,6 +621,45 @@ april_set_doc("ann.components.base.forward",
 
 ----------------------------------------------------------------------
 
+april_set_doc("ann.components.base.set_target",
+	      {
+		class="method",
+		summary="Gives the target of the next training forward step",
+		description={
+		  "Gives the target of the next forward step with",
+		  "during_training=true. Output components could use it to",
+		  "compute only the outputs needed by the loss function",
+		  "(see ann.components.factored_softmax and",
+		  "ann.components.sampled_output), the rest of",
+		  "components ignore it. Stacks give it to its last component.",
+		  "The target is forgotten by reset method.",
+		},
+		params={
+		  "A target token",
+		},
+	      })
+
+----------------------------------------------------------------------
+
+april_set_doc("ann.components.base.needs_target_for_gradient",
+	      {
+		class="method",
+		summary="Indicates if the training depends on the target",
+		description={
+		  "True for the components whose training outputs and",
+		  "gradients are computed from the target given by",
+		  "set_target (ann.components.factored_softmax and",
+		  "ann.components.sampled_output), and for stacks which end",
+		  "with one of them. They need the loss function designed",
+		  "for them.",
+		},
+		outputs={
+		  "A boolean",
+		},
+	      })
+
+----------------------------------------------------------------------
+
 april_set_doc("ann.components.base.backprop",
 	      {
 		class="method",
@@ -856,6 +896,94 @@ april_set_doc("ann.components.dot_product.__call",
 
 ----------------------------------------------------------------------
 
+april_set_doc("ann.components.factored_softmax", {
+		class="class",
+		summary="Class-factored softmax output layer for large vocabularies",
+		description = {
+		  "Computes the log probability of each word (output) as",
+		  "log P(class|input) + log P(word|class,input), with two",
+		  "softmax layers with bias. It replaces an",
+		  "ann.components.hyperplane followed by an",
+		  "ann.components.actf.log_softmax, and it could only be",
+		  "used with ann.loss.multi_class_cross_entropy: the gradient",
+		  "received by backprop is ignored, the cross-entropy gradient",
+		  "is computed from the target. trainable.supervised_trainer",
+		  "refuses other loss functions.",
+		  "During training, with a target given by set_target",
+		  "(trainable.supervised_trainer does it), only the classes",
+		  "and the words of the target class are computed, the rest",
+		  "of outputs are a very small value. Otherwise, the output",
+		  "contains the exact normalized log probabilities.",
+		  "The weights matrix has input+1 inputs (the last one is the",
+		  "bias) and num_classes+output outputs (classes, and the",
+		  "words grouped by class). It is computed in CPU.",
+		}, })
+
+----------------------------------------------------------------------
+
+april_set_doc("ann.components.factored_softmax.__call",
+	      {
+		class="method",
+		summary="Constructor of the component",
+		params={
+		  ["name"] = "A string with the given name [optional]",
+		  ["weights"] = {
+		    "A string with the weights name, two components with",
+		    "the same weights name share the weights matrix [optional]", },
+		  ["input"] = "Number of component input neurons [optional]",
+		  ["word_classes"] = {
+		    "A table with the class (from 1 to num_classes) of each",
+		    "word, its length is the number of outputs", },
+		},
+		outputs= { "An instance of ann.components.factored_softmax" }
+	      })
+
+----------------------------------------------------------------------
+
+april_set_doc("ann.components.sampled_output", {
+		class="class",
+		summary="Sampled output layer for training large vocabularies",
+		description = {
+		  "Output layer with bias whose training cost does not depend",
+		  "on the number of outputs. During training, with a target",
+		  "given by set_target (trainable.supervised_trainer does",
+		  "it), num_samples outputs are sampled for the whole bunch",
+		  "following the noise distribution, and only the targets",
+		  "and the samples are computed and updated. Its output are",
+		  "the scores of the target (first row) and the samples of",
+		  "each pattern, and it must be trained with",
+		  "ann.loss.sampled_output (NCE or sampled softmax).",
+		  "Otherwise, the output contains the exact normalized log",
+		  "probabilities of all the outputs, as log_softmax.",
+		  "The weights matrix has output inputs and input+1 outputs",
+		  "(the last one is the bias). It is computed in CPU.",
+		}, })
+
+----------------------------------------------------------------------
+
+april_set_doc("ann.components.sampled_output.__call",
+	      {
+		class="method",
+		summary="Constructor of the component",
+		params={
+		  ["name"] = "A string with the given name [optional]",
+		  ["weights"] = {
+		    "A string with the weights name, two components with",
+		    "the same weights name share the weights matrix [optional]", },
+		  ["input"] = "Number of component input neurons [optional]",
+		  ["output"] = "Number of component output neurons",
+		  ["num_samples"] = "Number of samples of each bunch",
+		  ["noise"] = {
+		    "A random.dice with output outcomes, the noise",
+		    "distribution (usually the unigram probabilities),",
+		    "all of them must be greater than zero", },
+		  ["random"] = "A random object [optional]",
+		},
+		outputs= { "An instance of ann.components.sampled_output" }
+	      })
+
+----------------------------------------------------------------------
+
 april_set_doc("ann.components.bias", {
 		class="class",
 		summary="A component which implements output = input + bias",
@@ -0,0 +1,52 @@
+-- throughput of ann.components.factored_softmax compared with a flat softmax
+-- (hyperplane + log_softmax) output layer, usage:
+-- april-ann bench_factored_softmax.lua [vocabulary=10000] [hidden=200] [bunch=64] [reps=20]
+V     = tonumber(arg and arg[1] or 10000)
+H     = tonumber(arg and arg[2] or 200)
+bunch = tonumber(arg and arg[3] or 64)
+reps  = tonumber(arg and arg[4] or 20)
+C     = math.ceil(math.sqrt(V))
+
+function bench(name, f)
+  f() -- warm up
+  local clock = util.stopwatch()
+  clock:go()
+  for i=1,reps do f() end
+  clock:stop()
+  local cpu,wall = clock:read()
+  printf("%-40s %10.3f ms %10.0f patterns/s\n", name, wall/reps*1000,
+	 bunch*reps/wall)
+end
+
+rnd = random(1234)
+x, targets = {}, {}
+for i=1,H*bunch do x[i] = rnd:rand(2) - 1 end
+for b=1,bunch do targets[b] = rnd:randInt(1,V) end
+input  = tokens.memblock(x)
+target = tokens.class_indices(targets, V)
+
+word_classes = {}
+for w=1,V do word_classes[w] = (w-1) % C + 1 end
+
+flat = ann.components.stack():
+push(ann.components.hyperplane{ input=H, output=V }):
+push(ann.components.actf.log_softmax())
+factored = ann.components.factored_softmax{ input=H,
+					    word_classes=word_classes }
+
+printf("# vocabulary= %d classes= %d hidden= %d bunch= %d\n", V, C, H, bunch)
+for _,v in ipairs{ { "flat", flat }, { "factored", factored } } do
+  local name,c = v[1],v[2]
+  local trainer = trainable.supervised_trainer(c,
+					       ann.loss.multi_class_cross_entropy(V),
+					       bunch)
+  trainer:build()
+  trainer:randomize_weights{ random=random(52), inf=-0.1, sup=0.1 }
+  for _,comp in trainer:iterate_components() do
+    if comp:has_option("learning_rate") then
+      comp:set_option("learning_rate", 0.01)
+    end
+  end
+  bench(name .. " train_step", function() trainer:train_step(input, target) end)
+  bench(name .. " forward (exact)", function() c:reset() c:forward(input) end)
+end
@@ -0,0 +1,62 @@
+-- training throughput of ann.components.sampled_output (NCE and sampled
+-- softmax) compared with a flat softmax (hyperplane + log_softmax) output
+-- layer, for several vocabulary sizes, usage:
+-- april-ann bench_sampled_output.lua [samples=100] [hidden=200] [bunch=64] [reps=20]
+K     = tonumber(arg and arg[1] or 100)
+H     = tonumber(arg and arg[2] or 200)
+bunch = tonumber(arg and arg[3] or 64)
+reps  = tonumber(arg and arg[4] or 20)
+
+function bench(name, f)
+  f() -- warm up
+  local clock = util.stopwatch()
+  clock:go()
+  for i=1,reps do f() end
+  clock:stop()
+  local cpu,wall = clock:read()
+  printf("%-40s %10.3f ms %10.0f patterns/s\n", name, wall/reps*1000,
+	 bunch*reps/wall)
+end
+
+rnd = random(1234)
+x = {}
+for i=1,H*bunch do x[i] = rnd:rand(2) - 1 end
+input = tokens.memblock(x)
+
+for _,V in ipairs{ 10000, 50000, 100000 } do
+  local targets = {}
+  for b=1,bunch do targets[b] = rnd:randInt(1,V) end
+  local target = tokens.class_indices(targets, V)
+  -- Zipf unigram distribution
+  local probs = {}
+  for w=1,V do probs[w] = 1/w end
+  local noise = random.dice(probs)
+  printf("# vocabulary= %d samples= %d hidden= %d bunch= %d\n", V, K, H, bunch)
+  local models = {
+    { "flat",
+      ann.components.stack():
+	push(ann.components.hyperplane{ input=H, output=V }):
+	push(ann.components.actf.log_softmax()),
+      ann.loss.multi_class_cross_entropy(V) },
+    { "nce",
+      ann.components.sampled_output{ input=H, output=V, num_samples=K,
+				     noise=noise },
+      ann.loss.sampled_output{ size=V, num_samples=K, mode="nce" } },
+    { "sampled softmax",
+      ann.components.sampled_output{ input=H, output=V, num_samples=K,
+				     noise=noise },
+      ann.loss.sampled_output{ size=V, num_samples=K, mode="softmax" } },
+  }
+  for _,v in ipairs(models) do
+    local name,c,loss = v[1],v[2],v[3]
+    local trainer = trainable.supervised_trainer(c, loss, bunch)
+    trainer:build()
+    trainer:randomize_weights{ random=random(52), inf=-0.1, sup=0.1 }
+    for _,comp in trainer:iterate_components() do
+      if comp:has_option("learning_rate") then
+	comp:set_option("learning_rate", 0.01)
+      end
+    end
+    bench(name .. " train_step", function() trainer:train_step(input, target) end)
+  end
+end
@@ -0,0 +1,63 @@
+-- The connections arena only changes the memory layout: training with and
+-- without arena gives the same weights. Max norm penalty of transposed dot
+-- products is computed with the sizes of the component.
+local nump, isz, osz = 60, 8, 4
+local rnd  = random(1357)
+local m_in = matrix(nump, isz)
+for i=1,nump do for j=1,isz do m_in:set(i,j, rnd:rand(2)-1) end end
+local m_out = matrix(nump, osz)
+for i=1,nump do m_out:set(i, rnd:randInt(1,osz), 1) end
+local ds_in, ds_out = dataset.matrix(m_in), dataset.matrix(m_out)
+
+local function train(arena, lr, momentum, weight_decay, epochs)
+  -- tied weights, the first use is transposed, and it is the last one
+  -- updated, so it applies the max norm penalty
+  local c = ann.components.stack():
+  push(ann.components.dot_product{ input=isz, output=6, weights="w1",
+				   transpose=true }):
+  push(ann.components.actf.tanh()):
+  push(ann.components.dot_product{ input=6, output=isz, weights="w1" }):
+  push(ann.components.actf.tanh()):
+  push(ann.components.hyperplane{ input=isz, output=osz,
+				  dot_product_weights="w2", bias_weights="b2" }):
+  push(ann.components.actf.log_softmax())
+  local tr = trainable.supervised_trainer(c,
+					  ann.loss.multi_class_cross_entropy(osz),
+					  5)
+  tr:build{ arena = arena }
+  tr:randomize_weights{ random=random(52), inf=-3, sup=3 }
+  c:set_option("learning_rate", lr)
+  c:set_option("momentum", momentum)
+  c:set_option("weight_decay", weight_decay)
+  c:set_option("max_norm_penalty", 0.8)
+  for e=1,epochs do
+    tr:train_dataset{ input_dataset=ds_in, output_dataset=ds_out,
+		      shuffle=random(e) }
+  end
+  return tr
+end
+
+local tr1, tr2 = train(false, 0.5, 0.3, 1e-3, 4),
+train(true, 0.5, 0.3, 1e-3, 4)
+assert(not tr1.weights_arena and tr2.weights_arena)
+for wname,cobj in tr1:iterate_weights() do
+  local w1, ow1 = cobj:weights()
+  local w2, ow2 = tr2:weights(wname):weights()
+  w1, ow1, w2, ow2 = w1:toTable(), ow1:toTable(), w2:toTable(), ow2:toTable()
+  for i=1,#w1 do assert(w1[i] == w2[i] and ow1[i] == ow2[i]) end
+end
+
+-- without learning, the weights only change by the max norm penalty; w1 is
+-- stored as 6 inputs x isz outputs (col-major), the transposed component has
+-- input=isz and output=6, so its max norm is applied to the weights at
+-- positions j + k*6 (0-based) for each j < 6
+local w = train(false, 0.0, 0.0, 0.0, 1):weights("w1")
+local nI, nO = w:get_input_size(), w:get_output_size()
+assert(nI == 6 and nO == isz)
+local data, raw = w:weights():toTable(), {}
+for j=0,nO-1 do for i=0,nI-1 do raw[i*nO + j] = data[j*nI + i + 1] end end
+for j=0,5 do
+  local norm2 = 0
+  for k=0,isz-1 do norm2 = norm2 + raw[j + k*6]^2 end
+  assert(math.abs(math.sqrt(norm2) - 0.8) < 1e-5)
+end
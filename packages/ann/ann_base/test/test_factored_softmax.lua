@@ -0,0 +1,125 @@
+-- ann.components.factored_softmax: exact normalized output at inference, the
+-- same target log probabilities when only the target blocks are computed,
+-- gradients compared with finite differences, and training
+local H, V, C, bunch = 8, 30, 5, 12
+local rnd = random(1234)
+
+local word_classes = {}
+for w=1,V do word_classes[w] = rnd:randInt(1,C) end
+-- every class needs at least one word
+for k=1,C do word_classes[k] = k end
+
+local function new_trainer(name)
+  local c = ann.components.factored_softmax{ name=name, input=H,
+					     word_classes=word_classes }
+  local trainer = trainable.supervised_trainer(c,
+					       ann.loss.multi_class_cross_entropy(V),
+					       bunch)
+  trainer:build()
+  trainer:randomize_weights{ random=random(52), inf=-0.5, sup=0.5 }
+  return c, trainer
+end
+
+local c, trainer = new_trainer("fsm")
+assert(c:get_num_classes() == C)
+assert(c:get_output_size() == V)
+
+local x, targets = {}, {}
+for i=1,H*bunch do x[i] = rnd:rand(2) - 1 end
+for b=1,bunch do targets[b] = rnd:randInt(1,V) end
+local input  = tokens.memblock(x)
+local target = tokens.class_indices(targets, V)
+
+-- exact output, normalized probabilities for each pattern
+c:reset()
+local full = c:forward(input):convert_to_memblock():to_table()
+for b=1,bunch do
+  local sum = 0
+  for w=1,V do sum = sum + math.exp(full[(w-1)*bunch + b]) end
+  assert(math.abs(sum - 1) < 1e-4)
+end
+
+-- during training only the target entries are computed
+c:reset()
+c:set_target(target)
+local out = c:forward(input, true):convert_to_memblock():to_table()
+for b=1,bunch do
+  local pos = (targets[b]-1)*bunch + b
+  assert(math.abs(out[pos] - full[pos]) < 1e-4)
+end
+-- one-hot targets select the same entries
+local onehot = {}
+for i=1,V*bunch do onehot[i] = 0 end
+for b=1,bunch do onehot[(targets[b]-1)*bunch + b] = 1 end
+c:reset()
+c:set_target(tokens.memblock(onehot))
+local out2 = c:forward(input, true):convert_to_memblock():to_table()
+for i=1,V*bunch do assert(out[i] == out2[i]) end
+c:reset()
+c:set_target(target)
+c:forward(input, true)
+local gradient = ann.loss.multi_class_cross_entropy(V):gradient(c:get_output(),
+								  target)
+local error_output = c:backprop(gradient):convert_to_memblock():to_table()
+
+-- finite differences of -log P(target) with respect to the inputs
+local function target_logp(x, b)
+  c:reset()
+  local out = c:forward(tokens.memblock(x)):convert_to_memblock():to_table()
+  return out[(targets[b]-1)*bunch + b]
+end
+local eps = 1e-2
+for _,b in ipairs{ 1, 5, bunch } do
+  for h=1,H do
+    local i = (h-1)*bunch + b
+    local old = x[i]
+    x[i] = old + eps local lp1 = target_logp(x, b)
+    x[i] = old - eps local lp2 = target_logp(x, b)
+    x[i] = old
+    local numeric = -(lp1 - lp2)/(2*eps)
+    assert(math.abs(numeric - error_output[i]) < 1e-2)
+  end
+end
+
+-- serialization
+local c2 = loadstring("return " .. c:to_lua_string())()
+assert(c2:get_num_classes() == C)
+
+-- training decreases the loss, with and without momentum (the second one
+-- follows the update of all the weights)
+for _,momentum in ipairs{ 0, 0.5 } do
+  local c, trainer = new_trainer("fsm"..momentum)
+  c:set_option("learning_rate", 0.1)
+  c:set_option("momentum", momentum)
+  local first, last
+  for i=1,50 do
+    last = trainer:train_step(input, target)
+    first = first or last
+  end
+  printf("momentum= %.1f first= %.4f last= %.4f\n", momentum, first, last)
+  assert(last < first*0.5)
+  -- validation uses the exact output
+  local loss = trainer:validate_step(input, target)
+  assert(math.abs(loss - last) < last*0.5)
+end
+
+-- the gradient is computed from the target, other loss functions are refused
+local c = ann.components.factored_softmax{ input=H, word_classes=word_classes }
+assert(c:needs_target_for_gradient())
+assert(ann.components.stack():push(ann.components.actf.tanh()):
+       push(c):needs_target_for_gradient())
+assert(not ann.components.stack():push(c):push(ann.components.actf.tanh()):
+       needs_target_for_gradient())
+local tr = trainable.supervised_trainer(c, ann.loss.mse(V), bunch)
+assert(not pcall(tr.build, tr))
+local tr = trainable.supervised_trainer(c, nil, bunch)
+tr:build()
+assert(not pcall(tr.set_loss_function, tr, ann.loss.mse(V)))
+tr:set_loss_function(ann.loss.multi_class_cross_entropy(V))
+-- incorrect classes
+assert(not pcall(ann.components.factored_softmax,
+		 { input=H, word_classes={ 1, 2, 0, 1 } }))
+-- class 2 has not words
+local ok, msg = pcall(ann.components.factored_softmax,
+		      { input=H, word_classes={ 1, 3, 3, 1 } })
+assert(not ok and msg:find("Class 2 has not words"))
@@ -0,0 +1,96 @@
+-- fp16/bf16 weights storage: forward and backprop against fp32 weights,
+-- and save/load round trips of trainers loaded with reduced precision
+local rnd = random(2468)
+local tolerance = { fp16 = 1e-2, bf16 = 5e-2 }
+
+local function rand_table(n)
+  local t = {}
+  for i=1,n do t[i] = rnd:rand(2) - 1 end
+  return t
+end
+
+local function max_diff(a, b)
+  assert(#a == #b)
+  local d = 0
+  for i=1,#a do d = math.max(d, math.abs(a[i] - b[i])) end
+  return d
+end
+
+-- tied weights, with and without transposition, big enough to be converted
+-- in several panels
+local isz, hsz, bunch = 300, 250, 3
+local c = ann.components.stack():
+push(ann.components.dot_product{ input=isz, output=hsz, weights="w" }):
+push(ann.components.actf.tanh()):
+push(ann.components.dot_product{ input=hsz, output=isz, weights="w",
+				 transpose=true })
+local tr = trainable.supervised_trainer(c)
+tr:build()
+tr:randomize_weights{ random=random(52), inf=-0.1, sup=0.1 }
+local w = tr:weights("w")
+local x = rand_table(isz*bunch)
+local e = rand_table(isz*bunch)
+
+local function run()
+  c:reset()
+  local out  = c:forward(tokens.memblock(x)):convert_to_memblock():to_table()
+  local grad = c:backprop(tokens.memblock(e)):convert_to_memblock():to_table()
+  return out, grad
+end
+
+local out32, grad32 = run()
+for _,precision in ipairs{ "fp16", "bf16" } do
+  -- fp32 weights with the same rounding than the half precision ones
+  w:set_precision(precision)
+  w:set_precision("fp32")
+  local out_ref, grad_ref = run()
+  w:set_precision(precision)
+  assert(w:get_precision() == precision)
+  local out, grad = run()
+  assert(max_diff(out, out_ref) < 1e-5)
+  assert(max_diff(grad, grad_ref) < 1e-5)
+  assert(max_diff(out, out32) < tolerance[precision])
+  assert(max_diff(grad, grad32) < tolerance[precision])
+  -- weights are not trainable in half precision, update raises an error
+  -- before any weights are changed
+  c:set_option("learning_rate", 0.1)
+  local ok, msg = pcall(c.update, c)
+  assert(not ok and msg:find("half precision"))
+  assert(w:get_precision() == precision)
+  assert(max_diff(run(), out) == 0)
+  w:set_precision("fp32")
+end
+
+-- trainers loaded with reduced precision
+local net = ann.mlp.all_all.generate("20 inputs 30 tanh 5 log_softmax")
+local tr  = trainable.supervised_trainer(net,
+					 ann.loss.multi_class_cross_entropy(5),
+					 4)
+tr:build()
+tr:randomize_weights{ random=random(99), inf=-0.5, sup=0.5 }
+local input = rand_table(20)
+local out32 = tr:calculate(input)
+local filename  = os.tmpname()
+local filename2 = os.tmpname()
+tr:save(filename)
+for _,precision in ipairs{ "fp16", "bf16" } do
+  local tr2 = trainable.supervised_trainer.load(filename, nil, nil, precision)
+  for _,cobj in tr2:iterate_weights() do
+    assert(cobj:get_precision() == precision)
+  end
+  assert(max_diff(tr2:calculate(input), out32) < tolerance[precision])
+  -- saved as fp32, loading it again gives the same weights and outputs
+  tr2:save(filename2)
+  local tr3 = trainable.supervised_trainer.load(filename2, nil, nil, precision)
+  assert(max_diff(tr3:calculate(input), tr2:calculate(input)) == 0)
+  local tr4 = trainable.supervised_trainer.load(filename2)
+  for wname,cobj in tr4:iterate_weights() do
+    assert(cobj:get_precision() == "fp32")
+    local w4 = cobj:weights():toTable()
+    local w2 = tr2:weights(wname):weights():toTable()
+    assert(max_diff(w4, w2) == 0)
+  end
+  assert(max_diff(tr4:calculate(input), tr2:calculate(input)) < 1e-6)
+end
+os.remove(filename)
+os.remove(filename2)
@@ -0,0 +1,33 @@
+-- int8 quantized inference compared with fp32 inference
+rnd = random(1234)
+nump, isz, osz = 200, 30, 10
+m_in = matrix(nump, isz)
+for i=1,nump do for j=1,isz do m_in:set(i,j, rnd:rand(2)-1) end end
+m_out = matrix(nump, osz)
+for i=1,nump do m_out:set(i, rnd:randInt(1,osz), 1) end
+ds_input  = dataset.matrix(m_in)
+ds_output = dataset.matrix(m_out)
+
+net = ann.mlp.all_all.generate(isz.." inputs 50 tanh "..osz.." log_softmax")
+trainer = trainable.supervised_trainer(net,
+				       ann.loss.multi_class_cross_entropy(osz),
+				       16)
+trainer:build()
+trainer:randomize_weights{ random=random(52), inf=-0.5, sup=0.5 }
+
+-- dynamic input range
+r = trainer:quantization_report{ input_dataset  = ds_input,
+				 output_dataset = ds_output }
+printf("dynamic:    max_err= %.6f mean_err= %.6f agreement= %.3f\n",
+       r.max_abs_error, r.mean_abs_error, r.argmax_agreement)
+assert(r.max_abs_error < 0.1)
+assert(math.abs(r.fp32_loss - r.int8_loss) < 0.01)
+
+-- calibrated input range
+trainer:quantize{ calibration_dataset = ds_input }
+r = trainer:quantization_report{ input_dataset  = ds_input,
+				 output_dataset = ds_output }
+printf("calibrated: max_err= %.6f mean_err= %.6f agreement= %.3f\n",
+       r.max_abs_error, r.mean_abs_error, r.argmax_agreement)
+assert(r.max_abs_error < 0.1)
+assert(math.abs(r.fp32_loss - r.int8_loss) < 0.01)
@@ -0,0 +1,126 @@
+-- ann.components.sampled_output: exact normalized output at inference, the
+-- scores of the targets and the samples during training, gradients compared
+-- with finite differences, and training with NCE and sampled softmax
+local H, V, K, bunch = 8, 40, 10, 12
+local rnd = random(1234)
+
+-- unigram-like noise distribution
+local probs = {}
+for w=1,V do probs[w] = 1/w end
+local noise = random.dice(probs)
+
+local function new_component(seed)
+  return ann.components.sampled_output{ name="so", input=H, output=V,
+					num_samples=K, noise=noise,
+					random=random(seed) }
+end
+
+local c = new_component(7)
+assert(c:get_num_samples() == K)
+c:build()
+for _,cnn in pairs(c:copy_weights()) do
+  cnn:randomize_weights{ random=random(52), inf=-0.5, sup=0.5 }
+end
+local weights = c:copy_weights()
+
+local x, targets = {}, {}
+for i=1,H*bunch do x[i] = rnd:rand(2) - 1 end
+for b=1,bunch do targets[b] = rnd:randInt(1,V) end
+local input  = tokens.memblock(x)
+local target = tokens.class_indices(targets, V)
+
+-- exact output, normalized probabilities for each pattern
+c:reset()
+local full = c:forward(input):convert_to_memblock():to_table()
+assert(#full == V*bunch)
+for b=1,bunch do
+  local sum = 0
+  for w=1,V do sum = sum + math.exp(full[(w-1)*bunch + b]) end
+  assert(math.abs(sum - 1) < 1e-4)
+end
+
+-- during training, the score of the target is z(t) - log(K*Q(t)) =
+-- log P(t) + log Z - log(K*Q(t)), being log Z constant for each pattern
+c:reset()
+c:set_target(target)
+local out = c:forward(input, true):convert_to_memblock():to_table()
+assert(#out == (K+1)*bunch)
+for b=1,bunch do
+  local t = targets[b]
+  local logZ = out[b] + math.log(K*noise:probability(t)) - full[(t-1)*bunch + b]
+  -- samples are not known, but their scores are either masked or follow
+  -- the same expression for some output
+  for j=1,K do
+    local s = out[j*bunch + b]
+    local found = (s < -1e29)
+    for w=1,V do
+      local z = full[(w-1)*bunch + b] + logZ - math.log(K*noise:probability(w))
+      if math.abs(z - s) < 1e-3 then found = true break end
+    end
+    assert(found)
+  end
+end
+
+-- finite differences of the loss with respect to the inputs, a new
+-- component with the same seed draws the same samples
+for _,mode in ipairs{ "nce", "softmax" } do
+  local loss = ann.loss.sampled_output{ size=V, num_samples=K, mode=mode }
+  local function eval(x)
+    local c = new_component(7)
+    c:build{ weights=weights }
+    c:set_target(target)
+    local out = c:forward(tokens.memblock(x), true)
+    loss:reset()
+    return loss:loss(out, target), c, out
+  end
+  local _,c,out = eval(x)
+  local error_output = c:backprop(loss:gradient(out, target))
+  error_output = error_output:convert_to_memblock():to_table()
+  local eps = 1e-2
+  for _,b in ipairs{ 1, 5, bunch } do
+    for h=1,H do
+      local i = (h-1)*bunch + b
+      local old = x[i]
+      x[i] = old + eps local l1 = eval(x)
+      x[i] = old - eps local l2 = eval(x)
+      x[i] = old
+      -- the loss is averaged over the bunch, the gradient is not
+      local numeric = (l1 - l2)/(2*eps)*bunch
+      assert(math.abs(numeric - error_output[i]) < 1e-2)
+    end
+  end
+end
+
+-- serialization
+local c2 = loadstring("return " .. c:to_lua_string())()
+assert(c2:get_num_samples() == K)
+
+-- training decreases the exact loss, with and without momentum (the second
+-- one follows the update of all the weights)
+for _,mode in ipairs{ "nce", "softmax" } do
+  for _,momentum in ipairs{ 0, 0.5 } do
+    local c = new_component(11)
+    local trainer = trainable.supervised_trainer(c,
+						 ann.loss.sampled_output{
+						   size=V, num_samples=K,
+						   mode=mode },
+						 bunch)
+    trainer:build()
+    trainer:randomize_weights{ random=random(52), inf=-0.5, sup=0.5 }
+    c:set_option("learning_rate", 0.2)
+    c:set_option("momentum", momentum)
+    local first = trainer:validate_step(input, target)
+    for i=1,100 do trainer:train_step(input, target) end
+    local last = trainer:validate_step(input, target)
+    printf("mode= %s momentum= %.1f first= %.4f last= %.4f\n",
+	   mode, momentum, first, last)
+    assert(last < first*0.5)
+  end
+end
+
+-- the training outputs are the sampled scores, other loss functions are
+-- refused
+local c = new_component(13)
+assert(c:needs_target_for_gradient())
+local tr = trainable.supervised_trainer(c, ann.loss.mse(V), bunch)
+assert(not pcall(tr.build, tr))
@@ -0,0 +1,164 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+//BIND_HEADER_C
+#include "bind_ann_base.h"
+//BIND_END
+
+//BIND_HEADER_H
+#include "fnnlm_scorer.h"
+
+using namespace ANN;
+
+//BIND_END
+
+/////////////////////////////////////////////////////
+//                  FNNLMScorer                    //
+/////////////////////////////////////////////////////
+
+//BIND_LUACLASSNAME FNNLMScorer ann.fnnlm.scorer
+//BIND_CPP_CLASS    FNNLMScorer
+
+//BIND_CONSTRUCTOR FNNLMScorer
+//DOC_BEGIN
+// scorer{ context=component, output=component, order=n,
+//         context_cache_size=65536, ngram_cache_size=1048576,
+//         bunch_size=128, log_output=true }
+/// Native scorer of n-grams with the given FNNLM components (see
+/// FNNLMScorer), with caches of hidden layers and of n-gram log
+/// probabilities
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 1);
+  LUABIND_CHECK_PARAMETER(1, table);
+  check_table_fields(L, 1, "context", "output", "order",
+		     "context_cache_size", "ngram_cache_size",
+		     "bunch_size", "log_output", 0);
+  ANNComponent *context_component, *output_component;
+  unsigned int order, context_cache_size, ngram_cache_size, bunch_size;
+  bool log_output;
+  LUABIND_GET_TABLE_PARAMETER(1, context, ANNComponent, context_component);
+  LUABIND_GET_TABLE_PARAMETER(1, output, ANNComponent, output_component);
+  LUABIND_GET_TABLE_PARAMETER(1, order, uint, order);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, context_cache_size, uint,
+				       context_cache_size, 65536);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, ngram_cache_size, uint,
+				       ngram_cache_size, 1048576);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, bunch_size, uint, bunch_size, 128);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, log_output, bool, log_output, true);
+  obj = new FNNLMScorer(context_component, output_component, order,
+			context_cache_size, ngram_cache_size, bunch_size,
+			log_output);
+  LUABIND_RETURN(FNNLMScorer, obj);
+}
+//BIND_END
+
+//BIND_DESTRUCTOR FNNLMScorer
+{
+}
+//BIND_END
+
+//BIND_METHOD FNNLMScorer score
+//DOC_BEGIN
+// score(ngrams)
+/// Receives a table of n-grams, each one a table with order word indices
+/// (from 1, the last one is the scored word), and returns a table with
+/// the log probability of each n-gram
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 1);
+  LUABIND_CHECK_PARAMETER(1, table);
+  int num_ngrams;
+  unsigned int order = obj->getOrder();
+  LUABIND_TABLE_GETN(1, num_ngrams);
+  int   *ngrams    = new int[num_ngrams*order];
+  float *log_probs = new float[num_ngrams];
+  for (int i=0; i<num_ngrams; ++i) {
+    lua_rawgeti(L, 1, i+1);
+    int len = 0;
+    if (lua_istable(L, -1)) LUABIND_TABLE_GETN(-1, len);
+    if (len != static_cast<int>(order)) {
+      delete[] ngrams;
+      delete[] log_probs;
+      LUABIND_FERROR1("Incorrect n-gram %d, expected a table with order "
+		      "words\n", i+1);
+    }
+    int *ngram = ngrams + i*order;
+    LUABIND_TABLE_TO_VECTOR(-1, int, ngram, order);
+    lua_pop(L, 1);
+    for (unsigned int p=0; p<order; ++p) --ngram[p];
+  }
+  obj->score(ngrams, num_ngrams, log_probs);
+  LUABIND_VECTOR_TO_NEW_TABLE(float, log_probs, num_ngrams);
+  delete[] ngrams;
+  delete[] log_probs;
+  LUABIND_RETURN_FROM_STACK(-1);
+}
+//BIND_END
+
+//BIND_METHOD FNNLMScorer stats
+//DOC_BEGIN
+// stats()
+/// Returns a table with ngram_hits, ngram_misses, context_hits,
+/// context_misses, context_forwards and output_forwards counters
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 0);
+  FNNLMScorer::Stats stats = obj->getStats();
+  lua_newtable(L);
+  lua_pushnumber(L, stats.ngram_hits);
+  lua_setfield(L, -2, "ngram_hits");
+  lua_pushnumber(L, stats.ngram_misses);
+  lua_setfield(L, -2, "ngram_misses");
+  lua_pushnumber(L, stats.context_hits);
+  lua_setfield(L, -2, "context_hits");
+  lua_pushnumber(L, stats.context_misses);
+  lua_setfield(L, -2, "context_misses");
+  lua_pushnumber(L, stats.context_forwards);
+  lua_setfield(L, -2, "context_forwards");
+  lua_pushnumber(L, stats.output_forwards);
+  lua_setfield(L, -2, "output_forwards");
+  LUABIND_RETURN_FROM_STACK(-1);
+}
+//BIND_END
+
+//BIND_METHOD FNNLMScorer reset_stats
+{
+  obj->resetStats();
+}
+//BIND_END
+
+//BIND_METHOD FNNLMScorer clear
+//DOC_BEGIN
+// clear()
+/// Forgets the cached contexts and n-grams, needed when the weights of the
+/// model are modified
+//DOC_END
+{
+  obj->clear();
+}
+//BIND_END
+
+//BIND_METHOD FNNLMScorer get_order
+{
+  LUABIND_RETURN(uint, obj->getOrder());
+}
+//BIND_END
@@ -0,0 +1,212 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include <cmath>
+#include "fnnlm_scorer.h"
+#include "token_memory_block.h"
+#include "hash_table.h"
+#include "maxmin.h"
+#include "error_print.h"
+
+namespace ANN {
+
+  FNNLMScorer::FNNLMScorer(ANNComponent *context_component,
+			   ANNComponent *output_component,
+			   unsigned int order,
+			   unsigned int context_cache_size,
+			   unsigned int ngram_cache_size,
+			   unsigned int bunch_size,
+			   bool log_output) :
+    Referenced(),
+    context_component(context_component),
+    output_component(output_component),
+    order(order), context_vocabulary_size(0),
+    hidden_size(context_component->getOutputSize()),
+    vocabulary_size(output_component->getOutputSize()),
+    bunch_size(bunch_size), log_output(log_output),
+    ngram_cache(static_cast<int>(ngram_cache_size)),
+    context_cache(static_cast<int>(context_cache_size)),
+    missed_rows(0) {
+    if (order < 2 || order > FNNLM_SCORER_MAX_ORDER)
+      ERROR_EXIT1(128, "The order must be between 2 and %d\n",
+		  FNNLM_SCORER_MAX_ORDER);
+    if (bunch_size == 0)
+      ERROR_EXIT(128, "The bunch size must be > 0\n");
+    if (context_component->getInputSize() == 0 || hidden_size == 0 ||
+	vocabulary_size == 0)
+      ERROR_EXIT(128, "The components must be built\n");
+    if (context_component->getInputSize() % (order-1) != 0)
+      ERROR_EXIT2(128, "The input size of the context component (%u) is not "
+		  "a multiple of %u\n",
+		  context_component->getInputSize(), order-1);
+    if (output_component->getInputSize() != hidden_size)
+      ERROR_EXIT2(128, "Incorrect input size of the output component, "
+		  "expected %u, found %u\n",
+		  hidden_size, output_component->getInputSize());
+    context_vocabulary_size = context_component->getInputSize() / (order-1);
+    IncRef(context_component);
+    IncRef(output_component);
+    missed_rows = new int[bunch_size];
+    resetStats();
+  }
+
+  FNNLMScorer::~FNNLMScorer() {
+    for (unsigned int i=0; i<hidden_slots.size(); ++i)
+      delete[] hidden_slots[i];
+    delete[] missed_rows;
+    DecRef(context_component);
+    DecRef(output_component);
+  }
+
+  void FNNLMScorer::makeKey(const int *words, unsigned int n,
+			    NGramKey &key) const {
+    memset(key.words, 0, sizeof(key.words));
+    memcpy(key.words, words, sizeof(int)*n);
+  }
+
+  void FNNLMScorer::computeHidden(const NGramKey *contexts, unsigned int n,
+				  float *hidden) {
+    unsigned int num_missed = 0;
+    for (unsigned int b=0; b<n; ++b) {
+      HiddenSlot *slot = context_cache.find(contexts[b]);
+      if (slot != 0) {
+	for (unsigned int i=0; i<hidden_size; ++i)
+	  hidden[i*n + b] = slot->values[i];
+	++stats.context_hits;
+      }
+      else missed_rows[num_missed++] = b;
+    }
+    if (num_missed == 0) return;
+    stats.context_misses += num_missed;
+    ++stats.context_forwards;
+    // one-hot encoding of the missed contexts
+    const unsigned int input_size = context_component->getInputSize();
+    TokenMemoryBlock *input = new TokenMemoryBlock(input_size*num_missed);
+    IncRef(input);
+    float *x = input->getMemBlock()->getPPALForWrite();
+    for (unsigned int i=0; i<input_size*num_missed; ++i) x[i] = 0.0f;
+    for (unsigned int m=0; m<num_missed; ++m) {
+      const NGramKey &context = contexts[missed_rows[m]];
+      for (unsigned int p=0; p<order-1; ++p)
+	x[(p*context_vocabulary_size + context.words[p])*num_missed + m] = 1.0f;
+    }
+    context_component->reset();
+    Token *output = context_component->doForward(input, false);
+    if (output->getTokenCode() != table_of_token_codes::token_mem_block)
+      ERROR_EXIT(128, "Incorrect output token type of the context "
+		 "component, expected memory block\n");
+    const float *h = output->convertTo<TokenMemoryBlock*>()->getMemBlock()->getPPALForRead();
+    for (unsigned int m=0; m<num_missed; ++m) {
+      unsigned int b = missed_rows[m];
+      HiddenSlot *slot;
+      context_cache.get(contexts[b], &slot);
+      if (slot->values == 0) {
+	slot->values = new float[hidden_size];
+	hidden_slots.push_back(slot->values);
+      }
+      for (unsigned int i=0; i<hidden_size; ++i) {
+	hidden[i*n + b]  = h[i*num_missed + m];
+	slot->values[i]  = h[i*num_missed + m];
+      }
+    }
+    context_component->reset();
+    DecRef(input);
+  }
+
+  void FNNLMScorer::score(const int *ngrams, unsigned int num_ngrams,
+			  float *log_probs) {
+    // the n-grams not found at the cache are grouped by context, each
+    // context keeps a list of its n-grams (first_ngram and next_ngram)
+    april_utils::hash<NGramKey,int> context_index;
+    april_utils::vector<NGramKey> contexts;
+    april_utils::vector<int> first_ngram;
+    int *next_ngram = new int[num_ngrams];
+    NGramKey key, context;
+    for (unsigned int i=0; i<num_ngrams; ++i) {
+      const int *ngram = ngrams + i*order;
+      for (unsigned int p=0; p<order; ++p) {
+	unsigned int size = (p < order-1) ? context_vocabulary_size : vocabulary_size;
+	if (ngram[p] < 0 || static_cast<unsigned int>(ngram[p]) >= size) {
+	  delete[] next_ngram;
+	  ERROR_EXIT2(128, "Incorrect word index %d at n-gram %u\n",
+		      ngram[p], i);
+	}
+      }
+      makeKey(ngram, order, key);
+      float *log_prob = ngram_cache.find(key);
+      if (log_prob != 0) {
+	log_probs[i] = *log_prob;
+	++stats.ngram_hits;
+	continue;
+      }
+      ++stats.ngram_misses;
+      makeKey(ngram, order-1, context);
+      bool is_new;
+      int &row = context_index.find_and_add_pair(context, is_new)->second;
+      if (is_new) {
+	row = static_cast<int>(contexts.size());
+	contexts.push_back(context);
+	first_ngram.push_back(-1);
+      }
+      next_ngram[i]    = first_ngram[row];
+      first_ngram[row] = i;
+    }
+    // the contexts are computed by bunches
+    const unsigned int num_contexts = contexts.size();
+    for (unsigned int first=0; first<num_contexts; first+=bunch_size) {
+      unsigned int n = april_utils::min(bunch_size, num_contexts - first);
+      TokenMemoryBlock *hidden = new TokenMemoryBlock(hidden_size*n);
+      IncRef(hidden);
+      computeHidden(&contexts[first], n,
+		    hidden->getMemBlock()->getPPALForWrite());
+      output_component->reset();
+      Token *output = output_component->doForward(hidden, false);
+      if (output->getTokenCode() != table_of_token_codes::token_mem_block)
+	ERROR_EXIT(128, "Incorrect output token type of the output "
+		   "component, expected memory block\n");
+      ++stats.output_forwards;
+      const float *out = output->convertTo<TokenMemoryBlock*>()->getMemBlock()->getPPALForRead();
+      for (unsigned int b=0; b<n; ++b)
+	for (int i=first_ngram[first+b]; i>=0; i=next_ngram[i]) {
+	  const int *ngram = ngrams + i*order;
+	  float log_prob = out[ngram[order-1]*n + b];
+	  if (!log_output) log_prob = logf(log_prob);
+	  log_probs[i] = log_prob;
+	  makeKey(ngram, order, key);
+	  ngram_cache[key] = log_prob;
+	}
+      output_component->reset();
+      DecRef(hidden);
+    }
+    delete[] next_ngram;
+  }
+
+  void FNNLMScorer::resetStats() {
+    stats.ngram_hits       = stats.ngram_misses   = 0;
+    stats.context_hits     = stats.context_misses = 0;
+    stats.context_forwards = stats.output_forwards = 0;
+  }
+
+  void FNNLMScorer::clear() {
+    ngram_cache.clear();
+    context_cache.clear();
+  }
+}
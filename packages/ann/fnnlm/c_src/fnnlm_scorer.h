@@ -0,0 +1,120 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef FNNLM_SCORER_H
+#define FNNLM_SCORER_H
+
+#include <cstring>
+#include "referenced.h"
+#include "ann_component.h"
+#include "cache_open_addressing_hash.h"
+#include "vector.h"
+
+/// Maximum order of the n-grams scored by FNNLMScorer
+#define FNNLM_SCORER_MAX_ORDER 16
+
+namespace ANN {
+
+  /// Scores n-grams with a feed-forward neural network language model,
+  /// caching the hidden layer of each context and the log probability of
+  /// each n-gram, for n-best rescoring where most histories are repeated.
+  /**
+     The model is given by two built components: the context component,
+     whose input is the one-hot encoding of the order-1 context words
+     ((order-1) x context_vocabulary_size neurons, first word first), and
+     the output component, whose input is the output of the first one and
+     whose output are the (log) probabilities of the vocabulary.
+
+     Both caches are cache_open_addr_hash objects, so a new entry replaces
+     the one which has the same position. The n-grams not found at the
+     cache are grouped by context, and the contexts not found at the
+     context cache are computed with one forward of bunch_size contexts.
+     Caches must be cleared (see clear) if the weights are modified.
+  */
+  class FNNLMScorer : public Referenced {
+  public:
+    struct Stats {
+      /// n-grams found in the cache, and computed
+      long ngram_hits, ngram_misses;
+      /// contexts of computed n-grams found in the cache, and computed
+      long context_hits, context_misses;
+      /// forwards of the context and the output components
+      long context_forwards, output_forwards;
+    };
+
+    FNNLMScorer(ANNComponent *context_component,
+		ANNComponent *output_component,
+		unsigned int order,
+		unsigned int context_cache_size,
+		unsigned int ngram_cache_size,
+		unsigned int bunch_size,
+		bool log_output);
+    ~FNNLMScorer();
+
+    /// Computes the log probability of the last word of num_ngrams n-grams,
+    /// given in ngrams as num_ngrams x order word indices (from 0)
+    void score(const int *ngrams, unsigned int num_ngrams, float *log_probs);
+    
+    unsigned int getOrder() const { return order; }
+    Stats getStats() const { return stats; }
+    void resetStats();
+    /// Forgets all the cached contexts and n-grams
+    void clear();
+
+  private:
+    struct NGramKey {
+      int words[FNNLM_SCORER_MAX_ORDER];
+      NGramKey() { memset(words, 0, sizeof(words)); }
+      bool operator==(const NGramKey &other) const {
+	return memcmp(words, other.words, sizeof(words)) == 0;
+      }
+    };
+    /// hidden layer of a context, allocated the first time a position of
+    /// the cache is used, and reused by the next contexts of that position
+    struct HiddenSlot {
+      float *values;
+      HiddenSlot() : values(0) { }
+    };
+    typedef april_utils::cache_open_addr_hash<NGramKey, float> NGramCache;
+    typedef april_utils::cache_open_addr_hash<NGramKey, HiddenSlot> ContextCache;
+
+    ANNComponent *context_component, *output_component;
+    unsigned int order, context_vocabulary_size, hidden_size, vocabulary_size;
+    unsigned int bunch_size;
+    /// false when the output are probabilities instead of log probabilities
+    bool log_output;
+    NGramCache   ngram_cache;
+    ContextCache context_cache;
+    april_utils::vector<float*> hidden_slots;
+    Stats stats;
+    /// positions (at the bunch) of the contexts not found at the cache
+    int *missed_rows;
+
+    void makeKey(const int *words, unsigned int n, NGramKey &key) const;
+    /// Writes the hidden layer of n contexts at hidden (hidden_size x n,
+    /// as the memory blocks of the tokens), computing the ones which are
+    /// not found at the cache with one forward
+    void computeHidden(const NGramKey *contexts, unsigned int n,
+		       float *hidden);
+  };
+}
+
+#endif // FNNLM_SCORER_H
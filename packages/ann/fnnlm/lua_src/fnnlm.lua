@@ -20,6 +20,15 @@ function ann.fnnlm:__call(t)
       hidden_actf = { mandatory = true,  type_match = "string" },
       hidden_size = { mandatory = true,  type_match = "number" },
       bunch_size  = { mandatory = false, type_match = "number", default = 32 },
+      -- class (from 1 to number of classes) of each output word, if given a
+      -- factored softmax is used as output layer
+      word_classes = { mandatory = false, type_match = "table", default = nil },
+      -- noise probability (usually unigram) of each output word, if given
+      -- the output layer is trained with num_samples sampled words, by NCE
+      -- or sampled softmax (sampled_mode)
+      noise_probs  = { mandatory = false, type_match = "table", default = nil },
+      num_samples  = { mandatory = false, type_match = "number", default = 100 },
+      sampled_mode = { mandatory = false, type_match = "string", default = "nce" },
     }, t)
   local obj = { 
     factor_names      = {},
@@ -27,6 +36,7 @@ function ann.fnnlm:__call(t)
     cache_component   = {},
     input_component   = ann.components.join{  name="factors_join" },
     hidden_component  = ann.components.stack{ name="hidden_stack" },
+    context_component = ann.components.stack{ name="context_stack" },
     output_component  = ann.components.stack{ name="output_stack" },
     ann_component     = ann.components.stack{ name="FNNLM" },
     trainer           = {},
@@ -74,26 +84,53 @@ function ann.fnnlm:__call(t)
 			       bias_weights        = "hidden_b", })
   obj.hidden_component:push(ann.components.actf[params.hidden_actf]{name="hidden_actf"})
   --
-  obj.output_component:push( ann.components.hyperplane{
-			       input  = params.hidden_size,
-			       output = params.output_size,
-			       name   = "output_layer",
-			       dot_product_name    = "output_w",
-			       bias_name           = "output_b",
-			       dot_product_weights = "output_w",
-			       bias_weights        = "output_b", })
-  obj.output_component:push(ann.components.actf.softmax{name="output_actf"})
+  local loss = ann.loss.multi_class_cross_entropy(params.output_size)
+  assert(not params.word_classes or not params.noise_probs,
+	 "word_classes and noise_probs are not compatible")
+  if params.noise_probs then
+    assert(#params.noise_probs == params.output_size,
+	   "Incorrect noise_probs size, expected output_size elements")
+    obj.output_component:push( ann.components.sampled_output{
+				 input       = params.hidden_size,
+				 output      = params.output_size,
+				 name        = "output_layer",
+				 weights     = "output_w",
+				 num_samples = params.num_samples,
+				 noise       = random.dice(params.noise_probs), })
+    loss = ann.loss.sampled_output{ size        = params.output_size,
+				    num_samples = params.num_samples,
+				    mode        = params.sampled_mode, }
+  elseif params.word_classes then
+    assert(#params.word_classes == params.output_size,
+	   "Incorrect word_classes size, expected output_size elements")
+    obj.output_component:push( ann.components.factored_softmax{
+				 input        = params.hidden_size,
+				 name         = "output_layer",
+				 weights      = "output_w",
+				 word_classes = params.word_classes, })
+  else
+    obj.output_component:push( ann.components.hyperplane{
+				 input  = params.hidden_size,
+				 output = params.output_size,
+				 name   = "output_layer",
+				 dot_product_name    = "output_w",
+				 bias_name           = "output_b",
+				 dot_product_weights = "output_w",
+				 bias_weights        = "output_b", })
+    obj.output_component:push(ann.components.actf.softmax{name="output_actf"})
+  end
   --
-  obj.ann_component:push(obj.input_component)
-  obj.ann_component:push(obj.hidden_component)
+  -- the context stack computes the hidden layer from the context words, it is
+  -- the first part of the model used by ann.fnnlm.scorer
+  obj.context_component:push(obj.input_component)
+  obj.context_component:push(obj.hidden_component)
+  obj.ann_component:push(obj.context_component)
   obj.ann_component:push(obj.output_component)
   --
   obj.trainer =
-    trainable.supervised_trainer(obj.ann_component,
-				 ann.loss.multi_class_cross_entropy(params.output_size),
-				 params.bunch_size)
+    trainable.supervised_trainer(obj.ann_component, loss, params.bunch_size)
   --
-  obj = class_instance(obj, fnnlm, true)
+  obj = class_instance(obj, ann.fnnlm, true)
   return obj
 end
 
@@ -101,6 +138,29 @@ function ann.fnnlm:get_component()
   return self.ann_component
 end
 
+-- Returns an ann.fnnlm.scorer of the model (it must be built), which caches
+-- the hidden layer of the contexts and the log probability of the n-grams.
+-- The optional table t could contain context_cache_size, ngram_cache_size and
+-- bunch_size fields. The scorer encodes the context words as the input of a
+-- single factor, so the model must have one factor and no cache input.
+function ann.fnnlm:get_scorer(t)
+  local t = t or {}
+  assert(#self.params.factors == 1 and self.params.cache_size == 0,
+	 "ann.fnnlm:get_scorer only supports models with one factor and " ..
+	   "cache_size=0")
+  return ann.fnnlm.scorer{
+    context    = self.context_component,
+    output     = self.output_component,
+    order      = self.params.factors[1].order,
+    context_cache_size = t.context_cache_size,
+    ngram_cache_size   = t.ngram_cache_size,
+    bunch_size         = t.bunch_size or self.params.bunch_size,
+    -- factored and sampled output layers compute log probabilities
+    log_output = (self.params.word_classes ~= nil or
+		  self.params.noise_probs ~= nil),
+  }
+end
+
 function ann.fnnlm:set_dropout(value)
   for name,component in obj.trainer:iterate_components("^.*actf.*$") do
     if not name:match("^factor_.*_1_actf$") then
@@ -0,0 +1,128 @@
+-- ann.fnnlm.scorer: the cached log probabilities are equal to the ones of
+-- the forward of the whole model, and repeated n-grams and contexts are
+-- found at the caches
+local V, H, order = 20, 6, 3
+local rnd = random(1234)
+
+local context = ann.components.stack():
+push(ann.components.hyperplane{ input=(order-1)*V, output=H }):
+push(ann.components.actf.tanh())
+local output = ann.components.stack():
+push(ann.components.hyperplane{ input=H, output=V }):
+push(ann.components.actf.log_softmax())
+local model = ann.components.stack():push(context):push(output)
+local trainer = trainable.supervised_trainer(model)
+trainer:build()
+trainer:randomize_weights{ random=random(52), inf=-1, sup=1 }
+
+-- log probability of an n-gram computed with the whole model
+local function logp(ngram)
+  local x = {}
+  for i=1,(order-1)*V do x[i] = 0 end
+  for p=1,order-1 do x[(p-1)*V + ngram[p]] = 1 end
+  model:reset()
+  return model:forward(tokens.memblock(x)):convert_to_memblock():to_table()[ngram[order]]
+end
+
+local scorer = ann.fnnlm.scorer{ context=context, output=output, order=order,
+				 context_cache_size=4096, ngram_cache_size=65536,
+				 bunch_size=4 }
+assert(scorer:get_order() == order)
+
+-- n-grams with few different contexts
+local ngrams = {}
+for i=1,50 do
+  ngrams[i] = { rnd:randInt(1,3), rnd:randInt(1,3), rnd:randInt(1,V) }
+end
+local lps = scorer:score(ngrams)
+assert(#lps == #ngrams)
+for i,ngram in ipairs(ngrams) do
+  assert(math.abs(lps[i] - logp(ngram)) < 1e-4)
+end
+local stats = scorer:stats()
+assert(stats.ngram_hits + stats.ngram_misses == #ngrams)
+-- at most 9 different contexts, computed by bunches of 4
+assert(stats.context_misses <= 9)
+assert(stats.output_forwards <= 3)
+
+-- the second time all of them are found at the cache
+scorer:reset_stats()
+local lps2 = scorer:score(ngrams)
+for i=1,#ngrams do assert(lps2[i] == lps[i]) end
+stats = scorer:stats()
+assert(stats.ngram_hits == #ngrams and stats.ngram_misses == 0)
+assert(stats.context_forwards == 0 and stats.output_forwards == 0)
+
+-- after clear, the results are the same
+scorer:clear()
+scorer:reset_stats()
+local lps3 = scorer:score(ngrams)
+for i=1,#ngrams do assert(math.abs(lps3[i] - lps[i]) < 1e-6) end
+assert(scorer:stats().ngram_hits == 0)
+
+-- with very small caches, colliding entries replace the previous ones
+local small = ann.fnnlm.scorer{ context=context, output=output, order=order,
+				context_cache_size=4, ngram_cache_size=4,
+				bunch_size=4 }
+for k=1,2 do
+  local lps = small:score(ngrams)
+  for i,ngram in ipairs(ngrams) do
+    assert(math.abs(lps[i] - logp(ngram)) < 1e-4)
+  end
+end
+assert(small:stats().ngram_misses > #ngrams)
+
+-- an output component which computes probabilities
+local prob_output = ann.components.stack():
+push(ann.components.hyperplane{ input=H, output=V }):
+push(ann.components.actf.softmax())
+prob_output:build()
+for _,cnn in pairs(prob_output:copy_weights()) do
+  cnn:randomize_weights{ random=random(7), inf=-1, sup=1 }
+end
+local prob_scorer = ann.fnnlm.scorer{ context=context, output=prob_output,
+				      order=order, log_output=false }
+local lps4 = prob_scorer:score(ngrams)
+for i,ngram in ipairs(ngrams) do
+  local x = {}
+  for j=1,(order-1)*V do x[j] = 0 end
+  for p=1,order-1 do x[(p-1)*V + ngram[p]] = 1 end
+  context:reset()
+  prob_output:reset()
+  local h = context:forward(tokens.memblock(x))
+  local p = prob_output:forward(h):convert_to_memblock():to_table()[ngram[order]]
+  assert(math.abs(lps4[i] - math.log(p)) < 1e-4)
+end
+
+-- scorer of an ann.fnnlm model
+local lm = ann.fnnlm{ factors={ { name="w", order=2,
+				  layers={ { size=V, actf="linear" },
+					   { size=4, actf="linear" } } } },
+		      output_size=V, hidden_actf="tanh", hidden_size=H }
+lm.trainer:build()
+lm.trainer:randomize_weights{ random=random(3), inf=-1, sup=1 }
+local lm_scorer = lm:get_scorer()
+local bigrams = { { 1, 2 }, { 3, 4 }, { 1, 5 } }
+local lps5 = lm_scorer:score(bigrams)
+for i,bigram in ipairs(bigrams) do
+  local x = {}
+  for j=1,V do x[j] = 0 end
+  x[bigram[1]] = 1
+  local model = lm:get_component()
+  model:reset()
+  local p = model:forward(tokens.memblock(x)):convert_to_memblock():to_table()[bigram[2]]
+  assert(math.abs(lps5[i] - math.log(p)) < 1e-4)
+end
+assert(lm_scorer:stats().context_misses == 2)
+
+-- several factors, or a cache input, are not supported by get_scorer
+local w_factor = { name="w", order=2,
+		   layers={ { size=V, actf="linear" }, { size=4, actf="linear" } } }
+local t_factor = { name="t", order=2,
+		   layers={ { size=5, actf="linear" }, { size=2, actf="linear" } } }
+local lm2 = ann.fnnlm{ factors={ w_factor, t_factor }, output_size=V,
+		       hidden_actf="tanh", hidden_size=H }
+assert(not pcall(lm2.get_scorer, lm2))
+local lm3 = ann.fnnlm{ factors={ w_factor }, cache_size=3, output_size=V,
+		       hidden_actf="tanh", hidden_size=H }
+assert(not pcall(lm3.get_scorer, lm3))
@@ -30,6 +30,7 @@
 #include "cross_entropy_loss_function.h"
 #include "multiclass_cross_entropy_loss_function.h"
 #include "local_fmeasure_loss_function.h"
+#include "sampled_output_loss_function.h"
 
 using namespace ANN;
 
@@ -74,6 +75,22 @@ using namespace ANN;
 }
 //BIND_END
 
+//BIND_METHOD LossFunction loss_and_gradient
+// returns the loss and the gradient, computed at once, the gradient token is
+// reused by the next call only if it is not referenced from elsewhere
+{
+  LUABIND_CHECK_ARGN(==,2);
+  LUABIND_CHECK_PARAMETER(1, Token);
+  LUABIND_CHECK_PARAMETER(2, Token);
+  Token *input, *target, *error;
+  LUABIND_GET_PARAMETER(1, Token, input);
+  LUABIND_GET_PARAMETER(2, Token, target);
+  float loss = obj->computeLossAndGradient(input, target, error);
+  LUABIND_RETURN(float, loss);
+  LUABIND_RETURN(Token, error);
+}
+//BIND_END
+
 //BIND_METHOD LossFunction get_accum_loss
 {
   float loss = obj->getAccumLoss();
@@ -225,3 +242,37 @@ using namespace ANN;
 		 dynamic_cast<LocalFMeasureLossFunction*>(obj->clone()));
 }
 //BIND_END
+
+/////////////////////////////////////////////////////
+//                 SAMPLED OUTPUT                  //
+/////////////////////////////////////////////////////
+
+//BIND_LUACLASSNAME SampledOutputLossFunction ann.loss.sampled_output
+//BIND_CPP_CLASS    SampledOutputLossFunction
+//BIND_SUBCLASS_OF  SampledOutputLossFunction LossFunction
+
+//BIND_CONSTRUCTOR SampledOutputLossFunction
+{
+  LUABIND_CHECK_ARGN(==,1);
+  LUABIND_CHECK_PARAMETER(1, table);
+  check_table_fields(L, 1, "size", "num_samples", "mode", 0);
+  unsigned int size, num_samples;
+  const char *mode;
+  LUABIND_GET_TABLE_PARAMETER(1, size, uint, size);
+  LUABIND_GET_TABLE_PARAMETER(1, num_samples, uint, num_samples);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, mode, string, mode, "nce");
+  bool nce = false;
+  if (strcmp(mode, "nce") == 0) nce = true;
+  else if (strcmp(mode, "softmax") != 0)
+    LUABIND_FERROR1("Incorrect mode %s, expected nce or softmax\n", mode);
+  obj=new SampledOutputLossFunction(size, num_samples, nce);
+  LUABIND_RETURN(SampledOutputLossFunction, obj);
+}
+//BIND_END
+
+//BIND_METHOD SampledOutputLossFunction clone
+{
+  LUABIND_RETURN(SampledOutputLossFunction,
+		 dynamic_cast<SampledOutputLossFunction*>(obj->clone()));
+}
+//BIND_END
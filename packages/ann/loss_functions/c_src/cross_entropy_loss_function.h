@@ -39,11 +39,18 @@ namespace ANN {
     virtual ~CrossEntropyLossFunction();
     virtual float  addLoss(Token *input, Token *target);
     virtual Token *computeGradient(Token *input, Token *target);
+    virtual float  computeLossAndGradient(Token *input, Token *target,
+					  Token *&gradient);
     virtual float  getAccumLoss();
     virtual void   reset();
     virtual LossFunction *clone() {
       return new CrossEntropyLossFunction(size, accumulated_loss, N);
     }
+    virtual void accumulateLoss(LossFunction *other) {
+      CrossEntropyLossFunction *o = static_cast<CrossEntropyLossFunction*>(other);
+      accumulated_loss += o->accumulated_loss;
+      N                += o->N;
+    }
   };
 }
 
@@ -84,6 +84,34 @@ namespace ANN {
     return error_output;
   }
   
+  float LocalFMeasureLossFunction::computeLossAndGradient(Token *input,
+							   Token *target,
+							   Token *&gradient) {
+    TokenMemoryBlock *input_mem_token, *target_mem_block;
+    unsigned int bunch_size = convertMemBlockTokens(input, target,
+						    input_mem_token,
+						    target_mem_block);
+    // the gradient needs Gab and Hab of the whole bunch, so the loss is
+    // computed first
+    float loss = doLocalFMeasureLossFunction(input_mem_token->getMemBlock(),
+					     target_mem_block->getMemBlock(),
+					     size, bunch_size,
+					     beta, Gab, Hab,
+					     complement_output,
+					     input_mem_token->getCudaFlag());
+    TokenMemoryBlock *error_mem_block;
+    error_mem_block = getErrorOutputMemBlock(input_mem_token->getUsedSize());
+    doComputeLocalFMeasureGradient(target_mem_block->getMemBlock(),
+				   error_mem_block->getMemBlock(),
+				   size, bunch_size,
+				   beta, Gab, Hab, complement_output,
+				   input_mem_token->getCudaFlag());
+    accumulated_loss += loss;
+    ++N;
+    gradient = error_output;
+    return loss;
+  }
+
   float LocalFMeasureLossFunction::getAccumLoss() {
     return accumulated_loss/N;
   }
@@ -43,6 +43,8 @@ namespace ANN {
     virtual ~LocalFMeasureLossFunction();
     virtual float  addLoss(Token *input, Token *target);
     virtual Token *computeGradient(Token *input, Token *target);
+    virtual float  computeLossAndGradient(Token *input, Token *target,
+					  Token *&gradient);
     virtual float  getAccumLoss();
     virtual void reset();
     virtual LossFunction *clone() {
@@ -50,6 +52,11 @@ namespace ANN {
 					   complement_output,
 					   accumulated_loss, N);
     }
+    virtual void accumulateLoss(LossFunction *other) {
+      LocalFMeasureLossFunction *o = static_cast<LocalFMeasureLossFunction*>(other);
+      accumulated_loss += o->accumulated_loss;
+      N                += o->N;
+    }
   };
 }
 
@@ -33,6 +33,40 @@ namespace ANN {
   protected:
     Token *error_output;
     unsigned int size;
+
+    /// Returns error_output as a memory block of the given used size,
+    /// reusing the previous one when nobody else has a reference to it and
+    /// its size is the same (components use the size of the memory block)
+    TokenMemoryBlock *getErrorOutputMemBlock(unsigned int used_size) {
+      if (error_output != 0 && error_output->getRef() == 1 &&
+	  error_output->getTokenCode() == table_of_token_codes::token_mem_block) {
+	TokenMemoryBlock *mem_block = error_output->convertTo<TokenMemoryBlock*>();
+	if (mem_block->getMemBlock()->getSize() == used_size) {
+	  mem_block->resize(used_size);
+	  return mem_block;
+	}
+      }
+      TokenMemoryBlock *mem_block = new TokenMemoryBlock(used_size);
+      AssignRef(error_output, mem_block);
+      return mem_block;
+    }
+    /// Checks that input and target are memory blocks of the same size, and
+    /// returns the bunch size
+    unsigned int convertMemBlockTokens(Token *input, Token *target,
+				       TokenMemoryBlock *&input_mem_token,
+				       TokenMemoryBlock *&target_mem_block) {
+      if (input->getTokenCode() != table_of_token_codes::token_mem_block)
+	ERROR_EXIT(128, "Incorrect input token type, expected memory block\n");
+      if (target->getTokenCode() != table_of_token_codes::token_mem_block)
+	ERROR_EXIT(128, "Incorrect target token type, expected memory block\n");
+      input_mem_token  = input->convertTo<TokenMemoryBlock*>();
+      target_mem_block = target->convertTo<TokenMemoryBlock*>();
+      if (input_mem_token->getUsedSize() != target_mem_block->getUsedSize())
+	ERROR_EXIT2(128, "Different token sizes found, input=%d  target=%d\n",
+		    input_mem_token->getUsedSize(),
+		    target_mem_block->getUsedSize());
+      return input_mem_token->getUsedSize() / size;
+    }
   public:
     LossFunction(unsigned int size) :
     Referenced(), error_output(0), size(size) {
@@ -44,12 +78,25 @@ namespace ANN {
     }
     virtual float  addLoss(Token *input, Token *target) = 0;
     virtual Token *computeGradient(Token *input, Token *target) = 0;
+    /// Does addLoss and computeGradient at once, returning the loss and
+    /// leaving the gradient at the given reference. The gradient token
+    /// belongs to the loss function, the next call reuses it only if nobody
+    /// else keeps a reference to it (see getErrorOutputMemBlock).
+    virtual float  computeLossAndGradient(Token *input, Token *target,
+					  Token *&gradient) {
+      float loss = addLoss(input, target);
+      gradient   = computeGradient(input, target);
+      return loss;
+    }
     virtual float  getAccumLoss() = 0;
     virtual void   reset() {
       if (error_output) DecRef(error_output);
       error_output = 0;
     }
     virtual LossFunction *clone() = 0;
+    /// Adds the accumulated loss of other, which must be a clone of this
+    /// object, used to reduce the losses computed in parallel by clones
+    virtual void accumulateLoss(LossFunction *other) = 0;
   };
 }
 
@@ -36,11 +36,18 @@ namespace ANN {
     virtual ~MAELossFunction();
     virtual float  addLoss(Token *input, Token *target);
     virtual Token *computeGradient(Token *input, Token *target);
+    virtual float  computeLossAndGradient(Token *input, Token *target,
+					  Token *&gradient);
     virtual float  getAccumLoss();
     virtual void reset();
     virtual LossFunction *clone() {
       return new MAELossFunction(size, accumulated_loss, N);
     }
+    virtual void accumulateLoss(LossFunction *other) {
+      MAELossFunction *o = static_cast<MAELossFunction*>(other);
+      accumulated_loss += o->accumulated_loss;
+      N                += o->N;
+    }
   };
 }
 
@@ -78,6 +78,26 @@ namespace ANN {
     return error_output;
   }
   
+  float MSELossFunction::computeLossAndGradient(Token *input, Token *target,
+						 Token *&gradient) {
+    TokenMemoryBlock *input_mem_token, *target_mem_block;
+    unsigned int bunch_size = convertMemBlockTokens(input, target,
+						    input_mem_token,
+						    target_mem_block);
+    TokenMemoryBlock *error_mem_block;
+    error_mem_block = getErrorOutputMemBlock(input_mem_token->getUsedSize());
+    float loss = doMSELossAndGradient(input_mem_token->getMemBlock(),
+				      target_mem_block->getMemBlock(),
+				      error_mem_block->getMemBlock(),
+				      0.0f, size, bunch_size,
+				      input_mem_token->getCudaFlag());
+    loss *= 0.5f/bunch_size;
+    accumulated_loss += loss;
+    ++N;
+    gradient = error_output;
+    return loss;
+  }
+
   float MSELossFunction::getAccumLoss() {
     return accumulated_loss/N;
   }
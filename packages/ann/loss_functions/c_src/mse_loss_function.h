@@ -36,11 +36,18 @@ namespace ANN {
     virtual ~MSELossFunction();
     virtual float  addLoss(Token *input, Token *target);
     virtual Token *computeGradient(Token *input, Token *target);
+    virtual float  computeLossAndGradient(Token *input, Token *target,
+					  Token *&gradient);
     virtual float  getAccumLoss();
     virtual void reset();
     virtual LossFunction *clone() {
       return new MSELossFunction(size, accumulated_loss, N);
     }
+    virtual void accumulateLoss(LossFunction *other) {
+      MSELossFunction *o = static_cast<MSELossFunction*>(other);
+      accumulated_loss += o->accumulated_loss;
+      N                += o->N;
+    }
   };
 }
 
@@ -19,6 +19,7 @@
  *
  */
 #include "token_memory_block.h"
+#include "token_class_indices.h"
 #include "multiclass_cross_entropy_loss_function.h"
 #include "wrapper.h"
 
@@ -36,11 +37,40 @@ namespace ANN {
   MultiClassCrossEntropyLossFunction::~MultiClassCrossEntropyLossFunction() {
   }
   
+  /// Checks the sparse target of a bunch, and returns its class indices token
+  static TokenClassIndices *getClassIndices(TokenMemoryBlock *input,
+					    Token *target,
+					    unsigned int size) {
+    TokenClassIndices *target_indices = target->convertTo<TokenClassIndices*>();
+    if (target_indices->getNumClasses() != size)
+      ERROR_EXIT2(128, "Incorrect number of classes, expected %u, found %u\n",
+		  size, target_indices->getNumClasses());
+    if (input->getUsedSize() != target_indices->getUsedSize()*size)
+      ERROR_EXIT(128, "Different token sizes found\n");
+    return target_indices;
+  }
+
   float MultiClassCrossEntropyLossFunction::addLoss(Token *input, Token *target) {
     if (input->getTokenCode() != table_of_token_codes::token_mem_block)
       ERROR_EXIT(128, "Incorrect input token type, expected memory block\n");
+    if (target->getTokenCode() == table_of_token_codes::token_class_indices) {
+      TokenMemoryBlock  *input_mem_token = input->convertTo<TokenMemoryBlock*>();
+      TokenClassIndices *target_indices  = getClassIndices(input_mem_token,
+							   target, size);
+      unsigned int bunch_size = target_indices->getUsedSize();
+      float loss = doMultiClassCrossEntropyLossFunctionIndexed(input_mem_token->getMemBlock(),
+							       target_indices->getIndices(),
+							       target_indices->getWeights(),
+							       size, bunch_size,
+							       input_mem_token->getCudaFlag());
+      loss = -loss/bunch_size;
+      accumulated_loss += loss;
+      ++N;
+      return loss;
+    }
     if (target->getTokenCode() != table_of_token_codes::token_mem_block)
-      ERROR_EXIT(128, "Incorrect target token type, expected memory block\n");
+      ERROR_EXIT(128, "Incorrect target token type, expected memory block "
+		 "or class indices\n");
     //
     TokenMemoryBlock *input_mem_token = input->convertTo<TokenMemoryBlock*>();
     TokenMemoryBlock *target_mem_block = target->convertTo<TokenMemoryBlock*>();
@@ -61,8 +91,24 @@ namespace ANN {
   Token *MultiClassCrossEntropyLossFunction::computeGradient(Token *input, Token *target) {
     if (input->getTokenCode() != table_of_token_codes::token_mem_block)
       ERROR_EXIT(128, "Incorrect token type, expected memory block\n");
+    if (target->getTokenCode() == table_of_token_codes::token_class_indices) {
+      TokenMemoryBlock  *input_mem_token = input->convertTo<TokenMemoryBlock*>();
+      TokenClassIndices *target_indices  = getClassIndices(input_mem_token,
+							   target, size);
+      TokenMemoryBlock *error_mem_block;
+      error_mem_block = new TokenMemoryBlock(input_mem_token->getUsedSize());
+      AssignRef(error_output, error_mem_block);
+      doComputeCrossEntropyGradientIndexed(input_mem_token->getMemBlock(),
+					   target_indices->getIndices(),
+					   target_indices->getWeights(),
+					   error_mem_block->getMemBlock(),
+					   size, target_indices->getUsedSize(),
+					   input_mem_token->getCudaFlag());
+      return error_output;
+    }
     if (target->getTokenCode() != table_of_token_codes::token_mem_block)
-      ERROR_EXIT(128, "Incorrect target token type, expected memory block\n");
+      ERROR_EXIT(128, "Incorrect target token type, expected memory block "
+		 "or class indices\n");
     //
     TokenMemoryBlock *input_mem_token  = input->convertTo<TokenMemoryBlock*>();
     TokenMemoryBlock *target_mem_block = target->convertTo<TokenMemoryBlock*>();
@@ -81,6 +127,47 @@ namespace ANN {
     return error_output;
   }
   
+  float MultiClassCrossEntropyLossFunction::computeLossAndGradient(Token *input,
+								    Token *target,
+								    Token *&gradient) {
+    float loss;
+    if (target->getTokenCode() == table_of_token_codes::token_class_indices) {
+      if (input->getTokenCode() != table_of_token_codes::token_mem_block)
+	ERROR_EXIT(128, "Incorrect input token type, expected memory block\n");
+      TokenMemoryBlock  *input_mem_token = input->convertTo<TokenMemoryBlock*>();
+      TokenClassIndices *target_indices  = getClassIndices(input_mem_token,
+							   target, size);
+      unsigned int bunch_size = target_indices->getUsedSize();
+      TokenMemoryBlock *error_mem_block;
+      error_mem_block = getErrorOutputMemBlock(input_mem_token->getUsedSize());
+      loss = doMultiClassCrossEntropyLossAndGradientIndexed(input_mem_token->getMemBlock(),
+							    target_indices->getIndices(),
+							    target_indices->getWeights(),
+							    error_mem_block->getMemBlock(),
+							    size, bunch_size,
+							    input_mem_token->getCudaFlag());
+      loss = -loss/bunch_size;
+    }
+    else {
+      TokenMemoryBlock *input_mem_token, *target_mem_block;
+      unsigned int bunch_size = convertMemBlockTokens(input, target,
+						      input_mem_token,
+						      target_mem_block);
+      TokenMemoryBlock *error_mem_block;
+      error_mem_block = getErrorOutputMemBlock(input_mem_token->getUsedSize());
+      loss = doCrossEntropyLossAndGradient(input_mem_token->getMemBlock(),
+					   target_mem_block->getMemBlock(),
+					   error_mem_block->getMemBlock(),
+					   0.0f, size, bunch_size, true,
+					   input_mem_token->getCudaFlag());
+      loss = -loss/bunch_size;
+    }
+    accumulated_loss += loss;
+    ++N;
+    gradient = error_output;
+    return loss;
+  }
+
   float MultiClassCrossEntropyLossFunction::getAccumLoss() {
     return accumulated_loss/N;
   }
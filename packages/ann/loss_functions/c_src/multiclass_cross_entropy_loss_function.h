@@ -37,11 +37,18 @@ namespace ANN {
     virtual ~MultiClassCrossEntropyLossFunction();
     virtual float  addLoss(Token *input, Token *target);
     virtual Token *computeGradient(Token *input, Token *target);
+    virtual float  computeLossAndGradient(Token *input, Token *target,
+					  Token *&gradient);
     virtual float  getAccumLoss();
     virtual void   reset();
     virtual LossFunction *clone() {
       return new MultiClassCrossEntropyLossFunction(size, accumulated_loss, N);
     }
+    virtual void accumulateLoss(LossFunction *other) {
+      MultiClassCrossEntropyLossFunction *o = static_cast<MultiClassCrossEntropyLossFunction*>(other);
+      accumulated_loss += o->accumulated_loss;
+      N                += o->N;
+    }
   };
 }
 
@@ -0,0 +1,184 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Salvador España-Boquera, Adrian Palacios, Francisco Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include <cmath>
+#include "token_memory_block.h"
+#include "token_class_indices.h"
+#include "sampled_output_loss_function.h"
+
+namespace ANN {
+
+  /// log(1 + exp(x)) without overflow
+  static inline float softplus(float x) {
+    if (x > 0.0f) return x + log1pf(expf(-x));
+    return log1pf(expf(x));
+  }
+
+  static inline float sigmoid(float x) {
+    return 1.0f/(1.0f + expf(-x));
+  }
+
+  SampledOutputLossFunction::
+  SampledOutputLossFunction(unsigned int size, unsigned int num_samples,
+			    bool nce) :
+    LossFunction(size), accumulated_loss(0.0f), N(0),
+    num_samples(num_samples), nce(nce),
+    exact_loss(new MultiClassCrossEntropyLossFunction(size)) {
+    if (num_samples == 0 || num_samples+1 >= size)
+      ERROR_EXIT(128, "The number of samples must be > 0 and less than "
+		 "size-1\n");
+    IncRef(exact_loss);
+  }
+
+  SampledOutputLossFunction::
+  SampledOutputLossFunction(unsigned int size, unsigned int num_samples,
+			    bool nce, float accumulated_loss,
+			    unsigned int N) :
+    LossFunction(size), accumulated_loss(accumulated_loss), N(N),
+    num_samples(num_samples), nce(nce),
+    exact_loss(new MultiClassCrossEntropyLossFunction(size)) {
+    IncRef(exact_loss);
+  }
+  
+  SampledOutputLossFunction::~SampledOutputLossFunction() {
+    DecRef(exact_loss);
+  }
+
+  unsigned int SampledOutputLossFunction::getBunchSize(Token *target) {
+    switch(target->getTokenCode()) {
+    case table_of_token_codes::token_class_indices:
+      return target->convertTo<TokenClassIndices*>()->getUsedSize();
+    case table_of_token_codes::token_mem_block:
+      return target->convertTo<TokenMemoryBlock*>()->getUsedSize() / size;
+    default:
+      ERROR_EXIT(128, "Incorrect target token type, expected memory block "
+		 "or class indices\n");
+    }
+    return 0;
+  }
+
+  float SampledOutputLossFunction::
+  sampledLossAndGradient(TokenMemoryBlock *input, Token *target,
+			 float *gradient) {
+    unsigned int bunch_size = getBunchSize(target);
+    const float *weights = 0;
+    if (target->getTokenCode() == table_of_token_codes::token_class_indices) {
+      FloatGPUMirroredMemoryBlock *w =
+	target->convertTo<TokenClassIndices*>()->getWeights();
+      if (w != 0) weights = w->getPPALForRead();
+    }
+    const float *scores = input->getMemBlock()->getPPALForRead();
+    const unsigned int rows = num_samples + 1;
+    double loss = 0.0;
+    for (unsigned int b=0; b<bunch_size; ++b) {
+      float pattern_loss = 0.0f;
+      float weight = (weights != 0) ? weights[b] : 1.0f;
+      if (nce) {
+	// the target is a true sample, and the others are noise samples
+	float s = scores[b];
+	pattern_loss = softplus(-s);
+	if (gradient) gradient[b] = weight*(sigmoid(s) - 1.0f);
+	for (unsigned int j=1; j<rows; ++j) {
+	  s = scores[j*bunch_size + b];
+	  pattern_loss += softplus(s);
+	  if (gradient) gradient[j*bunch_size + b] = weight*sigmoid(s);
+	}
+      }
+      else {
+	// softmax over the target and the samples
+	float max = scores[b];
+	for (unsigned int j=1; j<rows; ++j)
+	  if (scores[j*bunch_size + b] > max) max = scores[j*bunch_size + b];
+	float sum = 0.0f;
+	for (unsigned int j=0; j<rows; ++j)
+	  sum += expf(scores[j*bunch_size + b] - max);
+	float lse = max + logf(sum);
+	pattern_loss = lse - scores[b];
+	if (gradient) {
+	  for (unsigned int j=0; j<rows; ++j)
+	    gradient[j*bunch_size + b] =
+	      weight*expf(scores[j*bunch_size + b] - lse);
+	  gradient[b] -= weight;
+	}
+      }
+      loss += weight*pattern_loss;
+    }
+    return static_cast<float>(loss/bunch_size);
+  }
+  
+  float SampledOutputLossFunction::addLoss(Token *input, Token *target) {
+    if (input->getTokenCode() != table_of_token_codes::token_mem_block)
+      ERROR_EXIT(128, "Incorrect input token type, expected memory block\n");
+    TokenMemoryBlock *input_mem_token = input->convertTo<TokenMemoryBlock*>();
+    unsigned int bunch_size = getBunchSize(target);
+    float loss;
+    if (input_mem_token->getUsedSize() == bunch_size*(num_samples + 1))
+      loss = sampledLossAndGradient(input_mem_token, target, 0);
+    else loss = exact_loss->addLoss(input, target);
+    accumulated_loss += loss;
+    ++N;
+    return loss;
+  }
+
+  Token *SampledOutputLossFunction::computeGradient(Token *input, Token *target) {
+    Token *gradient;
+    float loss = computeLossAndGradient(input, target, gradient);
+    // computeLossAndGradient accumulates the loss
+    accumulated_loss -= loss;
+    --N;
+    return gradient;
+  }
+  
+  float SampledOutputLossFunction::computeLossAndGradient(Token *input,
+							   Token *target,
+							   Token *&gradient) {
+    if (input->getTokenCode() != table_of_token_codes::token_mem_block)
+      ERROR_EXIT(128, "Incorrect input token type, expected memory block\n");
+    TokenMemoryBlock *input_mem_token = input->convertTo<TokenMemoryBlock*>();
+    unsigned int bunch_size = getBunchSize(target);
+    float loss;
+    if (input_mem_token->getUsedSize() == bunch_size*(num_samples + 1)) {
+      TokenMemoryBlock *error_mem_block;
+      error_mem_block = getErrorOutputMemBlock(input_mem_token->getUsedSize());
+      float *gradient_ptr = error_mem_block->getMemBlock()->getPPALForWrite();
+      loss     = sampledLossAndGradient(input_mem_token, target, gradient_ptr);
+      gradient = error_output;
+    }
+    else {
+      loss = exact_loss->computeLossAndGradient(input, target, gradient);
+      AssignRef(error_output, gradient);
+      exact_loss->reset();
+    }
+    accumulated_loss += loss;
+    ++N;
+    return loss;
+  }
+
+  float SampledOutputLossFunction::getAccumLoss() {
+    return accumulated_loss/N;
+  }
+   
+  void SampledOutputLossFunction::reset() {
+    LossFunction::reset();
+    exact_loss->reset();
+    accumulated_loss = 0.0f;
+    N = 0;
+  }
+}
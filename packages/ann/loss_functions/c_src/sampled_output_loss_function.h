@@ -0,0 +1,74 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Salvador España-Boquera, Adrian Palacios, Francisco Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef SAMPLEDOUTPUTLOSSFUNCTION_H
+#define SAMPLEDOUTPUTLOSSFUNCTION_H
+
+#include "referenced.h"
+#include "token_base.h"
+#include "loss_function.h"
+#include "multiclass_cross_entropy_loss_function.h"
+
+namespace ANN {
+  /// Loss of the sampled outputs of SampledOutputANNComponent. Its input are
+  /// the (num_samples+1) x bunch_size scores of the target (first row) and
+  /// the samples of each pattern, and the loss is computed following
+  /// noise-contrastive estimation (nce=true) or the importance sampled
+  /// softmax (nce=false). Inputs with size x bunch_size values are the exact
+  /// log probabilities of all the outputs (validation), and their loss is the
+  /// multi-class cross entropy. The target could be class indices or one-hot
+  /// memory blocks, as in MultiClassCrossEntropyLossFunction.
+  class SampledOutputLossFunction : public LossFunction {
+    float accumulated_loss;
+    unsigned int N;
+    unsigned int num_samples;
+    bool nce;
+    MultiClassCrossEntropyLossFunction *exact_loss;
+    SampledOutputLossFunction(unsigned int size, unsigned int num_samples,
+			      bool nce, float accumulated_loss,
+			      unsigned int N);
+    unsigned int getBunchSize(Token *target);
+    float sampledLossAndGradient(TokenMemoryBlock *input, Token *target,
+				 float *gradient);
+  public:
+    SampledOutputLossFunction(unsigned int size, unsigned int num_samples,
+			      bool nce);
+    virtual ~SampledOutputLossFunction();
+    virtual float  addLoss(Token *input, Token *target);
+    virtual Token *computeGradient(Token *input, Token *target);
+    virtual float  computeLossAndGradient(Token *input, Token *target,
+					  Token *&gradient);
+    virtual float  getAccumLoss();
+    virtual void   reset();
+    virtual LossFunction *clone() {
+      return new SampledOutputLossFunction(size, num_samples, nce,
+					   accumulated_loss, N);
+    }
+    virtual void accumulateLoss(LossFunction *other) {
+      SampledOutputLossFunction *o = static_cast<SampledOutputLossFunction*>(other);
+      accumulated_loss += o->accumulated_loss;
+      N                += o->N;
+    }
+    unsigned int getNumSamples() const { return num_samples; }
+    bool isNCE() const { return nce; }
+  };
+}
+
+#endif // SAMPLEDOUTPUTLOSSFUNCTION_H
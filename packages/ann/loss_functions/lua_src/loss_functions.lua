@@ -72,6 +72,30 @@ april_set_doc("ann.loss.__base__.gradient",
 
 -------------------------------------------------------------------
 
+april_set_doc("ann.loss.__base__.loss_and_gradient",
+	      {
+		class="method",
+		summary="Computes the loss and its gradient at once",
+		description={
+		  "It is equivalent to call loss and gradient methods, but",
+		  "both are computed traversing the tokens once.",
+		  "The loss is accumulated in its internal state.",
+		  "The gradient token is reused by the next call only when",
+		  "nobody else references it, so a gradient kept by the",
+		  "caller is never overwritten.",
+		},
+		params={
+		  "Input token",
+		  "Target token",
+		},
+		outputs = {
+		  "The loss computed for this pair of tokens",
+		  "The gradient computed for this pair of tokens",
+		},
+	      })
+
+-------------------------------------------------------------------
+
 april_set_doc("ann.loss.__base__.get_accum_loss",
 	      {
 		class="method",
@@ -176,6 +200,10 @@ april_set_doc("ann.loss.multi_class_cross_entropy",
 		  "It only works with log_logistic or log_softmax",
 		  "activation funtions,",
 		  "and is mandataory to have more than two output units.",
+		  "The target could be a memory block (one-hot patterns) or",
+		  "a tokens.class_indices (see dataset.token.class_index),",
+		  "which only gives the index of the true class, and",
+		  "optionally a weight, of each pattern.",
 		}
 	      })
 
@@ -221,3 +249,40 @@ april_set_doc("ann.loss.local_fmeasure.__call",
 		outputs={ "An instance of ann.loss.local_fmeasure" },
 	      })
 
+
+-------------------------------------------------------------------
+
+april_set_doc("ann.loss.sampled_output",
+	      {
+		class="class",
+		summary="Loss of the sampled outputs of ann.components.sampled_output",
+		description={
+		  "During training, ann.components.sampled_output computes",
+		  "the scores of the target and of num_samples noise samples",
+		  "of each pattern, and this loss function computes",
+		  "noise-contrastive estimation (mode='nce') or the",
+		  "importance sampled softmax (mode='softmax') over them.",
+		  "Exact outputs (log probabilities of all the outputs) are",
+		  "evaluated with the multi-class cross-entropy, so the same",
+		  "loss could be used for validation.",
+		  "The target could be a memory block (one-hot patterns) or",
+		  "a tokens.class_indices (see dataset.token.class_index).",
+		}
+	      })
+
+april_set_doc("ann.loss.sampled_output.__call",
+	      {
+		class="method",
+		summary="Constructor",
+		params={
+		  ["size"]="The number of outputs of the component",
+		  ["num_samples"]={
+		    "The number of samples, equal to num_samples of",
+		    "the component",
+		  },
+		  ["mode"]={
+		    "nce or softmax [optional], by default is nce",
+		  },
+		},
+		outputs={ "An instance of ann.loss.sampled_output" },
+	      })
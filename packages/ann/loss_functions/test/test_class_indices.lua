@@ -0,0 +1,86 @@
+-- Checks that ann.loss.multi_class_cross_entropy computes the same loss and
+-- gradient with sparse class indices targets than with one-hot targets
+local nump, isz, osz, bunch = 60, 5, 4, 6
+local rnd = random(1234)
+
+local function equals(a, b, eps)
+  assert(#a == #b)
+  for i=1,#a do
+    if math.abs(a[i] - b[i]) > (eps or 1e-5) then return false end
+  end
+  return true
+end
+
+-- a bunch of log_softmax outputs, osz x bunch column-major bunch layout
+local logp = {}
+for b=1,bunch do
+  local v, sum = {}, 0
+  for i=1,osz do v[i] = rnd:rand(4) - 2 sum = sum + math.exp(v[i]) end
+  for i=1,osz do logp[(i-1)*bunch + b] = v[i] - math.log(sum) end
+end
+local classes, weights = {}, {}
+for b=1,bunch do classes[b], weights[b] = rnd:randInt(1,osz), rnd:rand(2) end
+local onehot, weighted = {}, {}
+for i=1,osz*bunch do onehot[i] = 0 end
+for b=1,bunch do onehot[(classes[b]-1)*bunch + b] = 1 end
+
+local input  = tokens.memblock(logp)
+local sparse = tokens.class_indices(classes, osz)
+assert(equals(sparse:to_table(), classes))
+local loss   = ann.loss.multi_class_cross_entropy(osz)
+local l1 = loss:loss(input, tokens.memblock(onehot))
+local g1 = loss:gradient(input, tokens.memblock(onehot)):convert_to_memblock():to_table()
+local l2 = loss:loss(input, sparse)
+local g2 = loss:gradient(input, sparse):convert_to_memblock():to_table()
+assert(math.abs(l1 - l2) < 1e-5)
+assert(equals(g1, g2))
+
+-- weights scale the loss and the gradient of each pattern
+local wsparse = tokens.class_indices(classes, osz, weights)
+local _,w = wsparse:to_table()
+assert(equals(w, weights))
+local l3 = loss:loss(input, wsparse)
+local g3 = loss:gradient(input, wsparse):convert_to_memblock():to_table()
+local expected = 0
+for b=1,bunch do
+  expected = expected - weights[b]*logp[(classes[b]-1)*bunch + b]
+end
+assert(math.abs(l3 - expected/bunch) < 1e-5)
+for i=1,osz*bunch do g1[i] = g1[i] * weights[(i-1)%bunch + 1] end
+assert(equals(g1, g3))
+
+-- training with dataset.token.class_index is equivalent to use one-hot
+-- patterns from dataset.indexed
+local m_in = matrix(nump, isz)
+for i=1,nump do for j=1,isz do m_in:set(i,j, rnd:rand(2)-1) end end
+local m_cls = matrix(nump, 1)
+for i=1,nump do m_cls:set(i, 1, rnd:randInt(1,osz)) end
+local ds_in, ds_cls = dataset.matrix(m_in), dataset.matrix(m_cls)
+local identity = dataset.identity(osz)
+
+local function run(output_dataset)
+  local net = ann.mlp.all_all.generate(isz.." inputs 8 tanh "..osz.." log_softmax")
+  local tr  = trainable.supervised_trainer(net,
+					   ann.loss.multi_class_cross_entropy(osz),
+					   bunch)
+  tr:build()
+  tr:randomize_weights{ random=random(52), inf=-0.5, sup=0.5 }
+  net:set_option("learning_rate", 0.1)
+  local losses = {}
+  for e=1,3 do
+    table.insert(losses, tr:train_dataset{ input_dataset  = ds_in,
+					   output_dataset = output_dataset,
+					   shuffle        = random(e) })
+  end
+  table.insert(losses, tr:validate_dataset{ input_dataset  = ds_in,
+					    output_dataset = output_dataset })
+  return losses
+end
+
+local dense  = run(dataset.indexed(ds_cls, { identity }))
+local sparse = run(dataset.token.class_index(ds_cls, osz))
+assert(equals(dense, sparse, 1e-4))
+
+-- out of range class indices are errors
+assert(not pcall(tokens.class_indices, { osz+1 }, osz))
+print("OK")
@@ -0,0 +1,78 @@
+-- Checks that loss_and_gradient gives the same loss and gradient than loss
+-- and gradient methods, for every loss function
+local rnd = random(825)
+
+local function equals(a, b, eps)
+  assert(#a == #b)
+  for i=1,#a do
+    if math.abs(a[i] - b[i]) > (eps or 1e-5) then return false end
+  end
+  return true
+end
+
+-- random outputs and targets for a bunch, kind is the kind of the outputs
+local function bunch_tokens(size, bunch, kind)
+  local out, tgt = {}, {}
+  for b=1,bunch do
+    local class = rnd:randInt(1,size)
+    local sum = 0
+    for i=1,size do
+      local pos = (i-1)*bunch + b
+      if kind == "log_softmax" then
+	out[pos] = rnd:rand(4) - 2
+	sum = sum + math.exp(out[pos])
+	tgt[pos] = (i == class) and 1 or 0
+      elseif kind == "log_logistic" then
+	out[pos] = math.log(rnd:rand(0.98) + 0.01)
+	tgt[pos] = rnd:randInt(0,1)
+      elseif kind == "logistic" then
+	out[pos] = rnd:rand()
+	tgt[pos] = rnd:randInt(0,1)
+      else
+	out[pos] = rnd:rand(2) - 1
+	tgt[pos] = rnd:rand(2) - 1
+      end
+    end
+    if kind == "log_softmax" then
+      for i=1,size do
+	local pos = (i-1)*bunch + b
+	out[pos] = out[pos] - math.log(sum)
+      end
+    end
+  end
+  return tokens.memblock(out), tokens.memblock(tgt)
+end
+
+local losses = {
+  { ann.loss.mse(5), 5, "linear" },
+  { ann.loss.mae(5), 5, "linear" },
+  { ann.loss.cross_entropy(1), 1, "log_logistic" },
+  { ann.loss.multi_class_cross_entropy(6), 6, "log_softmax" },
+  { ann.loss.local_fmeasure{ size=1 }, 1, "logistic" },
+}
+for _,data in ipairs(losses) do
+  local loss, size, kind = unpack(data)
+  local fused = loss:clone()
+  -- the gradient buffer is reused with different bunch sizes
+  for _,bunch in ipairs{ 8, 3, 8, 1 } do
+    local input, target = bunch_tokens(size, bunch, kind)
+    local l1 = loss:loss(input, target)
+    local g1 = loss:gradient(input, target):convert_to_memblock():to_table()
+    local l2, g2 = fused:loss_and_gradient(input, target)
+    g2 = g2:convert_to_memblock():to_table()
+    assert(math.abs(l1 - l2) < 1e-5)
+    assert(equals(g1, g2))
+  end
+  assert(math.abs(loss:get_accum_loss() - fused:get_accum_loss()) < 1e-5)
+end
+
+-- sparse class indices targets
+local loss  = ann.loss.multi_class_cross_entropy(6)
+local input = bunch_tokens(6, 4, "log_softmax")
+local target = tokens.class_indices({ 2, 6, 1, 3 }, 6, { 1, 0.5, 2, 1 })
+local l1 = loss:loss(input, target)
+local g1 = loss:gradient(input, target):convert_to_memblock():to_table()
+local l2, g2 = loss:loss_and_gradient(input, target)
+assert(math.abs(l1 - l2) < 1e-5)
+assert(equals(g1, g2:convert_to_memblock():to_table()))
+print("OK")
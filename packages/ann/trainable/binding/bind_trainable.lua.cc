@@ -0,0 +1,275 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+//BIND_HEADER_C
+#include "bind_ann_base.h"
+#include "bind_loss_functions.h"
+#include "bind_dataset.h"
+#include "bind_mtrand.h"
+//BIND_END
+
+//BIND_HEADER_H
+#include "index_source.h"
+#include "epoch_driver.h"
+
+using namespace ANN;
+
+//BIND_END
+
+/////////////////////////////////////////////////////
+//                   IndexSource                   //
+/////////////////////////////////////////////////////
+
+//BIND_LUACLASSNAME IndexSource trainable.index_source
+//BIND_CPP_CLASS    IndexSource
+
+//BIND_CONSTRUCTOR IndexSource
+{
+  LUABIND_ERROR("Abstract class!!!");
+}
+//BIND_END
+
+//BIND_METHOD IndexSource size
+{
+  LUABIND_RETURN(uint, obj->size());
+}
+//BIND_END
+
+//BIND_METHOD IndexSource next
+//DOC_BEGIN
+// table next(max)
+/// Returns a table with at most max indexes (starting at 0, as
+/// getPatternBunch needs) or nil when the sequence is finished.
+//DOC_END
+{
+  unsigned int max, n;
+  LUABIND_CHECK_ARGN(==, 1);
+  LUABIND_GET_PARAMETER(1, uint, max);
+  if (max == 0) LUABIND_ERROR("max must be > 0");
+  int *indexes = new int[max];
+  n = obj->next(indexes, max);
+  if (n > 0) {
+    lua_createtable(L, n, 0);
+    for (unsigned int i=0; i<n; ++i) {
+      lua_pushnumber(L, indexes[i]);
+      lua_rawseti(L, -2, i+1);
+    }
+  }
+  delete[] indexes;
+  if (n == 0) LUABIND_RETURN_NIL();
+  else LUABIND_RETURN_FROM_STACK(-1);
+}
+//BIND_END
+
+//BIND_LUACLASSNAME SequentialIndexSource trainable.index_source.sequential
+//BIND_CPP_CLASS    SequentialIndexSource
+//BIND_SUBCLASS_OF  SequentialIndexSource IndexSource
+
+//BIND_CONSTRUCTOR SequentialIndexSource
+//DOC_BEGIN
+// sequential(num_patterns)
+/// Indexes of the patterns in order.
+//DOC_END
+{
+  unsigned int num_patterns;
+  LUABIND_CHECK_ARGN(==, 1);
+  LUABIND_GET_PARAMETER(1, uint, num_patterns);
+  obj = new SequentialIndexSource(num_patterns);
+  LUABIND_RETURN(SequentialIndexSource, obj);
+}
+//BIND_END
+
+//BIND_LUACLASSNAME ShuffleIndexSource trainable.index_source.shuffle
+//BIND_CPP_CLASS    ShuffleIndexSource
+//BIND_SUBCLASS_OF  ShuffleIndexSource IndexSource
+
+//BIND_CONSTRUCTOR ShuffleIndexSource
+//DOC_BEGIN
+// shuffle(num_patterns, random)
+/// Indexes of the patterns in the order given by random:shuffle(num_patterns).
+//DOC_END
+{
+  unsigned int num_patterns;
+  MTRand *rnd;
+  LUABIND_CHECK_ARGN(==, 2);
+  LUABIND_GET_PARAMETER(1, uint, num_patterns);
+  LUABIND_GET_PARAMETER(2, MTRand, rnd);
+  obj = new ShuffleIndexSource(num_patterns, rnd);
+  LUABIND_RETURN(ShuffleIndexSource, obj);
+}
+//BIND_END
+
+//BIND_LUACLASSNAME ImplicitShuffleIndexSource trainable.index_source.implicit_shuffle
+//BIND_CPP_CLASS    ImplicitShuffleIndexSource
+//BIND_SUBCLASS_OF  ImplicitShuffleIndexSource IndexSource
+
+//BIND_CONSTRUCTOR ImplicitShuffleIndexSource
+//DOC_BEGIN
+// implicit_shuffle(num_patterns, random)
+/// Indexes of the patterns following a pseudo-random permutation which
+/// is computed on demand, without memory.
+//DOC_END
+{
+  unsigned int num_patterns;
+  MTRand *rnd;
+  LUABIND_CHECK_ARGN(==, 2);
+  LUABIND_GET_PARAMETER(1, uint, num_patterns);
+  LUABIND_GET_PARAMETER(2, MTRand, rnd);
+  obj = new ImplicitShuffleIndexSource(num_patterns, rnd);
+  LUABIND_RETURN(ImplicitShuffleIndexSource, obj);
+}
+//BIND_END
+
+//BIND_LUACLASSNAME ReplacementIndexSource trainable.index_source.replacement
+//BIND_CPP_CLASS    ReplacementIndexSource
+//BIND_SUBCLASS_OF  ReplacementIndexSource IndexSource
+
+//BIND_CONSTRUCTOR ReplacementIndexSource
+//DOC_BEGIN
+// replacement(num_patterns, replacement, random)
+/// replacement indexes sampled uniformly with replacement.
+//DOC_END
+{
+  unsigned int num_patterns, replacement;
+  MTRand *rnd;
+  LUABIND_CHECK_ARGN(==, 3);
+  LUABIND_GET_PARAMETER(1, uint, num_patterns);
+  LUABIND_GET_PARAMETER(2, uint, replacement);
+  LUABIND_GET_PARAMETER(3, MTRand, rnd);
+  obj = new ReplacementIndexSource(num_patterns, replacement, rnd);
+  LUABIND_RETURN(ReplacementIndexSource, obj);
+}
+//BIND_END
+
+//BIND_LUACLASSNAME DistributionIndexSource trainable.index_source.distribution
+//BIND_CPP_CLASS    DistributionIndexSource
+//BIND_SUBCLASS_OF  DistributionIndexSource IndexSource
+
+//BIND_CONSTRUCTOR DistributionIndexSource
+//DOC_BEGIN
+// distribution(dice, sizes, replacement, random)
+/// replacement indexes sampled from the union of datasets with the given
+/// sizes, choosing first the dataset with the given random.dice.
+//DOC_END
+{
+  dice *the_dice;
+  unsigned int *sizes, num_sizes, replacement;
+  MTRand *rnd;
+  LUABIND_CHECK_ARGN(==, 4);
+  LUABIND_GET_PARAMETER(1, dice, the_dice);
+  LUABIND_CHECK_PARAMETER(2, table);
+  LUABIND_TABLE_GETN(2, num_sizes);
+  if (static_cast<int>(num_sizes) != the_dice->get_outcomes())
+    LUABIND_FERROR2("Incorrect number of sizes, expected %d, found %d",
+		    the_dice->get_outcomes(), num_sizes);
+  sizes = new unsigned int[num_sizes];
+  LUABIND_TABLE_TO_VECTOR(2, uint, sizes, num_sizes);
+  LUABIND_GET_PARAMETER(3, uint, replacement);
+  LUABIND_GET_PARAMETER(4, MTRand, rnd);
+  obj = new DistributionIndexSource(the_dice, sizes, replacement, rnd);
+  delete[] sizes;
+  LUABIND_RETURN(DistributionIndexSource, obj);
+}
+//BIND_END
+
+/////////////////////////////////////////////////////
+//                   EpochDriver                   //
+/////////////////////////////////////////////////////
+
+//BIND_FUNCTION trainable.epoch_driver.train_dataset
+//DOC_BEGIN
+// float train_dataset(component, loss, input_dataset, output_dataset, index_source, bunch_size)
+/// Executes one training epoch natively, returns the accumulated loss.
+//DOC_END
+{
+  ANNComponent *component;
+  LossFunction *loss;
+  DataSetToken *input_dataset, *output_dataset;
+  IndexSource  *index_source;
+  unsigned int  bunch_size;
+  LUABIND_CHECK_ARGN(==, 6);
+  LUABIND_GET_PARAMETER(1, ANNComponent, component);
+  LUABIND_GET_PARAMETER(2, LossFunction, loss);
+  LUABIND_GET_PARAMETER(3, DataSetToken, input_dataset);
+  LUABIND_GET_PARAMETER(4, DataSetToken, output_dataset);
+  LUABIND_GET_PARAMETER(5, IndexSource, index_source);
+  LUABIND_GET_PARAMETER(6, uint, bunch_size);
+  LUABIND_RETURN(float, EpochDriver::trainDataset(component, loss,
+						  input_dataset,
+						  output_dataset,
+						  index_source,
+						  bunch_size));
+}
+//BIND_END
+
+//BIND_FUNCTION trainable.epoch_driver.validate_dataset
+//DOC_BEGIN
+// float validate_dataset(component, loss, input_dataset, output_dataset, index_source, bunch_size, num_threads=1)
+/// Executes one validation epoch natively, returns the accumulated loss.
+/// With num_threads > 1 the bunches are computed in parallel by clones of
+/// the component.
+//DOC_END
+{
+  ANNComponent *component;
+  LossFunction *loss;
+  DataSetToken *input_dataset, *output_dataset;
+  IndexSource  *index_source;
+  unsigned int  bunch_size, num_threads;
+  LUABIND_CHECK_ARGN(>=, 6);
+  LUABIND_CHECK_ARGN(<=, 7);
+  LUABIND_GET_PARAMETER(1, ANNComponent, component);
+  LUABIND_GET_PARAMETER(2, LossFunction, loss);
+  LUABIND_GET_PARAMETER(3, DataSetToken, input_dataset);
+  LUABIND_GET_PARAMETER(4, DataSetToken, output_dataset);
+  LUABIND_GET_PARAMETER(5, IndexSource, index_source);
+  LUABIND_GET_PARAMETER(6, uint, bunch_size);
+  LUABIND_GET_OPTIONAL_PARAMETER(7, uint, num_threads, 1);
+  LUABIND_RETURN(float, EpochDriver::validateDataset(component, loss,
+						     input_dataset,
+						     output_dataset,
+						     index_source,
+						     bunch_size,
+						     num_threads));
+}
+//BIND_END
+
+//BIND_FUNCTION trainable.epoch_driver.use_dataset
+//DOC_BEGIN
+// use_dataset(component, input_dataset, output_dataset, bunch_size, num_threads=1)
+/// Computes natively the forward of all input_dataset patterns, storing
+/// the outputs at output_dataset. With num_threads > 1 the bunches are
+/// computed in parallel by clones of the component.
+//DOC_END
+{
+  ANNComponent *component;
+  DataSetToken *input_dataset, *output_dataset;
+  unsigned int  bunch_size, num_threads;
+  LUABIND_CHECK_ARGN(>=, 4);
+  LUABIND_CHECK_ARGN(<=, 5);
+  LUABIND_GET_PARAMETER(1, ANNComponent, component);
+  LUABIND_GET_PARAMETER(2, DataSetToken, input_dataset);
+  LUABIND_GET_PARAMETER(3, DataSetToken, output_dataset);
+  LUABIND_GET_PARAMETER(4, uint, bunch_size);
+  LUABIND_GET_OPTIONAL_PARAMETER(5, uint, num_threads, 1);
+  EpochDriver::useDataset(component, input_dataset, output_dataset,
+			  bunch_size, num_threads);
+}
+//BIND_END
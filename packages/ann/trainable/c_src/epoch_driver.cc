@@ -0,0 +1,298 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include <pthread.h>
+#include "epoch_driver.h"
+#include "component_replicas.h"
+#include "parallel_for.h"
+#include "error_print.h"
+
+/// Minimum number of indexes requested to the IndexSource at once
+#define INDEX_CHUNK_SIZE 4096
+/// Number of bunches of each worker between two synchronizations of the
+/// parallel inference
+#define PARALLEL_BUNCHES_PER_WORKER 16
+
+namespace ANN {
+
+  /// Splits in bunches the indexes of an IndexSource, which are requested in
+  /// chunks of several bunches
+  class BunchReader {
+    IndexSource  *index_source;
+    int          *buffer;
+    unsigned int  bunch_size, capacity, first, last;
+    bool          finished;
+  public:
+    BunchReader(IndexSource *index_source, unsigned int bunch_size) :
+      index_source(index_source), bunch_size(bunch_size),
+      first(0), last(0), finished(false) {
+      capacity = ((INDEX_CHUNK_SIZE + bunch_size - 1)/bunch_size)*bunch_size;
+      buffer   = new int[capacity];
+    }
+    ~BunchReader() {
+      delete[] buffer;
+    }
+    /// Points indexes to the next bunch, and returns its size (only the last
+    /// one could be smaller than bunch_size), zero when finished
+    unsigned int next(const int **indexes) {
+      if (last - first < bunch_size && !finished) {
+	// moves the remaining indexes to the beginning and fills the buffer
+	for (unsigned int i=first; i<last; ++i) buffer[i-first] = buffer[i];
+	last -= first;
+	first = 0;
+	while (last < capacity && !finished) {
+	  unsigned int n = index_source->next(buffer + last, capacity - last);
+	  if (n == 0) finished = true;
+	  last += n;
+	}
+      }
+      unsigned int n = last - first;
+      if (n > bunch_size) n = bunch_size;
+      *indexes = buffer + first;
+      first   += n;
+      return n;
+    }
+  };
+
+  /// Components (and loss functions) used by the workers of the parallel
+  /// inference, the components are ComponentReplicas of the given one
+  class InferenceWorkers {
+    ComponentReplicas replicas;
+    april_utils::vector<LossFunction*> losses;
+  public:
+    InferenceWorkers(ANNComponent *component, LossFunction *loss_function,
+		     unsigned int num_workers) :
+      replicas(component, num_workers) {
+      if (loss_function != 0) {
+	for (unsigned int w=0; w<num_workers; ++w) {
+	  LossFunction *loss = loss_function->clone();
+	  IncRef(loss);
+	  loss->reset();
+	  losses.push_back(loss);
+	}
+      }
+    }
+    ~InferenceWorkers() {
+      for (unsigned int w=0; w<losses.size(); ++w) DecRef(losses[w]);
+    }
+    unsigned int size() const { return replicas.size(); }
+    ANNComponent *getComponent(unsigned int w) { return replicas.get(w); }
+    LossFunction *getLoss(unsigned int w) {
+      return (losses.size() > 0) ? losses[w] : 0;
+    }
+  };
+
+  /// Forward (and loss when the workers have loss functions) of a round of
+  /// bunches, distributed in contiguous blocks among the workers. Datasets
+  /// are not thread-safe, so they are used under dataset_mutex.
+  struct InferenceRound {
+    InferenceWorkers *workers;
+    DataSetToken     *input_dataset, *output_dataset;
+    const int        *indexes;
+    unsigned int      num_indexes, bunch_size;
+    pthread_mutex_t   dataset_mutex;
+    
+    void operator()(unsigned int w) {
+      ANNComponent *component = workers->getComponent(w);
+      LossFunction *loss      = workers->getLoss(w);
+      unsigned int num_bunches = (num_indexes + bunch_size - 1) / bunch_size;
+      unsigned int first = (num_bunches * w) / workers->size();
+      unsigned int last  = (num_bunches * (w+1)) / workers->size();
+      for (unsigned int b=first; b<last; ++b) {
+	const int *bunch_indexes = indexes + b*bunch_size;
+	unsigned int n = num_indexes - b*bunch_size;
+	if (n > bunch_size) n = bunch_size;
+	Token *target = 0;
+	pthread_mutex_lock(&dataset_mutex);
+	Token *input  = input_dataset->getPatternBunch(bunch_indexes, n);
+	if (loss != 0)
+	  target = output_dataset->getPatternBunch(bunch_indexes, n);
+	pthread_mutex_unlock(&dataset_mutex);
+	IncRef(input);
+	if (loss != 0) {
+	  IncRef(target);
+	  component->reset();
+	  Token *output = component->doForward(input, false);
+	  loss->addLoss(output, target);
+	  DecRef(target);
+	}
+	else {
+	  Token *output = component->doForward(input, false);
+	  pthread_mutex_lock(&dataset_mutex);
+	  output_dataset->putPatternBunch(bunch_indexes, n, output);
+	  pthread_mutex_unlock(&dataset_mutex);
+	}
+	DecRef(input);
+      }
+    }
+  };
+
+  /// Executes the parallel inference of all the index_source bunches, and
+  /// reduces the workers losses into loss_function (if it is not NULL)
+  static void parallelInference(ANNComponent *component,
+				LossFunction *loss_function,
+				DataSetToken *input_dataset,
+				DataSetToken *output_dataset,
+				IndexSource *index_source,
+				unsigned int bunch_size,
+				unsigned int num_threads) {
+    if (!component->getIsBuilt())
+      ERROR_EXIT(128, "Parallel inference needs a built component\n");
+    // more workers than bunches are useless
+    unsigned int num_bunches = (index_source->size() + bunch_size - 1) / bunch_size;
+    if (num_threads > num_bunches) num_threads = (num_bunches > 0) ? num_bunches : 1;
+    InferenceWorkers workers(component, loss_function, num_threads);
+    // the threads are alive during all the rounds
+    april_utils::WorkerThreads threads(num_threads);
+    unsigned int capacity = num_threads*PARALLEL_BUNCHES_PER_WORKER*bunch_size;
+    int *indexes = new int[capacity];
+    InferenceRound round;
+    round.workers        = &workers;
+    round.input_dataset  = input_dataset;
+    round.output_dataset = output_dataset;
+    round.indexes        = indexes;
+    round.bunch_size     = bunch_size;
+    pthread_mutex_init(&round.dataset_mutex, 0);
+    bool finished = false;
+    while (!finished) {
+      unsigned int n = 0;
+      while (n < capacity && !finished) {
+	unsigned int m = index_source->next(indexes + n, capacity - n);
+	if (m == 0) finished = true;
+	n += m;
+      }
+      if (n == 0) break;
+      round.num_indexes = n;
+      threads.run(round);
+    }
+    pthread_mutex_destroy(&round.dataset_mutex);
+    delete[] indexes;
+    if (loss_function != 0) {
+      loss_function->reset();
+      for (unsigned int w=0; w<workers.size(); ++w)
+	loss_function->accumulateLoss(workers.getLoss(w));
+    }
+  }
+
+  static void checkDatasets(DataSetToken *input_dataset,
+			    DataSetToken *output_dataset,
+			    unsigned int bunch_size) {
+    if (bunch_size == 0)
+      ERROR_EXIT(128, "Impossible to use ZERO bunch_size\n");
+    if (input_dataset->numPatterns() != output_dataset->numPatterns())
+      ERROR_EXIT2(128, "Different input/output datasets numPatterns "
+		  "found: %d != %d\n",
+		  input_dataset->numPatterns(),
+		  output_dataset->numPatterns());
+  }
+
+  float EpochDriver::trainDataset(ANNComponent *component,
+				  LossFunction *loss_function,
+				  DataSetToken *input_dataset,
+				  DataSetToken *output_dataset,
+				  IndexSource *index_source,
+				  unsigned int bunch_size) {
+    checkDatasets(input_dataset, output_dataset, bunch_size);
+    BunchReader bunch_reader(index_source, bunch_size);
+    const int *bunch_indexes;
+    unsigned int n;
+    loss_function->reset();
+    while( (n = bunch_reader.next(&bunch_indexes)) > 0 ) {
+      Token *input  = input_dataset->getPatternBunch(bunch_indexes, n);
+      Token *target = output_dataset->getPatternBunch(bunch_indexes, n);
+      IncRef(input);
+      IncRef(target);
+      component->reset();
+      component->setTarget(target);
+      Token *output   = component->doForward(input, true);
+      Token *gradient;
+      loss_function->computeLossAndGradient(output, target, gradient);
+      component->doBackprop(gradient);
+      component->doUpdate();
+      DecRef(input);
+      DecRef(target);
+    }
+    return loss_function->getAccumLoss();
+  }
+
+  float EpochDriver::validateDataset(ANNComponent *component,
+				     LossFunction *loss_function,
+				     DataSetToken *input_dataset,
+				     DataSetToken *output_dataset,
+				     IndexSource *index_source,
+				     unsigned int bunch_size,
+				     unsigned int num_threads) {
+    checkDatasets(input_dataset, output_dataset, bunch_size);
+    if (num_threads > 1 && !ComponentReplicas::isQuantized(component)) {
+      parallelInference(component, loss_function,
+			input_dataset, output_dataset,
+			index_source, bunch_size, num_threads);
+      return loss_function->getAccumLoss();
+    }
+    BunchReader bunch_reader(index_source, bunch_size);
+    const int *bunch_indexes;
+    unsigned int n;
+    loss_function->reset();
+    while( (n = bunch_reader.next(&bunch_indexes)) > 0 ) {
+      Token *input  = input_dataset->getPatternBunch(bunch_indexes, n);
+      Token *target = output_dataset->getPatternBunch(bunch_indexes, n);
+      IncRef(input);
+      IncRef(target);
+      component->reset();
+      Token *output = component->doForward(input, false);
+      loss_function->addLoss(output, target);
+      DecRef(input);
+      DecRef(target);
+    }
+    return loss_function->getAccumLoss();
+  }
+
+  void EpochDriver::useDataset(ANNComponent *component,
+			       DataSetToken *input_dataset,
+			       DataSetToken *output_dataset,
+			       unsigned int bunch_size,
+			       unsigned int num_threads) {
+    if (bunch_size == 0)
+      ERROR_EXIT(128, "Impossible to use ZERO bunch_size\n");
+    if (output_dataset->numPatterns() < input_dataset->numPatterns())
+      ERROR_EXIT2(128, "Not enough space at output_dataset, "
+		  "found %d, expected %d\n",
+		  output_dataset->numPatterns(),
+		  input_dataset->numPatterns());
+    SequentialIndexSource index_source(input_dataset->numPatterns());
+    if (num_threads > 1 && !ComponentReplicas::isQuantized(component)) {
+      parallelInference(component, 0, input_dataset, output_dataset,
+			&index_source, bunch_size, num_threads);
+      return;
+    }
+    BunchReader bunch_reader(&index_source, bunch_size);
+    const int *bunch_indexes;
+    unsigned int n;
+    while( (n = bunch_reader.next(&bunch_indexes)) > 0 ) {
+      Token *input  = input_dataset->getPatternBunch(bunch_indexes, n);
+      IncRef(input);
+      Token *output = component->doForward(input, false);
+      output_dataset->putPatternBunch(bunch_indexes, n, output);
+      DecRef(input);
+    }
+  }
+
+}
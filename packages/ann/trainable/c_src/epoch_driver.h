@@ -0,0 +1,73 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef EPOCH_DRIVER_H
+#define EPOCH_DRIVER_H
+
+#include "ann_component.h"
+#include "loss_function.h"
+#include "datasetToken.h"
+#include "index_source.h"
+
+namespace ANN {
+
+  /// Native loops over datasets used by trainable.supervised_trainer. Each
+  /// bunch is taken from the datasets following the given IndexSource, so no
+  /// Lua objects are created during the epoch.
+  class EpochDriver {
+  public:
+    /// Executes the training steps of one epoch (reset, forward with
+    /// during_training=true, loss, gradient, backprop and update for every
+    /// bunch). Returns the loss_function accumulated loss.
+    static float trainDataset(ANNComponent *component,
+			      LossFunction *loss_function,
+			      DataSetToken *input_dataset,
+			      DataSetToken *output_dataset,
+			      IndexSource *index_source,
+			      unsigned int bunch_size);
+    /// Executes the validation steps of one epoch (reset, forward and loss
+    /// for every bunch). Returns the loss_function accumulated loss. With
+    /// num_threads > 1 the bunches are distributed among clones of the
+    /// component (see useDataset).
+    static float validateDataset(ANNComponent *component,
+				 LossFunction *loss_function,
+				 DataSetToken *input_dataset,
+				 DataSetToken *output_dataset,
+				 IndexSource *index_source,
+				 unsigned int bunch_size,
+				 unsigned int num_threads=1);
+    /// Computes the forward of all input_dataset patterns in order, storing
+    /// the outputs at output_dataset. With num_threads > 1 the bunches are
+    /// distributed among num_threads clones of the component which share its
+    /// Connections, so the component must be built. Every clone has its own
+    /// thread during all the dataset, the number of threads is not limited
+    /// by util.set_num_threads (but it is never greater than the number of
+    /// bunches). Quantized components are always executed by one thread.
+    static void useDataset(ANNComponent *component,
+			   DataSetToken *input_dataset,
+			   DataSetToken *output_dataset,
+			   unsigned int bunch_size,
+			   unsigned int num_threads=1);
+  };
+
+}
+
+#endif // EPOCH_DRIVER_H
@@ -0,0 +1,168 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include "index_source.h"
+#include "error_print.h"
+
+namespace ANN {
+
+  unsigned int SequentialIndexSource::next(int *dest, unsigned int max) {
+    unsigned int n = num_patterns - pos;
+    if (n > max) n = max;
+    for (unsigned int i=0; i<n; ++i) dest[i] = static_cast<int>(pos + i);
+    pos += n;
+    return n;
+  }
+
+  ///////////////////////////////////////////////////////////////////////////
+
+  ShuffleIndexSource::ShuffleIndexSource(unsigned int num_patterns,
+					 MTRand *rnd) :
+    num_patterns(num_patterns), pos(0) {
+    if (num_patterns == 0)
+      ERROR_EXIT(128, "Impossible to shuffle ZERO patterns\n");
+    permutation = new uint32_t[num_patterns];
+    // the same Fisher-Yates algorithm as MTRand::shuffle
+    for (unsigned int i=0; i<num_patterns; ++i) permutation[i] = i;
+    for (unsigned int i=num_patterns-1; i>0; --i) {
+      uint32_t j    = rnd->randInt(i);
+      uint32_t swap = permutation[i];
+      permutation[i] = permutation[j];
+      permutation[j] = swap;
+    }
+  }
+
+  ShuffleIndexSource::~ShuffleIndexSource() {
+    delete[] permutation;
+  }
+
+  unsigned int ShuffleIndexSource::next(int *dest, unsigned int max) {
+    unsigned int n = num_patterns - pos;
+    if (n > max) n = max;
+    for (unsigned int i=0; i<n; ++i)
+      dest[i] = static_cast<int>(permutation[pos + i]);
+    pos += n;
+    return n;
+  }
+
+  ///////////////////////////////////////////////////////////////////////////
+
+  ImplicitShuffleIndexSource::
+  ImplicitShuffleIndexSource(unsigned int num_patterns, MTRand *rnd) :
+    num_patterns(num_patterns), pos(0) {
+    if (num_patterns == 0)
+      ERROR_EXIT(128, "Impossible to shuffle ZERO patterns\n");
+    // domain of 2^(2*half_bits) >= num_patterns, so the cycle walking needs
+    // less than four feistel calls in average
+    half_bits = 1;
+    while (half_bits < 16 &&
+	   (static_cast<uint64_t>(1) << (2*half_bits)) < num_patterns)
+      ++half_bits;
+    half_mask = (static_cast<uint32_t>(1) << half_bits) - 1;
+    for (unsigned int i=0; i<NUM_ROUNDS; ++i) keys[i] = rnd->randInt();
+  }
+
+  uint32_t ImplicitShuffleIndexSource::feistel(uint32_t x) const {
+    uint32_t left  = x >> half_bits;
+    uint32_t right = x & half_mask;
+    for (unsigned int i=0; i<NUM_ROUNDS; ++i) {
+      // round function, a 32 bits integer hash of right and the key
+      uint32_t h = (right ^ keys[i]) * 0x9E3779B1u;
+      h ^= h >> 16; h *= 0x85EBCA6Bu;
+      h ^= h >> 13; h *= 0xC2B2AE35u;
+      h ^= h >> 16;
+      uint32_t aux = left ^ (h & half_mask);
+      left  = right;
+      right = aux;
+    }
+    return (left << half_bits) | right;
+  }
+
+  unsigned int ImplicitShuffleIndexSource::next(int *dest, unsigned int max) {
+    unsigned int n = num_patterns - pos;
+    if (n > max) n = max;
+    for (unsigned int i=0; i<n; ++i)
+      dest[i] = static_cast<int>(permute(pos + i));
+    pos += n;
+    return n;
+  }
+
+  ///////////////////////////////////////////////////////////////////////////
+
+  ReplacementIndexSource::ReplacementIndexSource(unsigned int num_patterns,
+						 unsigned int replacement,
+						 MTRand *rnd) :
+    rnd(rnd), num_patterns(num_patterns), replacement(replacement), pos(0) {
+    if (num_patterns == 0)
+      ERROR_EXIT(128, "Impossible to sample from ZERO patterns\n");
+    IncRef(rnd);
+  }
+
+  ReplacementIndexSource::~ReplacementIndexSource() {
+    DecRef(rnd);
+  }
+
+  unsigned int ReplacementIndexSource::next(int *dest, unsigned int max) {
+    unsigned int n = replacement - pos;
+    if (n > max) n = max;
+    for (unsigned int i=0; i<n; ++i)
+      dest[i] = static_cast<int>(rnd->randInt(num_patterns - 1));
+    pos += n;
+    return n;
+  }
+
+  ///////////////////////////////////////////////////////////////////////////
+
+  DistributionIndexSource::DistributionIndexSource(dice *the_dice,
+						   const unsigned int *sizes,
+						   unsigned int replacement,
+						   MTRand *rnd) :
+    rnd(rnd), the_dice(the_dice), replacement(replacement), pos(0) {
+    IncRef(rnd);
+    IncRef(the_dice);
+    unsigned int sum = 0;
+    for (int i=0; i<the_dice->get_outcomes(); ++i) {
+      if (sizes[i] == 0)
+	ERROR_EXIT1(128, "Impossible to sample from ZERO patterns "
+		    "(dataset %d)\n", i+1);
+      this->sizes.push_back(sizes[i]);
+      this->sums.push_back(sum);
+      sum += sizes[i];
+    }
+  }
+
+  DistributionIndexSource::~DistributionIndexSource() {
+    DecRef(rnd);
+    DecRef(the_dice);
+  }
+
+  unsigned int DistributionIndexSource::next(int *dest, unsigned int max) {
+    unsigned int n = replacement - pos;
+    if (n > max) n = max;
+    for (unsigned int i=0; i<n; ++i) {
+      int which = the_dice->alias_thrown(rnd);
+      dest[i] = static_cast<int>(sums[which] + rnd->randInt(sizes[which] - 1));
+    }
+    pos += n;
+    return n;
+  }
+
+}
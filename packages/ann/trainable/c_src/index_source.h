@@ -0,0 +1,124 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef INDEX_SOURCE_H
+#define INDEX_SOURCE_H
+
+#include <stdint.h>
+#include "referenced.h"
+#include "MersenneTwister.h"
+#include "dice.h"
+#include "vector.h"
+
+namespace ANN {
+
+  /// Abstract generator of the sequence of pattern indexes (starting at 0)
+  /// traversed by one epoch. Indexes are produced in chunks by next(), so
+  /// the epoch loop never needs the whole sequence at the same time.
+  class IndexSource : public Referenced {
+  public:
+    virtual ~IndexSource() { }
+    /// Number of indexes produced in one epoch
+    virtual unsigned int size() const = 0;
+    /// Writes at most max indexes at dest, returns how many were written,
+    /// zero when the sequence is finished
+    virtual unsigned int next(int *dest, unsigned int max) = 0;
+  };
+
+  /// Indexes 0,1,...,num_patterns-1 in order
+  class SequentialIndexSource : public IndexSource {
+    unsigned int num_patterns, pos;
+  public:
+    SequentialIndexSource(unsigned int num_patterns) :
+      num_patterns(num_patterns), pos(0) { }
+    virtual unsigned int size() const { return num_patterns; }
+    virtual unsigned int next(int *dest, unsigned int max);
+  };
+
+  /// A random permutation of 0,...,num_patterns-1, computed at construction
+  /// as MTRand::shuffle does (the same sequence as random:shuffle in Lua) and
+  /// stored as an uint32 array
+  class ShuffleIndexSource : public IndexSource {
+    uint32_t *permutation;
+    unsigned int num_patterns, pos;
+  public:
+    ShuffleIndexSource(unsigned int num_patterns, MTRand *rnd);
+    virtual ~ShuffleIndexSource();
+    virtual unsigned int size() const { return num_patterns; }
+    virtual unsigned int next(int *dest, unsigned int max);
+  };
+
+  /// A pseudo-random permutation of 0,...,num_patterns-1 which needs no
+  /// memory: the index at position i is computed by a bijection given by a
+  /// Feistel network with keys taken from the MTRand, over the smallest
+  /// power of four domain which contains num_patterns, and cycle walking to
+  /// go back into [0,num_patterns). It is not the random:shuffle sequence.
+  class ImplicitShuffleIndexSource : public IndexSource {
+    static const unsigned int NUM_ROUNDS = 4;
+    uint32_t keys[NUM_ROUNDS];
+    uint32_t half_mask;
+    unsigned int half_bits;
+    unsigned int num_patterns, pos;
+    uint32_t feistel(uint32_t x) const;
+  public:
+    ImplicitShuffleIndexSource(unsigned int num_patterns, MTRand *rnd);
+    virtual unsigned int size() const { return num_patterns; }
+    virtual unsigned int next(int *dest, unsigned int max);
+    /// Image of position i of the permutation
+    uint32_t permute(uint32_t i) const {
+      do { i = feistel(i); } while (i >= num_patterns);
+      return i;
+    }
+  };
+
+  /// replacement indexes sampled uniformly with replacement, generated on
+  /// demand
+  class ReplacementIndexSource : public IndexSource {
+    MTRand *rnd;
+    unsigned int num_patterns, replacement, pos;
+  public:
+    ReplacementIndexSource(unsigned int num_patterns, unsigned int replacement,
+			   MTRand *rnd);
+    virtual ~ReplacementIndexSource();
+    virtual unsigned int size() const { return replacement; }
+    virtual unsigned int next(int *dest, unsigned int max);
+  };
+
+  /// replacement indexes sampled from a union of datasets: first the dataset
+  /// is chosen following the a-priori probabilities of the dice (with the
+  /// alias method), and after that a pattern of the chosen dataset is sampled
+  /// uniformly
+  class DistributionIndexSource : public IndexSource {
+    MTRand *rnd;
+    dice   *the_dice;
+    april_utils::vector<unsigned int> sizes, sums;
+    unsigned int replacement, pos;
+  public:
+    DistributionIndexSource(dice *the_dice, const unsigned int *sizes,
+			    unsigned int replacement, MTRand *rnd);
+    virtual ~DistributionIndexSource();
+    virtual unsigned int size() const { return replacement; }
+    virtual unsigned int next(int *dest, unsigned int max);
+  };
+
+}
+
+#endif // INDEX_SOURCE_H
@@ -13,6 +13,69 @@ local function check_dataset_sizes(ds1, ds2)
 		       ds2:numPatterns()))
 end
 
+-- Returns the trainable.index_source which traverses num_patterns following
+-- the given training mode (replacement, shuffled, or sequential). The
+-- implicit_shuffle flag uses a permutation computed on demand instead of
+-- a shuffled array of num_patterns indexes.
+local function get_index_source(num_patterns, shuffle, replacement,
+				implicit_shuffle)
+  if replacement then
+    assert(shuffle,"shuffle is mandatory with replacement")
+    return trainable.index_source.replacement(num_patterns, replacement,
+					      shuffle)
+  elseif shuffle and implicit_shuffle then
+    return trainable.index_source.implicit_shuffle(num_patterns, shuffle)
+  elseif shuffle then
+    return trainable.index_source.shuffle(num_patterns, shuffle)
+  else
+    return trainable.index_source.sequential(num_patterns)
+  end
+end
+
+-- Returns the C++ component which trainable.epoch_driver needs, or nil if the
+-- given component is not a C++ object (or a ann.mlp.all_all wrapper of it)
+local function get_native_component(ann_component)
+  if isa(ann_component, ann.components.base) then return ann_component end
+  if type(ann_component) == "table" and
+  isa(ann_component.thenet, ann.components.base) then
+    return ann_component.thenet
+  end
+end
+
+-- Components which compute their training outputs and gradients from the
+-- target are trained wrongly by other loss functions than the ones designed
+-- for them: ann.components.factored_softmax ignores the gradient received at
+-- backprop (it computes the multi-class cross-entropy one), and
+-- ann.components.sampled_output only computes the scores used by
+-- ann.loss.sampled_output
+local function check_loss_function(ann_component, loss_function)
+  if not loss_function or not ann_component:needs_target_for_gradient() then
+    return
+  end
+  local mt = getmetatable(loss_function) or {}
+  for _,loss_class in ipairs{ ann.loss.multi_class_cross_entropy,
+			      ann.loss.sampled_output } do
+    -- rawequal, the class tables of C++ bindings have their own __eq
+    if rawequal(mt.__index, loss_class.meta_instance.__index) then return end
+  end
+  error("ann.components.factored_softmax needs a " ..
+	"ann.loss.multi_class_cross_entropy loss function, and " ..
+	"ann.components.sampled_output needs a ann.loss.sampled_output one")
+end
+
+-- Calls func(bunch_indexes) for each bunch of the given index_source, used
+-- when the epoch couldn't be executed by trainable.epoch_driver
+local function for_each_bunch(index_source, bunch_size, func)
+  local k=0
+  local bunch_indexes = index_source:next(bunch_size)
+  while bunch_indexes do
+    func(bunch_indexes)
+    k=k+1
+    if k == MAX_ITERS_WO_COLLECT_GARBAGE then collectgarbage("collect") k=0 end
+    bunch_indexes = index_source:next(bunch_size)
+  end
+end
+
 -----------------------
 -- TRAINABLE CLASSES --
 -----------------------
@@ -54,6 +117,7 @@ function trainable.supervised_trainer:__call(ann_component,
     weights_order    = {},
     components_order = {},
     bunch_size       = bunch_size or false,
+    weights_arena    = false,
   }
   obj = class_instance(obj, self, true)
   return obj
@@ -78,6 +142,9 @@ april_set_doc("trainable.supervised_trainer.set_loss_function", {
 		params = { "Loss function" }, })
 
 function trainable.supervised_trainer:set_loss_function(loss_function)
+  if self.components_table then
+    check_loss_function(self.ann_component, loss_function)
+  end
   self.loss_function = loss_function
 end
 
@@ -128,7 +195,8 @@ april_set_doc("trainable.supervised_trainer.save", {
 		summary = "Save the model at a disk file",
 		description = {
 		  "Save the model and connection weights at",
-		  "a disk file.",
+		  "a disk file. The file is compressed with gzip when",
+		  "its name finishes with .gz.",
 		  "Only works after build method is called.",
 		},
 		params = {
@@ -140,28 +208,30 @@ april_set_doc("trainable.supervised_trainer.save", {
 function trainable.supervised_trainer:save(filename, binary)
   assert(#self.components_order > 0, "The component is not built")
   local binary = binary or "binary"
-  local f = io.open(filename,"w") or error("Unable to open " .. filename)
-  f:write("return { model=".. self.ann_component:to_lua_string() .. ",\n")
-  f:write("connections={")
+  -- the pieces are written at once by util.write_file, which compresses
+  -- them when filename finishes with .gz
+  local f = {}
+  table.insert(f, "return { model=".. self.ann_component:to_lua_string() .. ",\n")
+  table.insert(f, "connections={")
   for _,wname in ipairs(self.weights_order) do
     local cobj = self.weights_table[wname]
     local w,oldw = cobj:weights()
-    f:write("\n[\"".. wname .. "\"] = {")
-    f:write("\ninput = " .. cobj:get_input_size() .. ",")
-    f:write("\noutput = " .. cobj:get_output_size() .. ",")
-    f:write("\nw = matrix.fromString[[" .. w:toString(binary) .. "]],")
-    f:write("\noldw = matrix.fromString[[" .. oldw:toString(binary) .. "]],")
-    f:write("\n},")
+    table.insert(f, "\n[\"".. wname .. "\"] = {")
+    table.insert(f, "\ninput = " .. cobj:get_input_size() .. ",")
+    table.insert(f, "\noutput = " .. cobj:get_output_size() .. ",")
+    table.insert(f, "\nw = matrix.fromString[[" .. w:toString(binary) .. "]],")
+    table.insert(f, "\noldw = matrix.fromString[[" .. oldw:toString(binary) .. "]],")
+    table.insert(f, "\n},")
   end
-  f:write("\n},\n")
+  table.insert(f, "\n},\n")
   if self.loss_function then
     local id = get_object_id(self.loss_function)
     local sz = self.ann_component:get_output_size()
-    if id and sz then f:write("loss=" .. id .. "(".. sz .. "),\n") end
+    if id and sz then table.insert(f, "loss=" .. id .. "(".. sz .. "),\n") end
   end
-  if self.bunch_size then f:write("bunch_size="..self.bunch_size..",\n") end
-  f:write("}\n")
-  f:close()
+  if self.bunch_size then table.insert(f, "bunch_size="..self.bunch_size..",\n") end
+  table.insert(f, "}\n")
+  util.write_file(filename, f)
 end
 
 ------------------------------------------------------------------------
@@ -171,16 +241,25 @@ april_set_doc("trainable.supervised_trainer.load", {
 		summary = "Load the model and weights from a disk file",
 		description = {
 		  "Load the model and connection weights stored at",
-		  "a disk file. The trainer is loaded at build state.",
+		  "a disk file, which could be compressed with gzip (.gz).",
+		  "The trainer is loaded at build state.",
+		  "Connection weights could be stored in half precision",
+		  "(fp16 or bf16), which is only useful for inference, the",
+		  "trainer could not be trained.",
 		},
 		params = {
 		  "A filename string",
 		  "Loss function [optional]",
 		  "Bunch size (mini batch) [optional]",
+		  { "Precision of weights: fp32, fp16 or bf16 [optional].",
+		    "By default is fp32." },
 		}, })
 
-function trainable.supervised_trainer.load(filename, loss, bunch_size)
-  local f = loadfile(filename) or error("Unable to open " .. filename)
+function trainable.supervised_trainer.load(filename, loss, bunch_size,
+					   precision)
+  local str = util.read_file(filename) or error("Unable to open " .. filename)
+  local f = loadstring(str, "@" .. filename) or
+    error("Impossible to load chunk from file " .. filename)
   local t = f() or error("Impossible to load chunk from file " .. filename)
   local model = t.model
   local connections = t.connections
@@ -197,7 +276,13 @@ function trainable.supervised_trainer.load(filename, loss, bunch_size)
     assert(connections[wname].output == cobj:get_output_size(),
 	   string.format("Incorrect output size, expected %d, found %d\n",
 			 cobj:get_output_size(), connections[wname].output))
-    cobj:load{ w=w, oldw=oldw or w }
+    if precision and precision ~= "fp32" then
+      -- previous weights are not needed for inference
+      cobj:load{ w=w, oldw=w }
+      cobj:set_precision(precision)
+    else
+      cobj:load{ w=w, oldw=oldw or w }
+    end
   end
   return obj
 end
@@ -433,11 +518,16 @@ april_set_doc("trainable.supervised_trainer.build", {
 		    "also built. The method returns two tables with the",
 		    "content of weights_table and components_table, in order",
 		    "to provide easy acces to components and connections.",
+		    "If arena=true, all the weights are placed in one",
+		    "contiguous memory block (ann.connections_arena). It",
+		    "only changes the memory layout, updates are the same.",
+		    "The arena is not available in CUDA builds.",
 		  }, 
 		params = {
 		  ["weights"] = "A dictionary weights_name => ann.connections object [optional]",
 		  ["input"]   = "The input size of the component [optional]",
 		  ["output"]  = "The output size of the component [optional]",
+		  ["arena"]   = "A boolean [optional], by default false",
 		},
 		outputs = {
 		  "Weights table, associates weights_name => ann.connections object",
@@ -450,6 +540,7 @@ function trainable.supervised_trainer:build(t)
       weights = { type_match="table",  mandatory = false, default=nil },
       input   = { type_match="number", mandatory = false, default=nil },
       output  = { type_match="number", mandatory = false, default=nil },
+      arena   = { type_match="boolean", mandatory = false, default=false },
     }, t or {})
   self.weights_table = params.weights or {}
   self.ann_component:reset_connections()
@@ -463,11 +554,20 @@ function trainable.supervised_trainer:build(t)
     table.insert(self.weights_order, name)
   end
   table.sort(self.weights_order)
+  self.weights_arena = false
+  if params.arena then
+    self.weights_arena =
+      ann.connections_arena(table.imap(self.weights_order,
+				       function(name)
+					 return self.weights_table[name]
+				       end))
+  end
   self.components_order = {}
   for name,_ in pairs(self.components_table) do
     table.insert(self.components_order, name)
   end
   table.sort(self.components_order)
+  check_loss_function(self.ann_component, self.loss_function)
   return self.weights_table,self.components_table
 end
 
@@ -482,6 +582,10 @@ april_set_doc("trainable.supervised_trainer.train_step", {
 		    "with the given pair input/target output.",
 		    "It returns the loss for the given pair of patterns and",
 		    "the gradient computed at component inputs.",
+		    "The loss and its gradient are computed at once with",
+		    "loss_and_gradient when the loss function has it.",
+		    "The target is given to the component with set_target",
+		    "before the forward step.",
 		  }, 
 		params = {
 		  "A table with one input pattern or a token (with one or more patterns)",
@@ -496,9 +600,18 @@ function trainable.supervised_trainer:train_step(input, target)
   if type(input)  == "table" then input  = tokens.memblock(input)  end
   if type(target) == "table" then target = tokens.memblock(target) end
   self.ann_component:reset()
+  -- pure Lua components could not have set_target
+  if self.ann_component.set_target then
+    self.ann_component:set_target(target)
+  end
   local output   = self.ann_component:forward(input, true)
-  local tr_loss  = self.loss_function:loss(output, target)
-  local gradient = self.loss_function:gradient(output, target)
+  local tr_loss, gradient
+  if self.loss_function.loss_and_gradient then
+    tr_loss, gradient = self.loss_function:loss_and_gradient(output, target)
+  else
+    tr_loss  = self.loss_function:loss(output, target)
+    gradient = self.loss_function:gradient(output, target)
+  end
   self.ann_component:backprop(gradient)
   self.ann_component:update()
   return tr_loss,gradient
@@ -592,6 +705,12 @@ april_set_doc("trainable.supervised_trainer.train_dataset", {
 		  ["input_dataset"]  = "A dataset float or dataset token",
 		  ["output_dataset"] = "A dataset float or dataset token (target output)",
 		  ["shuffle"]        = "A random object used to shuffle patterns before training",
+		  ["implicit_shuffle"] =
+		    {
+		      "A boolean, true to traverse a pseudo-random permutation",
+		      "computed on demand, without memory, instead of the",
+		      "shuffled order [optional]. By default it is false.",
+		    },
 		  ["bunch_size"]     = 
 		    {
 		      "Bunch size (mini-batch). It is optional if bunch_size",
@@ -672,6 +791,8 @@ function trainable.supervised_trainer:train_dataset(t)
 			 mandatory = (self.bunch_size == false),
 			 default=self.bunch_size },
       shuffle        = { isa_match  = random,   mandatory = false, default=nil },
+      implicit_shuffle = { type_match = "boolean", mandatory = false,
+			   default=false },
       replacement    = { type_match = "number", mandatory = false, default=nil },
     }, t)
   -- ERROR CHECKING
@@ -681,12 +802,9 @@ function trainable.supervised_trainer:train_dataset(t)
 	 "input_dataset/output_dataset fields are forbidden with distribution")
   --
   
-  -- TRAINING TABLES
-  
-  -- for each pattern, index in dataset
-  local ds_idx_table = {}
-  -- set to ZERO the accumulated of loss
-  self.loss_function:reset()
+  -- INDEX SOURCE, generates the indexes of the patterns traversed by the
+  -- epoch (replacement, shuffled, sequential, or following a distribution)
+  local index_source
   if params.distribution then
     -- Training with distribution: given a table of datasets the patterns are
     -- sampled following the given apriory probability
@@ -696,7 +814,6 @@ function trainable.supervised_trainer:train_dataset(t)
     params.output_dataset = dataset.token.union()
     local aprioris = {}
     local sizes    = {}
-    local sums     = { 0 }
     for i,v in ipairs(params.distribution) do
       if isa(v.input_dataset, dataset) then
 	v.input_dataset  = dataset.token.wrapper(v.input_dataset)
@@ -707,17 +824,13 @@ function trainable.supervised_trainer:train_dataset(t)
       check_dataset_sizes(v.input_dataset, v.output_dataset)
       table.insert(aprioris, v.probability)
       table.insert(sizes, v.input_dataset:numPatterns())
-      table.insert(sums, sums[#sums] + sizes[#sizes])
       params.input_dataset:push_back(v.input_dataset)
       params.output_dataset:push_back(v.output_dataset)
     end
-    -- generate training tables
-    local dice = random.dice(aprioris)
-    for i=1,params.replacement do
-      local whichclass=dice:thrown(params.shuffle)
-      local idx=params.shuffle:randInt(1,sizes[whichclass])
-      table.insert(ds_idx_table, idx + sums[whichclass])
-    end
+    index_source = trainable.index_source.distribution(random.dice(aprioris),
+							sizes,
+							params.replacement,
+							params.shuffle)
   else
     if isa(params.input_dataset, dataset) then
       params.input_dataset  = dataset.token.wrapper(params.input_dataset)
@@ -726,35 +839,28 @@ function trainable.supervised_trainer:train_dataset(t)
       params.output_dataset = dataset.token.wrapper(params.output_dataset)
     end
     check_dataset_sizes(params.input_dataset, params.output_dataset)
-    local num_patterns = params.input_dataset:numPatterns()
-    -- generate training tables depending on training mode (replacement,
-    -- shuffled, or sequential)
-    if params.replacement then
-      assert(params.shuffle,"shuffle is mandatory with replacement")
-      for i=1,params.replacement do
-	table.insert(ds_idx_table, params.shuffle:randInt(1,num_patterns))
-      end
-    elseif params.shuffle then
-      ds_idx_table = params.shuffle:shuffle(num_patterns)
-    else
-      for i=1,num_patterns do table.insert(ds_idx_table, i) end
-    end
+    index_source = get_index_source(params.input_dataset:numPatterns(),
+				    params.shuffle, params.replacement,
+				    params.implicit_shuffle)
   end
-  -- TRAIN USING ds_idx_table
-  local k=0
-  for i=1,#ds_idx_table,params.bunch_size do
-    local bunch_indexes = {}
-    local last = math.min(i+params.bunch_size-1, #ds_idx_table)
-    -- OJO j - 1
-    for j=i,last do table.insert(bunch_indexes, ds_idx_table[j] - 1) end
-    local input_bunch  = params.input_dataset:getPatternBunch(bunch_indexes)
-    local output_bunch = params.output_dataset:getPatternBunch(bunch_indexes)
-    self:train_step(input_bunch, output_bunch)
-    k=k+1
-    if k == MAX_ITERS_WO_COLLECT_GARBAGE then collectgarbage("collect") k=0 end
+  -- TRAIN USING index_source, the whole epoch is executed in C++ when the
+  -- component and the loss function are C++ objects
+  local component = get_native_component(self.ann_component)
+  if component and isa(self.loss_function, ann.loss.__base__) then
+    return trainable.epoch_driver.train_dataset(component,
+						self.loss_function,
+						params.input_dataset,
+						params.output_dataset,
+						index_source,
+						params.bunch_size)
   end
-  ds_idx_table = nil
-  collectgarbage("collect")
+  self.loss_function:reset()
+  for_each_bunch(index_source, params.bunch_size,
+		 function(bunch_indexes)
+		   local input_bunch  = params.input_dataset:getPatternBunch(bunch_indexes)
+		   local output_bunch = params.output_dataset:getPatternBunch(bunch_indexes)
+		   self:train_step(input_bunch, output_bunch)
+		 end)
   return self.loss_function:get_accum_loss()
 end
 
@@ -773,6 +879,12 @@ april_set_doc("trainable.supervised_trainer.validate_dataset", {
 		params = {
 		  ["input_dataset"]  = "A dataset float or dataset token",
 		  ["output_dataset"] = "A dataset float or dataset token (target output)",
+		  ["num_threads"]    =
+		    {
+		      "Number of threads [optional]. With more than one, the",
+		      "bunches are computed in parallel by clones of the",
+		      "component sharing its weights. By default it is 1.",
+		    },
 		  ["bunch_size"]     = 
 		    {
 		      "Bunch size (mini-batch). It is optional if bunch_size",
@@ -797,6 +909,18 @@ april_set_doc("trainable.supervised_trainer.validate_dataset", {
 		  ["input_dataset"]  = "A dataset float or dataset token",
 		  ["output_dataset"] = "A dataset float or dataset token (target output)",
 		  ["shuffle"]        = "A random object used to shuffle patterns before validate",
+		  ["implicit_shuffle"] =
+		    {
+		      "A boolean, true to traverse a pseudo-random permutation",
+		      "computed on demand, without memory, instead of the",
+		      "shuffled order [optional]. By default it is false.",
+		    },
+		  ["num_threads"]    =
+		    {
+		      "Number of threads [optional]. With more than one, the",
+		      "bunches are computed in parallel by clones of the",
+		      "component sharing its weights. By default it is 1.",
+		    },
 		  ["bunch_size"]     = 
 		    {
 		      "Bunch size (mini-batch). It is optional if bunch_size",
@@ -823,6 +947,12 @@ april_set_doc("trainable.supervised_trainer.validate_dataset", {
 		  ["output_dataset"] = "A dataset float or dataset token (target output)",
 		  ["shuffle"]        = "A random object used to shuffle patterns before validate",
 		  ["replacement"]    = "A number with the size of replacement validate",
+		  ["num_threads"]    =
+		    {
+		      "Number of threads [optional]. With more than one, the",
+		      "bunches are computed in parallel by clones of the",
+		      "component sharing its weights. By default it is 1.",
+		    },
 		  ["bunch_size"]     = 
 		    {
 		      "Bunch size (mini-batch). It is optional if bunch_size",
@@ -842,18 +972,16 @@ function trainable.supervised_trainer:validate_dataset(t)
 			 mandatory = (self.bunch_size == false),
 			 default=self.bunch_size },
       shuffle        = { isa_match  = random, mandatory = false, default=nil },
+      implicit_shuffle = { type_match = "boolean", mandatory = false,
+			   default=false },
       replacement    = { type_match = "number", mandatory = false, default=nil },
+      num_threads    = { type_match = "number", mandatory = false, default=1 },
     }, t)
   -- ERROR CHECKING
   assert(params.input_dataset ~= not params.output_dataset,
 	 "input_dataset and output_dataset fields are mandatory together")
   assert(not params.input_dataset or not params.distribution,
 	 "input_dataset/output_dataset fields are forbidden with distribution")
-  -- TRAINING TABLES
-  
-  -- for each pattern, index in corresponding datasets
-  local ds_idx_table = {}
-  self.loss_function:reset()
   if isa(params.input_dataset, dataset) then
     params.input_dataset  = dataset.token.wrapper(params.input_dataset)
   end
@@ -861,34 +989,28 @@ function trainable.supervised_trainer:validate_dataset(t)
     params.output_dataset = dataset.token.wrapper(params.output_dataset)
   end
   check_dataset_sizes(params.input_dataset, params.output_dataset)
-  local num_patterns = params.input_dataset:numPatterns()
-  -- generate training tables depending on training mode (replacement,
-  -- shuffled, or sequential)
-  if params.replacement then
-    assert(params.shuffle,"shuffle is mandatory with replacement")
-    for i=1,params.replacement do
-      table.insert(ds_idx_table, params.shuffle:randInt(1,num_patterns))
-    end
-  elseif params.shuffle then
-    ds_idx_table = params.shuffle:shuffle(num_patterns)
-  else
-    for i=1,num_patterns do table.insert(ds_idx_table, i) end
-  end
-  -- TRAIN USING ds_idx_table
-  local k=0
-  for i=1,#ds_idx_table,params.bunch_size do
-    local bunch_indexes = {}
-    local last = math.min(i+params.bunch_size-1, #ds_idx_table)
-    -- OJO j - 1
-    for j=i,last do table.insert(bunch_indexes, ds_idx_table[j] - 1) end
-    local input_bunch  = params.input_dataset:getPatternBunch(bunch_indexes)
-    local output_bunch = params.output_dataset:getPatternBunch(bunch_indexes)
-    self:validate_step(input_bunch, output_bunch)
-    k=k+1
-    if k == MAX_ITERS_WO_COLLECT_GARBAGE then collectgarbage("collect") k=0 end
+  local index_source = get_index_source(params.input_dataset:numPatterns(),
+					params.shuffle, params.replacement,
+					params.implicit_shuffle)
+  -- VALIDATE USING index_source, the whole epoch is executed in C++ when the
+  -- component and the loss function are C++ objects
+  local component = get_native_component(self.ann_component)
+  if component and isa(self.loss_function, ann.loss.__base__) then
+    return trainable.epoch_driver.validate_dataset(component,
+						   self.loss_function,
+						   params.input_dataset,
+						   params.output_dataset,
+						   index_source,
+						   params.bunch_size,
+						   params.num_threads)
   end
-  ds_idx_table = nil
-  collectgarbage("collect")
+  self.loss_function:reset()
+  for_each_bunch(index_source, params.bunch_size,
+		 function(bunch_indexes)
+		   local input_bunch  = params.input_dataset:getPatternBunch(bunch_indexes)
+		   local output_bunch = params.output_dataset:getPatternBunch(bunch_indexes)
+		   self:validate_step(input_bunch, output_bunch)
+		 end)
   return self.loss_function:get_accum_loss()
 end
 
@@ -965,6 +1087,12 @@ april_set_doc("trainable.supervised_trainer.use_dataset", {
 		params = {
 		  ["input_dataset"]  = "A dataset float or dataset token",
 		  ["output_dataset"] = "A dataset float or dataset token [optional].",
+		  ["num_threads"]    =
+		    {
+		      "Number of threads [optional]. With more than one, the",
+		      "bunches are computed in parallel by clones of the",
+		      "component sharing its weights. By default it is 1.",
+		    },
 		  ["bunch_size"]     = 
 		    {
 		      "Bunch size (mini-batch). It is optional if bunch_size",
@@ -983,6 +1111,7 @@ function trainable.supervised_trainer:use_dataset(t)
       bunch_size     = { type_match = "number",
 			 mandatory = (self.bunch_size == false),
 			 default=self.bunch_size },
+      num_threads    = { type_match = "number", mandatory = false, default=1 },
     }, t)
   local nump    = params.input_dataset:numPatterns()
   local outsize = self.ann_component:get_output_size()
@@ -1001,23 +1130,167 @@ function trainable.supervised_trainer:use_dataset(t)
   if isa(params.input_dataset, dataset) then
     params.input_dataset = dataset.token.wrapper(params.input_dataset)
   end
-  local k=0
-  for i=1,nump,params.bunch_size do
-    local bunch_indexes = {}
-    local last = math.min(i+params.bunch_size-1, nump)
-    -- OJO j - 1
-    for j=i,last do table.insert(bunch_indexes, j - 1) end
-    local input  = params.input_dataset:getPatternBunch(bunch_indexes)
-    local output = self.ann_component:forward(input)
-    params.output_dataset:putPatternBunch(bunch_indexes,output)
-    k=k+1
-    if k == MAX_ITERS_WO_COLLECT_GARBAGE then collectgarbage("collect") k=0 end
+  local component = get_native_component(self.ann_component)
+  if component then
+    trainable.epoch_driver.use_dataset(component,
+				       params.input_dataset,
+				       params.output_dataset,
+				       params.bunch_size,
+				       params.num_threads)
+  else
+    for_each_bunch(trainable.index_source.sequential(nump), params.bunch_size,
+		   function(bunch_indexes)
+		     local input  = params.input_dataset:getPatternBunch(bunch_indexes)
+		     local output = self.ann_component:forward(input)
+		     params.output_dataset:putPatternBunch(bunch_indexes,output)
+		   end)
   end
   return t.output_dataset
 end
 
 ------------------------------------------------------------------------
 
+april_set_doc("trainable.supervised_trainer.quantize", {
+		class = "method",
+		summary = "Post-training int8 quantization of the model",
+		description = 
+		  {
+		    "This method converts the weights of all dot_product",
+		    "components into int8 weights with one scale per output",
+		    "neuron. Forward steps with during_training=false use",
+		    "int8 kernels with int32 accumulation. Training steps",
+		    "continue using fp32 weights (int8 copy is recomputed).",
+		    "If a calibration_dataset is given, the input range of",
+		    "each component is fixed using its patterns, otherwise",
+		    "the input range is computed for each pattern.",
+		    "Only works after build method is called.",
+		  }, 
+		params = {
+		  ["calibration_dataset"] = "A dataset float or dataset token [optional]",
+		  ["bunch_size"]     = 
+		    {
+		      "Bunch size (mini-batch). It is [optional] if bunch_size",
+		      "was set at constructor, otherwise it is mandatory",
+		      "with calibration_dataset.",
+		    }, 
+		}, })
+
+function trainable.supervised_trainer:quantize(t)
+  local params = get_table_fields(
+    {
+      calibration_dataset = { mandatory = false, default=nil },
+      bunch_size          = { type_match = "number",
+			      mandatory = false,
+			      default=self.bunch_size },
+    }, t or {})
+  if #self.components_order == 0 then
+    error("It is not build")
+  end
+  if params.calibration_dataset then
+    assert(params.bunch_size, "bunch_size is mandatory with calibration_dataset")
+    for _,c in self:iterate_components() do
+      c:set_quantized(false)
+      c:begin_calibration()
+    end
+    self:for_each_pattern{ input_dataset = params.calibration_dataset,
+			   bunch_size    = params.bunch_size,
+			   func          = function() end }
+    for _,c in self:iterate_components() do c:end_calibration() end
+  end
+  for _,c in self:iterate_components() do c:set_quantized(true) end
+end
+
+------------------------------------------------------------------------
+
+april_set_doc("trainable.supervised_trainer.dequantize", {
+		class = "method",
+		summary = "Returns to fp32 inference, removing int8 weights", })
+
+function trainable.supervised_trainer:dequantize()
+  for _,c in self:iterate_components() do c:set_quantized(false) end
+end
+
+------------------------------------------------------------------------
+
+april_set_doc("trainable.supervised_trainer.quantization_report", {
+		class = "method",
+		summary = "Compares int8 quantized outputs with fp32 outputs",
+		description = 
+		  {
+		    "This method computes the outputs of the model with fp32",
+		    "and with int8 weights for the given input_dataset, and",
+		    "returns a table with the comparison. If output_dataset",
+		    "is given, the loss of both models is computed also.",
+		    "The model is left quantized.",
+		  }, 
+		params = {
+		  ["input_dataset"]  = "A dataset float",
+		  ["output_dataset"] = "A dataset float (target output) [optional]",
+		  ["bunch_size"]     = 
+		    {
+		      "Bunch size (mini-batch). It is optional if bunch_size",
+		      "was set at constructor, otherwise it is mandatory.",
+		    }, 
+		},
+		outputs = {
+		  { "A table with fields: max_abs_error, mean_abs_error,",
+		    "argmax_agreement (ratio of patterns with same arg max),",
+		    "and fp32_loss, int8_loss if output_dataset is given" },
+		} })
+
+function trainable.supervised_trainer:quantization_report(t)
+  local params = get_table_fields(
+    {
+      input_dataset  = { mandatory = true },
+      output_dataset = { mandatory = false, default=nil },
+      bunch_size     = { type_match = "number",
+			 mandatory = (self.bunch_size == false),
+			 default=self.bunch_size },
+    }, t)
+  local nump    = params.input_dataset:numPatterns()
+  local outsize = self.ann_component:get_output_size()
+  local function compute_outputs()
+    local m = matrix(nump, outsize)
+    self:use_dataset{ input_dataset  = params.input_dataset,
+		      output_dataset = dataset.matrix(m),
+		      bunch_size     = params.bunch_size }
+    local loss
+    if params.output_dataset and self.loss_function then
+      loss = self:validate_dataset{ input_dataset  = params.input_dataset,
+				    output_dataset = params.output_dataset,
+				    bunch_size     = params.bunch_size }
+    end
+    return m:toTable(),loss
+  end
+  self:dequantize()
+  local fp32_out,fp32_loss = compute_outputs()
+  self:quantize()
+  local int8_out,int8_loss = compute_outputs()
+  local max_err,sum_err,agree = 0,0,0
+  for p=0,nump-1 do
+    local fp32_max,fp32_argmax = -math.huge,0
+    local int8_max,int8_argmax = -math.huge,0
+    for i=1,outsize do
+      local pos = p*outsize + i
+      local err = math.abs(fp32_out[pos] - int8_out[pos])
+      max_err   = math.max(max_err, err)
+      sum_err   = sum_err + err
+      if fp32_out[pos] > fp32_max then fp32_max,fp32_argmax = fp32_out[pos],i end
+      if int8_out[pos] > int8_max then int8_max,int8_argmax = int8_out[pos],i end
+    end
+    if fp32_argmax == int8_argmax then agree = agree + 1 end
+  end
+  return {
+    max_abs_error    = max_err,
+    mean_abs_error   = sum_err / (nump*outsize),
+    argmax_agreement = agree / nump,
+    fp32_loss        = fp32_loss,
+    int8_loss        = int8_loss,
+  }
+end
+
+------------------------------------------------------------------------
+
 april_set_doc("trainable.supervised_trainer.show_weights", {
 		class = "method",
 		summary = "Print connection weights (for debug purposes).", })
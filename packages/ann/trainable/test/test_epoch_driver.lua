@@ -0,0 +1,141 @@
+-- Checks that trainable.epoch_driver (native epochs) and the Lua loop over
+-- index sources (used with non C++ components) produce the same losses
+local nump, isz, osz = 100, 8, 3
+local rnd  = random(4321)
+local m_in = matrix(nump, isz)
+for i=1,nump do for j=1,isz do m_in:set(i,j, rnd:rand(2)-1) end end
+local m_out = matrix(nump, osz)
+for i=1,nump do m_out:set(i, rnd:randInt(1,osz), 1) end
+local ds_in, ds_out = dataset.matrix(m_in), dataset.matrix(m_out)
+
+-- a pure Lua wrapper which hides the C++ component to the epoch driver
+local function lua_wrapper(c)
+  return {
+    reset    = function(self) c:reset() end,
+    forward  = function(self, ...) return c:forward(...) end,
+    backprop = function(self, ...) return c:backprop(...) end,
+    update   = function(self) c:update() end,
+    get_output_size = function(self) return c:get_output_size() end,
+  }
+end
+
+local function run(native, mode)
+  local net = ann.mlp.all_all.generate(isz.." inputs 10 tanh "..osz.." log_softmax")
+  local tr  = trainable.supervised_trainer(net,
+					   ann.loss.multi_class_cross_entropy(osz),
+					   7)
+  tr:build()
+  tr:randomize_weights{ random=random(52), inf=-0.5, sup=0.5 }
+  net:set_option("learning_rate", 0.1)
+  net:set_option("momentum", 0.2)
+  if not native then tr.ann_component = lua_wrapper(net.thenet) end
+  local losses = {}
+  for e=1,3 do
+    local t = { bunch_size = 7 }
+    if mode == "distribution" then
+      t.distribution = {
+	{ input_dataset=ds_in, output_dataset=ds_out, probability=0.3 },
+	{ input_dataset=dataset.matrix(m_in, { patternSize={1,isz},
+					       offset={50,0},
+					       numSteps={50,1} }),
+	  output_dataset=dataset.matrix(m_out, { patternSize={1,osz},
+						 offset={50,0},
+						 numSteps={50,1} }),
+	  probability=0.7 },
+      }
+      t.shuffle, t.replacement = random(e), 60
+    else
+      t.input_dataset, t.output_dataset = ds_in, ds_out
+      if mode == "shuffle" then t.shuffle = random(e) end
+      if mode == "implicit_shuffle" then
+	t.shuffle, t.implicit_shuffle = random(e), true
+      end
+      if mode == "replacement" then t.shuffle, t.replacement = random(e), 40 end
+    end
+    table.insert(losses, tr:train_dataset(t))
+  end
+  table.insert(losses, tr:validate_dataset{ input_dataset  = ds_in,
+					    output_dataset = ds_out })
+  table.insert(losses, tr:validate_dataset{ input_dataset  = ds_in,
+					    output_dataset = ds_out,
+					    shuffle = random(9),
+					    replacement = 33 })
+  local out = tr:use_dataset{ input_dataset = ds_in }
+  return losses, out:toMatrix():toTable()
+end
+
+for _,mode in ipairs{ "sequential", "shuffle", "implicit_shuffle",
+		      "replacement", "distribution" } do
+  local l1,o1 = run(true, mode)
+  local l2,o2 = run(false, mode)
+  for i=1,#l1 do
+    assert(math.abs(l1[i] - l2[i]) < 1e-6,
+	   string.format("%s: %g ~= %g", mode, l1[i], l2[i]))
+  end
+  assert(#o1 == nump*osz)
+  for i=1,#o1 do assert(math.abs(o1[i] - o2[i]) < 1e-6) end
+end
+
+-- index sources
+local src = trainable.index_source.sequential(10)
+assert(src:size() == 10)
+local t = src:next(4)
+assert(#t == 4 and t[1] == 0 and t[4] == 3)
+src:next(4)
+assert(#src:next(4) == 2)
+assert(src:next(4) == nil)
+local perm = random(5):shuffle(20)
+src = trainable.index_source.shuffle(20, random(5))
+local t = src:next(20)
+for i=1,20 do assert(t[i] == perm[i] - 1) end
+src = trainable.index_source.replacement(5, 17, random(3))
+assert(src:size() == 17)
+local n = 0
+for i,v in ipairs(src:next(100)) do assert(v >= 0 and v < 5) n=n+1 end
+assert(n == 17)
+src = trainable.index_source.distribution(random.dice{ 0.5, 0.5 }, { 3, 4 },
+					  50, random(3))
+for i,v in ipairs(src:next(50)) do assert(v >= 0 and v < 7) end
+
+-- implicit permutations visit all the indexes once
+for _,n in ipairs{ 1, 2, 5, 1000, 70001 } do
+  src = trainable.index_source.implicit_shuffle(n, random(n))
+  local visited, count = {}, 0
+  local t = src:next(1000)
+  while t do
+    for _,v in ipairs(t) do
+      assert(v >= 0 and v < n and not visited[v])
+      visited[v], count = true, count + 1
+    end
+    t = src:next(1000)
+  end
+  assert(count == n)
+end
+
+-- parallel inference gives the same results than sequential inference, and
+-- it doesn't modify the training of the component
+local function run_parallel(num_threads)
+  local net = ann.mlp.all_all.generate(isz.." inputs 10 tanh "..osz.." log_softmax")
+  local tr  = trainable.supervised_trainer(net,
+					   ann.loss.multi_class_cross_entropy(osz),
+					   7)
+  tr:build()
+  tr:randomize_weights{ random=random(52), inf=-0.5, sup=0.5 }
+  net:set_option("learning_rate", 0.1)
+  local losses = {}
+  for e=1,2 do
+    tr:train_dataset{ input_dataset=ds_in, output_dataset=ds_out,
+		      shuffle=random(e) }
+    table.insert(losses, tr:validate_dataset{ input_dataset  = ds_in,
+					      output_dataset = ds_out,
+					      num_threads    = num_threads })
+  end
+  local out = tr:use_dataset{ input_dataset = ds_in,
+			      num_threads   = num_threads }
+  return losses, out:toMatrix():toTable()
+end
+
+local l1,o1 = run_parallel(1)
+local l2,o2 = run_parallel(4)
+for i=1,#l1 do assert(math.abs(l1[i] - l2[i]) < 1e-5) end
+for i=1,#o1 do assert(o1[i] == o2[i]) end
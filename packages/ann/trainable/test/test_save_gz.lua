@@ -0,0 +1,26 @@
+-- Checks that trainers saved to .gz files are loaded back with the same
+-- weights and the same outputs than trainers saved to plain files
+local isz, osz = 6, 3
+local net = ann.mlp.all_all.generate(isz.." inputs 8 tanh "..osz.." log_softmax")
+local tr  = trainable.supervised_trainer(net,
+					 ann.loss.multi_class_cross_entropy(osz),
+					 4)
+tr:build()
+tr:randomize_weights{ random=random(52), inf=-0.5, sup=0.5 }
+
+local input = { 0.1, -0.2, 0.3, -0.4, 0.5, -0.6 }
+local plain = os.tmpname()
+local gz    = plain .. ".gz"
+tr:save(plain)
+tr:save(gz)
+assert(os.execute("gzip -t " .. gz .. " 2> /dev/null") == 0)
+assert(util.read_file(gz) == util.read_file(plain))
+local out = tr:calculate(input)
+for _,filename in ipairs{ plain, gz } do
+  local tr2 = trainable.supervised_trainer.load(filename)
+  local out2 = tr2:calculate(input)
+  for i=1,#out do assert(out[i] == out2[i]) end
+end
+os.remove(plain)
+os.remove(gz)
+assert(not pcall(trainable.supervised_trainer.load, gz))
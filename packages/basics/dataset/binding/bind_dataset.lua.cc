@@ -20,7 +20,9 @@
  *
  */
 //BIND_HEADER_C
+#include <cerrno>
 #include <cmath>
+#include <cstring>
 #include "fmeasure.h"
 #include "bind_mtrand.h"
 #include "MersenneTwister.h"
@@ -370,12 +372,15 @@ LUABIND_ERROR("use constructor methods: matrix, etc.");
 // posiciones adyacentes, cosa que más o menos se puede hacer con
 // otros datasets, exceptuando lo que ocurre en los bordes. En este
 // dataset el patrón se repite en caso necesario para rellenar los
-// bordes.
+// bordes. Con reuse_window, las lecturas de índices consecutivos
+// reutilizan los patrones anteriores, sólo es correcto si los patrones del
+// dataset dependen únicamente de su índice (no con perturbation ni
+// salt_noise) y no se modifican entre llamadas.
 {
   DataSetFloat *ds;
   int izq,der;
   LUABIND_CHECK_ARGN(>=, 3);
-  LUABIND_CHECK_ARGN(<=, 4);
+  LUABIND_CHECK_ARGN(<=, 5);
   LUABIND_CHECK_PARAMETER(1, DataSetFloat);
   LUABIND_CHECK_PARAMETER(2, int);
   LUABIND_CHECK_PARAMETER(3, int);
@@ -384,7 +389,10 @@ LUABIND_ERROR("use constructor methods: matrix, etc.");
   LUABIND_GET_PARAMETER(3,int,der);
   bool reverse=false;
   LUABIND_GET_OPTIONAL_PARAMETER(4,bool,reverse,false);
-  DataSetFloat *obj = new ContextualizerDataSet<float>(ds,izq,der,reverse);
+  bool reuse_window=false;
+  LUABIND_GET_OPTIONAL_PARAMETER(5,bool,reuse_window,false);
+  DataSetFloat *obj = new ContextualizerDataSet<float>(ds,izq,der,reverse,
+						       reuse_window);
   LUABIND_RETURN(DataSetFloat,obj);
 }
 //BIND_END
@@ -488,6 +496,34 @@ LUABIND_ERROR("use constructor methods: matrix, etc.");
 }
 //BIND_END
 
+//BIND_METHOD DataSetFloat getPatternBunch
+// recibe una tabla de indices (entre 1 y numPatterns) y devuelve una matriz
+// con un patron por fila
+{
+  int bunch_size;
+  LUABIND_CHECK_ARGN(==, 1);
+  LUABIND_CHECK_PARAMETER(1, table);
+  LUABIND_TABLE_GETN(1, bunch_size);
+  int *indexes = new int[bunch_size];
+  LUABIND_TABLE_TO_VECTOR(1, int, indexes, bunch_size);
+  for (int i=0; i<bunch_size; ++i) {
+    if (indexes[i] < 1 || indexes[i] > obj->numPatterns()) {
+      delete[] indexes;
+      LUABIND_ERROR("index out of range");
+    }
+    --indexes[i]; // ojito que le RESTAMOS uno
+  }
+  int dim[2];
+  dim[0] = bunch_size;
+  dim[1] = obj->patternSize();
+  MatrixFloat* mat = new MatrixFloat(2,dim);
+  obj->getPatternBunch(indexes, bunch_size,
+		       mat->getRawDataAccess()->getPPALForWrite());
+  delete[] indexes;
+  LUABIND_RETURN(MatrixFloat,mat);
+}
+//BIND_END
+
 //BIND_METHOD DataSetFloat putPattern
 {
   int index;
@@ -527,8 +563,14 @@ LUABIND_ERROR("use constructor methods: matrix, etc.");
   dim[1] = obj->patternSize();
   MatrixFloat* mat = new MatrixFloat(2,dim);
   float *d = mat->getRawDataAccess()->getPPALForWrite();
-  for (int i=0; i < dim[0]; i++)
-    obj->getPattern(i,d+i*dim[1]);
+  // por bloques de indices consecutivos, para usar getPatternBunch
+  const int block = 256;
+  int indexes[block];
+  for (int i=0; i < dim[0]; i+=block) {
+    int n = april_utils::min(block, dim[0]-i);
+    for (int j=0; j<n; j++) indexes[j] = i+j;
+    obj->getPatternBunch(indexes, n, d+i*dim[1]);
+  }
   LUABIND_RETURN(MatrixFloat,mat);
 }
 //BIND_END
@@ -1042,6 +1084,165 @@ LUABIND_ERROR("use constructor methods: matrix, etc.");
 
 //////////////////////////////////////////
 
+//BIND_LUACLASSNAME LRUCacheDataSetFloat dataset.lru_cache
+//BIND_CPP_CLASS    LRUCacheDataSetFloat
+//BIND_SUBCLASS_OF  LRUCacheDataSetFloat DataSetFloat
+
+//BIND_CONSTRUCTOR LRUCacheDataSetFloat
+//DOC_BEGIN
+// lru_cache{ dataset=ds, memory=64MB, shards=16, spill_dir=nil }
+/// Keeps in memory the most recently used patterns of dataset (up to memory
+/// bytes), in LRU shards which allow concurrent getPattern calls. Evicted
+/// patterns are written to a spill file, when spill_dir is given, to be read
+/// from there instead of being computed again. The spill file is a new
+/// temporary file at the spill_dir directory, removed at once from it, and
+/// it is an error if it could not be created. Patterns must be a function
+/// of their index, don't put random datasets (perturbation, salt_noise)
+/// below it.
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 1);
+  LUABIND_CHECK_PARAMETER(1, table);
+  check_table_fields(L, 1, "dataset", "memory", "shards", "spill_dir", 0);
+  DataSetFloat *ds;
+  double memory;
+  int shards;
+  const char *spill_dir;
+  LUABIND_GET_TABLE_PARAMETER(1, dataset, DataSetFloat, ds);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, memory, double, memory,
+				       64.0*1024.0*1024.0);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, shards, int, shards, 16);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, spill_dir, string, spill_dir, 0);
+  if (memory < 0.0) LUABIND_ERROR("memory must be >= 0");
+  if (shards < 1) LUABIND_ERROR("shards must be > 0");
+  int spill_fd = -1;
+  if (spill_dir != 0) {
+    spill_fd = LRUCacheDataSetFloat::createSpillFile(spill_dir);
+    if (spill_fd < 0)
+      LUABIND_FERROR2("unable to create a spill file at %s: %s",
+		      spill_dir, strerror(errno));
+  }
+  obj = new LRUCacheDataSetFloat(ds, static_cast<size_t>(memory), shards,
+				 spill_fd);
+  LUABIND_RETURN(LRUCacheDataSetFloat, obj);
+}
+//BIND_END
+
+//BIND_METHOD LRUCacheDataSetFloat stats
+//DOC_BEGIN
+// stats()
+/// Returns a table with hits, disk_hits, misses, evictions, entries and
+/// capacity (in patterns) of the cache
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 0);
+  LRUCacheDataSetFloat::Stats stats = obj->getStats();
+  lua_newtable(L);
+  lua_pushnumber(L, stats.hits);
+  lua_setfield(L, -2, "hits");
+  lua_pushnumber(L, stats.disk_hits);
+  lua_setfield(L, -2, "disk_hits");
+  lua_pushnumber(L, stats.misses);
+  lua_setfield(L, -2, "misses");
+  lua_pushnumber(L, stats.evictions);
+  lua_setfield(L, -2, "evictions");
+  lua_pushnumber(L, stats.entries);
+  lua_setfield(L, -2, "entries");
+  lua_pushnumber(L, stats.capacity);
+  lua_setfield(L, -2, "capacity");
+  LUABIND_RETURN_FROM_STACK(-1);
+}
+//BIND_END
+
+//BIND_METHOD LRUCacheDataSetFloat reset_stats
+{
+  LUABIND_CHECK_ARGN(==, 0);
+  obj->resetStats();
+}
+//BIND_END
+
+//BIND_METHOD LRUCacheDataSetFloat clear
+//DOC_BEGIN
+// clear()
+/// Forgets the cached patterns, in memory and in the spill file. It could
+/// be called while other threads use the cache
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 0);
+  obj->clear();
+}
+//BIND_END
+
+//////////////////////////////////////////
+
+//BIND_LUACLASSNAME QuantizedDataSetFloat dataset.quantized
+//BIND_CPP_CLASS    QuantizedDataSetFloat
+//BIND_SUBCLASS_OF  QuantizedDataSetFloat DataSetFloat
+
+//BIND_CONSTRUCTOR QuantizedDataSetFloat
+//DOC_BEGIN
+// quantized{ dataset=ds, format="uint8" }
+/// Keeps a copy of dataset with each feature quantized to 8 or 16 bits,
+/// format is "uint8", "int16" or "fp16". Each feature has its own scale and
+/// offset, computed from its range. The quantization error is measured
+/// when it is built, see error_report.
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 1);
+  LUABIND_CHECK_PARAMETER(1, table);
+  check_table_fields(L, 1, "dataset", "format", 0);
+  DataSetFloat *ds;
+  const char *format_str;
+  QuantizedDataSetFloat::Format format = QuantizedDataSetFloat::UINT8;
+  LUABIND_GET_TABLE_PARAMETER(1, dataset, DataSetFloat, ds);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, format, string, format_str, "uint8");
+  if (strcmp(format_str, "uint8") == 0)
+    format = QuantizedDataSetFloat::UINT8;
+  else if (strcmp(format_str, "int16") == 0)
+    format = QuantizedDataSetFloat::INT16;
+  else if (strcmp(format_str, "fp16") == 0)
+    format = QuantizedDataSetFloat::FP16;
+  else LUABIND_FERROR1("Incorrect format %s, expected uint8, int16 or fp16",
+		       format_str);
+  obj = new QuantizedDataSetFloat(ds, format);
+  LUABIND_RETURN(QuantizedDataSetFloat, obj);
+}
+//BIND_END
+
+//BIND_METHOD QuantizedDataSetFloat error_report
+//DOC_BEGIN
+// error_report()
+/// Returns a table with the quantization error of the patterns of the
+/// original dataset: max_error (absolute), rmse, worst_feature (position
+/// with the max_error), feature_errors (max absolute error of each
+/// position), and the memory (bytes) used by the quantized copy
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 0);
+  QuantizedDataSetFloat::ErrorReport report = obj->getErrorReport();
+  const double *feature_errors = obj->getFeatureErrors();
+  int patsize = obj->patternSize();
+  lua_newtable(L);
+  lua_pushnumber(L, report.max_error);
+  lua_setfield(L, -2, "max_error");
+  lua_pushnumber(L, report.rmse);
+  lua_setfield(L, -2, "rmse");
+  lua_pushnumber(L, report.worst_feature + 1);
+  lua_setfield(L, -2, "worst_feature");
+  lua_createtable(L, patsize, 0);
+  for (int j=0; j<patsize; ++j) {
+    lua_pushnumber(L, feature_errors[j]);
+    lua_rawseti(L, -2, j+1);
+  }
+  lua_setfield(L, -2, "feature_errors");
+  lua_pushnumber(L, static_cast<double>(obj->getMemorySize()));
+  lua_setfield(L, -2, "memory");
+  LUABIND_RETURN_FROM_STACK(-1);
+}
+//BIND_END
+
+//////////////////////////////////////////
+
 //BIND_LUACLASSNAME DataSetToken dataset.token
 //BIND_CPP_CLASS    DataSetToken
 
@@ -1214,3 +1415,27 @@ LUABIND_ERROR("use constructor methods: matrix, etc.");
 }
 //BIND_END
 
+
+//////////////////////////////////////////
+
+//BIND_LUACLASSNAME DataSetFloat2ClassIndexTokenWrapper dataset.token.class_index
+//BIND_CPP_CLASS    DataSetFloat2ClassIndexTokenWrapper
+//BIND_SUBCLASS_OF  DataSetFloat2ClassIndexTokenWrapper DataSetToken
+
+//BIND_CONSTRUCTOR DataSetFloat2ClassIndexTokenWrapper
+// receives a dataset of pattern size 1 with class indices, the number of
+// classes, and optionally a dataset of pattern size 1 with weights
+{
+  LUABIND_CHECK_ARGN(>=,2);
+  LUABIND_CHECK_ARGN(<=,3);
+  LUABIND_CHECK_PARAMETER(1, DataSetFloat);
+  LUABIND_CHECK_PARAMETER(2, int);
+  DataSetFloat *ds, *weights_ds;
+  int num_classes;
+  LUABIND_GET_PARAMETER(1, DataSetFloat, ds);
+  LUABIND_GET_PARAMETER(2, int, num_classes);
+  LUABIND_GET_OPTIONAL_PARAMETER(3, DataSetFloat, weights_ds, 0);
+  obj = new DataSetFloat2ClassIndexTokenWrapper(ds, num_classes, weights_ds);
+  LUABIND_RETURN(DataSetFloat2ClassIndexTokenWrapper, obj);
+}
+//BIND_END
@@ -36,6 +36,61 @@ using april_utils::clamp;
 
 // ---------------------------------------------------------------------
 
+/// Copies a window fully inside the matrix, data points to its first element.
+/// Unrolled at compile time, the last dimension is a memcpy run.
+template <typename T, int D>
+struct MatrixWindowCopy {
+  static T *copy(const T *data, const int *size, const int *stride, T *pat) {
+    for (int i=0; i<size[0]; ++i)
+      pat = MatrixWindowCopy<T,D-1>::copy(data + i*stride[0],
+					  size+1, stride+1, pat);
+    return pat;
+  }
+};
+
+template <typename T>
+struct MatrixWindowCopy<T,1> {
+  static T *copy(const T *data, const int *size, const int *, T *pat) {
+    memcpy(pat, data, sizeof(T)*size[0]);
+    return pat + size[0];
+  }
+};
+
+/// Copies a window which crosses the matrix border, data points to the
+/// first element of the current dimension. Positions out of the matrix are
+/// filled with the default value, inner[0] values for each one.
+template <typename T, int D>
+struct MatrixWindowPaddedCopy {
+  static T *copy(const T *data, const int *coord, const int *size,
+		 const int *dimsize, const int *stride, const int *inner,
+		 T value, T *pat) {
+    int lo = clamp(-coord[0], 0, size[0]);
+    int hi = clamp(dimsize[0] - coord[0], lo, size[0]);
+    for (int i=lo*inner[0]; i; --i) *pat++ = value;
+    for (int i=lo; i<hi; ++i)
+      pat = MatrixWindowPaddedCopy<T,D-1>::copy(data + (coord[0]+i)*stride[0],
+						coord+1, size+1, dimsize+1,
+						stride+1, inner+1, value, pat);
+    for (int i=(size[0]-hi)*inner[0]; i; --i) *pat++ = value;
+    return pat;
+  }
+};
+
+template <typename T>
+struct MatrixWindowPaddedCopy<T,1> {
+  static T *copy(const T *data, const int *coord, const int *size,
+		 const int *dimsize, const int *, const int *,
+		 T value, T *pat) {
+    int lo = clamp(-coord[0], 0, size[0]);
+    int hi = clamp(dimsize[0] - coord[0], lo, size[0]);
+    for (int i=0; i<lo; ++i) *pat++ = value;
+    memcpy(pat, data + coord[0] + lo, sizeof(T)*(hi-lo));
+    pat += hi-lo;
+    for (int i=hi; i<size[0]; ++i) *pat++ = value;
+    return pat;
+  }
+};
+
 template <typename T>
 MatrixDataSet<T>::MatrixDataSet(Matrix<T> *m){
   if (!m->isSimple())
@@ -52,6 +107,8 @@ MatrixDataSet<T>::MatrixDataSet(Matrix<T> *m){
   numSteps     = new int[d];
   orderStep    = new int[d];
   coordinate   = new int[d];
+  stepIndex    = new int[d];
+  extractionReady = false;
   // valores por defecto
   defaultValue = 0;
   for (int i=0; i<d; i++) {
@@ -79,6 +136,7 @@ void MatrixDataSet<T>::setValue(int *dest, int *orig){
   for(int i=0;i<matrix->getNumDim();i++){
     dest[i]=orig[i];
   }
+  extractionReady = false;
 }
 
 template <typename T>
@@ -86,6 +144,7 @@ void MatrixDataSet<T>::setValue(bool *dest, bool *orig){
   for(int i=0;i<matrix->getNumDim();i++){
     dest[i]=orig[i];
   }
+  extractionReady = false;
 }
 
 template <typename T>
@@ -113,11 +172,96 @@ template <typename T>
 void MatrixDataSet<T>::index2coordinate(int index) {
   for (int i=0; i < matrix->getNumDim();i++) {
     int j = orderStep[i];
-    coordinate[j] = offset[j] + (index % numSteps[j])*step[j];
+    stepIndex[j]  = index % numSteps[j];
+    coordinate[j] = offset[j] + stepIndex[j]*step[j];
     index=index/numSteps[j];
   }
 }
 
+template <typename T>
+void MatrixDataSet<T>::nextCoordinate() {
+  for (int i=0; i < matrix->getNumDim(); i++) {
+    int j = orderStep[i];
+    if (++stepIndex[j] < numSteps[j]) {
+      coordinate[j] += step[j];
+      return;
+    }
+    stepIndex[j]  = 0;
+    coordinate[j] = offset[j];
+  }
+}
+
+template <typename T>
+void MatrixDataSet<T>::prepareExtraction() {
+  int nd = matrix->getNumDim();
+  extractionReady = true;
+  fastExtraction  = (nd >= 1 && nd <= 3);
+  for (int i=0; i<nd && fastExtraction; i++)
+    if (circular[i]) fastExtraction = false;
+  if (!fastExtraction) return;
+  for (int i=0; i<nd; i++) {
+    dimSize[i]   = matrix->getDimSize(i);
+    dimStride[i] = matrix->getStrideSize(i);
+  }
+  innerSize[nd-1] = 1;
+  for (int i=nd-2; i>=0; i--) innerSize[i] = innerSize[i+1]*subMatrixSize[i+1];
+  // while the inner run covers whole rows, it continues in the previous
+  // dimension
+  int d   = nd-1;
+  int run = subMatrixSize[d];
+  while (d > 0 && run == dimStride[d-1]) run *= subMatrixSize[--d];
+  copyNumDim = d+1;
+  for (int i=0; i<d; i++) {
+    copySize[i]   = subMatrixSize[i];
+    copyStride[i] = dimStride[i];
+  }
+  copySize[d]   = run;
+  copyStride[d] = 1;
+}
+
+template <typename T>
+void MatrixDataSet<T>::extractWindow(const T *data, T *pat) {
+  int nd = matrix->getNumDim();
+  int first = 0;
+  bool interior = true;
+  for (int i=0; i<nd; i++) {
+    int c = coordinate[i];
+    if (c < 0 || c + subMatrixSize[i] > dimSize[i]) {
+      interior = false;
+      break;
+    }
+    first += c*dimStride[i];
+  }
+  if (interior) {
+    switch(copyNumDim) {
+    case 1: MatrixWindowCopy<T,1>::copy(data+first, copySize, copyStride, pat);
+      break;
+    case 2: MatrixWindowCopy<T,2>::copy(data+first, copySize, copyStride, pat);
+      break;
+    default:
+      MatrixWindowCopy<T,3>::copy(data+first, copySize, copyStride, pat);
+    }
+  }
+  else {
+    switch(nd) {
+    case 1:
+      MatrixWindowPaddedCopy<T,1>::copy(data, coordinate, subMatrixSize,
+					dimSize, dimStride, innerSize,
+					defaultValue, pat);
+      break;
+    case 2:
+      MatrixWindowPaddedCopy<T,2>::copy(data, coordinate, subMatrixSize,
+					dimSize, dimStride, innerSize,
+					defaultValue, pat);
+      break;
+    default:
+      MatrixWindowPaddedCopy<T,3>::copy(data, coordinate, subMatrixSize,
+					dimSize, dimStride, innerSize,
+					defaultValue, pat);
+    }
+  }
+}
+
 template <typename T>
 void MatrixDataSet<T>::auxGetPattern(int offsetmatrix, int d) {
   int i,c,t;
@@ -163,12 +307,30 @@ void MatrixDataSet<T>::auxGetPattern(int offsetmatrix, int d) {
 template <typename T>
 int MatrixDataSet<T>::getPattern(int index, T *pat){
   index2coordinate(index); // actualiza vector coordinate
+  if (!extractionReady) prepareExtraction();
+  if (fastExtraction) {
+    extractWindow(matrix->getRawDataAccess()->getPPALForRead(), pat);
+    return patternSize();
+  }
   pattern = pat;
   offsetpat = 0;
   auxGetPattern(0, 0); // recibe offsetmatrix y dimension a tratar
   return patternSize();
 }
 
+template <typename T>
+int MatrixDataSet<T>::getPatternBunch(const int *indexes, int num, T *pats) {
+  if (!extractionReady) prepareExtraction();
+  if (!fastExtraction) return DataSet<T>::getPatternBunch(indexes, num, pats);
+  const T *data = matrix->getRawDataAccess()->getPPALForRead();
+  for (int i=0; i<num; i++) {
+    if (i > 0 && indexes[i] == indexes[i-1]+1) nextCoordinate();
+    else index2coordinate(indexes[i]);
+    extractWindow(data, pats + i*patternSizev);
+  }
+  return num*patternSizev;
+}
+
 template <typename T>
 void MatrixDataSet<T>::auxPutPattern(int offsetmatrix, int d) {
   int i,c,t;
@@ -229,6 +391,7 @@ MatrixDataSet<T>::~MatrixDataSet(){
   delete[] step;
   delete[] numSteps;
   delete[] coordinate;
+  delete[] stepIndex;
   delete[] orderStep;
   DecRef(matrix); // garbage collection
 }
@@ -522,39 +685,94 @@ int LinearCombDataSet<T>::getPattern(int index, T *pat) {
 template <typename T>
 ContextualizerDataSet<T>::ContextualizerDataSet(DataSet<T> *ds,
 						int izq, int der,
-						bool reverse) :
-  ctxtizq(izq), ctxtder(der), ds(ds), reverse(reverse) {
+						bool reverse,
+						bool reuse_window) :
+  ctxtizq(izq), ctxtder(der), ds(ds), reverse(reverse),
+  reuse_window(reuse_window),
+  window_first(0), window_index(-1),
+  range(0), range_indexes(0), range_capacity(0) {
   IncRef(ds); // garbage collection
   numpatterns = ds->numPatterns();
   patternsize = ds->patternSize()*(ctxtizq+1+ctxtder);
+  window      = new T[patternsize];
 }
 
 template <typename T>
 ContextualizerDataSet<T>::~ContextualizerDataSet() {
   DecRef(ds); // garbage collection
+  delete[] window;
+  delete[] range;
+  delete[] range_indexes;
 }
 
 template <typename T>
 int ContextualizerDataSet<T>::getPattern(int index, T *pat) {
-  T *vec = pat;
-  int ps = ds->patternSize(), i,j = index-ctxtizq;
-  if (reverse) {
-    vec += (ctxtizq+ctxtder)*ps;
-    ps   = -ps;
+  int ps = ds->patternSize(), len = ctxtizq+1+ctxtder;
+  if (!reuse_window) {
+    for (int i=0; i<len; ++i)
+      ds->getPattern(contextIndex(index, i),
+		     pat + ((reverse) ? (len-1-i) : i)*ps);
+    return patternsize;
+  }
+  if (window_index >= 0 && index == window_index+1) {
+    // the first pattern is replaced by the new last one
+    ds->getPattern(contextIndex(index, len-1), window + window_first*ps);
+    window_first = (window_first + 1) % len;
+  }
+  else if (index != window_index) {
+    for (int i=0; i<len; ++i)
+      ds->getPattern(contextIndex(index, i), window + i*ps);
+    window_first = 0;
+  }
+  window_index = index;
+  for (int i=0; i<len; ++i) {
+    T *dest = pat + ((reverse) ? (len-1-i) : i)*ps;
+    memcpy(dest, window + ((window_first + i) % len)*ps, sizeof(T)*ps);
   }
-  for (i=0; i<ctxtizq; i++,vec += ps, j++)
-    ds->getPattern(((j >= 0) ? j : 0), vec);
-  ds->getPattern(j, vec);
-  vec += ps; j++;
-  for (i=0; i<ctxtder; i++,vec += ps, j++)
-    ds->getPattern(((j < numpatterns) ? j : numpatterns-1), vec);
   return patternsize;
 }
 
+template <typename T>
+int ContextualizerDataSet<T>::getPatternBunch(const int *indexes, int num,
+					      T *pats) {
+  if (!reuse_window) return DataSet<T>::getPatternBunch(indexes, num, pats);
+  int ps = ds->patternSize(), len = ctxtizq+1+ctxtder;
+  int i = 0;
+  while (i < num) {
+    // run of consecutive indexes [indexes[i], indexes[i] + n)
+    int n = 1;
+    while (i+n < num && indexes[i+n] == indexes[i+n-1]+1) ++n;
+    int first = contextIndex(indexes[i], 0);
+    int last  = contextIndex(indexes[i+n-1], len-1);
+    int size  = last - first + 1;
+    if (size > range_capacity) {
+      delete[] range;
+      delete[] range_indexes;
+      range_capacity = size;
+      range          = new T[size*ps];
+      range_indexes  = new int[size];
+    }
+    for (int j=0; j<size; ++j) range_indexes[j] = first + j;
+    ds->getPatternBunch(range_indexes, size, range);
+    for (int k=0; k<n; ++k) {
+      T *pat = pats + (i+k)*patternsize;
+      for (int p=0; p<len; ++p) {
+	T *dest = pat + ((reverse) ? (len-1-p) : p)*ps;
+	memcpy(dest, range + (contextIndex(indexes[i+k], p) - first)*ps,
+	       sizeof(T)*ps);
+      }
+    }
+    i += n;
+  }
+  return num*patternsize;
+}
+
 template <typename T>
 int ContextualizerDataSet<T>::putPattern(int index, const T *pat) {
   const T *vec = pat;
   int ps = ds->patternSize(), i,j = index-ctxtizq;
+  // the underlying patterns at window could be modified
+  window_index = -1;
   for (i=0; i<ctxtizq; i++,vec += ps, j++)
     if (j >= 0)
       ds->putPattern(j, vec);
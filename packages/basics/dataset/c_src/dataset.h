@@ -52,6 +52,15 @@ class DataSet : public Referenced {
   /// Put the given vector pat at pattern index. The function returns the
   /// patternSize().
   virtual int putPattern(int index, const T *pat)=0;
+  /// Get the patterns of the num given indexes, one after another, to the
+  /// vector pats (num*patternSize() values). Returns the number of values.
+  /// DataSets which could do it better than num getPattern calls (for
+  /// instance, consecutive indexes) overwrite it.
+  virtual int getPatternBunch(const int *indexes, int num, T *pats) {
+    int ps = patternSize();
+    for (int i=0; i<num; ++i) getPattern(indexes[i], pats + i*ps);
+    return num*ps;
+  }
 };
 
 /// DataSet specialization to put or get patterns from a Matrix object.
@@ -86,7 +95,24 @@ class MatrixDataSet : public DataSet<T> {
   const T *const_pattern;
   /// Auxiliar, for getPattern.
   int offsetpat;
+  /// Step number of each dimension for the current coordinate.
+  int *stepIndex;
+  /// True when the window could be copied by the specialized extractors (1,
+  /// 2 or 3 dimensions, none circular). Updated by prepareExtraction() after
+  /// any setter call.
+  bool fastExtraction;
+  bool extractionReady;
+  /// Shape of the interior copy, merging the dimensions fully covered by the
+  /// window with the previous one, so a window of whole rows is a single run.
+  int copyNumDim, copySize[3], copyStride[3];
+  /// Matrix sizes and strides, and number of pattern values below each
+  /// dimension, for the windows which need padding.
+  int dimSize[3], dimStride[3], innerSize[3];
   void index2coordinate(int index);
+  /// Moves coordinate to the next index, as index2coordinate(index+1).
+  void nextCoordinate();
+  void prepareExtraction();
+  void extractWindow(const T *data, T *pat);
   void auxGetPattern(int offsetmatrix, int d);
   void auxPutPattern(int offsetmatrix, int d);
  public:
@@ -111,6 +137,8 @@ class MatrixDataSet : public DataSet<T> {
   int patternSize() { return patternSizev; }
   int getPattern(int index, T *pat);
   int putPattern(int index, const T *pat);
+  /// Consecutive indexes advance the coordinates without divisions.
+  int getPatternBunch(const int *indexes, int num, T *pats);
 };
 
 /// DataSet specialization to put or get patterns from a union of DataSets.
@@ -318,6 +346,15 @@ class LinearCombDataSet : public DataSet<T> {
    adjacents patterns, at left or/and at right positions from the interesting
    pattern index. In the case of a border limit, the interesting pattern will be
    repeated.
+
+   With reuse_window, consecutive getPattern calls (index, index+1, ...)
+   reuse the underlying patterns of the previous one, only the new right
+   pattern is asked to the underlying DataSet, and getPatternBunch asks once
+   for the patterns shared by the contexts of consecutive indexes. It is only
+   correct when the underlying patterns are a function of their index (not
+   with PerturbationDataSet or SaltNoiseDataSet) and they are not modified
+   between calls except through putPattern of this object. Otherwise, every
+   context pattern is asked to the underlying DataSet.
  */
 template <typename T>
 class ContextualizerDataSet : public DataSet<T> {
@@ -334,13 +371,36 @@ class ContextualizerDataSet : public DataSet<T> {
     patternsize;
   /// Indicates if the context will be reversed.
   bool reverse;
+  /// Indicates if the underlying patterns are reused between calls.
+  bool reuse_window;
+  /// Ring buffer with the ctxtizq+1+ctxtder underlying patterns of the last
+  /// index, reused when the next index is asked (sequential access).
+  T *window;
+  /// Position at window of the first (left) pattern.
+  int window_first;
+  /// Index of the patterns at window, -1 if not valid.
+  int window_index;
+  /// Auxiliar, for getPatternBunch, underlying patterns and its indexes.
+  T   *range;
+  int *range_indexes;
+  int  range_capacity;
+  /// Index of the underlying pattern at position pos of the context of index.
+  int contextIndex(int index, int pos) const {
+    int j = index - ctxtizq + pos;
+    return (j < 0) ? 0 : ((j < numpatterns) ? j : numpatterns-1);
+  }
  public:
-  ContextualizerDataSet(DataSet<T> *ds,int izq, int der, bool reverse=false);
+  ContextualizerDataSet(DataSet<T> *ds,int izq, int der, bool reverse=false,
+			bool reuse_window=false);
   virtual ~ContextualizerDataSet();
   int numPatterns() { return numpatterns; }
   int patternSize() { return patternsize; }
   int getPattern(int index, T *pat);
   int putPattern(int index, const T *pat);
+  /// With reuse_window, each run of consecutive indexes is built from one
+  /// getPatternBunch of the underlying patterns of all the contexts of the
+  /// run.
+  int getPatternBunch(const int *indexes, int num, T *pats);
 };
 
 /// A specialization of DataSet for data accumulation using putPattern
@@ -23,6 +23,8 @@
 #define UTILDATASETFLOAT_H
 
 #include "dataset.h"
+#include "lru_cache_dataset.h"
+#include "quantized_dataset.h"
 
 typedef DataSet<float> DataSetFloat;
 typedef MatrixDataSet<float> MatrixDataSetFloat;
@@ -34,5 +36,7 @@ typedef PerturbationDataSet<float> PerturbationDataSetFloat;
 typedef SaltNoiseDataSet<float> SaltNoiseDataSetFloat;
 typedef DerivDataSet<float> DerivDataSetFloat;
 typedef CacheDataSet<float> CacheDataSetFloat;
+typedef LRUCacheDataSet<float> LRUCacheDataSetFloat;
+typedef QuantizedDataSet<float> QuantizedDataSetFloat;
 
 #endif // UTILDATASETFLOAT_H
@@ -24,12 +24,14 @@
 
 #include "token_base.h"
 #include "token_memory_block.h"
+#include "token_class_indices.h"
 #include "token_vector.h"
 #include "table_of_token_codes.h"
 #include "dataset.h"
 #include "datasetFloat.h"
 #include "wrapper.h"
 #include "vector.h"
+#include "maxmin.h"
 
 class DataSetToken : public Referenced {
 public:
@@ -49,6 +51,34 @@ public:
 			       Token *pat)=0;
 };
 
+/// Joins the class indices of the patterns of a bunch, first is the pattern
+/// of indexes[0], already computed by the caller, and it is released here
+inline Token *classIndicesBunch(DataSetToken *ds, Token *first,
+				const int *indexes, unsigned int bunch_size) {
+  TokenClassIndices *aux = first->convertTo<TokenClassIndices*>();
+  TokenClassIndices *output = new TokenClassIndices(bunch_size,
+						    aux->getNumClasses(),
+						    aux->getWeights() != 0);
+  int   *output_indices = output->getIndices()->getPPALForWrite();
+  float *output_weights = 0;
+  if (output->getWeights()) output_weights = output->getWeights()->getPPALForWrite();
+  for (unsigned int i=0; i<bunch_size; ++i) {
+    if (i > 0) {
+      first = ds->getPattern(indexes[i]);
+      aux   = first->convertTo<TokenClassIndices*>();
+    }
+    IncRef(first);
+    output_indices[i] = aux->getIndices()->getPPALForRead()[0];
+    if (output_weights) {
+      if (aux->getWeights() == 0)
+	ERROR_EXIT(128, "Found class indices with and without weights\n");
+      output_weights[i] = aux->getWeights()->getPPALForRead()[0];
+    }
+    DecRef(first);
+  }
+  return output;
+}
+
 class DataSetTokenVector : public DataSetToken {
   april_utils::vector<Token*> data;
   int pattern_size;
@@ -77,6 +107,9 @@ public:
     Token *aux_token = getPattern(indexes[0]);
     TokenCode token_code = aux_token->getTokenCode();
     switch(token_code) {
+    case table_of_token_codes::token_class_indices:
+      output = classIndicesBunch(this, aux_token, indexes, bunch_size);
+      break;
     case table_of_token_codes::token_mem_block: {
       TokenMemoryBlock *output_mem_token;
       output_mem_token = new TokenMemoryBlock(bunch_size * pattern_size);
@@ -176,6 +209,9 @@ public:
     Token *aux_token = getPattern(indexes[0]);
     TokenCode token_code = aux_token->getTokenCode();
     switch(token_code) {
+    case table_of_token_codes::token_class_indices:
+      output = classIndicesBunch(this, aux_token, indexes, bunch_size);
+      break;
     case table_of_token_codes::token_mem_block: {
       TokenMemoryBlock *output_mem_token;
       output_mem_token = new TokenMemoryBlock(bunch_size * pattern_size);
@@ -224,11 +260,15 @@ public:
 
 class DataSetFloat2TokenWrapper : public DataSetToken {
   FloatGPUMirroredMemoryBlock *aux_mem_block;
+  /// Auxiliar, for getPatternBunch
+  float        *aux_bunch;
+  unsigned int  aux_bunch_capacity;
   DataSetFloat *ds;
   int           pattern_size;
   int           num_patterns;
 public:
-  DataSetFloat2TokenWrapper(DataSetFloat *ds) : ds(ds) {
+  DataSetFloat2TokenWrapper(DataSetFloat *ds) :
+    aux_bunch(0), aux_bunch_capacity(0), ds(ds) {
     IncRef(ds);
     pattern_size  = ds->patternSize();
     num_patterns  = ds->numPatterns();
@@ -237,6 +277,7 @@ public:
   virtual ~DataSetFloat2TokenWrapper() {
     DecRef(ds);
     delete aux_mem_block;
+    delete[] aux_bunch;
   }
   int numPatterns() { return num_patterns; }
   int patternSize() { return pattern_size; }
@@ -250,14 +291,26 @@ public:
   Token *getPatternBunch(const int *indexes, unsigned int bunch_size) {
     TokenMemoryBlock *token = new TokenMemoryBlock(bunch_size*pattern_size);
     FloatGPUMirroredMemoryBlock *mem_block = token->getMemBlock();
-    unsigned int mem_ptr_shift = 0;
-    for (unsigned int i=0; i<bunch_size; ++i, ++mem_ptr_shift) {
+    for (unsigned int i=0; i<bunch_size; ++i)
       assert(0 <= indexes[i] && indexes[i] < num_patterns);
-      ds->getPattern(indexes[i],
-		     aux_mem_block->getPPALForWrite());
-      doScopy(pattern_size, aux_mem_block, 0, 1,
-	      mem_block, mem_ptr_shift, bunch_size,
-	      false);
+    // all the patterns at once (one after another), and then transposed to
+    // the bunch layout
+    if (bunch_size > aux_bunch_capacity) {
+      delete[] aux_bunch;
+      aux_bunch_capacity = bunch_size;
+      aux_bunch = new float[aux_bunch_capacity*pattern_size];
+    }
+    ds->getPatternBunch(indexes, bunch_size, aux_bunch);
+    // by blocks of patterns, so each write fills consecutive positions
+    float *mem_ptr = mem_block->getPPALForWrite();
+    const unsigned int block = 16;
+    for (unsigned int i0=0; i0<bunch_size; i0+=block) {
+      unsigned int i1 = april_utils::min(i0+block, bunch_size);
+      for (int j=0; j<pattern_size; ++j) {
+	float *dest = mem_ptr + j*bunch_size;
+	for (unsigned int i=i0; i<i1; ++i)
+	  dest[i] = aux_bunch[i*pattern_size + j];
+      }
     }
     return token;
   }
@@ -288,4 +341,78 @@ public:
   }
 };
 
+/// Wraps a DataSetFloat of pattern size 1 with class indices (from 1 to
+/// num_classes) as a DataSetToken which produces TokenClassIndices, the
+/// sparse targets of ann.loss.multi_class_cross_entropy. Optionally, another
+/// DataSetFloat of pattern size 1 gives the weight of each pattern.
+class DataSetFloat2ClassIndexTokenWrapper : public DataSetToken {
+  DataSetFloat *ds, *weights_ds;
+  int           num_classes;
+  int           num_patterns;
+  
+  int getClassIndex(int index) {
+    float value;
+    ds->getPattern(index, &value);
+    int class_index = static_cast<int>(value);
+    if (class_index < 1 || class_index > num_classes)
+      ERROR_EXIT3(128, "Class index of pattern %d out of range [1,%d]: %g\n",
+		  index+1, num_classes, value);
+    return class_index - 1;
+  }
+public:
+  DataSetFloat2ClassIndexTokenWrapper(DataSetFloat *ds, int num_classes,
+				      DataSetFloat *weights_ds=0) :
+    ds(ds), weights_ds(weights_ds), num_classes(num_classes) {
+    if (ds->patternSize() != 1)
+      ERROR_EXIT1(128, "Incorrect pattern size, expected 1, found %d\n",
+		  ds->patternSize());
+    if (num_classes < 1)
+      ERROR_EXIT(128, "The number of classes must be > 0\n");
+    num_patterns = ds->numPatterns();
+    if (weights_ds != 0) {
+      if (weights_ds->patternSize() != 1)
+	ERROR_EXIT1(128, "Incorrect weights pattern size, expected 1, "
+		    "found %d\n", weights_ds->patternSize());
+      if (weights_ds->numPatterns() != num_patterns)
+	ERROR_EXIT2(128, "Incorrect number of weights, expected %d, "
+		    "found %d\n", num_patterns, weights_ds->numPatterns());
+      IncRef(weights_ds);
+    }
+    IncRef(ds);
+  }
+  virtual ~DataSetFloat2ClassIndexTokenWrapper() {
+    DecRef(ds);
+    if (weights_ds) DecRef(weights_ds);
+  }
+  int numPatterns() { return num_patterns; }
+  /// The size of the dense patterns, the number of classes
+  int patternSize() { return num_classes; }
+  Token *getPattern(int index) {
+    if (index < 0 || index >= num_patterns) return 0;
+    return getPatternBunch(&index, 1);
+  }
+  Token *getPatternBunch(const int *indexes, unsigned int bunch_size) {
+    TokenClassIndices *token = new TokenClassIndices(bunch_size, num_classes,
+						     weights_ds != 0);
+    int *indices = token->getIndices()->getPPALForWrite();
+    for (unsigned int i=0; i<bunch_size; ++i) {
+      assert(0 <= indexes[i] && indexes[i] < num_patterns);
+      indices[i] = getClassIndex(indexes[i]);
+    }
+    if (weights_ds != 0) {
+      float *weights = token->getWeights()->getPPALForWrite();
+      for (unsigned int i=0; i<bunch_size; ++i)
+	weights_ds->getPattern(indexes[i], weights + i);
+    }
+    return token;
+  }
+  void putPattern(int index, Token *pat) {
+    ERROR_EXIT(128, "Not implemented!!!\n");
+  }
+  void putPatternBunch(const int *indexes,unsigned int bunch_size,
+		       Token *pat) {
+    ERROR_EXIT(128, "Not implemented!!!\n");
+  }
+};
+
 #endif // UTILDATASETFLOAT_H
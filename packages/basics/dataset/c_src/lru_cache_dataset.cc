@@ -0,0 +1,258 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Francisco Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef LRU_CACHE_DATASET_CC
+#define LRU_CACHE_DATASET_CC
+
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include "lru_cache_dataset.h"
+#include "error_print.h"
+
+template <typename T>
+int LRUCacheDataSet<T>::createSpillFile(const char *spill_dir) {
+  // a new file with a unique name, which is unlinked at once, so it
+  // disappears when it is closed (or when the process dies)
+  const char *name_template = "/april_lru_cache_XXXXXX";
+  char *filename = new char[strlen(spill_dir)+strlen(name_template)+1];
+  strcpy(filename, spill_dir);
+  strcat(filename, name_template);
+  int fd = mkstemp(filename);
+  if (fd >= 0) ::unlink(filename);
+  delete[] filename;
+  return fd;
+}
+
+template <typename T>
+LRUCacheDataSet<T>::LRUCacheDataSet(DataSet<T> *ds, size_t memory_budget,
+				    int num_shards, int spill_fd) :
+  ds(ds), numpatterns(ds->numPatterns()), patternsize(ds->patternSize()),
+  num_shards(num_shards), on_disk(0), spill_fd(spill_fd) {
+  if (num_shards < 1)
+    ERROR_EXIT(128, "The number of shards must be > 0\n");
+  if (patternsize < 1)
+    ERROR_EXIT(128, "The pattern size must be > 0\n");
+  IncRef(ds);
+  // number of patterns which fit in the memory budget, at least one by shard
+  size_t capacity = memory_budget / (sizeof(T)*patternsize);
+  if (capacity > static_cast<size_t>(numpatterns)) capacity = numpatterns;
+  if (capacity < static_cast<size_t>(num_shards)) capacity = num_shards;
+  shards = new Shard[num_shards];
+  for (int i=0; i<num_shards; ++i) {
+    Shard &s = shards[i];
+    pthread_mutex_init(&s.mutex, 0);
+    s.capacity   = static_cast<int>((capacity + num_shards - 1 - i)/num_shards);
+    s.data       = new T[s.capacity*patternsize];
+    s.slot_index = new int[s.capacity];
+    s.prev       = new int[s.capacity];
+    s.next       = new int[s.capacity];
+    s.used       = 0;
+    s.head = s.tail = -1;
+    s.hits = s.disk_hits = s.misses = s.evictions = 0;
+  }
+  slot_of = new int[numpatterns];
+  for (int i=0; i<numpatterns; ++i) slot_of[i] = -1;
+  pthread_mutex_init(&ds_mutex, 0);
+  if (spill_fd >= 0) {
+    on_disk = new unsigned char[numpatterns];
+    memset(on_disk, 0, numpatterns);
+  }
+}
+
+template <typename T>
+LRUCacheDataSet<T>::~LRUCacheDataSet() {
+  for (int i=0; i<num_shards; ++i) {
+    pthread_mutex_destroy(&shards[i].mutex);
+    delete[] shards[i].data;
+    delete[] shards[i].slot_index;
+    delete[] shards[i].prev;
+    delete[] shards[i].next;
+  }
+  delete[] shards;
+  delete[] slot_of;
+  pthread_mutex_destroy(&ds_mutex);
+  if (spill_fd >= 0) close(spill_fd);
+  delete[] on_disk;
+  DecRef(ds);
+}
+
+template <typename T>
+void LRUCacheDataSet<T>::removeFromList(Shard &s, int slot) {
+  if (s.prev[slot] >= 0) s.next[s.prev[slot]] = s.next[slot];
+  else s.head = s.next[slot];
+  if (s.next[slot] >= 0) s.prev[s.next[slot]] = s.prev[slot];
+  else s.tail = s.prev[slot];
+}
+
+template <typename T>
+void LRUCacheDataSet<T>::pushFront(Shard &s, int slot) {
+  s.prev[slot] = -1;
+  s.next[slot] = s.head;
+  if (s.head >= 0) s.prev[s.head] = slot;
+  s.head = slot;
+  if (s.tail < 0) s.tail = slot;
+}
+
+template <typename T>
+int LRUCacheDataSet<T>::takeSlot(Shard &s) {
+  if (s.used < s.capacity) return s.used++;
+  int slot   = s.tail;
+  int victim = s.slot_index[slot];
+  removeFromList(s, slot);
+  // slots without pattern (see putPattern) are not evictions
+  if (victim >= 0) {
+    slot_of[victim] = -1;
+    if (on_disk != 0 && !on_disk[victim]) {
+      writeSpill(victim, s.data + slot*patternsize);
+      on_disk[victim] = 1;
+    }
+    ++s.evictions;
+  }
+  return slot;
+}
+
+template <typename T>
+bool LRUCacheDataSet<T>::readSpill(int index, T *pat) {
+  size_t bytes = sizeof(T)*patternsize;
+  return pread(spill_fd, pat, bytes,
+	       static_cast<off_t>(index)*bytes) == static_cast<ssize_t>(bytes);
+}
+
+template <typename T>
+void LRUCacheDataSet<T>::writeSpill(int index, const T *pat) {
+  size_t bytes = sizeof(T)*patternsize;
+  if (pwrite(spill_fd, pat, bytes,
+	     static_cast<off_t>(index)*bytes) != static_cast<ssize_t>(bytes))
+    ERROR_EXIT(128, "Unable to write the spill file\n");
+}
+
+template <typename T>
+int LRUCacheDataSet<T>::getPattern(int index, T *pat) {
+  if (index < 0 || index >= numpatterns) return 0;
+  Shard &s = shardOf(index);
+  pthread_mutex_lock(&s.mutex);
+  int slot = slot_of[index];
+  if (slot >= 0) {
+    memcpy(pat, s.data + slot*patternsize, sizeof(T)*patternsize);
+    removeFromList(s, slot);
+    pushFront(s, slot);
+    ++s.hits;
+    pthread_mutex_unlock(&s.mutex);
+    return patternsize;
+  }
+  bool spilled = (on_disk != 0 && on_disk[index]);
+  pthread_mutex_unlock(&s.mutex);
+  // the pattern is read or computed without the shard lock
+  if (spilled && readSpill(index, pat)) {
+    pthread_mutex_lock(&s.mutex);
+    ++s.disk_hits;
+  }
+  else {
+    pthread_mutex_lock(&ds_mutex);
+    ds->getPattern(index, pat);
+    pthread_mutex_unlock(&ds_mutex);
+    pthread_mutex_lock(&s.mutex);
+    ++s.misses;
+  }
+  // another thread could have inserted it meanwhile
+  if (slot_of[index] < 0) {
+    slot = takeSlot(s);
+    memcpy(s.data + slot*patternsize, pat, sizeof(T)*patternsize);
+    s.slot_index[slot] = index;
+    slot_of[index]     = slot;
+    pushFront(s, slot);
+  }
+  pthread_mutex_unlock(&s.mutex);
+  return patternsize;
+}
+
+template <typename T>
+int LRUCacheDataSet<T>::putPattern(int index, const T *pat) {
+  if (index < 0 || index >= numpatterns) return 0;
+  Shard &s = shardOf(index);
+  pthread_mutex_lock(&ds_mutex);
+  int result = ds->putPattern(index, pat);
+  pthread_mutex_unlock(&ds_mutex);
+  pthread_mutex_lock(&s.mutex);
+  int slot = slot_of[index];
+  if (slot >= 0) {
+    // the slot goes to the tail, without pattern, to be reused first
+    slot_of[index] = -1;
+    s.slot_index[slot] = -1;
+    removeFromList(s, slot);
+    s.prev[slot] = s.tail;
+    s.next[slot] = -1;
+    if (s.tail >= 0) s.next[s.tail] = slot;
+    else s.head = slot;
+    s.tail = slot;
+  }
+  // the spilled copy is outdated
+  if (on_disk != 0) on_disk[index] = 0;
+  pthread_mutex_unlock(&s.mutex);
+  return result;
+}
+
+template <typename T>
+typename LRUCacheDataSet<T>::Stats LRUCacheDataSet<T>::getStats() {
+  Stats stats;
+  stats.hits = stats.disk_hits = stats.misses = stats.evictions = 0;
+  stats.entries = stats.capacity = 0;
+  for (int i=0; i<num_shards; ++i) {
+    Shard &s = shards[i];
+    pthread_mutex_lock(&s.mutex);
+    stats.hits      += s.hits;
+    stats.disk_hits += s.disk_hits;
+    stats.misses    += s.misses;
+    stats.evictions += s.evictions;
+    stats.entries   += s.used;
+    stats.capacity  += s.capacity;
+    pthread_mutex_unlock(&s.mutex);
+  }
+  return stats;
+}
+
+template <typename T>
+void LRUCacheDataSet<T>::resetStats() {
+  for (int i=0; i<num_shards; ++i) {
+    Shard &s = shards[i];
+    pthread_mutex_lock(&s.mutex);
+    s.hits = s.disk_hits = s.misses = s.evictions = 0;
+    pthread_mutex_unlock(&s.mutex);
+  }
+}
+
+template <typename T>
+void LRUCacheDataSet<T>::clear() {
+  for (int i=0; i<num_shards; ++i) {
+    Shard &s = shards[i];
+    pthread_mutex_lock(&s.mutex);
+    for (int slot=s.head; slot>=0; slot=s.next[slot])
+      if (s.slot_index[slot] >= 0) slot_of[s.slot_index[slot]] = -1;
+    s.used = 0;
+    s.head = s.tail = -1;
+    // the spill flags of the shard patterns are protected by its mutex
+    if (on_disk != 0)
+      for (int index=i; index<numpatterns; index+=num_shards) on_disk[index] = 0;
+    pthread_mutex_unlock(&s.mutex);
+  }
+}
+
+#endif // LRU_CACHE_DATASET_CC
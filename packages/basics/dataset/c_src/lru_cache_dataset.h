@@ -0,0 +1,110 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Francisco Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef LRU_CACHE_DATASET_H
+#define LRU_CACHE_DATASET_H
+
+#include <pthread.h>
+#include "dataset.h"
+
+/// A DataSet which keeps the most recently used patterns of another DataSet
+/// (usually an expensive chain of contextualizer, deriv, linearcomb, join...)
+/**
+   The cache has a memory budget in bytes, which fixes the number of patterns
+   it holds, and it is divided in shards (pattern index modulo number of
+   shards), each one with its own LRU list and mutex, so getPattern could be
+   called from several threads. The underlying DataSet is only accessed by one
+   thread at a time. Optionally, evicted patterns are written to a spill file,
+   and later misses read them from there instead of recomputing them. The
+   spill file is a new file with a unique name (mkstemp) at the given
+   directory, it is unlinked as soon as it is created, so no existing file is
+   overwritten and nothing is left behind.
+
+   Patterns must be a function of their index: random datasets (perturbation,
+   salt_noise) must not be below the cache. putPattern writes through to the
+   underlying DataSet and forgets the cached copies of the pattern.
+ */
+template <typename T>
+class LRUCacheDataSet : public DataSet<T> {
+ public:
+  struct Stats {
+    /// patterns found in memory, read from the spill file, and computed
+    long hits, disk_hits, misses;
+    /// patterns removed from memory to make room for others
+    long evictions;
+    /// used slots of memory, and maximum number of patterns in memory
+    int entries, capacity;
+  };
+
+  /// Creates the spill file at spill_dir and unlinks it. It returns the file
+  /// descriptor, or -1 (with errno) when it is not possible
+  static int createSpillFile(const char *spill_dir);
+  /// The cache owns spill_fd (from createSpillFile), -1 for no spill file
+  LRUCacheDataSet(DataSet<T> *ds, size_t memory_budget,
+		  int num_shards=16, int spill_fd=-1);
+  virtual ~LRUCacheDataSet();
+  int numPatterns() { return numpatterns; }
+  int patternSize() { return patternsize; }
+  int getPattern(int index, T *pat);
+  int putPattern(int index, const T *pat);
+
+  Stats getStats();
+  void resetStats();
+  /// Forgets all the cached patterns, in memory and in the spill file. It
+  /// takes the shard locks, so it could run concurrently with getPattern
+  void clear();
+
+ private:
+  struct Shard {
+    pthread_mutex_t mutex;
+    /// patterns of the shard, capacity*patternsize values
+    T *data;
+    /// pattern index of each slot, and the LRU doubly linked list of the
+    /// used slots (head is the most recently used)
+    int *slot_index, *prev, *next;
+    int capacity, used, head, tail;
+    long hits, disk_hits, misses, evictions;
+  };
+
+  DataSet<T> *ds;
+  int numpatterns, patternsize, num_shards;
+  Shard *shards;
+  /// slot of each pattern in its shard, or -1
+  int *slot_of;
+  /// patterns which have been written to the spill file
+  unsigned char *on_disk;
+  int spill_fd;
+  /// serializes the accesses to the underlying DataSet
+  pthread_mutex_t ds_mutex;
+
+  Shard &shardOf(int index) { return shards[index % num_shards]; }
+  void removeFromList(Shard &s, int slot);
+  void pushFront(Shard &s, int slot);
+  /// Returns a slot for a new pattern, evicting the least recently used one
+  /// if the shard is full
+  int takeSlot(Shard &s);
+  bool readSpill(int index, T *pat);
+  void writeSpill(int index, const T *pat);
+};
+
+/*** Implementacion ***/
+#include "lru_cache_dataset.cc"
+
+#endif // LRU_CACHE_DATASET_H
@@ -0,0 +1,262 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Francisco Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef QUANTIZED_DATASET_CC
+#define QUANTIZED_DATASET_CC
+
+#include <cmath>
+#include <cfloat>
+#include "quantized_dataset.h"
+#include "half_float.h"
+#include "clamp.h"
+#include "maxmin.h"
+#include "error_print.h"
+
+/// Number of values read from the original DataSet by each getPatternBunch
+/// call of the constructor
+#define QUANTIZED_READ_BUNCH_VALUES 65536
+/// Size of the chunks which unpackHalfFloat decodes at once
+#define QUANTIZED_HALF_CHUNK 256
+
+template <typename T>
+QuantizedDataSet<T>::QuantizedDataSet(DataSet<T> *ds, Format format) :
+  numpatterns(ds->numPatterns()), patternsize(ds->patternSize()),
+  format(format), code_size(format == UINT8 ? 1 : 2), sum_sq_error(0.0) {
+  if (patternsize < 1)
+    ERROR_EXIT(128, "The pattern size must be > 0\n");
+  data          = new unsigned char[static_cast<size_t>(numpatterns)*
+				    patternsize*code_size];
+  scale         = new float[patternsize];
+  inv_scale     = new float[patternsize];
+  offset        = new float[patternsize];
+  feature_error = new double[patternsize];
+  double *min   = new double[patternsize];
+  double *max   = new double[patternsize];
+  for (int j=0; j<patternsize; ++j) {
+    min[j] = max[j] = 0.0;
+    feature_error[j] = 0.0;
+  }
+  int bunch = april_utils::max(1, QUANTIZED_READ_BUNCH_VALUES/patternsize);
+  int *indexes = new int[bunch];
+  T   *pats    = new T[bunch*patternsize];
+  T   *decoded = new T[patternsize];
+  // first pass, range of each feature
+  for (int first=0; first<numpatterns; first+=bunch) {
+    int n = april_utils::min(bunch, numpatterns - first);
+    for (int i=0; i<n; ++i) indexes[i] = first + i;
+    ds->getPatternBunch(indexes, n, pats);
+    for (int i=0; i<n; ++i) {
+      const T *pat = pats + i*patternsize;
+      for (int j=0; j<patternsize; ++j) {
+	double v = static_cast<double>(pat[j]);
+	if (!(v - v == 0.0))
+	  ERROR_EXIT2(128, "Non finite value at pattern %d, position %d\n",
+		      first+i+1, j+1);
+	if (first + i == 0) min[j] = max[j] = v;
+	else if (v < min[j]) min[j] = v;
+	else if (v > max[j]) max[j] = v;
+      }
+    }
+  }
+  computeParameters(min, max);
+  // second pass, encoding and error measurement
+  for (int first=0; first<numpatterns; first+=bunch) {
+    int n = april_utils::min(bunch, numpatterns - first);
+    for (int i=0; i<n; ++i) indexes[i] = first + i;
+    ds->getPatternBunch(indexes, n, pats);
+    for (int i=0; i<n; ++i) {
+      const T *pat = pats + i*patternsize;
+      unsigned char *codes = data + static_cast<size_t>(first+i)*
+	patternsize*code_size;
+      encode(pat, codes);
+      decode(codes, decoded);
+      for (int j=0; j<patternsize; ++j) {
+	double err = fabs(static_cast<double>(decoded[j]) -
+			  static_cast<double>(pat[j]));
+	if (err > feature_error[j]) feature_error[j] = err;
+	sum_sq_error += err*err;
+      }
+    }
+  }
+  delete[] indexes;
+  delete[] pats;
+  delete[] decoded;
+  delete[] min;
+  delete[] max;
+}
+
+template <typename T>
+QuantizedDataSet<T>::~QuantizedDataSet() {
+  delete[] data;
+  delete[] scale;
+  delete[] inv_scale;
+  delete[] offset;
+  delete[] feature_error;
+}
+
+template <typename T>
+void QuantizedDataSet<T>::computeParameters(const double *min,
+					    const double *max) {
+  for (int j=0; j<patternsize; ++j) {
+    double lo = min[j], hi = max[j], s = 0.0, off = 0.0;
+    switch(format) {
+    case UINT8:
+      off = lo;
+      s   = (hi - lo)/255.0;
+      break;
+    case INT16:
+      off = 0.5*(lo + hi);
+      s   = (hi - lo)/65534.0;
+      break;
+    case FP16:
+      {
+	// centering a range which contains 0 would lose the precision of
+	// the values near 0
+	if (lo > 0.0 || hi < 0.0) off = 0.5*(lo + hi);
+	double m = april_utils::max(hi - off, off - lo);
+	if (m > 0.0) {
+	  // m/s is below 2^15, inside the normal range of fp16
+	  int e;
+	  frexp(m, &e);
+	  s = ldexp(1.0, e - 15);
+	}
+      }
+      break;
+    }
+    offset[j] = static_cast<float>(off);
+    scale[j]  = static_cast<float>(s);
+    // constant features (or too narrow for a float scale) are decoded as
+    // the offset
+    if (scale[j] > 0.0f && 1.0/scale[j] < FLT_MAX)
+      inv_scale[j] = static_cast<float>(1.0/scale[j]);
+    else scale[j] = inv_scale[j] = 0.0f;
+  }
+}
+
+template <typename T>
+void QuantizedDataSet<T>::encode(const T *pat, unsigned char *codes) const {
+  switch(format) {
+  case UINT8:
+    for (int j=0; j<patternsize; ++j) {
+      double v = (static_cast<double>(pat[j]) - offset[j])*inv_scale[j];
+      v = april_utils::clamp(v, 0.0, 255.0);
+      codes[j] = static_cast<uint8_t>(round(v));
+    }
+    break;
+  case INT16:
+    {
+      int16_t *c = reinterpret_cast<int16_t*>(codes);
+      for (int j=0; j<patternsize; ++j) {
+	double v = (static_cast<double>(pat[j]) - offset[j])*inv_scale[j];
+	v = april_utils::clamp(v, -32767.0, 32767.0);
+	c[j] = static_cast<int16_t>(round(v));
+      }
+    }
+    break;
+  case FP16:
+    {
+      uint16_t *c = reinterpret_cast<uint16_t*>(codes);
+      for (int j=0; j<patternsize; ++j) {
+	double v = (static_cast<double>(pat[j]) - offset[j])*inv_scale[j];
+	v = april_utils::clamp(v, -65504.0, 65504.0);
+	c[j] = april_utils::floatToHalf(static_cast<float>(v));
+      }
+    }
+    break;
+  }
+}
+
+template <typename T>
+void QuantizedDataSet<T>::decode(const unsigned char *codes, T *pat) const {
+  const float *s = scale;
+  const float *o = offset;
+  switch(format) {
+  case UINT8:
+    for (int j=0; j<patternsize; ++j)
+      pat[j] = static_cast<T>(s[j]*codes[j] + o[j]);
+    break;
+  case INT16:
+    {
+      const int16_t *c = reinterpret_cast<const int16_t*>(codes);
+      for (int j=0; j<patternsize; ++j)
+	pat[j] = static_cast<T>(s[j]*c[j] + o[j]);
+    }
+    break;
+  case FP16:
+    {
+      const uint16_t *c = reinterpret_cast<const uint16_t*>(codes);
+      float tmp[QUANTIZED_HALF_CHUNK];
+      for (int first=0; first<patternsize; first+=QUANTIZED_HALF_CHUNK) {
+	int n = april_utils::min(QUANTIZED_HALF_CHUNK, patternsize - first);
+	april_utils::unpackHalfFloat(april_utils::HALF_FP16, c + first, 1,
+				     tmp, n);
+	for (int k=0; k<n; ++k)
+	  pat[first+k] = static_cast<T>(s[first+k]*tmp[k] + o[first+k]);
+      }
+    }
+    break;
+  }
+}
+
+template <typename T>
+int QuantizedDataSet<T>::getPattern(int index, T *pat) {
+  decode(data + static_cast<size_t>(index)*patternsize*code_size, pat);
+  return patternsize;
+}
+
+template <typename T>
+int QuantizedDataSet<T>::putPattern(int index, const T *pat) {
+  encode(pat, data + static_cast<size_t>(index)*patternsize*code_size);
+  return patternsize;
+}
+
+template <typename T>
+int QuantizedDataSet<T>::getPatternBunch(const int *indexes, int num,
+					 T *pats) {
+  size_t pattern_bytes = static_cast<size_t>(patternsize)*code_size;
+  for (int i=0; i<num; ++i)
+    decode(data + indexes[i]*pattern_bytes, pats + i*patternsize);
+  return num*patternsize;
+}
+
+template <typename T>
+typename QuantizedDataSet<T>::ErrorReport
+QuantizedDataSet<T>::getErrorReport() const {
+  ErrorReport report;
+  report.max_error     = 0.0;
+  report.worst_feature = 0;
+  for (int j=0; j<patternsize; ++j) {
+    if (feature_error[j] > report.max_error) {
+      report.max_error     = feature_error[j];
+      report.worst_feature = j;
+    }
+  }
+  double n = static_cast<double>(numpatterns)*patternsize;
+  report.rmse = (n > 0.0) ? sqrt(sum_sq_error/n) : 0.0;
+  return report;
+}
+
+template <typename T>
+size_t QuantizedDataSet<T>::getMemorySize() const {
+  return static_cast<size_t>(numpatterns)*patternsize*code_size +
+    3*patternsize*sizeof(float);
+}
+
+#endif // QUANTIZED_DATASET_CC
@@ -0,0 +1,96 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Francisco Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef QUANTIZED_DATASET_H
+#define QUANTIZED_DATASET_H
+
+#include <cstddef>
+#include <stdint.h>
+#include "dataset.h"
+
+/// A DataSet which keeps a copy of another DataSet in a compact format
+/**
+   Each feature (component of the patterns) is stored as a code of 8 or 16
+   bits, and it is recovered as value = scale[j]*code + offset[j], with the
+   scale and offset of feature j computed from its range at build time:
+
+   - UINT8: codes 0..255 over [min,max] of the feature.
+   - INT16: codes -32767..32767 over [min,max] of the feature.
+   - FP16: half floats, offset is 0 (or the center of the range when it
+     doesn't contain 0) and scale is a power of two which keeps the values
+     inside the range of fp16.
+
+   Codes are stored one pattern after another, so getPattern and
+   getPatternBunch decode contiguous runs, in loops which the compiler
+   vectorizes (fp16 uses unpackHalfFloat). The constructor measures the
+   quantization error of every feature (see getErrorReport). putPattern
+   encodes the given pattern with the build time scales, UINT8 and INT16
+   clamp the values out of the range of the feature.
+ */
+template <typename T>
+class QuantizedDataSet : public DataSet<T> {
+ public:
+  enum Format { UINT8=0, INT16=1, FP16=2 };
+  
+  struct ErrorReport {
+    /// maximum absolute error and root mean squared error over all values
+    double max_error, rmse;
+    /// feature with the maximum error
+    int worst_feature;
+  };
+  
+  QuantizedDataSet(DataSet<T> *ds, Format format);
+  virtual ~QuantizedDataSet();
+  int numPatterns() { return numpatterns; }
+  int patternSize() { return patternsize; }
+  int getPattern(int index, T *pat);
+  int putPattern(int index, const T *pat);
+  int getPatternBunch(const int *indexes, int num, T *pats);
+  
+  Format getFormat() const { return format; }
+  /// Quantization error of the patterns given to the constructor
+  ErrorReport getErrorReport() const;
+  /// Maximum absolute error of each feature, patternSize() values
+  const double *getFeatureErrors() const { return feature_error; }
+  const float *getScales() const { return scale; }
+  const float *getOffsets() const { return offset; }
+  /// Bytes used by the codes and the scales and offsets
+  size_t getMemorySize() const;
+  
+ private:
+  int numpatterns, patternsize;
+  Format format;
+  size_t code_size;
+  /// numpatterns*patternsize codes of code_size bytes
+  unsigned char *data;
+  /// per feature parameters, inv_scale is 0 for constant features
+  float *scale, *inv_scale, *offset;
+  double *feature_error;
+  double sum_sq_error;
+  
+  void computeParameters(const double *min, const double *max);
+  void encode(const T *pat, unsigned char *codes) const;
+  void decode(const unsigned char *codes, T *pat) const;
+};
+
+/*** Implementacion ***/
+#include "quantized_dataset.cc"
+
+#endif // QUANTIZED_DATASET_H
@@ -18,6 +18,8 @@
      depends = "init",
      copy{ file= "c_src/*.h", dest_dir = "include" },
      copy{ file= "c_src/dataset.cc", dest_dir = "include" },
+     copy{ file= "c_src/lru_cache_dataset.cc", dest_dir = "include" },
+     copy{ file= "c_src/quantized_dataset.cc", dest_dir = "include" },
      provide_bind{ file = "binding/bind_dataset.lua.cc", dest_dir = "include" }
    },
    target{
@@ -0,0 +1,96 @@
+-- dataset.contextualizer returns the same patterns with sequential access
+-- (reusing the previous window when asked), random access and bunches of
+-- consecutive and scattered indexes; without reuse_window, random datasets
+-- below it draw new values at every call
+local rnd = random(2468)
+local N, S = 50, 3
+local m = matrix(N, S)
+for i=1,N do for j=1,S do m:set(i,j, rnd:rand()) end end
+local base = dataset.matrix(m)
+
+-- expected pattern, the borders repeat the first and last patterns
+local function expected(i, left, right, reverse)
+  local pat = {}
+  for k=-left,right do
+    local row = base:getPattern(math.max(1, math.min(N, i+k)))
+    local pos = (reverse) and (right-k) or (k+left)
+    for j=1,S do pat[pos*S + j] = row[j] end
+  end
+  return pat
+end
+
+local function check(ds, i, pat, left, right, reverse)
+  local exp = expected(i, left, right, reverse)
+  assert(#pat == #exp)
+  for j=1,#exp do assert(pat[j] == exp[j]) end
+end
+
+for _,cfg in ipairs{ { 2, 3, false, true }, { 4, 0, true, true },
+		     { 0, 0, false, true }, { 10, 10, false, true },
+		     { 2, 3, false, false }, { 4, 0, true, false } } do
+  local left, right, reverse, reuse = cfg[1], cfg[2], cfg[3], cfg[4]
+  local ctx = dataset.contextualizer(base, left, right, reverse, reuse)
+  assert(ctx:patternSize() == S*(left+1+right))
+  -- sequential, twice the same index, and random order
+  for i=1,N do check(ctx, i, ctx:getPattern(i), left, right, reverse) end
+  for i=N,1,-1 do check(ctx, i, ctx:getPattern(i), left, right, reverse) end
+  check(ctx, 7, ctx:getPattern(7), left, right, reverse)
+  check(ctx, 7, ctx:getPattern(7), left, right, reverse)
+  for k=1,100 do
+    local i = rnd:randInt(1, N)
+    check(ctx, i, ctx:getPattern(i), left, right, reverse)
+  end
+  -- bunches (indexes from 0) with runs of consecutive indexes
+  local tok = dataset.token.wrapper(ctx)
+  for _,idx in ipairs{ { 0, 1, 2, 3, 4 }, { 45, 46, 47, 48, 49, 0, 1 },
+		       { 10, 3, 11, 12, 30, 31 }, { 20 } } do
+    local bunch = tok:getPatternBunch(idx):convert_to_memblock():to_table()
+    local n = #idx
+    for b,i in ipairs(idx) do
+      local pat = {}
+      for j=1,ctx:patternSize() do pat[j] = bunch[(j-1)*n + b] end
+      check(ctx, i+1, pat, left, right, reverse)
+    end
+  end
+end
+
+-- putPattern modifies the underlying patterns seen by the next calls
+local m2  = m:clone()
+local ctx = dataset.contextualizer(dataset.matrix(m2), 1, 1, false, true)
+ctx:getPattern(4)
+local pat = ctx:getPattern(5)
+for j=1,#pat do pat[j] = -j end
+ctx:putPattern(5, pat)
+local pat6 = ctx:getPattern(6)
+for j=1,2*S do assert(pat6[j] == -(S+j)) end
+
+-- by default the underlying patterns are asked at every call, so the matrix
+-- could be changed between calls
+local m3  = m:clone()
+local ctx = dataset.contextualizer(dataset.matrix(m3), 1, 1)
+ctx:getPattern(4)
+m3:set(5, 1, -1)
+assert(ctx:getPattern(5)[S + 1] == -1)
+
+-- a random dataset below gives new noise to each context pattern, also to
+-- the frames shared by consecutive indexes and to repeated indexes
+local noisy = dataset.perturbation{ dataset=base, random=random(77),
+				    mean=0, variance=1 }
+local ctx = dataset.contextualizer(noisy, 1, 1)
+local p1, p2 = ctx:getPattern(5), ctx:getPattern(5)
+local p3 = ctx:getPattern(6)
+local same_repeated, same_shifted = true, true
+for j=1,2*S do
+  if p1[j] ~= p2[j] then same_repeated = false end
+  if p1[S + j] ~= p3[j] then same_shifted = false end
+end
+assert(not same_repeated and not same_shifted)
+local tok   = dataset.token.wrapper(ctx)
+local bunch = tok:getPatternBunch{ 4, 5 }:convert_to_memblock():to_table()
+local same_bunch = true
+-- frame 5 (index 4 from 0) is the center of the first pattern and the left
+-- context of the second one
+for j=1,S do
+  if bunch[(S + j - 1)*2 + 1] ~= bunch[(j - 1)*2 + 2] then same_bunch = false end
+end
+assert(not same_bunch)
@@ -0,0 +1,86 @@
+-- Checks that dataset.lru_cache returns the same patterns than the cached
+-- dataset, with and without evictions and spill file
+local rnd = random(1357)
+local m = matrix(200, 4)
+for i=1,200 do for j=1,4 do m:set(i,j, rnd:rand()) end end
+local base  = dataset.matrix(m)
+local chain = dataset.deriv{ dataset=dataset.contextualizer(base, 2, 2) }
+local psize = chain:patternSize()
+
+local function check(cache, n)
+  for k=1,n do
+    local i = rnd:randInt(1, chain:numPatterns())
+    local a, b = cache:getPattern(i), chain:getPattern(i)
+    for j=1,psize do assert(a[j] == b[j]) end
+  end
+end
+
+-- everything fits in memory
+local cache = dataset.lru_cache{ dataset=chain }
+assert(cache:numPatterns() == chain:numPatterns())
+assert(cache:patternSize() == psize)
+for i=1,chain:numPatterns() do cache:getPattern(i) end
+local s = cache:stats()
+assert(s.misses == chain:numPatterns() and s.hits == 0 and s.evictions == 0)
+check(cache, 300)
+local s = cache:stats()
+assert(s.hits == 300 and s.misses == chain:numPatterns())
+cache:reset_stats()
+assert(cache:stats().hits == 0)
+
+-- room for 20 patterns in 4 shards
+local budget = 20 * psize * 4
+local cache  = dataset.lru_cache{ dataset=chain, memory=budget, shards=4 }
+assert(cache:stats().capacity == 20)
+check(cache, 500)
+local s = cache:stats()
+assert(s.evictions > 0 and s.hits + s.misses == 500 and s.entries == 20)
+-- the most recently used pattern is still in memory
+cache:getPattern(7)
+cache:reset_stats()
+cache:getPattern(7)
+assert(cache:stats().hits == 1)
+
+-- with a spill file, evicted patterns are not computed again; the spill
+-- file is created at the given directory and unlinked at once
+local spill_dir = os.tmpname()
+os.remove(spill_dir)
+assert(os.execute("mkdir " .. spill_dir) == 0)
+local function dir_is_empty()
+  local f = io.popen("ls -A " .. spill_dir)
+  local content = f:read("*a")
+  f:close()
+  return content == ""
+end
+local cache = dataset.lru_cache{ dataset=chain, memory=budget, shards=4,
+				 spill_dir=spill_dir }
+for i=1,chain:numPatterns() do cache:getPattern(i) end
+cache:reset_stats()
+check(cache, 500)
+local s = cache:stats()
+assert(s.misses == 0 and s.hits + s.disk_hits == 500 and s.disk_hits > 0)
+assert(dir_is_empty())
+cache:clear()
+check(cache, 10)
+assert(cache:stats().misses > 0)
+cache = nil
+collectgarbage("collect")
+assert(dir_is_empty())
+-- an existing file is not a directory, and it is kept untouched
+local existing = os.tmpname()
+util.write_file(existing, "keep me")
+local ok, msg = pcall(dataset.lru_cache, { dataset=chain, memory=budget,
+					    spill_dir=existing })
+assert(not ok and msg:find("spill file"))
+assert(util.read_file(existing) == "keep me")
+os.remove(existing)
+os.execute("rmdir " .. spill_dir)
+
+-- putPattern writes through and forgets the cached pattern
+local m2    = matrix(10, 3):fill(0)
+local cache = dataset.lru_cache{ dataset=dataset.matrix(m2), shards=2 }
+assert(cache:getPattern(4)[2] == 0)
+cache:putPattern(4, { 1, 2, 3 })
+assert(m2:get(4, 2) == 2)
+assert(cache:getPattern(4)[2] == 2)
+print("OK")
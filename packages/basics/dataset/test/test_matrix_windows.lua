@@ -0,0 +1,136 @@
+-- Checks the sliding windows of dataset.matrix (getPattern, getPatternBunch
+-- and toMatrix) against a direct computation, inside and across the borders
+local rnd = random(2468)
+
+-- window of pattern index (1-based), positions out of the matrix take the
+-- default value
+local function window(m, t, index)
+  local dims = m:dim()
+  local nd   = #dims
+  local coord, idx = {}, index-1
+  for i=1,nd do
+    local j = t.orderStep[i] + 1
+    coord[j] = t.offset[j] + (idx % t.numSteps[j])*t.stepSize[j]
+    idx = math.floor(idx / t.numSteps[j])
+  end
+  local pat, pos = {}, {}
+  local function fill(d)
+    if d > nd then
+      local inside = true
+      for i=1,nd do
+	if pos[i] < 0 or pos[i] >= dims[i] then inside = false end
+      end
+      local v = t.defaultValue
+      if inside then
+	local p = {}
+	for i=1,nd do p[i] = pos[i]+1 end
+	v = m:get(unpack(p))
+      end
+      table.insert(pat, v)
+      return
+    end
+    for k=0,t.patternSize[d]-1 do
+      pos[d] = coord[d] + k
+      fill(d+1)
+    end
+  end
+  fill(1)
+  return pat
+end
+
+local function check(m, t)
+  local ds = dataset.matrix(m, t)
+  local n  = ds:numPatterns()
+  assert(ds:patternSize() == #window(m, t, 1))
+  local all = ds:toMatrix()
+  local idx = {}
+  for i=1,n do idx[i] = i end
+  -- consecutive indexes, with a jump in the middle and a repetition
+  table.insert(idx, 1) table.insert(idx, 1)
+  table.insert(idx, math.ceil(n/2))
+  local bunch = ds:getPatternBunch(idx)
+  for b,i in ipairs(idx) do
+    local ref = window(m, t, i)
+    local pat = ds:getPattern(i)
+    for j=1,#ref do
+      assert(pat[j] == ref[j])
+      assert(bunch:get(b, j) == ref[j])
+      if b <= n then assert(all:get(i, j) == ref[j]) end
+    end
+  end
+end
+
+local function config(dims, t)
+  local nd = #dims
+  t.offset       = t.offset or {}
+  t.stepSize     = t.stepSize or {}
+  t.orderStep    = t.orderStep or {}
+  t.defaultValue = t.defaultValue or 0
+  for i=1,nd do
+    t.offset[i]    = t.offset[i] or 0
+    t.stepSize[i]  = t.stepSize[i] or 1
+    t.orderStep[i] = t.orderStep[i] or nd-i
+  end
+  return t
+end
+
+local function rand_matrix(dims)
+  local size = 1
+  for i=1,#dims do size = size * dims[i] end
+  local data = {}
+  for i=1,size do data[i] = rnd:rand(2) - 1 end
+  local args = { unpack(dims) }
+  table.insert(args, data)
+  return matrix(unpack(args))
+end
+
+-- 1-D: interior and border windows
+local m = rand_matrix{ 20 }
+check(m, config({20}, { patternSize={5}, numSteps={20}, offset={-2},
+			defaultValue=-7 }))
+check(m, config({20}, { patternSize={25}, numSteps={3}, offset={-3},
+			stepSize={2} }))
+
+-- 2-D: rows of a matrix (whole rows are one copy run) and image patches
+local m = rand_matrix{ 12, 9 }
+check(m, config({12,9}, { patternSize={3,9}, numSteps={10,1} }))
+check(m, config({12,9}, { patternSize={3,9}, numSteps={12,1}, offset={-1,0},
+			  defaultValue=5 }))
+check(m, config({12,9}, { patternSize={4,3}, numSteps={11,9},
+			  offset={-2,-1}, stepSize={1,1} }))
+check(m, config({12,9}, { patternSize={5,4}, numSteps={4,5}, offset={0,-2},
+			  stepSize={3,2}, orderStep={0,1} }))
+check(m, config({12,9}, { patternSize={20,20}, numSteps={2,2},
+			  offset={-4,-5}, stepSize={2,3} }))
+
+-- 3-D: spectrogram-like contexts and patches
+local m = rand_matrix{ 6, 7, 5 }
+check(m, config({6,7,5}, { patternSize={1,3,5}, numSteps={6,7,1},
+			   offset={0,-1,0} }))
+check(m, config({6,7,5}, { patternSize={2,3,2}, numSteps={6,7,5},
+			   offset={-1,-1,-1}, defaultValue=3 }))
+check(m, config({6,7,5}, { patternSize={3,2,5}, numSteps={3,4,1},
+			   stepSize={2,2,1}, orderStep={1,0,2} }))
+
+-- circular windows use the general extraction, bunch and single patterns
+-- must agree
+local m  = rand_matrix{ 8, 8 }
+local ds = dataset.matrix(m, { patternSize={3,3}, numSteps={8,8},
+			       offset={-1,-1}, circular={true,true} })
+local idx = {}
+for i=1,ds:numPatterns() do idx[i] = i end
+local bunch = ds:getPatternBunch(idx)
+for i=1,ds:numPatterns() do
+  local pat = ds:getPattern(i)
+  for j=1,9 do assert(bunch:get(i, j) == pat[j]) end
+end
+
+-- putPattern writes into the windows seen by the fast extraction
+local m  = rand_matrix{ 5, 4 }
+local ds = dataset.matrix(m, { patternSize={2,4}, numSteps={4,1} })
+ds:putPattern(2, { 1, 2, 3, 4, 5, 6, 7, 8 })
+local pat = ds:getPatternBunch{ 1, 2, 3 }
+for j=1,4 do
+  assert(pat:get(2, j) == j and pat:get(2, j+4) == j+4)
+  assert(pat:get(1, j+4) == j and pat:get(3, j) == j+4)
+end
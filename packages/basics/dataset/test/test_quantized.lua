@@ -0,0 +1,97 @@
+-- Checks dataset.quantized: decoded patterns within the error bound of each
+-- format, the error report against a direct computation, getPatternBunch
+-- and putPattern
+local rnd = random(9753)
+local nump, psize = 300, 7
+local m = matrix(nump, psize)
+for i=1,nump do
+  m:set(i, 1, rnd:rand(2) - 1)            -- zero centered
+  m:set(i, 2, 1000 + rnd:rand())          -- far from zero
+  m:set(i, 3, 5)                          -- constant
+  m:set(i, 4, rnd:randInt(0, 255))        -- bytes
+  m:set(i, 5, (rnd:rand(2) - 1) * 1e5)    -- out of the fp16 range
+  m:set(i, 6, rnd:rand() * 1e-3)          -- small values
+  m:set(i, 7, (i % 2 == 0) and 0 or 1)    -- binary
+end
+-- the bytes feature covers the whole range
+m:set(1, 4, 0)
+m:set(2, 4, 255)
+local ds = dataset.matrix(m)
+
+-- worst case error of each feature, relative to its range
+local bounds = { uint8 = 0.5/255 + 1e-6, int16 = 0.5/65534 + 1e-6,
+		 fp16 = 2^-11 + 1e-6 }
+for format,bound in pairs(bounds) do
+  local q = dataset.quantized{ dataset=ds, format=format }
+  assert(q:numPatterns() == nump and q:patternSize() == psize)
+  local report = q:error_report()
+  local ranges = {}
+  for j=1,psize do ranges[j] = { math.huge, -math.huge } end
+  local max_err, sum_sq, worst, ferr = 0, 0, 0, {}
+  for i=1,nump do
+    local a, b = q:getPattern(i), ds:getPattern(i)
+    for j=1,psize do
+      local r = ranges[j]
+      r[1], r[2] = math.min(r[1], b[j]), math.max(r[2], b[j])
+      local e = math.abs(a[j] - b[j])
+      ferr[j] = math.max(ferr[j] or 0, e)
+      sum_sq  = sum_sq + e*e
+    end
+  end
+  for j=1,psize do
+    local r = ranges[j]
+    local range = r[2] - r[1]
+    if format == "fp16" and r[1] <= 0 and r[2] >= 0 then
+      range = math.max(-r[1], r[2])
+    end
+    -- plus the rounding of the decoded float
+    local maxabs = math.max(math.abs(r[1]), math.abs(r[2]))
+    r.bound = bound*range + maxabs*2^-23
+    assert(ferr[j] <= r.bound,
+	   string.format("%s feature %d error %g range %g", format, j, ferr[j], range))
+    assert(math.abs(report.feature_errors[j] - ferr[j]) <= 1e-9*math.max(1,ferr[j]))
+    if ferr[j] > max_err then max_err, worst = ferr[j], j end
+  end
+  -- constant features are exact
+  assert(ferr[3] == 0)
+  assert(math.abs(report.max_error - max_err) <= 1e-9*max_err)
+  assert(report.worst_feature == worst)
+  assert(math.abs(report.rmse - math.sqrt(sum_sq/(nump*psize))) <= 1e-6*report.rmse)
+  local code_size = (format == "uint8") and 1 or 2
+  assert(report.memory == nump*psize*code_size + 3*psize*4)
+
+  -- bunches, with repetitions, are the same than single patterns
+  local idx = { 5, 6, 7, 1, 300, 5 }
+  local bunch = q:getPatternBunch(idx)
+  for b,i in ipairs(idx) do
+    local p = q:getPattern(i)
+    for j=1,psize do assert(bunch:get(b, j) == p[j]) end
+  end
+
+  -- putPattern uses the scales of the build, uint8 and int16 clamp the
+  -- values out of the range
+  q:putPattern(2, { 0, 1000.5, 5, 300, 0, -1, 1 })
+  local p = q:getPattern(2)
+  assert(math.abs(p[1]) <= ranges[1].bound)
+  assert(math.abs(p[2] - 1000.5) <= ranges[2].bound)
+  assert(p[3] == 5 and math.abs(p[7] - 1) <= ranges[7].bound)
+  -- fp16 only clamps to its own range
+  if format == "fp16" then assert(p[4] == 300 and p[6] < ranges[6][1])
+  else
+    assert(math.abs(p[4] - 255) <= ranges[4].bound)
+    assert(math.abs(p[6] - ranges[6][1]) <= ranges[6].bound)
+  end
+end
+
+-- uint8 keeps the bytes exactly, the same than dataset.byte
+local q = dataset.quantized{ dataset=dataset.matrix(m, { patternSize={1,1},
+							 offset={0,3},
+							 numSteps={nump,1} }) }
+local b = dataset.byte(dataset.matrix(m, { patternSize={1,1}, offset={0,3},
+					   numSteps={nump,1} }))
+for i=1,nump do
+  assert(q:getPattern(i)[1] == m:get(i, 4))
+  assert(math.abs(q:getPattern(i)[1] - b:getPattern(i)[1]) < 1e-3)
+end
+
+assert(not pcall(dataset.quantized, { dataset=ds, format="int4" }))
@@ -52,6 +52,9 @@ class GPUMirroredMemoryBlock : public Referenced {
 #endif
   unsigned int size;
   mutable T      *mem_ppal;
+  /// Memory block which owns mem_ppal when this object is a view, NULL
+  /// otherwise
+  GPUMirroredMemoryBlock<T> *parent;
 #ifdef USE_CUDA  
   mutable CUdeviceptr mem_gpu;
   mutable char        updated; // bit 0 CPU, bit 1 GPU
@@ -147,7 +150,8 @@ public:
 
   // WARNING!!! the memory zone is not initialized by default
   GPUMirroredMemoryBlock(unsigned int sz,
-			 bool initialize=false) : Referenced(), size(sz) {
+			 bool initialize=false) : Referenced(), size(sz),
+						  parent(0) {
 #ifdef USE_CUDA
     updated  = 0;
     unsetUpdatedGPU();
@@ -168,8 +172,29 @@ public:
 #endif
     if (initialize) for (unsigned int i=0; i<size; ++i) new(mem_ppal+i) T();
   }
+  /// View constructor, the new object shares sz positions of the other
+  /// memory block starting at shift. The other block is kept referenced
+  /// until the view is destroyed. Only available for CPU memory.
+  GPUMirroredMemoryBlock(GPUMirroredMemoryBlock<T> *other,
+			 unsigned int shift,
+			 unsigned int sz) : Referenced(), size(sz),
+					    parent(other) {
+#ifdef USE_CUDA
+    ERROR_EXIT(128, "Memory block views are not available with CUDA\n");
+#endif
+    if (shift + sz > other->size)
+      ERROR_EXIT3(128, "View out of memory block bounds: %u+%u > %u\n",
+		  shift, sz, other->size);
+    IncRef(parent);
+    mem_ppal = parent->mem_ppal + shift;
+  }
+  
   ~GPUMirroredMemoryBlock() {
     // for (unsigned int i=0; i<size; ++i) mem_ppal[i].~T();
+    if (parent != 0) {
+      DecRef(parent);
+      return;
+    }
 #ifdef USE_CUDA
     if (pinned) {
       if (cudaFreeHost(reinterpret_cast<void*>(mem_ppal)) != cudaSuccess)
@@ -297,6 +322,10 @@ public:
 
 // typedef for referring to float memory blocks
 typedef GPUMirroredMemoryBlock<float> FloatGPUMirroredMemoryBlock;
+// typedef for referring to int8 memory blocks (quantized weights)
+typedef GPUMirroredMemoryBlock<signed char> Int8GPUMirroredMemoryBlock;
+// typedef for referring to int memory blocks (class indices)
+typedef GPUMirroredMemoryBlock<int> IntGPUMirroredMemoryBlock;
 
 #ifndef NO_POOL
 template<typename T>
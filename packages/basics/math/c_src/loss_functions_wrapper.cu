@@ -191,6 +191,124 @@ __global__ void computeCrossEntropyGradientKernel(const float *output,
   }
 }
 
+__global__ void computeMultiClassCrossEntropyIndexedLossKernel(const float *output,
+							      const int *target_indices,
+							      const float *target_weights,
+							      float *pattern_errors,
+							      unsigned int max_x,
+							      unsigned int lda_x) {
+  unsigned int b = blockIdx.x*blockDim.x + threadIdx.x;
+  if (b < max_x) {
+    float log_o = output[getMatrixFlatIndex(b, lda_x, target_indices[b])];
+    pattern_errors[b] = (target_weights) ? target_weights[b]*log_o : log_o;
+  }
+}
+
+__global__ void computeCrossEntropyIndexedGradientKernel(const float *output,
+							 const int *target_indices,
+							 const float *target_weights,
+							 float *error_output,
+							 unsigned int max_x,
+							 unsigned int lda_x,
+							 unsigned int max_y) {
+  unsigned int matrix_x_pos, matrix_y_pos;
+  getColumnMajorBunchMatrixPositions(blockIdx,
+				     blockDim,
+				     threadIdx,
+				     matrix_x_pos,
+				     matrix_y_pos);
+  if (matrix_x_pos < max_x && matrix_y_pos < max_y) {
+    unsigned int index = getMatrixFlatIndex(matrix_x_pos, lda_x, matrix_y_pos);
+    float d = expf(output[index]);
+    if (static_cast<unsigned int>(target_indices[matrix_x_pos]) == matrix_y_pos)
+      d -= 1.0f;
+    if (target_weights) d *= target_weights[matrix_x_pos];
+    error_output[index] = d;
+  }
+}
+
+// Kernels which compute the loss of each position and the gradient at once
+
+__global__ void computeMSELossAndGradientKernel(const float *output,
+						const float *target_output,
+						float *pattern_errors,
+						float *error_output,
+						float zero_epsilon_distance,
+						unsigned int max_x,
+						unsigned int lda_x,
+						unsigned int max_y) {
+  unsigned int matrix_x_pos, matrix_y_pos;
+  getColumnMajorBunchMatrixPositions(blockIdx,
+				     blockDim,
+				     threadIdx,
+				     matrix_x_pos,
+				     matrix_y_pos);
+  if (matrix_x_pos < max_x && matrix_y_pos < max_y) {
+    unsigned int index = getMatrixFlatIndex(matrix_x_pos, lda_x, matrix_y_pos);
+    float d = output[index] - target_output[index];
+    if (fabsf(d) < zero_epsilon_distance) d = 0.0f;
+    pattern_errors[index] = d*d;
+    error_output[index]   = d;
+  }
+}
+
+__global__ void computeMAELossAndGradientKernel(const float *output,
+						const float *target_output,
+						float *pattern_errors,
+						float *error_output,
+						float zero_epsilon_distance,
+						unsigned int max_x,
+						unsigned int lda_x,
+						unsigned int max_y,
+						float invN) {
+  unsigned int matrix_x_pos, matrix_y_pos;
+  getColumnMajorBunchMatrixPositions(blockIdx,
+				     blockDim,
+				     threadIdx,
+				     matrix_x_pos,
+				     matrix_y_pos);
+  if (matrix_x_pos < max_x && matrix_y_pos < max_y) {
+    unsigned int index = getMatrixFlatIndex(matrix_x_pos, lda_x, matrix_y_pos);
+    float d    = output[index] - target_output[index];
+    float absd = fabsf(d);
+    pattern_errors[index] = absd * invN;
+    if (absd < zero_epsilon_distance) error_output[index] = 0.0f;
+    else error_output[index] = (d < 0.0f) ? -invN : invN;
+  }
+}
+
+__global__ void computeCrossEntropyLossAndGradientKernel(const float *output,
+							 const float *target_output,
+							 float *pattern_errors,
+							 float *error_output,
+							 float epsilon,
+							 unsigned int max_x,
+							 unsigned int lda_x,
+							 unsigned int max_y,
+							 bool multi_class) {
+  unsigned int matrix_x_pos, matrix_y_pos;
+  getColumnMajorBunchMatrixPositions(blockIdx,
+				     blockDim,
+				     threadIdx,
+				     matrix_x_pos,
+				     matrix_y_pos);
+  if (matrix_x_pos < max_x && matrix_y_pos < max_y) {
+    unsigned int index = getMatrixFlatIndex(matrix_x_pos, lda_x, matrix_y_pos);
+    float log_o = output[index];
+    float o     = expf(log_o);
+    float t     = clip(target_output[index], epsilon, 1.0f - epsilon);
+    float e     = 0.0f;
+    if (t > epsilon) e += t * log_o;
+    if (!multi_class) {
+      float log_inv_o = (o<1.0f) ? logf(1.0f - o) : logf(epsilon);
+      float inv_t     = clip(1.0f - target_output[index], epsilon, 1.0f - epsilon);
+      if (inv_t > epsilon) e += inv_t * log_inv_o;
+    }
+    pattern_errors[index] = e;
+    error_output[index]   = o - target_output[index];
+  }
+}
+
 __global__ void applyTanhErrorFunctionKernel(const float *output,
 					     const float *target_output,
 					     float *output_error,
@@ -570,6 +688,320 @@ void doComputeCrossEntropyGradient(FloatGPUMirroredMemoryBlock *input,
 #endif
 }
 
+float doMultiClassCrossEntropyLossFunctionIndexed(FloatGPUMirroredMemoryBlock *input,
+						  IntGPUMirroredMemoryBlock *target_indices,
+						  FloatGPUMirroredMemoryBlock *target_weights,
+						  unsigned int size,
+						  unsigned int bunch_size,
+						  bool use_gpu) {
+#ifdef USE_CUDA
+  if (use_gpu) {
+    const float *input_ptr   = input->getGPUForRead();
+    const int   *indices_ptr = target_indices->getGPUForRead();
+    const float *weights_ptr = (target_weights) ? target_weights->getGPUForRead() : 0;
+    FloatGPUMirroredMemoryBlock *pattern_errors =
+      new FloatGPUMirroredMemoryBlock(bunch_size);
+    float *pattern_errors_ptr = pattern_errors->getGPUForWrite();
+    dim3 block, grid;
+    computeBlockAndGridSizesForAnArray(bunch_size, block, grid);
+    computeMultiClassCrossEntropyIndexedLossKernel<<<grid, block, 0, GPUHelper::getCurrentStream()>>>
+      (input_ptr,
+       indices_ptr,
+       weights_ptr,
+       pattern_errors_ptr,
+       bunch_size,
+       bunch_size);
+    // all the errors are <= 0, and sasum returns the sum of absolute values
+    float sum = -cublasSasum(bunch_size, pattern_errors_ptr, 1);
+    delete pattern_errors;
+    return sum;
+  }
+  else {
+#endif
+    // only one element of each column is touched
+    const float *input_ptr   = input->getPPALForRead();
+    const int   *indices_ptr = target_indices->getPPALForRead();
+    const float *weights_ptr = (target_weights) ? target_weights->getPPALForRead() : 0;
+    float sum = 0.0f;
+    for (unsigned int b=0; b<bunch_size; ++b) {
+      assert(0 <= indices_ptr[b] && indices_ptr[b] < static_cast<int>(size) &&
+	     "Class index out of range");
+      float log_o = input_ptr[indices_ptr[b]*bunch_size + b];
+      assert(!(log_o > 0.0f) &&
+	     "Only log-based activation functions are allowed");
+      sum += (weights_ptr) ? weights_ptr[b]*log_o : log_o;
+    }
+    return sum;
+#ifdef USE_CUDA
+  }
+#endif
+}
+
+void doComputeCrossEntropyGradientIndexed(FloatGPUMirroredMemoryBlock *input,
+					  IntGPUMirroredMemoryBlock *target_indices,
+					  FloatGPUMirroredMemoryBlock *target_weights,
+					  FloatGPUMirroredMemoryBlock *error_output,
+					  unsigned int size,
+					  unsigned int bunch_size,
+					  bool use_gpu) {
+#ifdef USE_CUDA
+  if (use_gpu) {
+    const float *input_ptr   = input->getGPUForRead();
+    const int   *indices_ptr = target_indices->getGPUForRead();
+    const float *weights_ptr = (target_weights) ? target_weights->getGPUForRead() : 0;
+    float *error_output_ptr  = error_output->getGPUForWrite();
+    dim3 block, grid;
+    computeBlockAndGridSizesForAColumnMajorBunch(bunch_size, size,
+						 block, grid);
+    computeCrossEntropyIndexedGradientKernel<<<grid, block, 0, GPUHelper::getCurrentStream()>>>
+      (input_ptr,
+       indices_ptr,
+       weights_ptr,
+       error_output_ptr,
+       bunch_size,
+       bunch_size,
+       size);
+  }
+  else {
+#endif
+    const float *input_ptr   = input->getPPALForRead();
+    const int   *indices_ptr = target_indices->getPPALForRead();
+    const float *weights_ptr = (target_weights) ? target_weights->getPPALForRead() : 0;
+    float *error_output_ptr  = error_output->getPPALForWrite();
+    // softmax, and the one-hot target is subtracted in place
+    for (unsigned int i=0; i<size*bunch_size; ++i)
+      error_output_ptr[i] = expf(input_ptr[i]);
+    for (unsigned int b=0; b<bunch_size; ++b)
+      error_output_ptr[indices_ptr[b]*bunch_size + b] -= 1.0f;
+    if (weights_ptr) {
+      for (unsigned int i=0; i<size; ++i, error_output_ptr += bunch_size)
+	for (unsigned int b=0; b<bunch_size; ++b)
+	  error_output_ptr[b] *= weights_ptr[b];
+    }
+#ifdef USE_CUDA
+  }
+#endif
+}
+
+float doMSELossAndGradient(FloatGPUMirroredMemoryBlock *input,
+			   FloatGPUMirroredMemoryBlock *target,
+			   FloatGPUMirroredMemoryBlock *error_output,
+			   float zero_epsilon_distance,
+			   unsigned int size,
+			   unsigned int bunch_size,
+			   bool use_gpu) {
+#ifdef USE_CUDA
+  if (use_gpu) {
+    const float *input_ptr  = input->getGPUForRead();
+    const float *target_ptr = target->getGPUForRead();
+    float *error_output_ptr = error_output->getGPUForWrite();
+    FloatGPUMirroredMemoryBlock *pattern_errors =
+      new FloatGPUMirroredMemoryBlock(size*bunch_size);
+    float *pattern_errors_ptr = pattern_errors->getGPUForWrite();
+    dim3 block, grid;
+    computeBlockAndGridSizesForAColumnMajorBunch(bunch_size, size,
+						 block, grid);
+    computeMSELossAndGradientKernel<<<grid, block, 0, GPUHelper::getCurrentStream()>>>
+      (input_ptr,
+       target_ptr,
+       pattern_errors_ptr,
+       error_output_ptr,
+       zero_epsilon_distance,
+       bunch_size,
+       bunch_size,
+       size);
+    float sum = cublasSasum(pattern_errors->getSize(), pattern_errors_ptr, 1);
+    delete pattern_errors;
+    return sum;
+  }
+  else {
+#endif
+    const float *input_ptr  = input->getPPALForRead();
+    const float *target_ptr = target->getPPALForRead();
+    float *error_output_ptr = error_output->getPPALForWrite();
+    float sum = 0.0f;
+    for (unsigned int i=0; i<size*bunch_size; ++i) {
+      float d = input_ptr[i] - target_ptr[i];
+      if (fabsf(d) < zero_epsilon_distance) d = 0.0f;
+      sum += d*d;
+      error_output_ptr[i] = d;
+    }
+    return sum;
+#ifdef USE_CUDA
+  }
+#endif
+}
+
+float doMAELossAndGradient(FloatGPUMirroredMemoryBlock *input,
+			   FloatGPUMirroredMemoryBlock *target,
+			   FloatGPUMirroredMemoryBlock *error_output,
+			   float zero_epsilon_distance,
+			   unsigned int size,
+			   unsigned int bunch_size,
+			   bool use_gpu) {
+  float invN = 1.0f/size;
+#ifdef USE_CUDA
+  if (use_gpu) {
+    const float *input_ptr  = input->getGPUForRead();
+    const float *target_ptr = target->getGPUForRead();
+    float *error_output_ptr = error_output->getGPUForWrite();
+    FloatGPUMirroredMemoryBlock *pattern_errors =
+      new FloatGPUMirroredMemoryBlock(size*bunch_size);
+    float *pattern_errors_ptr = pattern_errors->getGPUForWrite();
+    dim3 block, grid;
+    computeBlockAndGridSizesForAColumnMajorBunch(bunch_size, size,
+						 block, grid);
+    computeMAELossAndGradientKernel<<<grid, block, 0, GPUHelper::getCurrentStream()>>>
+      (input_ptr,
+       target_ptr,
+       pattern_errors_ptr,
+       error_output_ptr,
+       zero_epsilon_distance,
+       bunch_size,
+       bunch_size,
+       size,
+       invN);
+    float sum = cublasSasum(pattern_errors->getSize(), pattern_errors_ptr, 1);
+    delete pattern_errors;
+    return sum;
+  }
+  else {
+#endif
+    const float *input_ptr  = input->getPPALForRead();
+    const float *target_ptr = target->getPPALForRead();
+    float *error_output_ptr = error_output->getPPALForWrite();
+    float sum = 0.0f;
+    for (unsigned int i = 0; i < size; i++) {
+      float mae = 0.0f;
+      for (unsigned int b=0; b<bunch_size; ++b) {
+	float d    = input_ptr[b] - target_ptr[b];
+	float absd = fabsf(d);
+	mae += absd;
+	if (absd < zero_epsilon_distance) error_output_ptr[b] = 0.0f;
+	else error_output_ptr[b] = (d < 0.0f) ? -invN : invN;
+      }
+      sum += mae*invN;
+      input_ptr  += bunch_size;
+      target_ptr += bunch_size;
+      error_output_ptr += bunch_size;
+    }
+    return sum;
+#ifdef USE_CUDA
+  }
+#endif
+}
+
+float doCrossEntropyLossAndGradient(FloatGPUMirroredMemoryBlock *input,
+				    FloatGPUMirroredMemoryBlock *target,
+				    FloatGPUMirroredMemoryBlock *error_output,
+				    float EPSILON,
+				    unsigned int size,
+				    unsigned int bunch_size,
+				    bool multi_class,
+				    bool use_gpu) {
+#ifdef USE_CUDA
+  if (use_gpu) {
+    const float *input_ptr  = input->getGPUForRead();
+    const float *target_ptr = target->getGPUForRead();
+    float *error_output_ptr = error_output->getGPUForWrite();
+    FloatGPUMirroredMemoryBlock *pattern_errors =
+      new FloatGPUMirroredMemoryBlock(size*bunch_size);
+    float *pattern_errors_ptr = pattern_errors->getGPUForWrite();
+    dim3 block, grid;
+    computeBlockAndGridSizesForAColumnMajorBunch(bunch_size, size,
+						 block, grid);
+    computeCrossEntropyLossAndGradientKernel<<<grid, block, 0, GPUHelper::getCurrentStream()>>>
+      (input_ptr,
+       target_ptr,
+       pattern_errors_ptr,
+       error_output_ptr,
+       EPSILON,
+       bunch_size,
+       bunch_size,
+       size,
+       multi_class);
+    // all the errors are <= 0, and sasum returns the sum of absolute values
+    float sum = -cublasSasum(pattern_errors->getSize(), pattern_errors_ptr, 1);
+    delete pattern_errors;
+    return sum;
+  }
+  else {
+#endif
+    const float *input_ptr  = input->getPPALForRead();
+    const float *target_ptr = target->getPPALForRead();
+    float *error_output_ptr = error_output->getPPALForWrite();
+    float sum = 0.0f;
+    for (unsigned int i=0; i<size*bunch_size; ++i) {
+      assert(!(input_ptr[i] > 0.0f) &&
+	     "Only log-based activation functions are allowed");
+      assert(!(target_ptr[i] < 0.0f) && !(target_ptr[i] > 1.0f) &&
+	     "Only [0,1] target patterns are allowed");
+      float log_o = input_ptr[i];
+      float t     = clamp(target_ptr[i], EPSILON, 1.0f - EPSILON);
+      if (t > EPSILON) sum += t * log_o;
+      if (!multi_class) {
+	double o        = exp(log_o);
+	float log_inv_o = (o<1.0) ? log(1.0 - o) : log(EPSILON);
+	float inv_t     = clamp(1.0f - target_ptr[i], EPSILON, 1.0f - EPSILON);
+	if (inv_t > EPSILON) sum += inv_t * log_inv_o;
+      }
+      error_output_ptr[i] = expf(log_o) - target_ptr[i];
+    }
+    return sum;
+#ifdef USE_CUDA
+  }
+#endif
+}
+
+float doMultiClassCrossEntropyLossAndGradientIndexed(FloatGPUMirroredMemoryBlock *input,
+						     IntGPUMirroredMemoryBlock *target_indices,
+						     FloatGPUMirroredMemoryBlock *target_weights,
+						     FloatGPUMirroredMemoryBlock *error_output,
+						     unsigned int size,
+						     unsigned int bunch_size,
+						     bool use_gpu) {
+#ifdef USE_CUDA
+  if (use_gpu) {
+    // the loss only touches one element by pattern, it is not worth to fuse
+    float sum = doMultiClassCrossEntropyLossFunctionIndexed(input,
+							    target_indices,
+							    target_weights,
+							    size, bunch_size,
+							    use_gpu);
+    doComputeCrossEntropyGradientIndexed(input, target_indices, target_weights,
+					 error_output, size, bunch_size,
+					 use_gpu);
+    return sum;
+  }
+  else {
+#endif
+    const float *input_ptr   = input->getPPALForRead();
+    const int   *indices_ptr = target_indices->getPPALForRead();
+    const float *weights_ptr = (target_weights) ? target_weights->getPPALForRead() : 0;
+    float *error_output_ptr  = error_output->getPPALForWrite();
+    for (unsigned int i=0; i<size*bunch_size; ++i)
+      error_output_ptr[i] = expf(input_ptr[i]);
+    // the loss is computed while the one-hot target is subtracted
+    float sum = 0.0f;
+    for (unsigned int b=0; b<bunch_size; ++b) {
+      assert(0 <= indices_ptr[b] && indices_ptr[b] < static_cast<int>(size) &&
+	     "Class index out of range");
+      unsigned int pos = indices_ptr[b]*bunch_size + b;
+      float w = (weights_ptr) ? weights_ptr[b] : 1.0f;
+      sum += w*input_ptr[pos];
+      error_output_ptr[pos] -= 1.0f;
+    }
+    if (weights_ptr) {
+      for (unsigned int i=0; i<size; ++i, error_output_ptr += bunch_size)
+	for (unsigned int b=0; b<bunch_size; ++b)
+	  error_output_ptr[b] *= weights_ptr[b];
+    }
+    return sum;
+#ifdef USE_CUDA
+  }
+#endif
+}
+
 /*
 void doCalculateTanhErrorFunction(FloatGPUMirroredMemoryBlock *output,
 				  FloatGPUMirroredMemoryBlock *target_output,
@@ -679,9 +1111,6 @@ float doLocalFMeasureLossFunction(FloatGPUMirroredMemoryBlock *input,
   if (size != 1) ERROR_EXIT(128, "Multi-class version is not implemented\n");
   const float *input_ptr  = input->getPPALForRead();
   const float *target_ptr = target->getPPALForRead();
-  FloatGPUMirroredMemoryBlock *pattern_errors = 
-    new FloatGPUMirroredMemoryBlock(target->getSize());
-  float *pattern_errors_ptr = pattern_errors->getPPALForReadAndWrite();
   Gab = 0.0f;
   Hab = 0.0f;
   float beta2 = beta*beta;
@@ -739,6 +1168,9 @@ void doComputeLocalFMeasureGradient(FloatGPUMirroredMemoryBlock *target,
       }
     }
   }
+  else {
+    for (unsigned int i=0; i<size*bunch_size; ++i) output_error_ptr[i] = 0.0f;
+  }
 }
 
 /*
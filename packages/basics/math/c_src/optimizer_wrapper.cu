@@ -0,0 +1,91 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include <cmath>
+#include "wrapper.h"
+
+///////////////////////////////////////////////////////////
+//////////////////// Wrappers /////////////////////////////
+///////////////////////////////////////////////////////////
+
+void doComputeMomentumAndWeightDecay(unsigned int size,
+				     float momentum,
+				     float c_weight_decay,
+				     FloatGPUMirroredMemoryBlock *w,
+				     unsigned int w_shift,
+				     FloatGPUMirroredMemoryBlock *prev_w,
+				     unsigned int prev_w_shift,
+				     bool use_gpu) {
+#ifdef USE_CUDA
+  if (use_gpu) {
+    // three BLAS calls, as in CPU version before fusion
+    doSaxpy(size, -1.0f, w, w_shift, 1, prev_w, prev_w_shift, 1, use_gpu);
+    doSscal(size, -momentum, prev_w, prev_w_shift, 1, use_gpu);
+    doSaxpy(size, c_weight_decay, w, w_shift, 1, prev_w, prev_w_shift, 1,
+	    use_gpu);
+    return;
+  }
+#endif
+  const float *w_ptr = w->getPPALForRead() + w_shift;
+  float *prev_w_ptr  = prev_w->getPPALForReadAndWrite() + prev_w_shift;
+  // one pass over memory, vectorized by the compiler
+  const float c = momentum + c_weight_decay;
+  for (unsigned int i=0; i<size; ++i)
+    prev_w_ptr[i] = c*w_ptr[i] - momentum*prev_w_ptr[i];
+}
+
+bool doPruneSubnormalAndMaxNorm(unsigned int num_inputs,
+				unsigned int num_outputs,
+				float max_norm,
+				FloatGPUMirroredMemoryBlock *w,
+				unsigned int w_shift,
+				bool check_normal,
+				FloatGPUMirroredMemoryBlock *norms2) {
+  float *w_ptr  = w->getPPALForReadAndWrite() + w_shift;
+  float *n2_ptr = (max_norm > 0.0f) ? norms2->getPPALForWrite() : 0;
+  if (n2_ptr)
+    for (unsigned int j=0; j<num_outputs; ++j) n2_ptr[j] = 0.0f;
+  // one pass over memory, input by input; the squared norm of every output
+  // neuron weights is accumulated at the same time
+  for (unsigned int i=0; i<num_inputs; ++i) {
+    float *row = w_ptr + i*num_outputs;
+    if (check_normal) {
+      for (unsigned int j=0; j<num_outputs; ++j) {
+	float v = row[j];
+	if (!std::isfinite(v)) return false;
+	if (!std::isnormal(v)) row[j] = 0.0f;
+      }
+    }
+    if (n2_ptr)
+      for (unsigned int j=0; j<num_outputs; ++j) n2_ptr[j] += row[j]*row[j];
+  }
+  if (n2_ptr) {
+    const float max_norm2 = max_norm*max_norm;
+    for (unsigned int j=0; j<num_outputs; ++j) {
+      if (n2_ptr[j] > max_norm2) {
+	const float scal = max_norm/sqrtf(n2_ptr[j]);
+	for (unsigned int i=0; i<num_inputs; ++i)
+	  w_ptr[i*num_outputs + j] *= scal;
+      }
+    }
+  }
+  return true;
+}
@@ -0,0 +1,126 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include <cmath>
+#include "wrapper.h"
+
+// Number of weight rows processed together at doInt8Gemm, chosen to keep
+// the block of int8 rows at L1/L2 cache while all patterns are traversed
+#define INT8_GEMM_ROWS_BLOCK 32
+
+///////////////////////////////////////////////////////////
+/////////////////// Kernels ///////////////////////////////
+///////////////////////////////////////////////////////////
+
+// int8 x int8 dot product with int32 accumulation. Written as a plain loop
+// over contiguous memory, so the compiler (-O3 -march=native) vectorizes it
+// using packed multiply-add instructions.
+static inline int int8Dot(const signed char *a,
+			  const signed char *b,
+			  unsigned int size) {
+  int acc = 0;
+  for (unsigned int i=0; i<size; ++i)
+    acc += static_cast<int>(a[i]) * static_cast<int>(b[i]);
+  return acc;
+}
+
+static inline signed char quantizeValue(float v, float inv_scale) {
+  float q = roundf(v * inv_scale);
+  if (q > 127.0f)  q = 127.0f;
+  if (q < -127.0f) q = -127.0f;
+  return static_cast<signed char>(q);
+}
+
+///////////////////////////////////////////////////////////
+//////////////////// Wrappers /////////////////////////////
+///////////////////////////////////////////////////////////
+
+// int8 kernels are only implemented for CPU, the quantized path is intended
+// for inference deployment, so use_gpu flag is not needed here
+void doQuantizeInt8(FloatGPUMirroredMemoryBlock *src,
+		    unsigned int src_shift,
+		    unsigned int row_inc,
+		    unsigned int col_inc,
+		    unsigned int rows,
+		    unsigned int cols,
+		    Int8GPUMirroredMemoryBlock *dest,
+		    FloatGPUMirroredMemoryBlock *scales,
+		    float fixed_scale) {
+  const float *src_ptr = src->getPPALForRead() + src_shift;
+  signed char *dest_ptr = dest->getPPALForWrite();
+  float *scales_ptr     = scales->getPPALForWrite();
+  for (unsigned int r=0; r<rows; ++r) {
+    const float *row = src_ptr + r*row_inc;
+    float scale = fixed_scale;
+    if (scale <= 0.0f) {
+      float max_abs = 0.0f;
+      for (unsigned int c=0; c<cols; ++c) {
+	float v = fabsf(row[c*col_inc]);
+	if (v > max_abs) max_abs = v;
+      }
+      scale = (max_abs > 0.0f) ? (max_abs / 127.0f) : 1.0f;
+    }
+    const float inv_scale = 1.0f / scale;
+    signed char *dest_row = dest_ptr + r*cols;
+    if (col_inc == 1)
+      for (unsigned int c=0; c<cols; ++c)
+	dest_row[c] = quantizeValue(row[c], inv_scale);
+    else
+      for (unsigned int c=0; c<cols; ++c)
+	dest_row[c] = quantizeValue(row[c*col_inc], inv_scale);
+    scales_ptr[r] = scale;
+  }
+}
+
+void doInt8Gemm(unsigned int m,
+		unsigned int n,
+		unsigned int k,
+		Int8GPUMirroredMemoryBlock *a,
+		FloatGPUMirroredMemoryBlock *a_scales,
+		Int8GPUMirroredMemoryBlock *b,
+		FloatGPUMirroredMemoryBlock *b_scales,
+		FloatGPUMirroredMemoryBlock *bias,
+		FloatGPUMirroredMemoryBlock *c,
+		unsigned int c_inc) {
+  const signed char *a_ptr = a->getPPALForRead();
+  const signed char *b_ptr = b->getPPALForRead();
+  const float *a_scales_ptr = a_scales->getPPALForRead();
+  const float *b_scales_ptr = b_scales->getPPALForRead();
+  const float *bias_ptr     = (bias != 0) ? bias->getPPALForRead() : 0;
+  float *c_ptr = c->getPPALForWrite();
+  // blocks of rows of B (output neurons), and for each block all the rows of
+  // A (patterns), so B rows are reused from cache
+  for (unsigned int j0=0; j0<n; j0+=INT8_GEMM_ROWS_BLOCK) {
+    unsigned int j1 = j0 + INT8_GEMM_ROWS_BLOCK;
+    if (j1 > n) j1 = n;
+    for (unsigned int i=0; i<m; ++i) {
+      const signed char *a_row = a_ptr + i*k;
+      const float a_scale = a_scales_ptr[i];
+      for (unsigned int j=j0; j<j1; ++j) {
+	int acc = int8Dot(a_row, b_ptr + j*k, k);
+	// fused dequantization and bias
+	float v = static_cast<float>(acc) * a_scale * b_scales_ptr[j];
+	if (bias_ptr != 0) v += bias_ptr[j];
+	c_ptr[j*c_inc + i] = v;
+      }
+    }
+  }
+}
@@ -214,6 +214,23 @@ void doComputeCrossEntropyGradient(FloatGPUMirroredMemoryBlock *input,
 				   unsigned int bunch_size,
 				   bool use_gpu);
 
+// Multi-class cross entropy with the target given as one class index (0 to
+// size-1) by bunch column, and an optional weight by column (0 means 1.0)
+float doMultiClassCrossEntropyLossFunctionIndexed(FloatGPUMirroredMemoryBlock *input,
+						  IntGPUMirroredMemoryBlock *target_indices,
+						  FloatGPUMirroredMemoryBlock *target_weights,
+						  unsigned int size,
+						  unsigned int bunch_size,
+						  bool use_gpu);
+
+void doComputeCrossEntropyGradientIndexed(FloatGPUMirroredMemoryBlock *input,
+					  IntGPUMirroredMemoryBlock *target_indices,
+					  FloatGPUMirroredMemoryBlock *target_weights,
+					  FloatGPUMirroredMemoryBlock *error_output,
+					  unsigned int size,
+					  unsigned int bunch_size,
+					  bool use_gpu);
+
 /*
   void doCalculateTanhErrorFunction(FloatGPUMirroredMemoryBlock *output,
   FloatGPUMirroredMemoryBlock *target_output,
@@ -224,6 +241,45 @@ void doComputeCrossEntropyGradient(FloatGPUMirroredMemoryBlock *input,
   bool use_gpu);
 */
 
+// Fused versions of the previous loss and gradient functions, they write
+// the gradient at error_output and return the same value than the loss ones
+float doMSELossAndGradient(FloatGPUMirroredMemoryBlock *input,
+			   FloatGPUMirroredMemoryBlock *target,
+			   FloatGPUMirroredMemoryBlock *error_output,
+			   float zero_epsilon_distance,
+			   unsigned int size,
+			   unsigned int bunch_size,
+			   bool use_gpu);
+
+// zero_epsilon_distance is only applied to the gradient, as in
+// doComputeMAEGradient
+float doMAELossAndGradient(FloatGPUMirroredMemoryBlock *input,
+			   FloatGPUMirroredMemoryBlock *target,
+			   FloatGPUMirroredMemoryBlock *error_output,
+			   float zero_epsilon_distance,
+			   unsigned int size,
+			   unsigned int bunch_size,
+			   bool use_gpu);
+
+// multi_class=false for doCrossEntropyLossFunction, true for
+// doMultiClassCrossEntropyLossFunction
+float doCrossEntropyLossAndGradient(FloatGPUMirroredMemoryBlock *input,
+				    FloatGPUMirroredMemoryBlock *target,
+				    FloatGPUMirroredMemoryBlock *error_output,
+				    float epsilon,
+				    unsigned int size,
+				    unsigned int bunch_size,
+				    bool multi_class,
+				    bool use_gpu);
+
+float doMultiClassCrossEntropyLossAndGradientIndexed(FloatGPUMirroredMemoryBlock *input,
+						     IntGPUMirroredMemoryBlock *target_indices,
+						     FloatGPUMirroredMemoryBlock *target_weights,
+						     FloatGPUMirroredMemoryBlock *error_output,
+						     unsigned int size,
+						     unsigned int bunch_size,
+						     bool use_gpu);
+
 float doLocalFMeasureLossFunction(FloatGPUMirroredMemoryBlock *input,
 				  FloatGPUMirroredMemoryBlock *target,
 				  unsigned int size,
@@ -333,4 +389,63 @@ float doSnrm2(unsigned int n,
 	      unsigned int shift,
 	      unsigned int inc,
 	      bool use_gpu);
+
+// OPTIMIZER FUNCTIONS
+
+/// Fused momentum and weight decay over prev_w, in one memory pass:
+/// prev_w = momentum*(w - prev_w) + c_weight_decay*w
+void doComputeMomentumAndWeightDecay(unsigned int size,
+				     float momentum,
+				     float c_weight_decay,
+				     FloatGPUMirroredMemoryBlock *w,
+				     unsigned int w_shift,
+				     FloatGPUMirroredMemoryBlock *prev_w,
+				     unsigned int prev_w_shift,
+				     bool use_gpu);
+
+/// Traverses a col-major num_outputs x num_inputs weights matrix once,
+/// pruning subnormal values and checking finiteness (when check_normal is
+/// true), and computing the norm of each output neuron weights. When
+/// max_norm > 0, weights of neurons with larger norm are rescaled to
+/// max_norm. norms2 is an auxiliary block of num_outputs size. Returns
+/// false if a non finite number is found. Only CPU.
+bool doPruneSubnormalAndMaxNorm(unsigned int num_inputs,
+				unsigned int num_outputs,
+				float max_norm,
+				FloatGPUMirroredMemoryBlock *w,
+				unsigned int w_shift,
+				bool check_normal,
+				FloatGPUMirroredMemoryBlock *norms2);
+
+// INT8 QUANTIZED FUNCTIONS (only CPU)
+
+/// Quantizes a rows x cols float matrix into a packed row-major int8 matrix,
+/// with a symmetric scale for each row (value = int8 * scale). The element
+/// (r,c) is taken from src[src_shift + r*row_inc + c*col_inc]. If fixed_scale
+/// is > 0 it is used for all rows (clamping values out of range), otherwise
+/// each row scale is computed as max(abs(row))/127.
+void doQuantizeInt8(FloatGPUMirroredMemoryBlock *src,
+		    unsigned int src_shift,
+		    unsigned int row_inc,
+		    unsigned int col_inc,
+		    unsigned int rows,
+		    unsigned int cols,
+		    Int8GPUMirroredMemoryBlock *dest,
+		    FloatGPUMirroredMemoryBlock *scales,
+		    float fixed_scale);
+
+/// Computes C = (A * B') with int8 A (m x k) and B (n x k) packed row-major
+/// matrices, accumulating in int32, and dequantizing at the end with the
+/// scales of A rows and B rows, adding bias[j] if bias is not NULL. C is
+/// stored in column major (bunch) order: C[j*c_inc + i].
+void doInt8Gemm(unsigned int m,
+		unsigned int n,
+		unsigned int k,
+		Int8GPUMirroredMemoryBlock *a,
+		FloatGPUMirroredMemoryBlock *a_scales,
+		Int8GPUMirroredMemoryBlock *b,
+		FloatGPUMirroredMemoryBlock *b_scales,
+		FloatGPUMirroredMemoryBlock *bias,
+		FloatGPUMirroredMemoryBlock *c,
+		unsigned int c_inc);
 #endif // WRAPPER_H
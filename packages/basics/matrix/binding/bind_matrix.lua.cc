@@ -20,11 +20,42 @@
  */
 //BIND_HEADER_C
 #include <cmath> // para isfinite
+
+// span functors used with MatrixFloat::applySpans, they read or write a Lua
+// table following the matrix row-major order
+class MatrixFromLuaTable {
+  lua_State *L;
+  int table, index;
+public:
+  MatrixFromLuaTable(lua_State *L, int table) : L(L), table(table), index(1) { }
+  void operator()(float *v, int n, int inc) {
+    for (int i=0; i<n; ++i, v+=inc, ++index) {
+      lua_rawgeti(L, table, index);
+      *v = (float)luaL_checknumber(L, -1);
+      lua_pop(L, 1);
+    }
+  }
+};
+
+class MatrixToLuaTable {
+  lua_State *L;
+  int index;
+public:
+  // the table must be at the top of the stack
+  MatrixToLuaTable(lua_State *L) : L(L), index(1) { }
+  void operator()(float *v, int n, int inc) {
+    for (int i=0; i<n; ++i, v+=inc, ++index) {
+      lua_pushnumber(L, *v);
+      lua_rawseti(L, -2, index);
+    }
+  }
+};
 //BIND_END
 
 //BIND_HEADER_H
 #include "utilMatrixFloat.h"
 #include "utilLua.h"
+#include "mapped_file.h"
 #include <cmath> // para isfinite
 //BIND_END
 
@@ -66,12 +97,8 @@
   MatrixFloat* obj;
   obj = new MatrixFloat(ndims,dim);
   if (lua_istable(L,argn)) {
-    int i=1;
-    for (MatrixFloat::iterator it(obj->begin()); it != obj->end(); ++it, ++i) {
-      lua_rawgeti(L,argn,i);
-      *it = (float)luaL_checknumber(L, -1);
-      lua_remove(L,-1);
-    }
+    MatrixFromLuaTable from_table(L, argn);
+    obj->applySpans(from_table);
   }
   delete[] dim;
   LUABIND_RETURN(MatrixFloat,obj);
@@ -113,12 +140,8 @@
   MatrixFloat* obj;
   obj = new MatrixFloat(ndims,dim,0.0f,CblasColMajor);
   if (lua_istable(L,argn)) {
-    int i=1;
-    for (MatrixFloat::iterator it(obj->begin()); it != obj->end(); ++it, ++i) {
-      lua_rawgeti(L,argn,i);
-      *it = (float)luaL_checknumber(L, -1);
-      lua_remove(L,-1);
-    }
+    MatrixFromLuaTable from_table(L, argn);
+    obj->applySpans(from_table);
   }
   delete[] dim;
   LUABIND_RETURN(MatrixFloat,obj);
@@ -153,8 +176,25 @@
   const char *filename;
   LUABIND_GET_PARAMETER(1,string,filename);
   MatrixFloat *obj;
-  ReadFileStream f(filename);
-  if ((obj = readMatrixFloatFromStream(f)) == 0)
+  if (isGZPath(filename)) {
+    // decompressed by a background thread while it is parsed
+    ReadFileStream f(filename);
+    if (!f.isOpen())
+      LUABIND_FERROR1("unable to open %s", filename);
+    obj = readMatrixFloatFromStream(f);
+    if (f.getError() != 0) {
+      if (obj != 0) delete obj;
+      LUABIND_FERROR2("%s: %s", filename, f.getError());
+    }
+  }
+  else {
+    MappedFile f(filename);
+    if (!f.isOpen())
+      LUABIND_FERROR1("unable to open %s", filename);
+    constString cs(f.getData(), f.getSize());
+    obj = readMatrixFloatFromStream(cs);
+  }
+  if (obj == 0)
     LUABIND_ERROR("bad format");
   else LUABIND_RETURN(MatrixFloat,obj);
 }
@@ -190,7 +230,7 @@
 // void toFilename(string filename, string type='ascii')
 /// Permite salvar una matriz con un formato tal y como se carga con el
 /// metodo fromString. El unico argumento opcional indica el tipo 'ascii'
-/// o 'binary'.
+/// o 'binary'. Si el nombre acaba en .gz el fichero se comprime.
 ///@param filename Indica el nombre del fichero.
 ///@param type Parametro opcional. Puede ser 'ascii' o 'binary', y por defecto es 'ascii'.
 //DOC_END
@@ -202,9 +242,14 @@
   LUABIND_GET_PARAMETER(1, string, filename);
   LUABIND_GET_OPTIONAL_PARAMETER(2,constString,cs,constString("ascii"));
   bool is_ascii = (cs == "ascii");
-  FILE *f = fopen(filename, "w");
+  OutputStream *f = openOutputStream(filename);
+  if (f == 0)
+    LUABIND_FERROR1("unable to open %s", filename);
   saveMatrixFloatToFile(obj,f,is_ascii);
-  fclose(f);
+  bool ok = f->close();
+  delete f;
+  if (!ok)
+    LUABIND_FERROR1("error writing %s", filename);
 }
 //BIND_END
 
@@ -332,12 +377,8 @@
   LUABIND_TABLE_GETN(1, veclen);
   if (veclen != obj->size())
     LUABIND_FERROR2("wrong size %d instead of %d",veclen,obj->size());
-  int i=1;
-  for (MatrixFloat::iterator it(obj->begin()); it != obj->end(); ++it, ++i) {
-    lua_rawgeti(L,1,i);
-    *it = (float)luaL_checknumber(L, -1);
-    lua_remove(L,-1);
-  }
+  MatrixFromLuaTable from_table(L, 1);
+  obj->applySpans(from_table);
   LUABIND_RETURN(MatrixFloat, obj);
 }
 //BIND_END
@@ -460,9 +501,7 @@
   LUABIND_CHECK_PARAMETER(1, float);
   float value;
   LUABIND_GET_PARAMETER(1,float,value);
-  for (MatrixFloat::iterator it(obj->begin()); it != obj->end(); ++it) {
-    *it = value;
-  }
+  obj->fill(value);
   LUABIND_RETURN(MatrixFloat, obj);
 }
 //BIND_END
@@ -592,9 +631,7 @@
   obj->minAndMax(mmin, mmax);
   if (mmax - mmin == 0) {
     // caso especial, poner todos al valor inferior
-    for (MatrixFloat::iterator it(obj->begin()); it!=obj->end(); ++it) {
-      *it = rmin;
-    }
+    obj->fill(rmin);
   } else {
     float offset = rmin-mmin;
     double ratio = (rmax-rmin)/(mmax-mmin);
@@ -621,7 +658,9 @@
 // TODO: Tener en cuenta las dimensiones de la matriz
   {
     LUABIND_CHECK_ARGN(==, 0);
-    LUABIND_FORWARD_CONTAINER_TO_NEW_TABLE(MatrixFloat, float, *obj);
+    lua_createtable(L, obj->size(), 0);
+    MatrixToLuaTable to_table(L);
+    obj->applySpans(to_table);
     LUABIND_RETURN_FROM_STACK(-1);
   }
 //BIND_END
@@ -18,3 +18,66 @@
  * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  *
  */
+#include <cassert>
+#include "swap.h"
+#include "matrix_spans.h"
+
+MatrixSpanLayout::MatrixSpanLayout(int num_dims, const int *sizes,
+				   int num_operands,
+				   const int * const *strides,
+				   bool memory_order) :
+  num_dims(0), num_operands(num_operands), total_size(1) {
+  assert(num_operands > 0 && num_operands <= MAX_OPERANDS);
+  this->sizes = new int[num_dims+1];
+  for (int k=0; k<num_operands; ++k) this->strides[k] = new int[num_dims+1];
+  // dimensions of size 1 are removed
+  for (int d=0; d<num_dims; ++d) {
+    total_size *= sizes[d];
+    if (sizes[d] == 1) continue;
+    this->sizes[this->num_dims] = sizes[d];
+    for (int k=0; k<num_operands; ++k)
+      this->strides[k][this->num_dims] = strides[k][d];
+    ++this->num_dims;
+  }
+  if (this->num_dims == 0) {
+    this->sizes[0] = 1;
+    for (int k=0; k<num_operands; ++k) this->strides[k][0] = 1;
+    this->num_dims = 1;
+    return;
+  }
+  if (memory_order) {
+    // insertion sort by decreasing stride of the first operand, it is stable
+    for (int i=1; i<this->num_dims; ++i) {
+      for (int j=i; j>0 && this->strides[0][j-1] < this->strides[0][j]; --j) {
+	april_utils::swap(this->sizes[j-1], this->sizes[j]);
+	for (int k=0; k<num_operands; ++k)
+	  april_utils::swap(this->strides[k][j-1], this->strides[k][j]);
+      }
+    }
+  }
+  // collapse consecutive dimensions which are contiguous in all operands
+  int last = 0;
+  for (int d=1; d<this->num_dims; ++d) {
+    bool contiguous = true;
+    for (int k=0; k<num_operands && contiguous; ++k)
+      contiguous = (this->strides[k][last] ==
+		    this->strides[k][d]*this->sizes[d]);
+    if (contiguous) {
+      this->sizes[last] *= this->sizes[d];
+      for (int k=0; k<num_operands; ++k)
+	this->strides[k][last] = this->strides[k][d];
+    }
+    else {
+      ++last;
+      this->sizes[last] = this->sizes[d];
+      for (int k=0; k<num_operands; ++k)
+	this->strides[k][last] = this->strides[k][d];
+    }
+  }
+  this->num_dims = last+1;
+}
+
+MatrixSpanLayout::~MatrixSpanLayout() {
+  delete[] sizes;
+  for (int k=0; k<num_operands; ++k) delete[] strides[k];
+}
@@ -34,6 +34,7 @@
 #include "aligned_memory.h"
 #include "swap.h"
 #include "maxmin.h"
+#include "matrix_spans.h"
 
 template <typename T>
 class Matrix : public Referenced {
@@ -225,6 +226,13 @@ public:
   Matrix<T> *clone(CBLAS_ORDER major_order);
   /// Shallow copy
   Matrix<T>* copy();
+  /// Sets all the elements to the given value
+  void fill(T value);
+  /// Calls func(T *ptr, int n, int inc) for every span of n elements
+  /// separated by inc positions, following the row-major order of the
+  /// iterators. It is sequential, so func could use non thread-safe state.
+  template<typename Func>
+  void applySpans(Func &func);
   T& operator[] (int i);
   const T& operator[] (int i) const;
   // Access to independent elements, one and two dimensions are special cases
@@ -303,6 +311,10 @@ private:
   void allocate_memory(int size);
   void release_memory();
   void initialize(const int *dim);
+  /// Copies other into this matrix, both with the dimensions of this matrix,
+  /// other viewed with the given strides and offset
+  void copySpansFrom(const Matrix<T> *other,
+		     const int *other_stride, int other_offset);
 };
 
 template <typename T>
@@ -379,14 +391,7 @@ Matrix<T>::Matrix(Matrix<T> *other,
   if (clone) {
     initialize(sizes);
     allocate_memory(total_size);
-    int other_offset = other->computeRawPos(coords);
-    const T *other_data = other->data->getPPALForRead();
-    for (int i=0; i<numDim; ++i) aux_coords[i] = 0;
-    for (iterator it(begin()); it!=end(); ++it) {
-      int other_raw_pos = other_offset + other->computeRawPos(aux_coords);
-      *it = other_data[other_raw_pos];
-      nextCoordVectorRowOrder(aux_coords, sizes, numDim);
-    }
+    copySpansFrom(other, other->stride, other->computeRawPos(coords));
   }
   else {
     total_size = 1;
@@ -446,13 +451,7 @@ Matrix<T>::Matrix(Matrix<T> *other, bool clone) : numDim(other->numDim),
   if (clone) {
     initialize(other->matrixSize);
     allocate_memory(total_size);
-    iterator       this_it(begin());
-    const_iterator other_it(other->begin());
-    while(this_it != end()) {
-      *this_it = *other_it;
-      ++this_it;
-      ++other_it;
-    }
+    copySpansFrom(other, other->stride, other->offset);
   }
   else {
     offset       = other->offset;
@@ -479,13 +478,12 @@ Matrix<T> *Matrix<T>::transpose() {
   int *aux_matrix_size = new int[numDim];
   for (int i=0; i<numDim; ++i) aux_matrix_size[i] = matrixSize[numDim-i-1];
   Matrix<T> *resul = new Matrix<T>(numDim, aux_matrix_size, T(), major_order);
-  const T *d = data->getPPALForRead();
-  for (int i=0; i<numDim; ++i) aux_coords[i] = 0;
-  for (iterator resul_it(resul->begin()); resul_it!=resul->end(); ++resul_it) {
-    *resul_it = d[computeRawPos(aux_coords)];
-    nextCoordVectorColOrder(aux_coords, matrixSize, numDim);
-  }
+  // this matrix viewed with the dimensions of resul
+  int *aux_stride = new int[numDim];
+  for (int i=0; i<numDim; ++i) aux_stride[i] = stride[numDim-i-1];
+  resul->copySpansFrom(this, aux_stride, offset);
   delete[] aux_matrix_size;
+  delete[] aux_stride;
   return resul;
 }
 
@@ -495,13 +493,7 @@ Matrix<T> *Matrix<T>::clone(CBLAS_ORDER major_order) {
   if (numDim != 2) ERROR_EXIT(128, "Major type not availabe when numDim!=2\n");
   if (this->major_order != major_order) {
     resul = new Matrix<T>(numDim, matrixSize, T(), major_order);
-    iterator resul_it(resul->begin());
-    const_iterator this_it(begin());
-    while(resul_it != resul->end()) {
-      *resul_it = *this_it;
-      ++resul_it;
-      ++this_it;
-    }
+    resul->copySpansFrom(this, stride, offset);
   }
   else resul = this->clone();
   return resul;
@@ -517,6 +509,23 @@ Matrix<T>* Matrix<T>::copy() {
   return new Matrix<T>(this,false);
 }
 
+template <typename T>
+void Matrix<T>::fill(T value) {
+  const int *strides[1] = { stride };
+  MatrixSpanLayout layout(numDim, matrixSize, 1, strides, true);
+  MatrixFillSpans<T> func(getData(), layout.getSpanStride(0), value);
+  applyMatrixSpans(layout, &offset, func);
+}
+
+template <typename T>
+template <typename Func>
+void Matrix<T>::applySpans(Func &func) {
+  const int *strides[1] = { stride };
+  MatrixSpanLayout layout(numDim, matrixSize, 1, strides, false);
+  MatrixPointerSpans<T,Func> adapter(getData(), layout.getSpanStride(0), &func);
+  applyMatrixSpans(layout, &offset, adapter, false);
+}
+
 template <typename T>
 T& Matrix<T>::operator[] (int i) {
   return data->get(i);
@@ -655,9 +664,10 @@ bool Matrix<T>::putSubCol(int col, int first_row, T* vec, int vecsize) {
 
 template <typename T>
 void Matrix<T>::clamp(T lower, T upper) {
-  T *d = data->getPPALForReadAndWrite();
-  for (int i=0; i<total_size; ++i)
-    d[i] = april_utils::clamp(d[i],lower,upper);
+  const int *strides[1] = { stride };
+  MatrixSpanLayout layout(numDim, matrixSize, 1, strides, true);
+  MatrixClampSpans<T> func(getData(), layout.getSpanStride(0), lower, upper);
+  applyMatrixSpans(layout, &offset, func);
 }
 
 template <typename T>
@@ -938,33 +948,40 @@ T Matrix<T>::norm2() const {
 
 template <typename T>
 T Matrix<T>::min() const {
-  const_iterator it(begin());
-  T min = *it;
-  for (; it!=end(); ++it) if (*it < min) min = *it;
+  T min, max;
+  minAndMax(min, max);
   return min;
 }
 
 template <typename T>
 T Matrix<T>::max() const {
-  const_iterator it(begin());
-  T max = *it;
-  for (; it!=end(); ++it) if (*it > max) max = *it;
+  T min, max;
+  minAndMax(min, max);
   return max;
 }
 
 template <typename T>
 void Matrix<T>::minAndMax(T &min, T &max) const {
-  const_iterator it(begin());
-  min = *it;
-  max = *it;
-  for (; it!=end(); ++it) {
-    if (*it < min) min = *it;
-    if (*it > max) max = *it;
-  }
+  const int *strides[1] = { stride };
+  MatrixSpanLayout layout(numDim, matrixSize, 1, strides, true);
+  const T *d = getData();
+  MatrixMinAndMaxSpans<T> func(d, layout.getSpanStride(0), d[offset]);
+  applyMatrixSpans(layout, &offset, func);
+  min = func.min;
+  max = func.max;
 }
 
 /***** PRIVATE METHODS *****/
 
+template <typename T>
+void Matrix<T>::copySpansFrom(const Matrix<T> *other,
+			      const int *other_stride, int other_offset) {
+  const int *strides[2] = { stride, other_stride };
+  const int  offsets[2] = { offset, other_offset };
+  MatrixSpanLayout layout(numDim, matrixSize, 2, strides, true);
+  copyMatrixSpans(layout, offsets, getData(), other->getData());
+}
+
 template <typename T>
 bool Matrix<T>::nextCoordVectorRowOrder(int *coords, const int *sizes,
 					int numDim) {
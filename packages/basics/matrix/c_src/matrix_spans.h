@@ -0,0 +1,356 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef MATRIX_SPANS_H
+#define MATRIX_SPANS_H
+
+#include <cstring>
+#include <new>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+#include "parallel_for.h"
+#include "maxmin.h"
+#include "clamp.h"
+
+/// Number of elements from which element-wise operations and reductions are
+/// distributed among worker threads
+#define MATRIX_PARALLEL_THRESHOLD 262144
+/// Number of elements processed by each parallel work unit
+#define MATRIX_PARALLEL_CHUNK     65536
+/// Side of the square tiles used when copying transposed layouts
+#define MATRIX_COPY_TILE_SIZE     32
+
+/// Describes the traversal of one or two matrices with the same logical
+/// dimensions as a sequence of 1D spans (n elements separated by a constant
+/// stride). Dimensions of size 1 are removed and consecutive dimensions are
+/// collapsed when they are contiguous in all the operands, so a simple
+/// matrix, or a sub-matrix with complete rows, becomes only one span. When
+/// memory_order=true, dimensions are sorted by the strides of the first
+/// operand, so the traversal follows its memory layout; this is only valid
+/// for operations which don't depend on the logical (row-major) order.
+class MatrixSpanLayout {
+public:
+  static const int MAX_OPERANDS = 2;
+
+  MatrixSpanLayout(int num_dims, const int *sizes,
+		   int num_operands, const int * const *strides,
+		   bool memory_order);
+  ~MatrixSpanLayout();
+
+  int getNumDims() const { return num_dims; }
+  int getNumOperands() const { return num_operands; }
+  const int *getSizes() const { return sizes; }
+  const int *getStrides(int op) const { return strides[op]; }
+  int getTotalSize() const { return total_size; }
+  /// Length and stride of the innermost dimension
+  int getSpanSize() const { return sizes[num_dims-1]; }
+  int getSpanStride(int op) const { return strides[op][num_dims-1]; }
+  /// Returns true if the innermost dimension is transposed between the two
+  /// operands (first operand contiguous, second operand contiguous at the
+  /// previous dimension), which is better copied by square tiles
+  bool isTransposedCopy() const {
+    return (num_operands == 2 && num_dims >= 2 &&
+	    strides[0][num_dims-1] == 1 && strides[1][num_dims-1] != 1 &&
+	    strides[1][num_dims-2] == 1);
+  }
+
+private:
+  int num_dims, num_operands, total_size;
+  int *sizes;
+  int *strides[MAX_OPERANDS];
+};
+
+/// Walks the elements [begin,end) of the layout traversal, calling
+/// func(pos, n) for every span, where pos[k] is the position of the first
+/// span element at operand k (offsets[k] is the position of the first matrix
+/// element), and n is the number of elements of the span. Coordinates are
+/// only updated once per span, never per element.
+template<typename Func>
+void walkMatrixSpans(const MatrixSpanLayout &layout, const int *offsets,
+		     int begin, int end, Func &func) {
+  const int  num_dims = layout.getNumDims();
+  const int  num_ops  = layout.getNumOperands();
+  const int *sizes    = layout.getSizes();
+  const int  span     = layout.getSpanSize();
+  int *coords = new int[num_dims];
+  int  row_pos[MatrixSpanLayout::MAX_OPERANDS], pos[MatrixSpanLayout::MAX_OPERANDS];
+  // coordinates of the begin element
+  int idx = begin;
+  for (int d=num_dims-1; d>=0; --d) {
+    coords[d] = idx % sizes[d];
+    idx /= sizes[d];
+  }
+  // row_pos is the position of the span start (coords[num_dims-1] = 0)
+  for (int k=0; k<num_ops; ++k) {
+    const int *strides = layout.getStrides(k);
+    row_pos[k] = offsets[k];
+    for (int d=0; d<num_dims-1; ++d) row_pos[k] += coords[d]*strides[d];
+  }
+  int current = begin;
+  while(current < end) {
+    const int first = coords[num_dims-1];
+    const int n     = april_utils::min(span - first, end - current);
+    for (int k=0; k<num_ops; ++k)
+      pos[k] = row_pos[k] + first*layout.getSpanStride(k);
+    func(pos, n);
+    current += n;
+    coords[num_dims-1] = 0;
+    // next span, carry over outer dimensions
+    for (int d=num_dims-2; d>=0; --d) {
+      for (int k=0; k<num_ops; ++k) row_pos[k] += layout.getStrides(k)[d];
+      if (++coords[d] < sizes[d]) break;
+      for (int k=0; k<num_ops; ++k) row_pos[k] -= sizes[d]*layout.getStrides(k)[d];
+      coords[d] = 0;
+    }
+  }
+  delete[] coords;
+}
+
+template<typename Func>
+struct MatrixSpansChunk {
+  const MatrixSpanLayout *layout;
+  const int *offsets;
+  Func *funcs;
+  int num_chunks;
+  void operator()(unsigned int i) {
+    const int total = layout->getTotalSize();
+    int begin = static_cast<int>((static_cast<long>(total)*i)/num_chunks);
+    int end   = static_cast<int>((static_cast<long>(total)*(i+1))/num_chunks);
+    walkMatrixSpans(*layout, offsets, begin, end, funcs[i]);
+  }
+};
+
+/// Applies func to all the spans of the layout. Large layouts are split in
+/// chunks which are processed by worker threads, each one with its own copy
+/// of func, and the copies are combined in order with func.merge(copy).
+/// Func must be copy constructible and implement operator()(pos, n) and
+/// merge(other).
+template<typename Func>
+void applyMatrixSpans(const MatrixSpanLayout &layout, const int *offsets,
+		      Func &func, bool parallel=true) {
+  const int total = layout.getTotalSize();
+  int num_chunks = total / MATRIX_PARALLEL_CHUNK;
+  if (!parallel || total < MATRIX_PARALLEL_THRESHOLD ||
+      april_utils::getNumWorkerThreads() <= 1 || num_chunks <= 1) {
+    walkMatrixSpans(layout, offsets, 0, total, func);
+    return;
+  }
+  // copies need to be constructed from func, not by default
+  Func *funcs = static_cast<Func*>(::operator new(sizeof(Func)*num_chunks));
+  for (int i=0; i<num_chunks; ++i) new (funcs+i) Func(func);
+  MatrixSpansChunk<Func> chunk;
+  chunk.layout     = &layout;
+  chunk.offsets    = offsets;
+  chunk.funcs      = funcs;
+  chunk.num_chunks = num_chunks;
+  april_utils::parallelFor(num_chunks, chunk);
+  for (int i=0; i<num_chunks; ++i) {
+    func.merge(funcs[i]);
+    funcs[i].~Func();
+  }
+  ::operator delete(funcs);
+}
+
+/**** SPAN KERNELS, contiguous spans (inc=1) are written to be vectorized ****/
+
+template<typename T>
+inline void spanFill(T *v, int n, int inc, T value) {
+  if (inc == 1) for (int i=0; i<n; ++i) v[i] = value;
+  else for (int i=0; i<n; ++i, v+=inc) *v = value;
+}
+
+template<typename T>
+inline void spanCopy(const T *src, int src_inc, T *dest, int dest_inc, int n) {
+  if (src_inc == 1 && dest_inc == 1) memcpy(dest, src, sizeof(T)*n);
+  else for (int i=0; i<n; ++i, src+=src_inc, dest+=dest_inc) *dest = *src;
+}
+
+template<typename T>
+inline void spanClamp(T *v, int n, int inc, T lower, T upper) {
+  for (int i=0; i<n; ++i, v+=inc) *v = april_utils::clamp(*v, lower, upper);
+}
+
+/// Updates min and max with the n values of the span, following the same
+/// comparisons as "if (x<min) min=x; if (x>max) max=x;"
+template<typename T>
+inline void spanMinAndMax(const T *v, int n, int inc, T &min, T &max) {
+  for (int i=0; i<n; ++i, v+=inc) {
+    if (*v < min) min = *v;
+    if (*v > max) max = *v;
+  }
+}
+
+#ifdef __SSE__
+// SSE version for contiguous float spans, _mm_min_ps(x,m) and _mm_max_ps(x,m)
+// keep the current value m when x is NaN, as the scalar comparisons do
+template<>
+inline void spanMinAndMax<float>(const float *v, int n, int inc,
+				 float &min, float &max) {
+  int i=0;
+  if (inc == 1 && n >= 8) {
+    __m128 vmin0 = _mm_set1_ps(min), vmin1 = vmin0;
+    __m128 vmax0 = _mm_set1_ps(max), vmax1 = vmax0;
+    for (; i+8<=n; i+=8) {
+      __m128 x0 = _mm_loadu_ps(v+i), x1 = _mm_loadu_ps(v+i+4);
+      vmin0 = _mm_min_ps(x0, vmin0); vmin1 = _mm_min_ps(x1, vmin1);
+      vmax0 = _mm_max_ps(x0, vmax0); vmax1 = _mm_max_ps(x1, vmax1);
+    }
+    float aux_min[8], aux_max[8];
+    _mm_storeu_ps(aux_min, vmin0); _mm_storeu_ps(aux_min+4, vmin1);
+    _mm_storeu_ps(aux_max, vmax0); _mm_storeu_ps(aux_max+4, vmax1);
+    for (int j=0; j<8; ++j) {
+      if (aux_min[j] < min) min = aux_min[j];
+      if (aux_max[j] > max) max = aux_max[j];
+    }
+  }
+  for (v += i*inc; i<n; ++i, v+=inc) {
+    if (*v < min) min = *v;
+    if (*v > max) max = *v;
+  }
+}
+#endif
+
+/**** SPAN FUNCTORS ****/
+
+template<typename T>
+struct MatrixFillSpans {
+  T *data; int inc; T value;
+  MatrixFillSpans(T *data, int inc, T value) :
+    data(data), inc(inc), value(value) { }
+  void operator()(const int *pos, int n) { spanFill(data+pos[0], n, inc, value); }
+  void merge(const MatrixFillSpans &) { }
+};
+
+template<typename T>
+struct MatrixClampSpans {
+  T *data; int inc; T lower, upper;
+  MatrixClampSpans(T *data, int inc, T lower, T upper) :
+    data(data), inc(inc), lower(lower), upper(upper) { }
+  void operator()(const int *pos, int n) {
+    spanClamp(data+pos[0], n, inc, lower, upper);
+  }
+  void merge(const MatrixClampSpans &) { }
+};
+
+/// Adapts a functor with interface func(T *ptr, int n, int inc) to the span
+/// walker, for one operand layouts
+template<typename T, typename Func>
+struct MatrixPointerSpans {
+  T *data; int inc; Func *func;
+  MatrixPointerSpans(T *data, int inc, Func *func) :
+    data(data), inc(inc), func(func) { }
+  void operator()(const int *pos, int n) { (*func)(data+pos[0], n, inc); }
+  void merge(const MatrixPointerSpans &) { }
+};
+
+/// Copies the second operand into the first one
+template<typename T>
+struct MatrixCopySpans {
+  T *dest; const T *src; int dest_inc, src_inc;
+  MatrixCopySpans(T *dest, int dest_inc, const T *src, int src_inc) :
+    dest(dest), src(src), dest_inc(dest_inc), src_inc(src_inc) { }
+  void operator()(const int *pos, int n) {
+    spanCopy(src+pos[1], src_inc, dest+pos[0], dest_inc, n);
+  }
+  void merge(const MatrixCopySpans &) { }
+};
+
+template<typename T>
+struct MatrixMinAndMaxSpans {
+  const T *data; int inc; T min, max;
+  MatrixMinAndMaxSpans(const T *data, int inc, T first) :
+    data(data), inc(inc), min(first), max(first) { }
+  void operator()(const int *pos, int n) {
+    spanMinAndMax(data+pos[0], n, inc, min, max);
+  }
+  void merge(const MatrixMinAndMaxSpans &other) {
+    if (other.min < min) min = other.min;
+    if (other.max > max) max = other.max;
+  }
+};
+
+/// Copies the second operand into the first one when the layout is a
+/// transposition (MatrixSpanLayout::isTransposedCopy), by square tiles of the
+/// two innermost dimensions. Each work unit is a row of tiles.
+template<typename T>
+struct MatrixTiledCopy {
+  const MatrixSpanLayout *layout;
+  const int *offsets;
+  T *dest; const T *src;
+  int rows, cols, row_tiles;
+  MatrixTiledCopy(const MatrixSpanLayout *layout, const int *offsets,
+		  T *dest, const T *src) :
+    layout(layout), offsets(offsets), dest(dest), src(src) {
+    const int nd = layout->getNumDims();
+    rows      = layout->getSizes()[nd-2];
+    cols      = layout->getSizes()[nd-1];
+    row_tiles = (rows + MATRIX_COPY_TILE_SIZE - 1) / MATRIX_COPY_TILE_SIZE;
+  }
+  int getNumUnits() const {
+    return (layout->getTotalSize() / (rows*cols)) * row_tiles;
+  }
+  void operator()(unsigned int unit) {
+    const int nd = layout->getNumDims();
+    const int *sizes = layout->getSizes();
+    const int *dst_strides = layout->getStrides(0);
+    const int *src_strides = layout->getStrides(1);
+    // position of the 2D slab, outer dimensions are indexed by unit/row_tiles
+    int slab = unit / row_tiles, dest_pos = offsets[0], src_pos = offsets[1];
+    for (int d=nd-3; d>=0; --d) {
+      int c = slab % sizes[d];
+      slab /= sizes[d];
+      dest_pos += c*dst_strides[d];
+      src_pos  += c*src_strides[d];
+    }
+    const int dst_row = dst_strides[nd-2], src_col = src_strides[nd-1];
+    const int i0 = (unit % row_tiles) * MATRIX_COPY_TILE_SIZE;
+    const int i1 = april_utils::min(i0 + MATRIX_COPY_TILE_SIZE, rows);
+    for (int j0=0; j0<cols; j0+=MATRIX_COPY_TILE_SIZE) {
+      const int j1 = april_utils::min(j0 + MATRIX_COPY_TILE_SIZE, cols);
+      for (int i=i0; i<i1; ++i) {
+	T *d = dest + dest_pos + i*dst_row + j0;
+	const T *s = src + src_pos + i + j0*src_col;
+	for (int j=j0; j<j1; ++j, ++d, s+=src_col) *d = *s;
+      }
+    }
+  }
+};
+
+/// Copies the second operand of the layout into the first one, using square
+/// tiles for transpositions and spans otherwise
+template<typename T>
+void copyMatrixSpans(const MatrixSpanLayout &layout, const int *offsets,
+		     T *dest, const T *src) {
+  if (layout.isTransposedCopy()) {
+    MatrixTiledCopy<T> tiled(&layout, offsets, dest, src);
+    if (layout.getTotalSize() < MATRIX_PARALLEL_THRESHOLD)
+      for (int i=0; i<tiled.getNumUnits(); ++i) tiled(i);
+    else april_utils::parallelFor(tiled.getNumUnits(), tiled);
+  }
+  else {
+    MatrixCopySpans<T> func(dest, layout.getSpanStride(0),
+			    src,  layout.getSpanStride(1));
+    applyMatrixSpans(layout, offsets, func);
+  }
+}
+
+#endif // MATRIX_SPANS_H
@@ -22,11 +22,46 @@
 #include "utilMatrixFloat.h"
 #include "binarizer.h"
 #include "clamp.h"
+#include "fast_float.h"
 #include <cmath>
 #include <cstdio>
+#include <cstring>
 
 using april_utils::clamp;
 
+// Reads up to max_values ASCII values (all of them if max_values < 0), line
+// by line. Returns a new[] vector with size values.
+template <typename T>
+static float *readAsciiFloats(T &stream, int max_values, int &size) {
+  constString linea;
+  int maxsize=4096;
+  float *data = new float[maxsize];
+  size = 0;
+  while (size != max_values && (linea=stream.extract_u_line()))
+    while (size != max_values && linea.extract_float(&data[size])) {
+      size++;
+      if (size == maxsize) { // resize data vector
+	float *aux = new float[2*maxsize];
+	for (int a=0;a<maxsize;a++)
+	  aux[a] = data[a];
+	maxsize *= 2;
+	delete[] data; data = aux;
+      }
+    }
+  return data;
+}
+
+// The rest of a constString is available at once, so it is parsed by
+// parseFloatText, in parallel for big texts
+static float *readAsciiFloats(constString &stream, int max_values, int &size) {
+  const char *begin = stream;
+  const char *stop;
+  float *data = april_utils::parseFloatText(begin, begin + stream.len(),
+					    max_values, size, stop);
+  stream.skip(stop - begin);
+  return data;
+}
+
 template <typename T>
 MatrixFloat* readMatrixFloatFromStream(T &stream) {
   constString linea,formato,order,token;
@@ -71,11 +106,20 @@ MatrixFloat* readMatrixFloatFromStream(T &stream) {
       mat = new MatrixFloat(n,dims);
     else if (order == "col_major")
       mat = new MatrixFloat(n,dims,0.0f,CblasColMajor);
-    int i=0;
     MatrixFloat::iterator data_it(mat->begin());
     if (formato == "ascii") {
-      while (data_it!=mat->end() && (linea=stream.extract_u_line()))
-	while (data_it!=mat->end() && linea.extract_float( &(*data_it) )) { ++data_it; }
+      int size;
+      float *data = readAsciiFloats(stream, mat->size(), size);
+      if (size == mat->size()) {
+	if (mat->getMajorOrder() == CblasRowMajor) {
+	  memcpy(mat->getRawDataAccess()->getPPALForWrite(), data,
+		 sizeof(float)*size);
+	  data_it = mat->end();
+	}
+	else
+	  for (int i=0; data_it!=mat->end(); ++data_it, ++i) *data_it = data[i];
+      }
+      delete[] data;
     } else { // binary
       while (data_it!=mat->end() && (linea=stream.extract_u_line()))
 	while (data_it!=mat->end() && linea.extract_float_binary( &(*data_it) )) { ++data_it; }
@@ -83,20 +127,11 @@ MatrixFloat* readMatrixFloatFromStream(T &stream) {
     if (data_it!=mat->end()) { delete mat; mat = 0; }
   } else { // version with comodin
     int size=0,maxsize=4096;
-    float *data = new float[maxsize];
+    float *data;
     if (formato == "ascii") {
-      while ( (linea=stream.extract_u_line()) )
-	while (linea.extract_float(&data[size])) { 
-	  size++; 
-	  if (size == maxsize) { // resize data vector
-	    float *aux = new float[2*maxsize];
-	    for (int a=0;a<maxsize;a++)
-	      aux[a] = data[a];
-	    maxsize *= 2;
-	    delete[] data; data = aux;
-	  }
-	}
+      data = readAsciiFloats(stream, -1, size);
     } else { // binary
+      data = new float[maxsize];
       while ( (linea=stream.extract_u_line()) )
 	while (linea.extract_float_binary(&data[size])) { 
 	  size++; 
@@ -132,45 +167,45 @@ MatrixFloat* readMatrixFloatFromStream(T &stream) {
 }
 
 // Returns the string length (there is a '\0' that is not counted)
-void saveMatrixFloatToFile(MatrixFloat *mat, FILE *f, bool is_ascii) {
+void saveMatrixFloatToFile(MatrixFloat *mat, OutputStream *f, bool is_ascii) {
   int i;
   for (i=0;i<mat->getNumDim()-1;i++)
-    fprintf(f, "%d ",mat->getDimSize(i));
-  fprintf(f,"%d\n",mat->getDimSize(mat->getNumDim()-1));
+    f->printf("%d ",mat->getDimSize(i));
+  f->printf("%d\n",mat->getDimSize(mat->getNumDim()-1));
   if (is_ascii) {
     const int columns = 9;
-    fprintf(f,"ascii");
+    f->printf("ascii");
     if (mat->getMajorOrder() == CblasColMajor)
-      fprintf(f, " col_major");
+      f->printf(" col_major");
     else
-      fprintf(f, " row_major");
-    fprintf(f, "\n");
+      f->printf(" row_major");
+    f->printf("\n");
     int i=0;
     for(MatrixFloat::const_iterator it(mat->begin()); it!=mat->end();++it,++i) {
-      fprintf(f,"%.5g%c",(*it),
+      f->printf("%.5g%c",(*it),
 	      ((((i+1) % columns) == 0) ? '\n' : ' '));
     }
     if ((i % columns) != 0) {
-      fprintf(f,"\n"); 
+      f->printf("\n"); 
     }
   } else { // binary
     const int columns = 16;
-    fprintf(f,"binary");
+    f->printf("binary");
     if (mat->getMajorOrder() == CblasColMajor)
-      fprintf(f, " col_major");
+      f->printf(" col_major");
     else
-      fprintf(f, " row_major");
-    fprintf(f, "\n");
+      f->printf(" row_major");
+    f->printf("\n");
     // We substract 1 so the final '\0' is not considered
     char b[5];
     int i=0;
     for(MatrixFloat::const_iterator it(mat->begin()); it!=mat->end();++it,++i) {
       binarizer::code_float(*it, b);
-      fprintf(f, "%c%c%c%c%c", b[0], b[1], b[2], b[3], b[4]);
-      if ((i+1) % columns == 0) fprintf(f, "\n");
+      f->write(b, 5);
+      if ((i+1) % columns == 0) f->printf("\n");
     }
     if ((i % columns) != 0)
-      fprintf(f,"\n"); 
+      f->printf("\n"); 
   }
 }
 
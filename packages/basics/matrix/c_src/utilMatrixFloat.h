@@ -28,7 +28,7 @@
 template <typename T>
 MatrixFloat* readMatrixFloatFromStream(T &stream);
 int saveMatrixFloatToString(MatrixFloat *mat, char **buffer, bool is_ascii);
-void saveMatrixFloatToFile(MatrixFloat *mat, FILE *f, bool is_ascii);
+void saveMatrixFloatToFile(MatrixFloat *mat, OutputStream *f, bool is_ascii);
 
 MatrixFloat* readMatrixFloatHEX(int width, int height, constString cs);
 
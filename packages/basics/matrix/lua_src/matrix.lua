@@ -161,6 +161,8 @@ april_set_doc("matrix.fromFilename", {
 		class = "function", summary = "constructor",
 		description ={
 		  "Loads a matrix from a filename.",
+		  "The file is mapped in memory, and big ASCII matrices",
+		  "are parsed in parallel by util.get_num_threads() threads.",
 		},
 		params = {
 		  "A filename path.",
@@ -0,0 +1,35 @@
+-- benchmark of matrix element-wise operations and reductions over different
+-- layouts, usage: april-ann bench_matrix.lua [size=1000] [reps=20]
+size = tonumber(arg and arg[1] or 1000)
+reps = tonumber(arg and arg[2] or 20)
+
+function bench(name, f)
+  f() -- warm up
+  local clock = util.stopwatch()
+  clock:go()
+  for i=1,reps do f() end
+  clock:stop()
+  local cpu,wall = clock:read()
+  printf("%-40s %10.3f ms\n", name, wall/reps*1000)
+end
+
+rnd = random(1234)
+base = matrix(size, size)
+t = {}
+for i=1,size*size do t[i] = rnd:rand() end
+base:copy_from_table(t)
+layouts = {
+  { "simple",    base },
+  { "sub-matrix", base:slice({2,2},{size-2,size-2}) },
+  { "col_major", base:clone("col_major") },
+}
+for _,l in ipairs(layouts) do
+  local name,m = l[1],l[2]
+  local values = m:toTable()
+  bench(name .. " min/max",        function() m:min() m:max() end)
+  bench(name .. " fill",           function() m:fill(0.5) end)
+  bench(name .. " clone",          function() m:clone() end)
+  bench(name .. " transpose",      function() m:transpose() end)
+  bench(name .. " toTable",        function() m:toTable() end)
+  bench(name .. " copy_from_table",function() m:copy_from_table(values) end)
+end
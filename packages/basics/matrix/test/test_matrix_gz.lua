@@ -0,0 +1,89 @@
+-- Checks the gzip streams: matrices saved and loaded through .gz paths
+-- (several compressed blocks, written with one and with several threads),
+-- and util.read_file/util.write_file
+local rnd = random(4321)
+local data = {}
+for i=1,300000 do data[i] = (rnd:rand(2) - 1) * 10^rnd:randInt(-3,3) end
+local m = matrix(1000, 300, data)
+
+local plain = os.tmpname()
+local gz    = plain .. ".gz"
+local function gzip_ok(filename)
+  return os.execute("gzip -t " .. filename .. " 2> /dev/null") == 0
+end
+local function equals(a, b)
+  local ta, tb = a:toTable(), b:toTable()
+  if #ta ~= #tb then return false end
+  for i=1,#ta do if ta[i] ~= tb[i] then return false end end
+  return true
+end
+
+local nthreads = util.get_num_threads()
+for _,threads in ipairs{ 1, 3 } do
+  util.set_num_threads(threads)
+  for _,mode in ipairs{ "ascii", "binary" } do
+    m:toFilename(plain, mode)
+    m:toFilename(gz, mode)
+    -- more than one block of 1MB
+    assert(#util.read_file(plain) > 2^20)
+    assert(gzip_ok(gz))
+    -- the decompressed file is the same than the plain one
+    assert(util.read_file(gz) == util.read_file(plain))
+    local ref = matrix.fromFilename(plain)
+    assert(equals(matrix.fromFilename(gz), ref))
+    if mode == "binary" then assert(equals(ref, m)) end
+  end
+end
+util.set_num_threads(nthreads)
+
+-- strings and tables of strings, empty files, files not found
+util.write_file(gz, "")
+assert(gzip_ok(gz) and util.read_file(gz) == "")
+util.write_file(gz, { "return ", 4, "+", "5" })
+assert(loadstring(util.read_file(gz))() == 9)
+util.write_file(plain, "1 2\nascii\n7 8\n")
+assert(matrix.fromFilename(plain):get(1,2) == 8)
+assert(not pcall(util.write_file, gz, { "a", {} }))
+os.remove(plain)
+os.remove(gz)
+assert(util.read_file(gz) == nil)
+assert(not pcall(matrix.fromFilename, gz))
+assert(not pcall(m.toFilename, m, "/nonexistent/dir/m.mat.gz"))
+
+-- truncated and corrupt gzip files raise an error, they are not read as
+-- short files. io.open decompresses .gz paths, so the raw bytes are read and
+-- written through other names
+m:toFilename(gz, "binary")
+local content = util.read_file(gz)
+os.rename(gz, plain)
+local compressed = io.open(plain, "rb"):read("*a")
+local function write_gz(filename, data)
+  local f = io.open(plain, "wb")
+  f:write(data)
+  f:close()
+  os.rename(plain, filename)
+end
+write_gz(plain .. "-trunc.gz", compressed:sub(1, math.floor(#compressed/2)))
+assert(not pcall(util.read_file, plain .. "-trunc.gz"))
+assert(not pcall(matrix.fromFilename, plain .. "-trunc.gz"))
+-- a byte changed after the header breaks the deflate data or the crc
+local p = math.floor(#compressed/3)
+write_gz(plain .. "-bad.gz",
+	 compressed:sub(1, p-1) .. string.char((compressed:byte(p) + 1) % 256) ..
+	   compressed:sub(p+1))
+assert(not pcall(util.read_file, plain .. "-bad.gz"))
+assert(not pcall(matrix.fromFilename, plain .. "-bad.gz"))
+-- the original bytes are still a valid file
+write_gz(gz, compressed)
+assert(#content > 0 and util.read_file(gz) == content)
+-- with gzip=true any name is decompressed, and plain files are read as
+-- they are
+os.rename(gz, plain)
+assert(util.read_file(plain, true) == content)
+assert(util.read_file(plain) == compressed)
+util.write_file(plain, "plain text\n")
+assert(util.read_file(plain, true) == "plain text\n")
+os.remove(plain)
+os.remove(gz)
+os.remove(plain .. "-trunc.gz")
+os.remove(plain .. "-bad.gz")
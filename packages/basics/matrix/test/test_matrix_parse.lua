@@ -0,0 +1,113 @@
+-- Checks the ASCII matrix parser of fromString and fromFilename: number
+-- syntax and rounding, comments and bad tokens, and the parallel parse of
+-- big texts
+local function values(str)
+  local m = matrix.fromString(str)
+  return m:toTable(), m
+end
+
+-- number syntax, the result is the float nearest to the decimal value
+local t = values[[
+1 *
+ascii
+0 -0 +3 .5 5. -2.25e2 1E-3 12345678 0.1 -7.5e-1,8;9
+1.000000059604644775390625 1.00000005960464478 1.0000000596046448
+0x10 123456789012345678901234567890 3.4028234e38
+]]
+local expected = { 0, 0, 3, 0.5, 5, -225, 0.0010000000474974513, 12345678,
+		   0.10000000149011612, -0.75, 8, 9,
+		   -- halfway between 1 and the next float, rounded to even
+		   1,
+		   -- a bit above halfway
+		   1.00000011920928955078125, 1.00000011920928955078125,
+		   16, 1.2345678918272927e29, 3.4028234663852886e38 }
+assert(#t == #expected)
+for i=1,#t do
+  if t[i] ~= expected[i] then
+    error(string.format("value %d: %.17g ~= %.17g", i, t[i], expected[i]))
+  end
+end
+
+-- out of range values
+local t = values("1 3\nascii\n1e-40 -1e39 1e400\n")
+assert(t[1] > 0 and t[1] < 1.2e-38)
+assert(t[2] == -math.huge and t[3] == math.huge)
+
+-- comment lines, and a token which is not a number skips its line
+local t = values("1 *\nascii\n# 1 2\n3 4 # 5\n  6 x 7\n8,9e\n10 1e+\n")
+local expected = { 3, 4, 6, 8, 9, 10, 1 }
+assert(#t == #expected)
+for i=1,#t do assert(t[i] == expected[i]) end
+
+-- a matrix with more values than needed, and with less
+local t, m = values("2 2\nascii\n1 2\n3 4 5 6\n")
+assert(m:dim()[1] == 2 and t[4] == 4)
+assert(not pcall(matrix.fromString, "2 2\nascii\n1 2 3\n"))
+
+-- column major order
+local m = matrix.fromString("2 2\nascii col_major\n1 2 3 4\n")
+assert(m:get(1,1) == 1 and m:get(1,2) == 2 and m:get(2,1) == 3)
+
+-- big texts are parsed in pieces, the result must be the same than with
+-- only one thread
+local rnd   = random(1234)
+local lines = { "* 8", "ascii" }
+for i=1,40000 do
+  local row = {}
+  for j=1,8 do row[j] = string.format("%.7g", (rnd:rand(2) - 1) * 10^rnd:randInt(-5,5)) end
+  if i % 1000 == 0 then table.insert(lines, "# comment " .. i) end
+  table.insert(lines, table.concat(row, " "))
+end
+local str = table.concat(lines, "\n")
+assert(#str > 2^21)
+local nthreads = util.get_num_threads()
+util.set_num_threads(4)
+local m4 = matrix.fromString(str)
+util.set_num_threads(1)
+local m1 = matrix.fromString(str)
+util.set_num_threads(nthreads)
+assert(m4:dim()[1] == 40000 and m1:dim()[1] == 40000)
+local d1, d4 = m1:toTable(), m4:toTable()
+for i=1,#d1 do assert(d1[i] == d4[i]) end
+-- spot check against Lua numbers
+local n = 0
+for i=3,#lines,97 do
+  if not lines[i]:find("#") then
+    local j = 0
+    for v in lines[i]:gmatch("%S+") do
+      j = j + 1
+      local x = tonumber(v)
+      assert(math.abs(m1:get(i - 2 - math.floor((i-2)/1001), j) - x) <= math.abs(x)*1e-7)
+      n = n + 1
+    end
+  end
+end
+assert(n > 0)
+
+-- fromFilename, with a file of exactly one page (not finished by a new
+-- line) and with a smaller one
+local filename = os.tmpname()
+local function load_text(text)
+  local f = io.open(filename, "w")
+  f:write(text)
+  f:close()
+  return matrix.fromFilename(filename)
+end
+local header = "1 *\nascii\n"
+local body   = { }
+local len    = #header
+local i      = 0
+while len < 4096 - 12 do
+  i = i + 1
+  body[i] = tostring(i)
+  len = len + #body[i] + 1
+end
+local text = header .. table.concat(body, " ")
+text = text .. string.rep(" ", 4096 - #text - 4) .. "9999"
+assert(#text == 4096)
+local m = load_text(text)
+assert(m:dim()[2] == i + 1 and m:get(1, i + 1) == 9999 and m:get(1, i) == i)
+local m = load_text("2 3\nascii\n1 2 3\n4 5 6")
+assert(m:get(2,3) == 6)
+os.remove(filename)
+assert(not pcall(matrix.fromFilename, filename))
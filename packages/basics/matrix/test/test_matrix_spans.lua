@@ -0,0 +1,84 @@
+-- element-wise operations and reductions over contiguous, strided and
+-- sub-matrix layouts, compared with element by element access
+rnd = random(825)
+
+function random_matrix(...)
+  local m = matrix(...)
+  local t = {}
+  for i=1,#m:toTable() do t[i] = rnd:rand(200)-100 end
+  return m:copy_from_table(t)
+end
+
+function check_equal(a, b, msg)
+  local ta, tb = a:toTable(), b:toTable()
+  assert(#ta == #tb, msg)
+  for i=1,#ta do assert(ta[i] == tb[i], msg) end
+end
+
+function check_min_max(m, msg)
+  local t = m:toTable()
+  local mn, mx = t[1], t[1]
+  for i=2,#t do mn = math.min(mn, t[i]) mx = math.max(mx, t[i]) end
+  assert(m:min() == mn and m:max() == mx, msg)
+end
+
+-- toTable follows row-major order in all the layouts
+m = random_matrix(7, 9, 5)
+t = m:toTable()
+for i=1,7 do for j=1,9 do for k=1,5 do
+      assert(m:get(i,j,k) == t[((i-1)*9 + (j-1))*5 + k])
+end end end
+
+layouts = {
+  simple    = random_matrix(40, 30),
+  sub_rows  = random_matrix(40, 30):slice({5,1},{20,30}),
+  sub       = random_matrix(40, 30):slice({3,4},{20,11}),
+  sub_sub   = random_matrix(40, 30):slice({3,4},{30,20}):slice({2,5},{10,7}),
+  col_major = matrix.col_major(13, 17):copy_from_table(random_matrix(13,17):toTable()),
+  three_dim = random_matrix(6, 8, 10):slice({2,1,3},{4,8,5}),
+  -- large enough to be processed by several threads
+  large     = random_matrix(700, 600),
+  large_sub = random_matrix(700, 600):slice({10,10},{600,500}),
+}
+
+for name,m in pairs(layouts) do
+  check_min_max(m, name .. " min/max")
+  -- clone and copy_from_table
+  local c = m:clone()
+  check_equal(m, c, name .. " clone")
+  local dims = m:dim()
+  if #dims == 2 then
+    local c2 = m:clone("col_major")
+    check_equal(m, c2, name .. " clone col_major")
+  end
+  -- transpose
+  local tr = m:transpose()
+  if #dims == 2 then
+    for i=1,dims[1],3 do for j=1,dims[2],2 do
+	assert(m:get(i,j) == tr:get(j,i), name .. " transpose")
+    end end
+  else
+    for i=1,dims[1] do for j=1,dims[2] do for k=1,dims[3] do
+	  assert(m:get(i,j,k) == tr:get(k,j,i), name .. " transpose")
+    end end end
+  end
+  check_equal(m, tr:transpose(), name .. " transpose twice")
+  -- clamp
+  local cl = m:clone():clamp(-50, 50)
+  local tm, tc = m:toTable(), cl:toTable()
+  for i=1,#tm do
+    assert(tc[i] == math.max(-50, math.min(50, tm[i])), name .. " clamp")
+  end
+  -- fill only modifies the sub-matrix
+  m:fill(3)
+  assert(m:min() == 3 and m:max() == 3, name .. " fill")
+end
+
+-- fill over a sub-matrix keeps the rest of the parent matrix
+p = matrix(10, 10)
+p:fill(1)
+p:slice({3,3},{4,5}):fill(2)
+s = 0
+for _,v in ipairs(p:toTable()) do s = s + v end
+assert(s == 100 + 4*5)
+print("OK")
@@ -366,3 +366,41 @@
 }
 //BIND_END
 
+
+//BIND_METHOD dice probability
+//DOC_BEGIN
+// number probability(int outcome)
+/// Returns the normalized probability of the given outcome (from 1).
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 1);
+  int outcome;
+  LUABIND_GET_PARAMETER(1, int, outcome);
+  if (outcome < 1 || outcome > obj->get_outcomes())
+    LUABIND_FERROR1("Incorrect outcome %d\n", outcome);
+  LUABIND_RETURN(number, obj->probability(outcome-1));
+}
+//BIND_END
+
+//BIND_METHOD dice sample
+//DOC_BEGIN
+// table sample(random *generator, int n)
+/// Returns a table with n outcomes sampled with the alias method.
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 2);
+  LUABIND_CHECK_PARAMETER(1, MTRand);
+  MTRand *generator = lua_toMTRand(L,1);
+  unsigned int n;
+  LUABIND_GET_PARAMETER(2, uint, n);
+  int *outcomes = new int[n];
+  obj->sample(generator, n, outcomes);
+  lua_createtable(L, n, 0);
+  for (unsigned int i=0; i<n; i++) {
+    lua_pushnumber(L, outcomes[i]+1);
+    lua_rawseti(L, -2, i+1);
+  }
+  delete[] outcomes;
+  LUABIND_RETURN_FROM_STACK(-1);
+}
+//BIND_END
@@ -31,10 +31,60 @@ dice::dice(int outcom, double *prob) {
   sum = 1.0/sum;
   for (int i=0; i<outcomes-1; i++)
     threshold[i] *= sum;
+  buildAliasTables(prob);
 }
 dice::~dice() {
   delete[] threshold;
+  delete[] alias_prob;
+  delete[] alias;
 }
+
+void dice::buildAliasTables(const double *prob) {
+  alias_prob = new double[outcomes];
+  alias      = new int[outcomes];
+  double sum = 0.0;
+  for (int i=0; i<outcomes; i++) sum += prob[i];
+  // scaled probabilities, the mean is 1.0
+  double *scaled = new double[outcomes];
+  int *small = new int[outcomes], *large = new int[outcomes];
+  int num_small = 0, num_large = 0;
+  for (int i=0; i<outcomes; i++) {
+    scaled[i] = prob[i] * outcomes / sum;
+    if (scaled[i] < 1.0) small[num_small++] = i;
+    else large[num_large++] = i;
+  }
+  while (num_small > 0 && num_large > 0) {
+    int s = small[--num_small], l = large[--num_large];
+    alias_prob[s] = scaled[s];
+    alias[s]      = l;
+    scaled[l]     = (scaled[l] + scaled[s]) - 1.0;
+    if (scaled[l] < 1.0) small[num_small++] = l;
+    else large[num_large++] = l;
+  }
+  // the remaining ones have probability 1.0 (up to rounding errors)
+  while (num_large > 0) {
+    int l = large[--num_large];
+    alias_prob[l] = 1.0; alias[l] = l;
+  }
+  while (num_small > 0) {
+    int s = small[--num_small];
+    alias_prob[s] = 1.0; alias[s] = s;
+  }
+  delete[] scaled;
+  delete[] small;
+  delete[] large;
+}
+
+void dice::sample(MTRand *generator, unsigned int n, int *dest) {
+  for (unsigned int i=0; i<n; i++) dest[i] = alias_thrown(generator);
+}
+double dice::probability(int outcome) const {
+  // the last threshold is not normalized, it is always 1.0
+  double upper = (outcome < outcomes-1) ? threshold[outcome] : 1.0;
+  double lower = (outcome > 0) ? threshold[outcome-1] : 0.0;
+  return upper - lower;
+}
+
 int dice::thrown(MTRand *generator) {
   double key = generator->rand(); //real number in [0,1]
   int left=0,right=outcomes-1;
@@ -27,11 +27,28 @@
 class dice : public Referenced {
   int outcomes;
   double *threshold;
+  // alias method tables (Walker/Vose), used by sample
+  double *alias_prob;
+  int    *alias;
+  void buildAliasTables(const double *prob);
 public:
   dice(int outcom, double *prob);
   ~dice();
   int get_outcomes() const { return outcomes; }
   int thrown(MTRand *generator);
+  /// Normalized probability of the given outcome
+  double probability(int outcome) const;
+  /// One outcome using the alias method, O(1) and only one random number.
+  /// The sequence is different than the one given by thrown.
+  int alias_thrown(MTRand *generator) {
+    // one random number gives the column and the coin of the column
+    double u   = generator->randExc() * outcomes;
+    int    col = static_cast<int>(u);
+    if (col >= outcomes) col = outcomes-1;
+    return ((u - col) < alias_prob[col]) ? col : alias[col];
+  }
+  /// Writes n outcomes at dest using alias_thrown
+  void sample(MTRand *generator, unsigned int n, int *dest);
 };
 
 #endif // DICE_H
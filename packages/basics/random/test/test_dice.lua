@@ -16,3 +16,25 @@ for i=1,dado:outcomes() do
 	 i,histogram[i]/veces,tabladice[i])
 end
 
+
+-- alias method sampler
+histogram = {}
+for i=1,dado:outcomes() do table.insert(histogram,0) end
+for _,resul in ipairs(dado:sample(aleat, veces)) do
+  histogram[resul] = histogram[resul]+1
+end
+
+print"---------------------------------------"
+for i=1,dado:outcomes() do
+  printf("Histograma[%d] = %.3f should be %.3f\n",
+	 i,histogram[i]/veces,tabladice[i])
+  assert(math.abs(histogram[i]/veces - tabladice[i]) < 0.03)
+end
+
+-- normalized probabilities of the outcomes
+dado2 = random.dice{ 2, 1, 1 }
+assert(math.abs(dado2:probability(1) - 0.5)  < 1e-9)
+assert(math.abs(dado2:probability(3) - 0.25) < 1e-9)
+for i=1,dado:outcomes() do
+  assert(math.abs(dado:probability(i) - tabladice[i]) < 1e-9)
+end
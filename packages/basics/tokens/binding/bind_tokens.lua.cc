@@ -59,6 +59,7 @@ int token_sparse_iterator_function(lua_State *L) {
 //BIND_HEADER_H
 #include "token_base.h"
 #include "token_memory_block.h"
+#include "token_class_indices.h"
 #include "token_vector.h"
 //BIND_END
 
@@ -84,6 +85,13 @@ int token_sparse_iterator_function(lua_State *L) {
 }
 //BIND_END
 
+//BIND_METHOD Token convert_to_class_indices
+{
+  TokenClassIndices *token_class_indices = obj->convertTo<TokenClassIndices*>();
+  LUABIND_RETURN(TokenClassIndices, token_class_indices);
+}
+//BIND_END
+
 //BIND_METHOD Token convert_to_bunch_vector
 {
   TokenBunchVector *token_bunch_vector = obj->convertTo<TokenBunchVector*>();
@@ -130,6 +138,77 @@ int token_sparse_iterator_function(lua_State *L) {
 
 ////////////////////////////////////////////////////////////////////
 
+//BIND_LUACLASSNAME TokenClassIndices tokens.class_indices
+//BIND_CPP_CLASS    TokenClassIndices
+//BIND_SUBCLASS_OF  TokenClassIndices Token
+
+//BIND_CONSTRUCTOR TokenClassIndices
+// receives a table with class indices (from 1 to num_classes), the number of
+// classes, and optionally a table with the weight of each pattern
+{
+  LUABIND_CHECK_ARGN(>=,2);
+  LUABIND_CHECK_ARGN(<=,3);
+  LUABIND_CHECK_PARAMETER(1, table);
+  unsigned int sz, num_classes;
+  LUABIND_TABLE_GETN(1, sz);
+  LUABIND_GET_PARAMETER(2, uint, num_classes);
+  bool with_weights = (lua_gettop(L) == 3 && !lua_isnil(L, 3));
+  if (with_weights) {
+    unsigned int wsz;
+    LUABIND_CHECK_PARAMETER(3, table);
+    LUABIND_TABLE_GETN(3, wsz);
+    if (wsz != sz)
+      LUABIND_FERROR2("Incorrect number of weights, expected %d, found %d\n",
+		      sz, wsz);
+  }
+  obj = new TokenClassIndices(sz, num_classes, with_weights);
+  int *indices = obj->getIndices()->getPPALForWrite();
+  LUABIND_TABLE_TO_VECTOR(1, int, indices, sz);
+  for (unsigned int i=0; i<sz; ++i) {
+    if (indices[i] < 1 || indices[i] > static_cast<int>(num_classes)) {
+      delete obj;
+      LUABIND_FERROR2("Class index out of range [1,%d]: %d\n",
+		      num_classes, indices[i]);
+    }
+    --indices[i];
+  }
+  if (with_weights) {
+    float *weights = obj->getWeights()->getPPALForWrite();
+    LUABIND_TABLE_TO_VECTOR(3, float, weights, sz);
+  }
+  LUABIND_RETURN(TokenClassIndices, obj);
+}
+//BIND_END
+
+//BIND_METHOD TokenClassIndices to_table
+// returns the class indices (from 1 to num_classes), and the weights table
+// if the token has weights
+{
+  int sz = static_cast<int>(obj->getUsedSize());
+  const int *indices = obj->getIndices()->getPPALForRead();
+  lua_createtable(L, sz, 0);
+  for (int i=0; i<sz; ++i) {
+    lua_pushint(L, indices[i] + 1);
+    lua_rawseti(L, -2, i+1);
+  }
+  if (obj->getWeights() == 0) LUABIND_RETURN_FROM_STACK(-1);
+  else {
+    const float *weights = obj->getWeights()->getPPALForRead();
+    LUABIND_VECTOR_TO_NEW_TABLE(float, weights, sz);
+    LUABIND_RETURN_FROM_STACK(-2);
+    LUABIND_RETURN_FROM_STACK(-2);
+  }
+}
+//BIND_END
+
+//BIND_METHOD TokenClassIndices get_num_classes
+{
+  LUABIND_RETURN(uint, obj->getNumClasses());
+}
+//BIND_END
+
+////////////////////////////////////////////////////////////////////
+
 //BIND_LUACLASSNAME TokenVectorGeneric tokens.vector.__base__
 //BIND_CPP_CLASS    TokenVectorGeneric
 //BIND_SUBCLASS_OF  TokenVectorGeneric Token
@@ -0,0 +1,108 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Francisco Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include "token_class_indices.h"
+
+TokenClassIndices::TokenClassIndices(unsigned int size,
+				     unsigned int num_classes,
+				     bool with_weights) :
+  indices(new IntGPUMirroredMemoryBlock(size)),
+  weights(with_weights ? new FloatGPUMirroredMemoryBlock(size) : 0),
+  used_size(size), num_classes(num_classes) {
+}
+
+TokenClassIndices::~TokenClassIndices() {
+  delete indices;
+  delete weights;
+}
+
+void TokenClassIndices::resize(unsigned int size) {
+  if (size > indices->getSize()) {
+    delete indices;
+    indices = new IntGPUMirroredMemoryBlock(size);
+    if (weights) {
+      delete weights;
+      weights = new FloatGPUMirroredMemoryBlock(size);
+    }
+  }
+  used_size = size;
+}
+
+Token *TokenClassIndices::clone() const {
+  TokenClassIndices *token = new TokenClassIndices(used_size, num_classes,
+						   weights != 0);
+  const int *src = indices->getPPALForRead();
+  int *dest      = token->indices->getPPALForWrite();
+  for (unsigned int i=0; i<used_size; ++i) dest[i] = src[i];
+  if (weights) {
+    const float *wsrc = weights->getPPALForRead();
+    float *wdest      = token->weights->getPPALForWrite();
+    for (unsigned int i=0; i<used_size; ++i) wdest[i] = wsrc[i];
+  }
+  return token;
+}
+
+buffer_list* TokenClassIndices::toString() {
+  buffer_list *resul = new buffer_list;
+  uint32_t header[3] = { num_classes, used_size, (weights != 0) ? 1u : 0u };
+  resul->add_binarized_uint32_right(header, 3);
+  resul->add_binarized_int32_right(indices->getPPALForRead(), used_size);
+  if (weights)
+    resul->add_binarized_float_right(weights->getPPALForRead(), used_size);
+  return resul;
+}
+
+buffer_list* TokenClassIndices::debugString(const char *prefix, int debugLevel) {
+  buffer_list *resul = new buffer_list;
+  resul->add_formatted_string_right("%s TokenClassIndices with %u indices of "
+				    "%u classes%s\n", prefix, used_size,
+				    num_classes,
+				    (weights != 0) ? " and weights" : "");
+  return resul;
+}
+
+Token *TokenClassIndices::fromString(constString &cs) {
+  uint32_t header[3];
+  for (int i=0; i<3; ++i)
+    if (!cs.extract_uint32_binary(&header[i])) return 0;
+  unsigned int size = header[1];
+  if (header[2] > 1 || cs.len() != (size*(header[2]+1))*5)
+    return 0; // talla incorrecta
+  TokenClassIndices *resul = new TokenClassIndices(size, header[0],
+						   header[2] == 1);
+  bool all_is_ok = true;
+  int *dest = resul->indices->getPPALForWrite();
+  for (unsigned int i=0; all_is_ok && i<size; ++i)
+    all_is_ok = cs.extract_int32_binary(&dest[i]);
+  if (resul->weights) {
+    float *wdest = resul->weights->getPPALForWrite();
+    for (unsigned int i=0; all_is_ok && i<size; ++i)
+      all_is_ok = cs.extract_float_binary(&wdest[i]);
+  }
+  if (!all_is_ok) {
+    delete resul;
+    resul = 0;
+  }
+  return resul;
+}
+
+TokenCode TokenClassIndices::getTokenCode() const {
+  return table_of_token_codes::token_class_indices;
+}
@@ -0,0 +1,56 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Francisco Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef TOKEN_CLASS_INDICES_H
+#define TOKEN_CLASS_INDICES_H
+
+#include "gpu_mirrored_memory_block.h"
+#include "token_base.h"
+
+/// A bunch of targets of a classification problem, given by the index of
+/// the true class of each pattern (from 0 to num_classes-1) instead of a
+/// one-hot memory block of num_classes x bunch_size floats. Optionally, each
+/// pattern has a weight, which multiplies its loss and its gradient.
+class TokenClassIndices : public Token {
+  IntGPUMirroredMemoryBlock   *indices;
+  FloatGPUMirroredMemoryBlock *weights;
+  unsigned int used_size, num_classes;
+public:
+  TokenClassIndices(unsigned int size, unsigned int num_classes,
+		    bool with_weights=false);
+  ~TokenClassIndices();
+  IntGPUMirroredMemoryBlock *getIndices() { return indices; }
+  /// Returns 0 if the patterns have not weights
+  FloatGPUMirroredMemoryBlock *getWeights() { return weights; }
+  unsigned int getUsedSize() const { return used_size; }
+  unsigned int getNumClasses() const { return num_classes; }
+  void resize(unsigned int size);
+  Token *clone() const;
+  /// Binarized num_classes, size and a with_weights flag, followed by the
+  /// indices and the weights (if any)
+  buffer_list* toString();
+  buffer_list* debugString(const char *prefix, int debugLevel);
+  TokenCode getTokenCode() const;
+  /// Returns 0 if cs is not a string given by toString
+  static Token *fromString(constString &cs);
+  bool getCudaFlag() { return indices->getCudaFlag(); }
+};
+
+#endif // TOKEN_CLASS_INDICES_H
@@ -48,6 +48,8 @@ FILE **newfile (lua_State *L) {
 #include <cmath>
 #include <ctime>
 #include "popen2.h"
+#include "parallel_for.h"
+#include "io_stream.h"
 
 using namespace april_utils;
 
@@ -488,6 +490,112 @@ using namespace april_utils;
 // se podría devolver el booleano que devuelve (y que estamos
 // ignorando) y el tiempo restante :P
 
+//BIND_FUNCTION util.set_num_threads
+//DOC_BEGIN
+// set_num_threads(int n)
+/// changes the number of threads used by parallel operations (matrix
+/// operations over large matrices, ...)
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==,1);
+  unsigned int n;
+  LUABIND_GET_PARAMETER(1, uint, n);
+  setNumWorkerThreads(n);
+}
+//BIND_END
+
+//BIND_FUNCTION util.get_num_threads
+{
+  LUABIND_CHECK_ARGN(==,0);
+  LUABIND_RETURN(uint, getNumWorkerThreads());
+}
+//BIND_END
+
+//BIND_FUNCTION util.read_file
+//DOC_BEGIN
+// string read_file(string filename, bool gzip=false)
+/// returns the content of the file, or nil if it could not be opened.
+/// Files whose name finishes with .gz, or any file when gzip is true, are
+/// decompressed in a background thread while they are read (plain files
+/// are read as they are), corrupt or truncated ones raise an error.
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(>=,1);
+  LUABIND_CHECK_ARGN(<=,2);
+  const char *filename;
+  bool gzip;
+  LUABIND_GET_PARAMETER(1, string, filename);
+  LUABIND_GET_OPTIONAL_PARAMETER(2, bool, gzip, false);
+  InputStream *f = openInputStream(filename, gzip);
+  if (f == 0) {
+    LUABIND_RETURN_NIL();
+  }
+  else {
+    luaL_Buffer b;
+    luaL_buffinit(L, &b);
+    size_t n;
+    do {
+      char *dest = luaL_prepbuffer(&b);
+      n = f->read(dest, LUAL_BUFFERSIZE);
+      luaL_addsize(&b, n);
+    } while (n > 0);
+    if (f->getError() != 0) {
+      // the partial content is discarded, the message is kept at the stack
+      // to delete the stream before raising the error
+      luaL_pushresult(&b);
+      lua_pop(L, 1);
+      lua_pushstring(L, f->getError());
+      delete f;
+      LUABIND_FERROR2("%s: %s", filename, lua_tostring(L, -1));
+    }
+    delete f;
+    luaL_pushresult(&b);
+    LUABIND_RETURN_FROM_STACK(-1);
+  }
+}
+//BIND_END
+
+//BIND_FUNCTION util.write_file
+//DOC_BEGIN
+// write_file(string filename, string|table data)
+/// writes the string, or the concatenation of the strings of the table,
+/// into the file. Files whose name finishes with .gz are compressed, using
+/// util.get_num_threads() threads.
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==,2);
+  const char *filename;
+  LUABIND_GET_PARAMETER(1, string, filename);
+  if (!lua_isstring(L,2) && !lua_istable(L,2))
+    LUABIND_ERROR("expected a string or a table of strings");
+  OutputStream *f = openOutputStream(filename);
+  if (f == 0)
+    LUABIND_FERROR1("unable to open %s", filename);
+  size_t len;
+  if (lua_istable(L,2)) {
+    int n = lua_objlen(L,2);
+    for (int i=1; i<=n; ++i) {
+      lua_rawgeti(L,2,i);
+      const char *data = lua_tolstring(L,-1,&len);
+      if (data == 0) {
+	delete f;
+	LUABIND_FERROR1("position %d is not a string", i);
+      }
+      f->write(data, len);
+      lua_pop(L,1);
+    }
+  }
+  else {
+    const char *data = lua_tolstring(L,2,&len);
+    f->write(data, len);
+  }
+  bool ok = f->close();
+  delete f;
+  if (!ok)
+    LUABIND_FERROR1("error writing %s", filename);
+}
+//BIND_END
+
 //BIND_FUNCTION util.sleep
 {
   LUABIND_CHECK_ARGN(==,1);
@@ -80,7 +80,7 @@ namespace april_utils {
 
     typedef KeyType         key_type;
     typedef DataType        data_type;
-    typedef pair<const key_type, data_type> value_type;
+    typedef pair<key_type, data_type> value_type;
     typedef value_type&     reference;
     typedef const reference const_reference;
     typedef value_type*     pointer;
@@ -139,7 +139,7 @@ namespace april_utils {
     public:
       typedef KeyType         key_type;
       typedef DataType        data_type;
-      typedef pair<const key_type, data_type> value_type;
+      typedef pair<key_type, data_type> value_type;
       typedef value_type&     reference;
       typedef const reference const_reference;
       typedef value_type*     pointer;
@@ -363,7 +363,7 @@ namespace april_utils {
 
   template <typename ky, typename dt, 
 	    typename hfcn, typename eqky>
-    const pair<const ky,dt> * cache_open_addr_hash<ky,dt,hfcn,eqky>::find_pair(const ky& k) const {
+    const pair<ky,dt> * cache_open_addr_hash<ky,dt,hfcn,eqky>::find_pair(const ky& k) const {
     unsigned int index = hash_function(k) & hash_mask;
     if (equal_key(buckets[index].value.first,k) &&
 	buckets[index].stamp == timestamp)
@@ -22,6 +22,7 @@
 #include <cstdlib>
 #include "constString.h"
 #include "binarizer.h"
+#include "fast_float.h"
 
 constString::constString(const char *s, size_t n) {
   buffer = s;
@@ -171,16 +172,11 @@ bool constString::extract_char(char *resul) {
 bool constString::extract_float(float *resul,const char *separadores) {
   ltrim(separadores);
   if (empty()) return false;
-  char *aux;
-  // fixme: strtof no controla si nos salimos del constString, luego
-  // lo comprobamos viendo si length < 0 pero podría dar violación de
-  // segmento
-  float value = strtof(buffer,&aux);  
-  if (aux == buffer) return false;
-  if (aux > buffer+length) return false;
+  // parseFloat no lee fuera del constString
+  const char *aux = april_utils::parseFloat(buffer, buffer+length, resul);
+  if (aux == 0) return false;
   length -= aux-buffer;
   buffer = aux;
-  *resul = value;
   return true;
 }
 
@@ -0,0 +1,248 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Francisco Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include "fast_float.h"
+#include "parallel_for.h"
+
+namespace april_utils {
+
+  // powers of ten which are exact in double precision
+  static const double exact_pow10[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  // separators of constString::extract_float
+  static inline bool isSeparator(char c) {
+    return c == ' ' || c == '\t' || c == ',' || c == ';' ||
+      c == '\r' || c == '\n';
+  }
+
+  static inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+  // strtof needs a '\0' terminated string, so the token is copied
+  static const char *slowParseFloat(const char *begin, const char *end,
+				    float *result) {
+    const char *p = begin;
+    while (p < end && *p != '\0' && !isSeparator(*p)) ++p;
+    size_t len = p - begin;
+    char local[64];
+    char *buf  = (len < sizeof(local)) ? local : new char[len+1];
+    memcpy(buf, begin, len);
+    buf[len] = '\0';
+    char *aux;
+    float value = strtof(buf, &aux);
+    size_t consumed = aux - buf;
+    if (buf != local) delete[] buf;
+    if (consumed == 0) return 0;
+    *result = value;
+    return begin + consumed;
+  }
+
+  const char *parseFloat(const char *begin, const char *end, float *result) {
+    const char *p = begin;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+    // up to 19 significant digits fit in 64 bits
+    uint64_t mantissa = 0;
+    int  digits = 0, exponent = 0;
+    bool any_digit = false, exact = true;
+    for (; p < end && isDigit(*p); ++p) {
+      any_digit = true;
+      if (digits < 19) {
+	mantissa = mantissa*10 + (*p - '0');
+	if (mantissa > 0) ++digits;
+      }
+      else {
+	++exponent;
+	if (*p != '0') exact = false;
+      }
+    }
+    if (p < end && *p == '.') {
+      for (++p; p < end && isDigit(*p); ++p) {
+	any_digit = true;
+	if (digits < 19) {
+	  mantissa = mantissa*10 + (*p - '0');
+	  if (mantissa > 0) ++digits;
+	  --exponent;
+	}
+	else if (*p != '0') exact = false;
+      }
+    }
+    // inf, nan, hexadecimal numbers, or not a number
+    if (!any_digit || (p < end && (*p == 'x' || *p == 'X')))
+      return slowParseFloat(begin, end, result);
+    if (p < end && (*p == 'e' || *p == 'E')) {
+      const char *q = p+1;
+      bool negative_exp = false;
+      if (q < end && (*q == '-' || *q == '+')) negative_exp = (*q++ == '-');
+      if (q < end && isDigit(*q)) {
+	int e = 0;
+	for (; q < end && isDigit(*q); ++q)
+	  if (e < 100000) e = e*10 + (*q - '0');
+	exponent += negative_exp ? -e : e;
+	p = q;
+      }
+    }
+    // the mantissa and the power of ten are exact doubles, so the double
+    // operation is correctly rounded (Clinger's fast path)
+    if (exact && mantissa <= (static_cast<uint64_t>(1) << 53) &&
+	exponent >= -22 && exponent <= 22) {
+      double value = static_cast<double>(mantissa);
+      if (exponent < 0) value /= exact_pow10[-exponent];
+      else value *= exact_pow10[exponent];
+      if (value == 0.0) {
+	*result = negative ? -0.0f : 0.0f;
+	return p;
+      }
+      if (value >= FLT_MIN && value <= FLT_MAX) {
+	// rounding the double to float gives the correctly rounded float,
+	// unless the double is exactly halfway between two floats (the
+	// decimal value could be on either side), these go to strtof
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(double));
+	if ((bits & 0x1fffffffu) != 0x10000000u) {
+	  float f = static_cast<float>(value);
+	  *result = negative ? -f : f;
+	  return p;
+	}
+      }
+    }
+    return slowParseFloat(begin, end, result);
+  }
+
+  /////////////////////////////////////////////////////////////////////////
+
+  struct FloatTextChunk {
+    const char *begin, *end;
+    /// position after the last parsed value
+    const char *last;
+    float *values;
+    int size, capacity, max_values;
+  };
+
+  static void parseChunk(FloatTextChunk &c) {
+    const char *p = c.begin, *end = c.end;
+    c.last = p;
+    while (p < end && c.size != c.max_values) {
+      if (isSeparator(*p)) {
+	++p;
+	continue;
+      }
+      float value;
+      const char *next = parseFloat(p, end, &value);
+      if (next == 0) {
+	// not a number, the rest of the line is ignored
+	while (p < end && *p != '\n' && *p != '\r') ++p;
+	continue;
+      }
+      if (c.size == c.capacity) {
+	c.capacity = (c.capacity > 0) ? c.capacity*2 : 4096;
+	float *aux = new float[c.capacity];
+	if (c.size > 0) memcpy(aux, c.values, sizeof(float)*c.size);
+	delete[] c.values;
+	c.values = aux;
+      }
+      c.values[c.size++] = value;
+      c.last = p = next;
+    }
+  }
+
+  struct FloatTextChunkParser {
+    FloatTextChunk *chunks;
+    void operator()(unsigned int i) { parseChunk(chunks[i]); }
+  };
+
+  float *parseFloatText(const char *begin, const char *end, int max_values,
+			int &num_values, const char *&stop) {
+    // pieces of 1MB at least
+    const size_t min_chunk_len = 1 << 20;
+    size_t len = end - begin;
+    unsigned int num_chunks = getNumWorkerThreads();
+    if (len / min_chunk_len < num_chunks)
+      num_chunks = static_cast<unsigned int>(len / min_chunk_len);
+    if (num_chunks < 1) num_chunks = 1;
+    FloatTextChunk *chunks = new FloatTextChunk[num_chunks];
+    const char *p = begin;
+    for (unsigned int i=0; i<num_chunks; ++i) {
+      chunks[i].begin = p;
+      if (i+1 < num_chunks) {
+	// every piece finishes at the end of a line
+	const char *q = begin + (len*(i+1))/num_chunks;
+	if (q < p) q = p;
+	q = static_cast<const char*>(memchr(q, '\n', end - q));
+	p = (q != 0) ? q+1 : end;
+      }
+      else p = end;
+      chunks[i].end        = p;
+      chunks[i].values     = 0;
+      chunks[i].size       = chunks[i].capacity = 0;
+      chunks[i].max_values = (num_chunks == 1) ? max_values : -1;
+    }
+    float *result;
+    if (num_chunks == 1) {
+      parseChunk(chunks[0]);
+      result     = chunks[0].values;
+      num_values = chunks[0].size;
+      stop       = chunks[0].last;
+    }
+    else {
+      FloatTextChunkParser parser;
+      parser.chunks = chunks;
+      parallelFor(num_chunks, parser);
+      num_values = 0;
+      for (unsigned int i=0; i<num_chunks; ++i) num_values += chunks[i].size;
+      if (max_values >= 0 && num_values > max_values) num_values = max_values;
+      result = (num_values > 0) ? new float[num_values] : 0;
+      stop   = begin;
+      int pos = 0;
+      for (unsigned int i=0; i<num_chunks; ++i) {
+	int n = num_values - pos;
+	if (n > chunks[i].size) n = chunks[i].size;
+	if (n > 0) memcpy(result + pos, chunks[i].values, sizeof(float)*n);
+	pos += n;
+	if (n == chunks[i].size) {
+	  if (n > 0) stop = chunks[i].last;
+	}
+	else if (n > 0) {
+	  // the last value is inside this piece, it is parsed again up to
+	  // that value to know where it finishes
+	  FloatTextChunk c = chunks[i];
+	  c.values     = 0;
+	  c.size       = c.capacity = 0;
+	  c.max_values = n;
+	  parseChunk(c);
+	  stop = c.last;
+	  delete[] c.values;
+	}
+	delete[] chunks[i].values;
+      }
+    }
+    delete[] chunks;
+    if (max_values < 0) stop = end;
+    else while (stop < end && *stop != '\n' && *stop != '\r') ++stop;
+    return result;
+  }
+
+}
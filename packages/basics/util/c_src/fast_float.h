@@ -0,0 +1,48 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Francisco Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef FAST_FLOAT_H
+#define FAST_FLOAT_H
+
+namespace april_utils {
+
+  /// Parses the decimal number at the beginning of [begin,end), with the
+  /// syntax of strtof (no leading blanks are skipped). Returns the position
+  /// after the number, or 0 if there is no number. It never reads past end,
+  /// and the result is correctly rounded: common numbers (up to 19
+  /// significant digits and exponents up to 22) are converted with one
+  /// exact double operation, the rest with strtof.
+  const char *parseFloat(const char *begin, const char *end, float *result);
+
+  /// Parses all the numbers of an ASCII text [begin,end), with the rules of
+  /// consecutive constString::extract_float calls over its lines: numbers
+  /// are separated by " \t,;\r\n", and a token which is not a number skips
+  /// the rest of its line (so lines starting with '#' are comments).
+  /// Big texts are split at line boundaries and the pieces are parsed in
+  /// parallel (see parallelFor), the values keep the order of the text.
+  /// When max_values >= 0 only the first max_values values are returned,
+  /// and stop points to the end of the line of the last one. Returns a new[]
+  /// vector with num_values floats (0 if there are no values).
+  float *parseFloatText(const char *begin, const char *end, int max_values,
+			int &num_values, const char *&stop);
+
+}
+
+#endif // FAST_FLOAT_H
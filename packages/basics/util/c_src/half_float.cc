@@ -0,0 +1,63 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include "half_float.h"
+
+namespace april_utils {
+  
+  void packHalfFloat(HalfFloatFormat format,
+		     const float *src, unsigned int src_inc,
+		     uint16_t *dest, unsigned int sz) {
+    switch(format) {
+    case HALF_FP16:
+      for (unsigned int i=0; i<sz; ++i, src+=src_inc)
+	dest[i] = floatToHalf(*src);
+      break;
+    case HALF_BF16:
+      for (unsigned int i=0; i<sz; ++i, src+=src_inc)
+	dest[i] = floatToBFloat16(*src);
+      break;
+    }
+  }
+  
+  void unpackHalfFloat(HalfFloatFormat format,
+		       const uint16_t *src, unsigned int src_inc,
+		       float *dest, unsigned int sz) {
+    unsigned int i=0;
+    switch(format) {
+    case HALF_FP16:
+#if defined(__F16C__) && defined(__AVX__)
+      if (src_inc == 1) {
+	// eight values at a time
+	for (; i+8<=sz; i+=8) {
+	  __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i));
+	  _mm256_storeu_ps(dest+i, _mm256_cvtph_ps(h));
+	}
+      }
+#endif
+      for (; i<sz; ++i) dest[i] = halfToFloat(src[i*src_inc]);
+      break;
+    case HALF_BF16:
+      for (; i<sz; ++i) dest[i] = bfloat16ToFloat(src[i*src_inc]);
+      break;
+    }
+  }
+}
@@ -0,0 +1,124 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef HALF_FLOAT_H
+#define HALF_FLOAT_H
+
+#include <cstring>
+#include <stdint.h>
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+// Conversion between fp32 and 16 bits float formats used as storage:
+// IEEE-754 half precision (fp16) and brain float (bf16). Both conversions use
+// round to nearest even.
+
+namespace april_utils {
+  
+  enum HalfFloatFormat { HALF_FP16=0, HALF_BF16=1 };
+  
+  inline uint16_t floatToHalf(float f) {
+#ifdef __F16C__
+    return _cvtss_sh(f, 0);
+#else
+    uint32_t x;
+    memcpy(&x, &f, sizeof(float));
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t mant = x & 0x007fffff;
+    int      fexp = (x >> 23) & 0xff;
+    if (fexp == 0xff) // inf or NaN
+      return static_cast<uint16_t>(sign | 0x7c00 | (mant ? 0x200 : 0));
+    int exp = fexp - 127 + 15;
+    if (exp >= 0x1f) return static_cast<uint16_t>(sign | 0x7c00); // overflow
+    if (exp <= 0) {
+      // subnormal half, or zero
+      if (exp < -10) return static_cast<uint16_t>(sign);
+      mant |= 0x00800000;
+      unsigned int shift = 14 - exp;
+      uint32_t h       = mant >> shift;
+      uint32_t rem     = mant & ((1u << shift) - 1);
+      uint32_t halfway = 1u << (shift - 1);
+      if (rem > halfway || (rem == halfway && (h & 1))) ++h;
+      return static_cast<uint16_t>(sign | h);
+    }
+    uint32_t h   = sign | (exp << 10) | (mant >> 13);
+    uint32_t rem = mant & 0x1fff;
+    // a carry into the exponent gives the correct rounded value
+    if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) ++h;
+    return static_cast<uint16_t>(h);
+#endif
+  }
+  
+  inline float halfToFloat(uint16_t h) {
+#ifdef __F16C__
+    return _cvtsh_ss(h);
+#else
+    uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+    int      exp  = (h >> 10) & 0x1f;
+    uint32_t mant = h & 0x3ff;
+    uint32_t x;
+    if (exp == 0) {
+      if (mant == 0) x = sign;
+      else {
+	// subnormal half is a normal float
+	exp = 1;
+	while (!(mant & 0x400)) { mant <<= 1; --exp; }
+	mant &= 0x3ff;
+	x = sign | (static_cast<uint32_t>(exp + 112) << 23) | (mant << 13);
+      }
+    }
+    else if (exp == 0x1f) x = sign | 0x7f800000 | (mant << 13);
+    else x = sign | (static_cast<uint32_t>(exp + 112) << 23) | (mant << 13);
+    float f;
+    memcpy(&f, &x, sizeof(float));
+    return f;
+#endif
+  }
+  
+  inline uint16_t floatToBFloat16(float f) {
+    uint32_t x;
+    memcpy(&x, &f, sizeof(float));
+    if ((x & 0x7fffffff) > 0x7f800000) // NaN, keep it quiet
+      return static_cast<uint16_t>((x >> 16) | 0x40);
+    x += 0x7fff + ((x >> 16) & 1);
+    return static_cast<uint16_t>(x >> 16);
+  }
+  
+  inline float bfloat16ToFloat(uint16_t h) {
+    uint32_t x = static_cast<uint32_t>(h) << 16;
+    float f;
+    memcpy(&f, &x, sizeof(float));
+    return f;
+  }
+  
+  /// Converts sz floats from src into 16 bits values at dest
+  void packHalfFloat(HalfFloatFormat format,
+		     const float *src, unsigned int src_inc,
+		     uint16_t *dest, unsigned int sz);
+  
+  /// Converts sz 16 bits values from src into floats at dest
+  void unpackHalfFloat(HalfFloatFormat format,
+		       const uint16_t *src, unsigned int src_inc,
+		       float *dest, unsigned int sz);
+}
+
+#endif // HALF_FLOAT_H
@@ -0,0 +1,340 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Francisco Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include <cerrno>
+#include <cstdarg>
+#include <cstring>
+#include "io_stream.h"
+#include "parallel_for.h"
+
+void OutputStream::printf(const char *format, ...) {
+  char local[256];
+  va_list ap;
+  va_start(ap, format);
+  int len = vsnprintf(local, sizeof(local), format, ap);
+  va_end(ap);
+  if (len < 0) return;
+  if (static_cast<size_t>(len) < sizeof(local)) {
+    write(local, len);
+    return;
+  }
+  char *buf = new char[len+1];
+  va_start(ap, format);
+  vsnprintf(buf, len+1, format, ap);
+  va_end(ap);
+  write(buf, len);
+  delete[] buf;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+FileInputStream::FileInputStream(const char *path) {
+  f = fopen(path, "r");
+}
+
+FileInputStream::~FileInputStream() {
+  if (f != 0) fclose(f);
+}
+
+size_t FileInputStream::read(char *dest, size_t n) {
+  if (f == 0) return 0;
+  return fread(dest, sizeof(char), n, f);
+}
+
+const char *FileInputStream::getError() const {
+  return (f != 0 && ferror(f)) ? "read error" : 0;
+}
+
+FileOutputStream::FileOutputStream(const char *path) : ok(true) {
+  f = fopen(path, "w");
+}
+
+FileOutputStream::~FileOutputStream() {
+  close();
+}
+
+void FileOutputStream::write(const char *data, size_t n) {
+  if (f != 0 && fwrite(data, sizeof(char), n, f) != n) ok = false;
+}
+
+bool FileOutputStream::close() {
+  if (f != 0) {
+    if (fclose(f) != 0) ok = false;
+    f = 0;
+  }
+  return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+GZInputStream::GZInputStream(const char *path, size_t block_size,
+			     int num_blocks) :
+  error(0), block_size(block_size), num_blocks(num_blocks),
+  head(0), count(0), pos(0), finished(false), stop(false),
+  thread_running(false) {
+  gz = gzopen(path, "rb");
+  this->path = new char[strlen(path)+1];
+  strcpy(this->path, path);
+  blocks    = new char*[num_blocks];
+  block_len = new size_t[num_blocks];
+  for (int i=0; i<num_blocks; ++i) {
+    blocks[i]    = new char[block_size];
+    block_len[i] = 0;
+  }
+  pthread_mutex_init(&mutex, 0);
+  pthread_cond_init(&filled_cond, 0);
+  pthread_cond_init(&free_cond, 0);
+  if (gz == 0) finished = true;
+  else {
+    gzbuffer(gz, 1<<17);
+    thread_running = (pthread_create(&thread, 0, decompressThread, this) == 0);
+    // without thread, blocks are decompressed by read
+    if (!thread_running) finished = true;
+  }
+}
+
+GZInputStream::~GZInputStream() {
+  if (thread_running) {
+    pthread_mutex_lock(&mutex);
+    stop = true;
+    pthread_cond_signal(&free_cond);
+    pthread_mutex_unlock(&mutex);
+    pthread_join(thread, 0);
+  }
+  if (gz != 0) gzclose(gz);
+  delete[] path;
+  delete[] error;
+  for (int i=0; i<num_blocks; ++i) delete[] blocks[i];
+  delete[] blocks;
+  delete[] block_len;
+  pthread_mutex_destroy(&mutex);
+  pthread_cond_destroy(&filled_cond);
+  pthread_cond_destroy(&free_cond);
+}
+
+void *GZInputStream::decompressThread(void *ptr) {
+  reinterpret_cast<GZInputStream*>(ptr)->decompress();
+  return 0;
+}
+
+void GZInputStream::checkReadError(int n) {
+  if (error != 0) return;
+  int errnum;
+  const char *msg = gzerror(gz, &errnum);
+  if (n >= 0 && errnum == Z_OK) return;
+  if (errnum == Z_ERRNO) msg = strerror(errno);
+  else {
+    // zlib messages are "path: message"
+    size_t len = strlen(path);
+    if (strncmp(msg, path, len) == 0 && strncmp(msg + len, ": ", 2) == 0)
+      msg += len + 2;
+  }
+  error = new char[strlen(msg)+1];
+  strcpy(error, msg);
+}
+
+void GZInputStream::decompress() {
+  for (;;) {
+    pthread_mutex_lock(&mutex);
+    while (count == num_blocks && !stop)
+      pthread_cond_wait(&free_cond, &mutex);
+    if (stop) {
+      pthread_mutex_unlock(&mutex);
+      return;
+    }
+    // this slot is not used by read until count is increased
+    int slot = (head + count) % num_blocks;
+    pthread_mutex_unlock(&mutex);
+    int n = gzread(gz, blocks[slot], static_cast<unsigned int>(block_size));
+    pthread_mutex_lock(&mutex);
+    // the error is visible to read together with finished
+    checkReadError(n);
+    if (n > 0) {
+      block_len[slot] = static_cast<size_t>(n);
+      ++count;
+    }
+    else finished = true;
+    pthread_cond_signal(&filled_cond);
+    pthread_mutex_unlock(&mutex);
+    if (n <= 0) return;
+  }
+}
+
+size_t GZInputStream::read(char *dest, size_t n) {
+  size_t total = 0;
+  if (!thread_running) {
+    // synchronous decompression
+    while (gz != 0 && total < n) {
+      int r = gzread(gz, dest + total, static_cast<unsigned int>(n - total));
+      checkReadError(r);
+      if (r <= 0) break;
+      total += r;
+    }
+    return total;
+  }
+  while (total < n) {
+    pthread_mutex_lock(&mutex);
+    while (count == 0 && !finished)
+      pthread_cond_wait(&filled_cond, &mutex);
+    bool empty = (count == 0);
+    pthread_mutex_unlock(&mutex);
+    if (empty) break;
+    // the head block belongs to read while count > 0
+    size_t m = block_len[head] - pos;
+    if (m > n - total) m = n - total;
+    memcpy(dest + total, blocks[head] + pos, m);
+    pos   += m;
+    total += m;
+    if (pos == block_len[head]) {
+      pthread_mutex_lock(&mutex);
+      head = (head + 1) % num_blocks;
+      --count;
+      pos = 0;
+      pthread_cond_signal(&free_cond);
+      pthread_mutex_unlock(&mutex);
+    }
+  }
+  return total;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+struct GZBlockCompressor {
+  const char *data;
+  size_t used, block_size;
+  int level;
+  unsigned char **out;
+  size_t *out_len;
+  bool *ok;
+  void operator()(unsigned int i) {
+    size_t begin = i*block_size;
+    size_t len   = (used - begin < block_size) ? used - begin : block_size;
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    out[i] = 0;
+    ok[i]  = false;
+    // 15+16 window bits writes a gzip header and trailer
+    if (deflateInit2(&strm, level, Z_DEFLATED, 15+16, 8,
+		     Z_DEFAULT_STRATEGY) != Z_OK) return;
+    uLong bound = deflateBound(&strm, len);
+    out[i] = new unsigned char[bound];
+    strm.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(data + begin));
+    strm.avail_in  = static_cast<uInt>(len);
+    strm.next_out  = out[i];
+    strm.avail_out = static_cast<uInt>(bound);
+    ok[i]      = (deflate(&strm, Z_FINISH) == Z_STREAM_END);
+    out_len[i] = bound - strm.avail_out;
+    deflateEnd(&strm);
+  }
+};
+
+GZOutputStream::GZOutputStream(const char *path, int level,
+			       size_t block_size) :
+  ok(true), level(level), block_size(block_size), used(0),
+  any_member(false) {
+  f = fopen(path, "wb");
+  num_blocks = april_utils::getNumWorkerThreads();
+  buffer = (f != 0) ? new char[num_blocks*block_size] : 0;
+}
+
+GZOutputStream::~GZOutputStream() {
+  close();
+}
+
+void GZOutputStream::write(const char *data, size_t n) {
+  if (f == 0) return;
+  size_t capacity = num_blocks*block_size;
+  while (n > 0) {
+    size_t m = capacity - used;
+    if (m > n) m = n;
+    memcpy(buffer + used, data, m);
+    used += m;
+    data += m;
+    n    -= m;
+    if (used == capacity) flushBlocks();
+  }
+}
+
+void GZOutputStream::flushBlocks() {
+  // an empty file is written as one empty member
+  unsigned int n = static_cast<unsigned int>((used + block_size - 1) /
+					     block_size);
+  if (n == 0) n = 1;
+  GZBlockCompressor compressor;
+  compressor.data       = buffer;
+  compressor.used       = used;
+  compressor.block_size = block_size;
+  compressor.level      = level;
+  compressor.out        = new unsigned char*[n];
+  compressor.out_len    = new size_t[n];
+  compressor.ok         = new bool[n];
+  april_utils::parallelFor(n, compressor);
+  for (unsigned int i=0; i<n; ++i) {
+    if (!compressor.ok[i] ||
+	fwrite(compressor.out[i], 1, compressor.out_len[i], f) !=
+	compressor.out_len[i]) ok = false;
+    delete[] compressor.out[i];
+  }
+  delete[] compressor.out;
+  delete[] compressor.out_len;
+  delete[] compressor.ok;
+  used       = 0;
+  any_member = true;
+}
+
+bool GZOutputStream::close() {
+  if (f != 0) {
+    if (used > 0 || !any_member) flushBlocks();
+    if (fclose(f) != 0) ok = false;
+    f = 0;
+    delete[] buffer;
+    buffer = 0;
+  }
+  return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool isGZPath(const char *path) {
+  size_t len = strlen(path);
+  return len > 3 && strcmp(path + len - 3, ".gz") == 0;
+}
+
+InputStream *openInputStream(const char *path, bool gzip) {
+  InputStream *stream;
+  if (gzip || isGZPath(path)) stream = new GZInputStream(path);
+  else stream = new FileInputStream(path);
+  if (!stream->isOpen()) {
+    delete stream;
+    return 0;
+  }
+  return stream;
+}
+
+OutputStream *openOutputStream(const char *path) {
+  OutputStream *stream;
+  if (isGZPath(path)) stream = new GZOutputStream(path);
+  else stream = new FileOutputStream(path);
+  if (!stream->isOpen()) {
+    delete stream;
+    return 0;
+  }
+  return stream;
+}
@@ -0,0 +1,156 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Francisco Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef IO_STREAM_H
+#define IO_STREAM_H
+
+#include <cstddef>
+#include <cstdio>
+#include <pthread.h>
+#include <zlib.h>
+
+/// Source of bytes for the parsers (ReadFileStream)
+class InputStream {
+ public:
+  virtual ~InputStream() { }
+  /// False when the file could not be opened
+  virtual bool isOpen() const = 0;
+  /// Reads up to n bytes into dest, returns the number of bytes read, which
+  /// is 0 at the end of the stream or after an error
+  virtual size_t read(char *dest, size_t n) = 0;
+  /// Message of the error which stopped the stream, or 0 if it reached the
+  /// end of the data. It is valid after read returns 0.
+  virtual const char *getError() const = 0;
+};
+
+/// Destination of bytes for the writers of matrices and models
+class OutputStream {
+ public:
+  virtual ~OutputStream() { }
+  virtual bool isOpen() const = 0;
+  virtual void write(const char *data, size_t n) = 0;
+  /// Writes the remaining data and closes the stream, returns false if
+  /// some write failed. It is called by the destructor if needed.
+  virtual bool close() = 0;
+  /// printf like formatted write
+  void printf(const char *format, ...);
+};
+
+class FileInputStream : public InputStream {
+  FILE *f;
+ public:
+  FileInputStream(const char *path);
+  ~FileInputStream();
+  bool isOpen() const { return f != 0; }
+  size_t read(char *dest, size_t n);
+  const char *getError() const;
+};
+
+class FileOutputStream : public OutputStream {
+  FILE *f;
+  bool ok;
+ public:
+  FileOutputStream(const char *path);
+  ~FileOutputStream();
+  bool isOpen() const { return f != 0; }
+  void write(const char *data, size_t n);
+  bool close();
+};
+
+/// Reads a gzip file, decompressing it in a background thread which fills
+/// a ring of num_blocks blocks of block_size bytes, so decompression and
+/// parsing run at the same time. Files of several gzip members, as written
+/// by GZOutputStream, are read as one stream. Corrupt or truncated files
+/// stop the stream with the zlib error (see getError).
+class GZInputStream : public InputStream {
+ public:
+  GZInputStream(const char *path, size_t block_size = 1<<20,
+		int num_blocks = 4);
+  ~GZInputStream();
+  bool isOpen() const { return gz != 0; }
+  size_t read(char *dest, size_t n);
+  const char *getError() const { return error; }
+
+ private:
+  gzFile gz;
+  /// path of the file, and the gzerror message (without the path) when
+  /// gzread fails, or 0
+  char *path, *error;
+  size_t block_size;
+  int num_blocks;
+  char **blocks;
+  size_t *block_len;
+  /// first filled block (the one being read), number of filled blocks, and
+  /// read position inside the first block
+  int head, count;
+  size_t pos;
+  /// the background thread reached the end of the file, or it must stop
+  bool finished, stop;
+  pthread_t thread;
+  bool thread_running;
+  pthread_mutex_t mutex;
+  pthread_cond_t  filled_cond, free_cond;
+
+  static void *decompressThread(void *ptr);
+  void decompress();
+  /// Keeps the gzerror message if the last gzread, which returned n, failed.
+  /// zlib reports truncated files with a positive n, and the message is only
+  /// valid until the next call, so it is checked after every gzread.
+  void checkReadError(int n);
+};
+
+/// Writes a gzip file. The data is cut in blocks of block_size bytes, the
+/// blocks are compressed in parallel (see parallelFor) as independent gzip
+/// members, and written in order. The result is a valid gzip file for gzip,
+/// zlib and GZInputStream.
+class GZOutputStream : public OutputStream {
+ public:
+  GZOutputStream(const char *path, int level = Z_DEFAULT_COMPRESSION,
+		 size_t block_size = 1<<20);
+  ~GZOutputStream();
+  bool isOpen() const { return f != 0; }
+  void write(const char *data, size_t n);
+  bool close();
+
+ private:
+  FILE *f;
+  bool ok;
+  int level;
+  size_t block_size;
+  /// uncompressed data of num_blocks blocks, and used bytes
+  char *buffer;
+  unsigned int num_blocks;
+  size_t used;
+  bool any_member;
+
+  void flushBlocks();
+};
+
+/// True when path finishes with ".gz"
+bool isGZPath(const char *path);
+/// New stream of the file, decompressed when it is a .gz path or gzip is
+/// true (gzread reads plain files as they are). Returns 0 if the file could
+/// not be opened.
+InputStream *openInputStream(const char *path, bool gzip=false);
+/// New stream to the file, compressed when it is a .gz path. Returns 0 if
+/// the file could not be opened.
+OutputStream *openOutputStream(const char *path);
+
+#endif // IO_STREAM_H
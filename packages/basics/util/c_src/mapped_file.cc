@@ -0,0 +1,67 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Francisco Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mapped_file.h"
+
+MappedFile::MappedFile(const char *path) :
+  data(0), size(0), is_mapped(false) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return;
+  }
+  size = static_cast<size_t>(st.st_size);
+  long page_size = sysconf(_SC_PAGESIZE);
+  // the rest of the last page is filled with zeros by mmap
+  if (size > 0 && page_size > 0 && size % page_size != 0) {
+    void *ptr = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (ptr != MAP_FAILED) {
+      data      = static_cast<char*>(ptr);
+      is_mapped = true;
+      madvise(ptr, size, MADV_WILLNEED);
+    }
+  }
+  if (!is_mapped) {
+    char *buffer = new char[size+1];
+    size_t pos = 0;
+    while (pos < size) {
+      ssize_t n = pread(fd, buffer + pos, size - pos, pos);
+      if (n <= 0) break;
+      pos += n;
+    }
+    if (pos == size) {
+      buffer[size] = '\0';
+      data = buffer;
+    }
+    else delete[] buffer;
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (is_mapped) munmap(data, size);
+  else delete[] data;
+}
@@ -0,0 +1,45 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Francisco Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+/// Read-only view of a whole file in memory. The file is mapped with mmap
+/// when the data could be followed by a '\0' inside its last page,
+/// otherwise it is read into a new buffer. In both cases getData()[getSize()]
+/// is '\0', so the data could be parsed as a C string (constString).
+class MappedFile {
+ public:
+  MappedFile(const char *path);
+  ~MappedFile();
+  /// False when the file could not be opened or read
+  bool isOpen() const { return data != 0; }
+  const char *getData() const { return data; }
+  size_t getSize() const { return size; }
+
+ private:
+  char *data;
+  size_t size;
+  bool is_mapped;
+};
+
+#endif // MAPPED_FILE_H
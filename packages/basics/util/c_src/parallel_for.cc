@@ -0,0 +1,118 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include <cstdlib>
+#include <unistd.h>
+#include "parallel_for.h"
+
+namespace april_utils {
+
+  // 0 means not initialized
+  static unsigned int num_worker_threads = 0;
+
+  unsigned int getNumWorkerThreads() {
+    if (num_worker_threads == 0) {
+      const char *env = getenv("APRIL_NUM_THREADS");
+      long n = (env != 0) ? atol(env) : sysconf(_SC_NPROCESSORS_ONLN);
+      num_worker_threads = (n > 0) ? static_cast<unsigned int>(n) : 1;
+    }
+    return num_worker_threads;
+  }
+
+  void setNumWorkerThreads(unsigned int n) {
+    num_worker_threads = (n > 0) ? n : 1;
+  }
+
+  WorkerThreads::WorkerThreads(unsigned int num_threads) :
+    num_threads((num_threads > 0) ? num_threads : 1),
+    generation(0), pending(0), stop(false), task(0), task_arg(0) {
+    pthread_mutex_init(&mutex, 0);
+    pthread_cond_init(&start_cond, 0);
+    pthread_cond_init(&done_cond, 0);
+    ids     = new pthread_t[this->num_threads];
+    created = new bool[this->num_threads];
+    args    = new WorkerArg[this->num_threads];
+    created[0] = false;
+    for (unsigned int t=1; t<this->num_threads; ++t) {
+      args[t].pool = this;
+      args[t].id   = t;
+      // if the thread couldn't be created, its work is done by the caller
+      created[t] = (pthread_create(&ids[t], 0, workerMain, &args[t]) == 0);
+    }
+  }
+
+  WorkerThreads::~WorkerThreads() {
+    pthread_mutex_lock(&mutex);
+    stop = true;
+    pthread_cond_broadcast(&start_cond);
+    pthread_mutex_unlock(&mutex);
+    for (unsigned int t=1; t<num_threads; ++t)
+      if (created[t]) pthread_join(ids[t], 0);
+    pthread_cond_destroy(&done_cond);
+    pthread_cond_destroy(&start_cond);
+    pthread_mutex_destroy(&mutex);
+    delete[] ids;
+    delete[] created;
+    delete[] args;
+  }
+
+  void *WorkerThreads::workerMain(void *ptr) {
+    WorkerArg     *arg  = reinterpret_cast<WorkerArg*>(ptr);
+    WorkerThreads *pool = arg->pool;
+    unsigned int   last_generation = 0;
+    while(true) {
+      pthread_mutex_lock(&pool->mutex);
+      while(pool->generation == last_generation && !pool->stop)
+	pthread_cond_wait(&pool->start_cond, &pool->mutex);
+      if (pool->stop) {
+	pthread_mutex_unlock(&pool->mutex);
+	break;
+      }
+      last_generation = pool->generation;
+      TaskFunc f = pool->task;
+      void *f_arg = pool->task_arg;
+      pthread_mutex_unlock(&pool->mutex);
+      f(f_arg, arg->id);
+      pthread_mutex_lock(&pool->mutex);
+      if (--pool->pending == 0) pthread_cond_signal(&pool->done_cond);
+      pthread_mutex_unlock(&pool->mutex);
+    }
+    return 0;
+  }
+
+  void WorkerThreads::runTask(TaskFunc f, void *arg) {
+    unsigned int num_created = 0;
+    for (unsigned int t=1; t<num_threads; ++t) if (created[t]) ++num_created;
+    pthread_mutex_lock(&mutex);
+    task     = f;
+    task_arg = arg;
+    pending  = num_created;
+    ++generation;
+    pthread_cond_broadcast(&start_cond);
+    pthread_mutex_unlock(&mutex);
+    f(arg, 0);
+    for (unsigned int t=1; t<num_threads; ++t) if (!created[t]) f(arg, t);
+    pthread_mutex_lock(&mutex);
+    while(pending > 0) pthread_cond_wait(&done_cond, &mutex);
+    pthread_mutex_unlock(&mutex);
+  }
+
+}
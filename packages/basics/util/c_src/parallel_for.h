@@ -0,0 +1,123 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <pthread.h>
+
+namespace april_utils {
+
+  /// Number of threads used by parallelFor. By default it is the number of
+  /// online processors, it could be changed with APRIL_NUM_THREADS
+  /// environment variable or with setNumWorkerThreads.
+  unsigned int getNumWorkerThreads();
+  void setNumWorkerThreads(unsigned int n);
+
+  template<typename Func>
+  struct ParallelForTask {
+    Func *func;
+    unsigned int begin, end;
+    static void *run(void *ptr) {
+      ParallelForTask *task = reinterpret_cast<ParallelForTask*>(ptr);
+      for (unsigned int i=task->begin; i<task->end; ++i) (*task->func)(i);
+      return 0;
+    }
+  };
+
+  /// Executes func(i) for every i in [0,n). The indices are distributed in
+  /// contiguous blocks among worker threads, the calling thread executes the
+  /// first block. Func must be safe to be called concurrently with different
+  /// indices.
+  template<typename Func>
+  void parallelFor(unsigned int n, Func &func) {
+    unsigned int num_threads = getNumWorkerThreads();
+    if (num_threads > n) num_threads = n;
+    if (num_threads <= 1) {
+      for (unsigned int i=0; i<n; ++i) func(i);
+      return;
+    }
+    ParallelForTask<Func> *tasks  = new ParallelForTask<Func>[num_threads];
+    pthread_t             *ids    = new pthread_t[num_threads];
+    bool                  *joined = new bool[num_threads];
+    for (unsigned int t=0; t<num_threads; ++t) {
+      tasks[t].func  = &func;
+      tasks[t].begin = static_cast<unsigned int>((static_cast<unsigned long>(n)*t)/num_threads);
+      tasks[t].end   = static_cast<unsigned int>((static_cast<unsigned long>(n)*(t+1))/num_threads);
+      joined[t] = false;
+    }
+    for (unsigned int t=1; t<num_threads; ++t) {
+      joined[t] = (pthread_create(&ids[t], 0, ParallelForTask<Func>::run,
+				  &tasks[t]) == 0);
+      // if the thread couldn't be created, its block is executed here
+      if (!joined[t]) ParallelForTask<Func>::run(&tasks[t]);
+    }
+    ParallelForTask<Func>::run(&tasks[0]);
+    for (unsigned int t=1; t<num_threads; ++t)
+      if (joined[t]) pthread_join(ids[t], 0);
+    delete[] tasks;
+    delete[] ids;
+    delete[] joined;
+  }
+
+  /// A fixed number of threads which are kept alive between several
+  /// executions of run(func), avoiding to spawn new threads every time. The
+  /// number of threads is the given one, getNumWorkerThreads() doesn't limit
+  /// it. The calling thread is the worker 0.
+  class WorkerThreads {
+    typedef void (*TaskFunc)(void *, unsigned int);
+    struct WorkerArg {
+      WorkerThreads *pool;
+      unsigned int   id;
+    };
+    unsigned int    num_threads;
+    pthread_t      *ids;
+    bool           *created;
+    WorkerArg      *args;
+    pthread_mutex_t mutex;
+    pthread_cond_t  start_cond, done_cond;
+    unsigned int    generation, pending;
+    bool            stop;
+    TaskFunc        task;
+    void           *task_arg;
+    
+    template<typename Func>
+    static void call(void *func, unsigned int id) {
+      (*reinterpret_cast<Func*>(func))(id);
+    }
+    static void *workerMain(void *ptr);
+    void runTask(TaskFunc f, void *arg);
+  public:
+    explicit WorkerThreads(unsigned int num_threads);
+    ~WorkerThreads();
+    unsigned int size() const { return num_threads; }
+    /// Executes func(w) for every worker w in [0,size()) and waits until all
+    /// of them finish. Func must be safe to be called concurrently with
+    /// different workers.
+    template<typename Func>
+    void run(Func &func) {
+      runTask(&WorkerThreads::call<Func>, &func);
+    }
+  };
+
+}
+
+#endif // PARALLEL_FOR_H
@@ -27,8 +27,11 @@ bool ReadFileStream::moveAndFillBuffer() {
   // printf ("------------- MOVE ------------ %d %d\n", buffer_pos, buffer_len);
   int diff = buffer_len - buffer_pos;
   for (int i=0; i<diff; ++i) buffer[i] = buffer[buffer_pos + i];
-  if (!feof(f))
-    buffer_len = fread(buffer + diff, sizeof(char), buffer_pos, f) + diff;
+  if (!at_eof) {
+    int n = static_cast<int>(f->read(buffer + diff, buffer_pos));
+    at_eof = (n < buffer_pos);
+    buffer_len = n + diff;
+  }
   else buffer_len = 0;
   buffer_pos = 0;
   return buffer_len != 0;
@@ -36,12 +39,15 @@ bool ReadFileStream::moveAndFillBuffer() {
   
 bool ReadFileStream::resizeAndFillBuffer() {
   // printf ("------------- RESIZE ------------\n");
-  if (feof(f)) return false;
+  if (at_eof) return false;
   unsigned int old_max_len = max_buffer_len;
   max_buffer_len *= 2;
   char *new_buffer = new char[max_buffer_len + 1];
   memcpy(new_buffer, buffer, old_max_len);
-  buffer_len += fread(new_buffer + buffer_len, sizeof(char), max_buffer_len - buffer_len, f);
+  int n = static_cast<int>(f->read(new_buffer + buffer_len,
+				  max_buffer_len - buffer_len));
+  at_eof = (n < max_buffer_len - buffer_len);
+  buffer_len += n;
   delete[] buffer;
   buffer = new_buffer;
   return true;
@@ -56,7 +62,8 @@ bool ReadFileStream::trim(const char *delim) {
 }
 
 ReadFileStream::ReadFileStream(const char *path) {
-  f		   = fopen(path, "r");
+  f		   = openInputStream(path);
+  at_eof	   = (f == 0);
   buffer	   = new char[DEFAULT_BUFFER_LEN+1];
   max_buffer_len = DEFAULT_BUFFER_LEN;
   buffer_len	   = max_buffer_len;
@@ -65,11 +72,11 @@ ReadFileStream::ReadFileStream(const char *path) {
 
 ReadFileStream::~ReadFileStream() {
   delete[] buffer;
-  fclose(f);
+  delete f;
 }
 
 constString ReadFileStream::getToken(const char *delim) {
-  if (buffer_len == 0) return constString();
+  if (f == 0 || buffer_len == 0) return constString();
   // comprobamos que haya datos en el buffer
   if (buffer_pos >= buffer_len && !moveAndFillBuffer()) return constString();
   // hacemos un trim de los delimitadores
@@ -22,12 +22,16 @@
 #define READ_FILE_STREAM_H
 
 #include "constString.h"
+#include "io_stream.h"
 
-#define DEFAULT_BUFFER_LEN 4096
+#define DEFAULT_BUFFER_LEN 65536
+/// Tokens and lines of a file, .gz files are decompressed on the fly (see
+/// openInputStream)
 class ReadFileStream {
   char *buffer;
   int max_buffer_len, buffer_pos, buffer_len;
-  FILE *f;
+  InputStream *f;
+  bool at_eof;
   
   bool moveAndFillBuffer();
   bool resizeAndFillBuffer();
@@ -36,6 +40,9 @@ class ReadFileStream {
 public:
   ReadFileStream(const char *path);
   ~ReadFileStream();
+  bool isOpen() const { return f != 0; }
+  /// Error which stopped the reading of the file, or 0 (see InputStream)
+  const char *getError() const { return (f != 0) ? f->getError() : 0; }
   constString getToken(const char *delim);
   
   // para ser compatible con el interfaz de constString
@@ -37,6 +37,8 @@ class Referenced {
   virtual ~Referenced();
   virtual void incRef();
   virtual bool decRef();
+  /// Number of references to this object
+  int getRef() const { return refs; }
 };
 
 #endif // REFERENCED_H
@@ -1,6 +1,7 @@
 package{ name = "util",
    version = "1.0",
    depends = { },
+   link_libraries = { "z" },
    keywords = { },
    description = "",
    -- targets como en ant
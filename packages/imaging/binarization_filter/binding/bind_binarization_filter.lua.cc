@@ -59,6 +59,21 @@
 }
 //BIND_END
 
+//BIND_METHOD ImageFloat binarize_sauvola
+{
+  int radius;
+  float k, R;
+  LUABIND_CHECK_ARGN(>=, 1);
+  LUABIND_CHECK_ARGN(<=, 3);
+  LUABIND_GET_PARAMETER(1, int, radius);
+  LUABIND_GET_OPTIONAL_PARAMETER(2, float, k, 0.5);
+  LUABIND_GET_OPTIONAL_PARAMETER(3, float, R, 0.5);
+  if (radius < 1)
+    LUABIND_ERROR("sauvola filter, radius must be > 0");
+  LUABIND_RETURN(ImageFloat, binarize_sauvola(obj, radius, k, R));
+}
+//BIND_END
+
 //BIND_METHOD ImageFloat binarize_otsus
 {
   LUABIND_CHECK_ARGN(==, 0);
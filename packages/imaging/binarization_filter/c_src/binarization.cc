@@ -21,185 +21,117 @@
 #include <cmath>
 #include "binarization.h"
 
-ImageFloat *binarize_niblack(const ImageFloat *src, int windowRadius, float k, float minThreshold, float maxThreshold)
-{
+/// Local thresholding filters compute, by bands of rows, the mean and the
+/// standard deviation of the window of each pixel with an IntegralImageFloat,
+/// and pass them to a Rule which gives the binarized pixel
+template<typename Rule>
+struct LocalThresholdBands {
+  const IntegralImageFloat *integral;
+  const float *source; int source_stride;
+  float *dest; int dest_stride;
+  int width, radius;
+  IntegralImageFloat::BorderMode mode;
+  double border_value;
+  Rule rule;
+
+  void operator()(int y0, int y1) {
+    float *mean     = new float[width];
+    float *variance = new float[width];
+    for (int y=y0; y<y1; ++y) {
+      integral->localMeanVariance(y, radius, mean, variance,
+				  mode, border_value);
+      const float *s = source + y*source_stride;
+      float *d       = dest + y*dest_stride;
+      for (int x=0; x<width; ++x)
+	d[x] = rule(s[x], mean[x], sqrtf(variance[x]));
+    }
+    delete[] mean;
+    delete[] variance;
+  }
+};
+
+template<typename Rule>
+static ImageFloat *binarize_local_threshold(const ImageFloat *src,
+					    int windowRadius,
+					    IntegralImageFloat::BorderMode mode,
+					    double border_value,
+					    const Rule &rule) {
   assert(src->width  > 0 && "Zero-sized image!");
   assert(src->height > 0 && "Zero-sized image!");
-
-  ImageFloat *result       = new ImageFloat(src->width, src->height);
-  ImageFloat *sum          = new ImageFloat(src->width, src->height);
-  ImageFloat *sumOfSquares = new ImageFloat(src->width, src->height);
-
-  // each pixel in the "sum" image contains the sum of the pixels to the left
-  // and above it, same for sumOfSquares
-
-  // init to the upper-left corner pixel
-  (*sum)(0,0) = (*src)(0,0);
-  (*sumOfSquares)(0,0) = (*src)(0,0) * (*src)(0,0);
-
-  // First row
-  for (int x=1; x < src->width; x++) {
-    float current_pixel = (*src)(x,0);
-    (*sum)(x,0) = (*sum)(x-1, 0) + current_pixel;
-    (*sumOfSquares)(x,0) = (*sumOfSquares)(x-1, 0) + current_pixel * current_pixel;
-  }
-
-  // Rest of rows
-  for (int y=1; y < src->height; y++)
-    for (int x=0; x < src->width; x++) {
-      float s  = (*sum)(x,y-1);
-      float s2 = (*sumOfSquares)(x,y-1);
-      if (x>0) {
-        s  += (*sum)(x-1,y) - (*sum)(x-1,y-1);
-        s2 += (*sumOfSquares)(x-1, y) - (*sumOfSquares)(x-1,y-1);
-      }
-      
-      float current_pixel = (*src)(x,y);
-      (*sum)(x,y) = s + current_pixel;
-      (*sumOfSquares)(x,y) = s + current_pixel * current_pixel;
-    }
- 
-
-  // Apply Niblack filter using sum and sumOfSquares for fast mean/std.dev. computation
-  int windowSize = 2*windowRadius+1;
-  int totalWindowPixels = windowSize*windowSize;
-  for (int y=0; y < src->height; y++)
-    for (int x=0; x < src->width; x++) {
-      float val = (*src)(x,y);
-      if (val < minThreshold) {
-        (*result)(x,y) = 0;
-      }
-      else if (val > maxThreshold) {
-        (*result)(x,y) = 1;
-      }
-      else {
-        int windowUpper, windowLower, windowLeft, windowRight;
-        
-        windowUpper = (y-windowRadius < 0 ? 0 : y-windowRadius);
-        windowLeft  = (x-windowRadius < 0 ? 0 : x-windowRadius);
-        windowLower = (y+windowRadius > src->height - 1 ? src->height-1 : y+windowRadius);
-        windowRight = (x+windowRadius > src->width  - 1 ? src->width -1 : x+windowRadius);
-
-        // assume pixels outside the image are white (value = 1)
-        int windowPixels = (windowRight-windowLeft+1) * (windowLower-windowUpper+1);
-        float s = totalWindowPixels - windowPixels;
-        float s2 = s; // 1 squared is 1, too
-
-        s  += (*sum)(windowRight, windowLower);
-        s2 += (*sumOfSquares)(windowRight, windowLower);
-
-        if (windowLeft > 0) {
-          s  -= (*sum)(windowLeft-1, windowLower);
-          s2 -= (*sumOfSquares)(windowLeft-1, windowLower);
-        }
-
-        if (windowUpper > 0) {
-          s  -= (*sum)(windowRight, windowUpper-1);
-          s2 -= (*sumOfSquares)(windowRight, windowUpper-1);
-        }
-        
-        if (windowLeft > 0 && windowUpper > 0) {
-          s  += (*sum)(windowLeft-1, windowUpper-1);
-          s2 += (*sumOfSquares)(windowLeft-1, windowUpper-1);
-        }
-
-        float mean = s/totalWindowPixels;
-        float std_dev = sqrt(s2/totalWindowPixels - mean*mean);
-        float threshold = mean + k*std_dev;
-
-        (*result)(x,y) = val < threshold ? 0 : 1;
-      }
-    }
-  
+  ImageFloat *result = new ImageFloat(src->width, src->height);
+  IntegralImageFloat *integral = new IntegralImageFloat(src);
+  IncRef(integral);
+  LocalThresholdBands<Rule> bands;
+  bands.integral      = integral;
+  bands.source        = src->row_ptr(0);
+  bands.source_stride = src->row_stride();
+  bands.dest          = result->row_ptr(0);
+  bands.dest_stride   = result->row_stride();
+  bands.width         = src->width;
+  bands.radius        = windowRadius;
+  bands.mode          = mode;
+  bands.border_value  = border_value;
+  bands.rule          = rule;
+  imageForEachRowBand(src->width, src->height, bands);
+  DecRef(integral);
   return result;
 }
 
+struct NiblackRule {
+  float k, minThreshold, maxThreshold;
+  float operator()(float val, float mean, float std_dev) const {
+    if (val < minThreshold) return 0.0f;
+    if (val > maxThreshold) return 1.0f;
+    return val < mean + k*std_dev ? 0.0f : 1.0f;
+  }
+};
 
+ImageFloat *binarize_niblack(const ImageFloat *src, int windowRadius, float k, float minThreshold, float maxThreshold)
+{
+  NiblackRule rule;
+  rule.k            = k;
+  rule.minThreshold = minThreshold;
+  rule.maxThreshold = maxThreshold;
+  // assume pixels outside the image are white (value = 1)
+  return binarize_local_threshold(src, windowRadius,
+				  IntegralImageFloat::CONSTANT_BORDER, 1.0,
+				  rule);
+}
 
+struct NiblackSimpleRule {
+  float k;
+  float operator()(float val, float mean, float std_dev) const {
+    //Apply the Threshold T=mean-0.2sd
+    return val < mean - k*std_dev ? 0.0f : 1.0f;
+  }
+};
 
 ImageFloat *binarize_niblack_simple(const ImageFloat *src, int windowRadius, float k)
 {
-    assert(src->width  > 0 && "Zero-sized image!");
-    assert(src->height > 0 && "Zero-sized image!");
-    // Image Integral Matrix
-    ImageFloat *result = new ImageFloat(src->width, src->height);
-    double **M = new double*[src->width];
-    for(int i = 0; i < src->width; ++i)
-        M[i] = new double[src->height];
-    // Square Image Integral
-    double **M2 = new double*[src->width];
-    for(int i = 0; i < src->width; ++i)
-        M2[i] = new double[src->height];
-
-    int env=windowRadius;
-    for(int y = 0; y < src->height; y++)      
-        for (int x = 0; x < src->width; x++){
-            M[x][y]=(*src)(x,y);
-            M2[x][y]=(*src)(x,y)*(*src)(x,y);
-            if(x && y){
-                M[x][y]+=M[x-1][y]+M[x][y-1]-M[x-1][y-1];
-                M2[x][y]+=M2[x-1][y]+M2[x][y-1]-M2[x-1][y-1];
-            }
-            else if(x && !y){
-                M[x][y]+=M[x-1][y];
-                M2[x][y]+=M2[x-1][y];
-            }
-            else if(!x && y){
-                M[x][y]+=M[x][y-1];
-                M2[x][y]+=M2[x][y-1];
-            }
-
-        }
-
-    for(int y = 0; y < src->height; y++){
-        for (int x = 0; x < src->width; x++){
-            int limInf , limSup , limRight,limLeft = 0;
-            int area = 1;
-
-            // We take the limits of the enviroment
-            if(x-env < 0){
-                limLeft = 0;
-            }
-            else limLeft=x-env;
-
-            if(x+env >= src->width){
-                limRight = src->width-1;
-            }
-            else limRight=x+env;
-
-            if(y-env < 0){
-                limSup = 0;
-            }
-            else limSup=y-env;
-
-            if(y+env >= src->height){
-                limInf = src->height-1;
-            }
-            else limInf=y+env;       
-
-            area = (limInf-limSup+1)*(limRight-limLeft+1);
-
-            //Calculate the mean
-            double mean = double(M[limLeft][limSup]+ M[limRight][limInf] - M[limLeft][limInf] -M[limRight][limSup])/area;
-            double mean2 = double(M2[limLeft][limSup]+ M2[limRight][limInf] - M2[limLeft][limInf] -M2[limRight][limSup])/area;
-            //Compute the Standar Deviacion square(Mean^2-mean2)
-            double sd = sqrt(mean2-mean*mean);
-
-            //Apply the Threshold T=mean-0.2sd
-            float T = mean - k*sd;
-            (*result)(x,y) = (*src)(x,y) < T ? 0 : 1;
-        }
-    }
-
-    for(int i = 0; i < src->width;++i){
-        delete []M[i];
-        delete []M2[i];
+  NiblackSimpleRule rule;
+  rule.k = k;
+  // windows are clipped at the image borders
+  return binarize_local_threshold(src, windowRadius,
+				  IntegralImageFloat::CLIP_WINDOW, 0.0,
+				  rule);
+}
 
-    }
-    delete []M;
-    delete []M2;
+struct SauvolaRule {
+  float k, R;
+  float operator()(float val, float mean, float std_dev) const {
+    return val < mean*(1.0f + k*(std_dev/R - 1.0f)) ? 0.0f : 1.0f;
+  }
+};
 
-    return result;
+ImageFloat *binarize_sauvola(const ImageFloat *src, int windowRadius,
+			     float k, float R)
+{
+  SauvolaRule rule;
+  rule.k = k;
+  rule.R = R;
+  return binarize_local_threshold(src, windowRadius,
+				  IntegralImageFloat::CLIP_WINDOW, 0.0,
+				  rule);
 }
 
 
@@ -31,6 +31,11 @@ ImageFloat *binarize_niblack(const ImageFloat *src, int windowRadius, float k,
 ImageFloat *binarize_niblack_simple(const ImageFloat *src,
                                    int windowRadius, float k);
 
+//// Sauvola's binarization, T = mean*(1 + k*(std_dev/R - 1)), where R is the
+//// dynamic range of the standard deviation (0.5 for images in [0,1])
+ImageFloat *binarize_sauvola(const ImageFloat *src, int windowRadius,
+                             float k, float R);
+
 //// Otsu's Binarization
 ImageFloat *binarize_otsus(const ImageFloat *src);
 
@@ -0,0 +1,50 @@
+-- Checks the local thresholding filters (built on image.integral_image)
+-- against a naive computation of the window means and deviations
+local rnd = random(9876)
+local w,h = 45, 38
+local m = matrix(h, w)
+for y=1,h do for x=1,w do m:set(y,x, rnd:rand()) end end
+local img = Image(m)
+
+-- mean and standard deviation of the window, border_value for the pixels
+-- outside the image, or clipped window when it is nil
+local function window(x, y, radius, border_value)
+  local s, s2, n = 0, 0, 0
+  for j=y-radius,y+radius do
+    for i=x-radius,x+radius do
+      local v
+      if i >= 0 and j >= 0 and i < w and j < h then v = img:getpixel(i,j)
+      else v = border_value end
+      if v then s, s2, n = s + v, s2 + v*v, n + 1 end
+    end
+  end
+  local mean = s/n
+  return mean, math.sqrt(math.max(0, s2/n - mean*mean))
+end
+
+local function check(result, radius, border_value, threshold_func)
+  for y=0,h-1 do
+    for x=0,w-1 do
+      local v = img:getpixel(x,y)
+      local T = threshold_func(v, window(x, y, radius, border_value))
+      -- pixels too close to the threshold are not checked
+      if math.abs(v - T) > 1e-4 then
+	assert(result:getpixel(x,y) == (v < T and 0 or 1))
+      end
+    end
+  end
+end
+
+local radius, k = 4, 0.2
+check(img:binarize_niblack(radius, k, 0.1, 0.9), radius, 1.0,
+      function(v, mean, sd)
+	if v < 0.1 then return math.huge elseif v > 0.9 then return -math.huge end
+	return mean + k*sd
+      end)
+check(img:binarize_niblack_simple(radius, k), radius, nil,
+      function(v, mean, sd) return mean - k*sd end)
+check(img:binarize_sauvola(radius, 0.3, 0.5), radius, nil,
+      function(v, mean, sd) return mean*(1 + 0.3*(sd/0.5 - 1)) end)
+check(img:binarize_sauvola(radius), radius, nil,
+      function(v, mean, sd) return mean*(1 + 0.5*(sd/0.5 - 1)) end)
+print("OK")
@@ -20,6 +20,36 @@
  */
 //BIND_HEADER_C
 #include "bind_image_RGB.h"
+#include "luabindutil.h"
+
+static int getImageIntField(lua_State *L, int i, const char *name,
+			    int default_value) {
+  int value = default_value;
+  lua_getfield(L, i, name);
+  if (!lua_isnil(L, -1)) {
+    if (!lua_isint(L, -1))
+      luaL_error(L, "field %s must be an integer", name);
+    value = lua_toint(L, -1);
+  }
+  lua_pop(L, 1);
+  return value;
+}
+
+void getImageReadParams(lua_State *L, int i,
+			int &x, int &y, int &width, int &height,
+			int &downscale) {
+  x = y = width = height = 0;
+  downscale = 1;
+  if (lua_gettop(L) < i || lua_isnil(L, i)) return;
+  luaL_checktype(L, i, LUA_TTABLE);
+  check_table_fields(L, i, "layout", "x", "y", "width", "height",
+		     "downscale", 0);
+  x         = getImageIntField(L, i, "x", 0);
+  y         = getImageIntField(L, i, "y", 0);
+  width     = getImageIntField(L, i, "width", 0);
+  height    = getImageIntField(L, i, "height", 0);
+  downscale = getImageIntField(L, i, "downscale", 1);
+}
 //BIND_END
 
 //BIND_HEADER_H
@@ -28,6 +58,14 @@
 #include "bind_matrix.h"
 #include "bind_affine_transform.h"
 #include <cmath>
+
+// Reads the optional region of interest and downscale fields (x, y, width,
+// height, downscale) of the table at position i, which could be nil or
+// absent, for the read_matrix functions of the image readers (libpng,
+// libtiff). The layout field is allowed, the caller reads it.
+void getImageReadParams(lua_State *L, int i,
+			int &x, int &y, int &width, int &height,
+			int &downscale);
 //BIND_END
 
 //BIND_LUACLASSNAME ImageFloat Image
@@ -411,3 +449,100 @@
 //BIND_END
 
 
+//////////////////////////////////////////////////////////////////////
+
+//BIND_LUACLASSNAME IntegralImageFloat image.integral_image
+//BIND_CPP_CLASS    IntegralImageFloat
+
+//BIND_CONSTRUCTOR IntegralImageFloat
+//DOC_BEGIN
+// integral_image(img, with_squares=true)
+/// Integral image (summed-area table) of img, in double precision, and of its
+/// squared pixels when with_squares is true
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(>=, 1);
+  LUABIND_CHECK_ARGN(<=, 2);
+  ImageFloat *img;
+  bool with_squares;
+  LUABIND_GET_PARAMETER(1, ImageFloat, img);
+  LUABIND_GET_OPTIONAL_PARAMETER(2, bool, with_squares, true);
+  obj = new IntegralImageFloat(img, with_squares);
+  LUABIND_RETURN(IntegralImageFloat, obj);
+}
+//BIND_END
+
+//BIND_METHOD IntegralImageFloat sum
+//DOC_BEGIN
+// sum(x0, y0, x1, y1)
+/// Sum of the pixels in the rectangle [x0,x1]x[y0,y1] (0-based, included)
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 4);
+  int x0, y0, x1, y1;
+  LUABIND_GET_PARAMETER(1, int, x0);
+  LUABIND_GET_PARAMETER(2, int, y0);
+  LUABIND_GET_PARAMETER(3, int, x1);
+  LUABIND_GET_PARAMETER(4, int, y1);
+  if (x0 < 0 || y0 < 0 || x1 >= obj->getWidth() || y1 >= obj->getHeight() ||
+      x0 > x1 || y0 > y1)
+    LUABIND_ERROR("rectangle out of the image");
+  LUABIND_RETURN(double, obj->sum(x0, y0, x1, y1));
+}
+//BIND_END
+
+//BIND_METHOD IntegralImageFloat sum_of_squares
+//DOC_BEGIN
+// sum_of_squares(x0, y0, x1, y1)
+/// Sum of the squared pixels in the rectangle [x0,x1]x[y0,y1]
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 4);
+  int x0, y0, x1, y1;
+  LUABIND_GET_PARAMETER(1, int, x0);
+  LUABIND_GET_PARAMETER(2, int, y0);
+  LUABIND_GET_PARAMETER(3, int, x1);
+  LUABIND_GET_PARAMETER(4, int, y1);
+  if (!obj->hasSquares())
+    LUABIND_ERROR("the integral image has been computed without squares");
+  if (x0 < 0 || y0 < 0 || x1 >= obj->getWidth() || y1 >= obj->getHeight() ||
+      x0 > x1 || y0 > y1)
+    LUABIND_ERROR("rectangle out of the image");
+  LUABIND_RETURN(double, obj->sumOfSquares(x0, y0, x1, y1));
+}
+//BIND_END
+
+//BIND_METHOD IntegralImageFloat local_mean_variance
+//DOC_BEGIN
+// local_mean_variance(radius, border_value)
+/// Returns two height x width matrices with the mean and the variance of the
+/// (2*radius+1)x(2*radius+1) window centered at each pixel. Windows are
+/// clipped at the image borders, unless border_value is given, which is then
+/// the value of the pixels outside the image.
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(>=, 1);
+  LUABIND_CHECK_ARGN(<=, 2);
+  int radius;
+  LUABIND_GET_PARAMETER(1, int, radius);
+  if (radius < 0) LUABIND_ERROR("radius must be >= 0");
+  IntegralImageFloat::BorderMode mode = IntegralImageFloat::CLIP_WINDOW;
+  double border_value = 0.0;
+  if (lua_gettop(L) == 2 && !lua_isnil(L, 2)) {
+    LUABIND_GET_PARAMETER(2, double, border_value);
+    mode = IntegralImageFloat::CONSTANT_BORDER;
+  }
+  if (!obj->hasSquares())
+    LUABIND_ERROR("the integral image has been computed without squares");
+  int dims[2] = { obj->getHeight(), obj->getWidth() };
+  MatrixFloat *mean     = new MatrixFloat(2, dims);
+  MatrixFloat *variance = new MatrixFloat(2, dims);
+  float *mean_ptr     = mean->getRawDataAccess()->getPPALForWrite();
+  float *variance_ptr = variance->getRawDataAccess()->getPPALForWrite();
+  for (int y=0; y<dims[0]; ++y)
+    obj->localMeanVariance(y, radius, mean_ptr + y*dims[1],
+			   variance_ptr + y*dims[1], mode, border_value);
+  LUABIND_RETURN(MatrixFloat, mean);
+  LUABIND_RETURN(MatrixFloat, variance);
+}
+//BIND_END
@@ -32,6 +32,36 @@
 #include <cstdlib>
 #include "clamp.h"
 #include "maxmin.h"
+#include "parallel_for.h"
+
+/// Images with at least this number of pixels are processed by worker threads
+#define IMAGE_PARALLEL_THRESHOLD 65536
+/// Number of rows of each band, and side of the tiles used in rotations
+#define IMAGE_ROWS_PER_BAND 32
+
+template<typename Func>
+struct ImageRowBands {
+  Func *func;
+  int height;
+  void operator()(unsigned int band) {
+    int y0 = band*IMAGE_ROWS_PER_BAND;
+    (*func)(y0, april_utils::min(y0 + IMAGE_ROWS_PER_BAND, height));
+  }
+};
+
+/// Calls func(y0,y1) for bands of rows [y0,y1) which cover [0,height). Bands
+/// are distributed among worker threads for large images, so func must allow
+/// concurrent calls with different bands.
+template<typename Func>
+void imageForEachRowBand(int width, int height, Func &func) {
+  ImageRowBands<Func> bands;
+  bands.func   = &func;
+  bands.height = height;
+  unsigned int num_bands = (height + IMAGE_ROWS_PER_BAND - 1)/IMAGE_ROWS_PER_BAND;
+  if (width*height < IMAGE_PARALLEL_THRESHOLD)
+    for (unsigned int i=0; i<num_bands; ++i) bands(i);
+  else april_utils::parallelFor(num_bands, bands);
+}
 
 template <typename T>
 Image<T>::Image(Matrix<T> *mat) {
@@ -232,68 +262,20 @@ void Image<T>::projection_h(Matrix<T> **m) const {
    +-------+  |gle+-------+
 */
 template <typename T>
-Image<T>* Image<T>::shear_h(double angle, T default_value) const {
-  int dims[2];
-  //printf("angle = %frad = %fdeg\n",angle, angle*180/M_PI);
-  dims[0]=height;
-  if (angle > 0)
-    dims[1]=width+int(height*tan(angle))+1;
-  else
-    dims[1]=width+int(height*tan(-angle))+1;
-
-  //printf("dims = %dfilas x %dcolumnas\n", dims[0], dims[1]);
-	
-  Matrix<T> *mat = new Matrix<T>(2,dims);
-  Image<T>  *img = new Image<T>(mat);
-
-	
-  if (angle > 0)
-    {
-      // Angle > 0
-      const T *source_line = matrix->getRawDataAccess()->getPPALForRead() + offset;
-      T *dest_line = mat->getRawDataAccess()->getPPALForReadAndWrite();
-      for (int line=0; line<height; line++){
-	float x = line*tan(angle);
-	float izq = x-int(x);
-	float der = 1.0-izq;
-	//printf("x=%f izq=%f der=%f\n", x, izq, der);
-	int x_int = int(x);	
-	// x contiene la posicion del pixel i-esimo
-	// por tanto, debemos poner en blanco los pixels [0,x[
-	// copiar la fila original en [x, x+width] y seguir
-	// con blanco hasta el final
-
-	for (int i=0; i < x_int; i++)
-	  dest_line[i]=default_value;
-			
-	// El primer pixel lo tratamos de forma "especial"
-	// porque se obtiene a partir del primer pixel origen y el
-	// color por defecto
-
-	dest_line[x_int]=izq*default_value+der*source_line[0];
-
-	for (int i=1; i < width; i++)
-	  {
-	    dest_line[x_int+i]=izq*source_line[i-1]+der*source_line[i];
-	  }
-
-	dest_line[x_int+width]=izq*source_line[width-1]+der*default_value;
-
-			
-	for (int i=x_int+width+1; i<dims[1]; i++)
-	  dest_line[i]=default_value;
-			
-	source_line += matrix_width();
-	dest_line += dims[1];
-      }
-    } else {
-    // Angle < 0
-    // Empezamos por abajo
-    angle=-angle;
-    const T *source_line = matrix->getRawDataAccess()->getPPALForRead() + offset + matrix_width()*(height-1);
-    T *dest_line = mat->getRawDataAccess()->getPPALForReadAndWrite() + dims[1]*(height-1);
-    for (int line= 0 ; line < height; line++){
-      float x = line*tan(angle);
+struct ImageShearH {
+  const T *source; int source_stride;
+  T *dest; int dest_width;
+  int width, height;
+  double tan_angle;
+  T default_value;
+  bool bottom_up;
+  void operator()(int line0, int line1) {
+    for (int line=line0; line<line1; line++){
+      // with angle < 0 lines are sheared starting from the bottom
+      int row = (bottom_up) ? height-1-line : line;
+      const T *source_line = source + row*source_stride;
+      T *dest_line = dest + row*dest_width;
+      float x = line*tan_angle;
       float izq = x-int(x);
       float der = 1.0-izq;
       int x_int = int(x);	
@@ -301,28 +283,66 @@ Image<T>* Image<T>::shear_h(double angle, T default_value) const {
       // por tanto, debemos poner en blanco los pixels [0,x[
       // copiar la fila original en [x, x+width] y seguir
       // con blanco hasta el final
-
+      
       for (int i=0; i < x_int; i++)
 	dest_line[i]=default_value;
-			
+      
       // El primer pixel lo tratamos de forma "especial"
       // porque se obtiene a partir del primer pixel origen y el
       // color por defecto
-
+      
       dest_line[x_int]=izq*default_value+der*source_line[0];
-
+      
       for (int i=1; i < width; i++)
 	dest_line[x_int+i]=izq*source_line[i-1]+der*source_line[i];
-
+      
       dest_line[x_int+width]=izq*source_line[width-1]+der*default_value;
-			
-      for (int i=x_int+width+1; i<dims[1]; i++)
+      
+      for (int i=x_int+width+1; i<dest_width; i++)
 	dest_line[i]=default_value;
-			
-      source_line -= matrix_width();
-      dest_line -= dims[1];
     }
   }
+};
+
+/**
+
+   -  angle va en radianes
+   -  default_value es el color de los pixels nuevos que aparecen
+   en las esquinas
+  
+   +-------+  +-------+
+   |       |  |\       \
+   |  OLD  |  | \  NEW  \
+   |       |  |an\       \
+   +-------+  |gle+-------+
+*/
+template <typename T>
+Image<T>* Image<T>::shear_h(double angle, T default_value) const {
+  int dims[2];
+  //printf("angle = %frad = %fdeg\n",angle, angle*180/M_PI);
+  dims[0]=height;
+  if (angle > 0)
+    dims[1]=width+int(height*tan(angle))+1;
+  else
+    dims[1]=width+int(height*tan(-angle))+1;
+
+  //printf("dims = %dfilas x %dcolumnas\n", dims[0], dims[1]);
+	
+  Matrix<T> *mat = new Matrix<T>(2,dims);
+  Image<T>  *img = new Image<T>(mat);
+
+  ImageShearH<T> shear;
+  shear.source        = row_ptr(0);
+  shear.source_stride = row_stride();
+  shear.dest          = img->row_ptr(0);
+  shear.dest_width    = dims[1];
+  shear.width         = width;
+  shear.height        = height;
+  shear.default_value = default_value;
+  // Angle < 0, empezamos por abajo
+  shear.bottom_up     = !(angle > 0);
+  shear.tan_angle     = (angle > 0) ? tan(angle) : tan(-angle);
+  imageForEachRowBand(dims[1], height, shear);
 
   return img;
 }
@@ -539,6 +559,32 @@ void Image<T>::copy(const Image<T> *src, int dst_x, int dst_y)
 }
 
 
+// Rotation of 90 degrees by square tiles, source pixel (x,y) goes to
+// result pixel (height-1-y, x) when clockwise, or (y, width-1-x) otherwise
+template<typename T>
+struct ImageRotate90 {
+  const T *source; int source_stride;
+  T *dest; int dest_stride;
+  int width, height;
+  bool clockwise;
+  void operator()(int y0, int y1) {
+    for (int x0=0; x0<width; x0+=IMAGE_ROWS_PER_BAND) {
+      int x1 = april_utils::min(x0 + IMAGE_ROWS_PER_BAND, width);
+      for (int x=x0; x<x1; ++x) {
+	const T *s = source + x;
+	if (clockwise) {
+	  T *d = dest + x*dest_stride + (height-1);
+	  for (int y=y0; y<y1; ++y) d[-y] = s[y*source_stride];
+	}
+	else {
+	  T *d = dest + (width-1-x)*dest_stride;
+	  for (int y=y0; y<y1; ++y) d[y] = s[y*source_stride];
+	}
+      }
+    }
+  }
+};
+
 template<typename T>
 Image<T> *Image<T>::rotate90_cw() const
 {
@@ -549,14 +595,15 @@ Image<T> *Image<T>::rotate90_cw() const
   Matrix<T> *new_mat = new Matrix<T>(2, dimensions);
   Image<T> *result = new Image<T>(new_mat);
 
-  for (int y=0; y < height; ++y)
-    {
-      for (int x=0; x < width; ++x)
-	{
-	  //printf("(%d, %d) ---> (%d, %d)\n",x,y,height-1-y,x);
-	  (*result)(height - 1 - y, x)=(*this)(x, y);
-	}
-    }
+  ImageRotate90<T> rotate;
+  rotate.source        = row_ptr(0);
+  rotate.source_stride = row_stride();
+  rotate.dest          = result->row_ptr(0);
+  rotate.dest_stride   = result->row_stride();
+  rotate.width         = width;
+  rotate.height        = height;
+  rotate.clockwise     = true;
+  imageForEachRowBand(width, height, rotate);
 	
   return result;
 }
@@ -571,13 +618,15 @@ Image<T> *Image<T>::rotate90_ccw() const
   Matrix<T> *new_mat = new Matrix<T>(2, dimensions);
   Image<T> *result = new Image<T>(new_mat);
 
-  for (int y=0; y < height; ++y)
-    {
-      for (int x=0; x < width; ++x)
-	{
-	  (*result)(y, width - 1 - x)=(*this)(x, y);
-	}
-    }
+  ImageRotate90<T> rotate;
+  rotate.source        = row_ptr(0);
+  rotate.source_stride = row_stride();
+  rotate.dest          = result->row_ptr(0);
+  rotate.dest_stride   = result->row_stride();
+  rotate.width         = width;
+  rotate.height        = height;
+  rotate.clockwise     = false;
+  imageForEachRowBand(width, height, rotate);
 	
   return result;
 }
@@ -698,6 +747,78 @@ Image<T> *Image<T>::add_rows(int top_rows, int bottom_rows, T value) const
   return result;
 }
 
+template<typename T>
+struct ImageConvolution5x5 {
+  const Image<T> *img;
+  const T *source; int source_stride;
+  T *dest; int dest_stride;
+  const float *k;
+  T default_color;
+  
+  // bound-checked version, used at image borders
+  T border_pixel(int x, int y) const {
+    const T *s = source; const int st = source_stride; const T dc = default_color;
+    return img->getpixel(s,st,x-2, y-2, dc) * k[0] + 
+      img->getpixel(s,st,x-1, y-2, dc) * k[1] +
+      img->getpixel(s,st,x  , y-2, dc) * k[2] +
+      img->getpixel(s,st,x+1, y-2, dc) * k[3] +
+      img->getpixel(s,st,x+2, y-2, dc) * k[4] +
+      img->getpixel(s,st,x-2, y-1, dc) * k[5] + 
+      img->getpixel(s,st,x-1, y-1, dc) * k[6] +
+      img->getpixel(s,st,x  , y-1, dc) * k[7] +
+      img->getpixel(s,st,x+1, y-1, dc) * k[8] +
+      img->getpixel(s,st,x+2, y-1, dc) * k[9] +
+      img->getpixel(s,st,x-2, y,   dc) * k[10] + 
+      img->getpixel(s,st,x-1, y,   dc) * k[11] +
+      img->getpixel(s,st,x  , y,   dc) * k[12] +
+      img->getpixel(s,st,x+1, y,   dc) * k[13] +
+      img->getpixel(s,st,x+2, y,   dc) * k[14] +
+      img->getpixel(s,st,x-2, y+1, dc) * k[15] + 
+      img->getpixel(s,st,x-1, y+1, dc) * k[16] +
+      img->getpixel(s,st,x  , y+1, dc) * k[17] +
+      img->getpixel(s,st,x+1, y+1, dc) * k[18] +
+      img->getpixel(s,st,x+2, y+1, dc) * k[19] +
+      img->getpixel(s,st,x-2, y+2, dc) * k[20] + 
+      img->getpixel(s,st,x-1, y+2, dc) * k[21] +
+      img->getpixel(s,st,x  , y+2, dc) * k[22] +
+      img->getpixel(s,st,x+1, y+2, dc) * k[23] +
+      img->getpixel(s,st,x+2, y+2, dc) * k[24];
+  }
+  
+  void operator()(int y0, int y1) {
+    const int width = img->width, height = img->height;
+    // local copy of the kernel, it can't alias the destination
+    float kl[25];
+    for (int i=0; i<25; ++i) kl[i] = k[i];
+    for (int y=y0; y<y1; y++) {
+      T *d = dest + y*dest_stride;
+      if (y < 2 || y+2 >= height || width < 5) {
+	for (int x=0; x<width; x++) d[x] = border_pixel(x, y);
+	continue;
+      }
+      d[0] = border_pixel(0, y);
+      d[1] = border_pixel(1, y);
+      // inner pixels, the 5 rows are accessed by pointers, same sum order
+      // than border_pixel
+      const T *r0 = source + (y-2)*source_stride;
+      const T *r1 = r0 + source_stride;
+      const T *r2 = r1 + source_stride;
+      const T *r3 = r2 + source_stride;
+      const T *r4 = r3 + source_stride;
+      for (int x=2; x<width-2; x++) {
+	d[x] =
+	  r0[x-2]*kl[0]  + r0[x-1]*kl[1]  + r0[x]*kl[2]  + r0[x+1]*kl[3]  + r0[x+2]*kl[4]  +
+	  r1[x-2]*kl[5]  + r1[x-1]*kl[6]  + r1[x]*kl[7]  + r1[x+1]*kl[8]  + r1[x+2]*kl[9]  +
+	  r2[x-2]*kl[10] + r2[x-1]*kl[11] + r2[x]*kl[12] + r2[x+1]*kl[13] + r2[x+2]*kl[14] +
+	  r3[x-2]*kl[15] + r3[x-1]*kl[16] + r3[x]*kl[17] + r3[x+1]*kl[18] + r3[x+2]*kl[19] +
+	  r4[x-2]*kl[20] + r4[x-1]*kl[21] + r4[x]*kl[22] + r4[x+1]*kl[23] + r4[x+2]*kl[24];
+      }
+      d[width-2] = border_pixel(width-2, y);
+      d[width-1] = border_pixel(width-1, y);
+    }
+  }
+};
+
 /**
  * Aplica un kernel de convolucion de 5x5 a la imagen. Devuelve el resultado
  * en una imagen nueva. El kernel se organiza por filas:
@@ -718,122 +839,136 @@ Image<T> *Image<T>::convolution5x5(float *k, T default_color) const
   Matrix<T> *new_mat = new Matrix<T>(2, dimensions);
   Image<T> *result = new Image<T>(new_mat);
 
-  for (int y=0; y<height; y++) {
-    for (int x=0; x<width; x++) {
-      T value = getpixel(x-2, y-2, default_color) * k[0] + 
-	getpixel(x-1, y-2, default_color) * k[1] +
-	getpixel(x  , y-2, default_color) * k[2] +
-	getpixel(x+1, y-2, default_color) * k[3] +
-	getpixel(x+2, y-2, default_color) * k[4] +
-	getpixel(x-2, y-1, default_color) * k[5] + 
-	getpixel(x-1, y-1, default_color) * k[6] +
-	getpixel(x  , y-1, default_color) * k[7] +
-	getpixel(x+1, y-1, default_color) * k[8] +
-	getpixel(x+2, y-1, default_color) * k[9] +
-	getpixel(x-2, y,   default_color) * k[10] + 
-	getpixel(x-1, y,   default_color) * k[11] +
-	getpixel(x  , y,   default_color) * k[12] +
-	getpixel(x+1, y,   default_color) * k[13] +
-	getpixel(x+2, y,   default_color) * k[14] +
-	getpixel(x-2, y+1, default_color) * k[15] + 
-	getpixel(x-1, y+1, default_color) * k[16] +
-	getpixel(x  , y+1, default_color) * k[17] +
-	getpixel(x+1, y+1, default_color) * k[18] +
-	getpixel(x+2, y+1, default_color) * k[19] +
-	getpixel(x-2, y+2, default_color) * k[20] + 
-	getpixel(x-1, y+2, default_color) * k[21] +
-	getpixel(x  , y+2, default_color) * k[22] +
-	getpixel(x+1, y+2, default_color) * k[23] +
-	getpixel(x+2, y+2, default_color) * k[24];
-      (*result)(x,y) = value;
-    }
-  }
+  ImageConvolution5x5<T> conv;
+  conv.img           = this;
+  conv.source        = row_ptr(0);
+  conv.source_stride = row_stride();
+  conv.dest          = result->row_ptr(0);
+  conv.dest_stride   = result->row_stride();
+  conv.k             = k;
+  conv.default_color = default_color;
+  imageForEachRowBand(width, height, conv);
 
   return result;
 }
 
 template<typename T>
-Image<T> *Image<T>::resize(int dst_width, int dst_height) const
-{
-  T default_value=T();
-  int dimensions[2];
-  dimensions[0] = dst_height;
-  dimensions[1] = dst_width;
-
-  Matrix<T> *new_mat = new Matrix<T>(2, dimensions);
-  Image<T> *result = new Image<T>(new_mat);
-
-  // we go through the destination image
-  for (int y=0; y<dst_height; y++) {
-    for (int x=0; x<dst_width; x++) {
-      // each pixel (x,y) in the destination image corresponds to a rectangle (x0,y0)-(x1,y1) in the source image
-      float x0 = (float(x)/float(dst_width)) * (width-1);
-      float x1 = (float(x+1)/float(dst_width)) * (width-1);
+struct ImageResize {
+  const Image<T> *img;
+  const T *source; int source_stride;
+  T *dest; int dest_stride;
+  int dst_width, dst_height;
+  // source interval [xs0[x],xs1[x]] of each destination column
+  const float *xs0, *xs1;
+  
+  T sample(float x, float y) const {
+    return img->getpixel_bilinear(source, source_stride, x, y, T());
+  }
+  
+  void operator()(int row0, int row1) {
+    const int width = img->width, height = img->height;
+    for (int y=row0; y<row1; y++) {
+      T *d = dest + y*dest_stride;
       float y0 = (float(y)/float(dst_height)) * (height-1);
       float y1 = (float(y+1)/float(dst_height)) * (height-1);
-      int ix0 = int(x0);
-      int ix1 = int(x1);
       int iy0 = int(y0);
       int iy1 = int(y1);
-
-      float area = ((x1-x0)*(y1-y0));
-      T sum=T();
-
-      if (iy0 == iy1) {
-	// Less than one row (only a fraction)
-	float yinterp = 0.5f*(y0+y1);
-	if (ix0 == ix1) {
-	  sum = (x1-x0) * getpixel_bilinear(0.5f*(x0+x1), yinterp, default_value);
-	} 
-	else {
-	  sum += (float(ix0+1)-x0) * getpixel_bilinear(0.5f*(float(ix0+1)+x0), yinterp, default_value); // beginning of iy0 (possibly fractional)
-	  sum += (x1-floor(x1)) * getpixel_bilinear(0.5f*(x1+floor(x1)), yinterp, default_value);    // end of iy0 (possibly fractional)
-	  for (int col=ix0+1; col < ix1; col++) {
-	    sum += getpixel_bilinear(col+0.5f, yinterp, default_value);
-	  }
-	}
-	sum *= (y1-y0);
-      } 
-      else {
-	// Several rows
-	for (int row = iy0; row <= iy1; row++) {
-	  float row_fraction, yinterp;
-	  T sum_row=T();
-	  if (row == iy0) {
-	    row_fraction = float(iy0+1)-y0;
-	    yinterp = 0.5f*(float(iy0+1)+y0);
-	  }
-	  else if (row == iy1) {
-	    row_fraction = y1-floor(y1);
-	    yinterp = 0.5f*(float(y1+floor(y1)));
-	  }
-	  else {
-	    row_fraction=1.0f;
-	    yinterp = row+0.5f;
-	  }
-
-	  //printf("row_fraction=%f\n", row_fraction);
-
+      for (int x=0; x<dst_width; x++) {
+	// each pixel (x,y) in the destination image corresponds to a rectangle (x0,y0)-(x1,y1) in the source image
+	float x0 = xs0[x];
+	float x1 = xs1[x];
+	int ix0 = int(x0);
+	int ix1 = int(x1);
+	
+	float area = ((x1-x0)*(y1-y0));
+	T sum=T();
+	
+	if (iy0 == iy1) {
+	  // Less than one row (only a fraction)
+	  float yinterp = 0.5f*(y0+y1);
 	  if (ix0 == ix1) {
-	    sum_row = (x1-x0) * getpixel_bilinear(0.5f*(x0+x1), row, default_value);
+	    sum = (x1-x0) * sample(0.5f*(x0+x1), yinterp);
 	  } 
 	  else {
-	    sum_row += (float(ix0+1)-x0) * getpixel_bilinear(0.5f*(float(ix0+1)+x0), yinterp, default_value); // beginning of iy0 (possibly fractional)
-	    sum_row += (x1-floor(x1)) * getpixel_bilinear(0.5f*(x1+floor(x1)), yinterp, default_value);    // end of iy0 (possibly fractional)
-
+	    sum += (float(ix0+1)-x0) * sample(0.5f*(float(ix0+1)+x0), yinterp); // beginning of iy0 (possibly fractional)
+	    sum += (x1-floor(x1)) * sample(0.5f*(x1+floor(x1)), yinterp);    // end of iy0 (possibly fractional)
 	    for (int col=ix0+1; col < ix1; col++) {
-	      sum_row += getpixel_bilinear(col+0.5f, yinterp, default_value);
+	      sum += sample(col+0.5f, yinterp);
 	    }
 	  }
-	  sum += row_fraction*sum_row;
-	  //printf("sum_row = %f\n", sum_row);
+	  sum *= (y1-y0);
+	} 
+	else {
+	  // Several rows
+	  for (int row = iy0; row <= iy1; row++) {
+	    float row_fraction, yinterp;
+	    T sum_row=T();
+	    if (row == iy0) {
+	      row_fraction = float(iy0+1)-y0;
+	      yinterp = 0.5f*(float(iy0+1)+y0);
+	    }
+	    else if (row == iy1) {
+	      row_fraction = y1-floor(y1);
+	      yinterp = 0.5f*(float(y1+floor(y1)));
+	    }
+	    else {
+	      row_fraction=1.0f;
+	      yinterp = row+0.5f;
+	    }
+	    
+	    if (ix0 == ix1) {
+	      sum_row = (x1-x0) * sample(0.5f*(x0+x1), row);
+	    } 
+	    else {
+	      sum_row += (float(ix0+1)-x0) * sample(0.5f*(float(ix0+1)+x0), yinterp); // beginning of iy0 (possibly fractional)
+	      sum_row += (x1-floor(x1)) * sample(0.5f*(x1+floor(x1)), yinterp);    // end of iy0 (possibly fractional)
+	      
+	      for (int col=ix0+1; col < ix1; col++) {
+		sum_row += sample(col+0.5f, yinterp);
+	      }
+	    }
+	    sum += row_fraction*sum_row;
+	  }
 	}
+	
+	d[x] = sum/area;
       }
-
-      (*result)(x,y) = sum/area;
-      //printf("(%d, %d) ---> (%f, %f)-(%f, %f) area= %f, sum=%f\n", x, y, x0, y0, x1, y1, area, sum); 
     }
   }
+};
+
+template<typename T>
+Image<T> *Image<T>::resize(int dst_width, int dst_height) const
+{
+  int dimensions[2];
+  dimensions[0] = dst_height;
+  dimensions[1] = dst_width;
+
+  Matrix<T> *new_mat = new Matrix<T>(2, dimensions);
+  Image<T> *result = new Image<T>(new_mat);
+
+  // the source columns interval only depends on the destination column
+  float *xs0 = new float[dst_width];
+  float *xs1 = new float[dst_width];
+  for (int x=0; x<dst_width; x++) {
+    xs0[x] = (float(x)/float(dst_width)) * (width-1);
+    xs1[x] = (float(x+1)/float(dst_width)) * (width-1);
+  }
+  
+  ImageResize<T> res;
+  res.img           = this;
+  res.source        = row_ptr(0);
+  res.source_stride = row_stride();
+  res.dest          = result->row_ptr(0);
+  res.dest_stride   = result->row_stride();
+  res.dst_width     = dst_width;
+  res.dst_height    = dst_height;
+  res.xs0           = xs0;
+  res.xs1           = xs1;
+  imageForEachRowBand(dst_width, dst_height, res);
+  
+  delete[] xs0;
+  delete[] xs1;
   return result;
 }
 
@@ -852,6 +987,27 @@ void Image<T>::invert_affine_matrix(float *c, float *dest) const
 }
 
 
+template <typename T>
+struct ImageAffineTransform {
+  const Image<T> *img;
+  const T *source; int source_stride;
+  T *dest; int dest_stride;
+  const float *c;
+  int xmin, xmax, ymin;
+  T default_value;
+  void operator()(int row0, int row1) {
+    for (int y=ymin+row0; y<ymin+row1; y++) {
+      T *d = dest + (y-ymin)*dest_stride;
+      for (int x=xmin; x<=xmax; x++) {
+	float srcx = c[0]*x+c[1]*y+c[2];
+	float srcy = c[3]*x+c[4]*y+c[5];
+	d[x-xmin] = img->getpixel_bilinear(source, source_stride, srcx, srcy,
+				      default_value);
+      }
+    }
+  }
+};
+
 /** 
  *  Applies an affine transform given by the matrix
  *
@@ -921,15 +1077,18 @@ Image<T> *Image<T>::affine_transform(AffineTransform2D *trans, T default_value,
   Matrix<T> *new_mat = new Matrix<T>(2, dimensions);
   Image<T> *result = new Image<T>(new_mat);
 
-  for (int y=ymin; y<=ymax; y++) {
-    for (int x=xmin; x<=xmax; x++) {
-      float srcx = c[0]*x+c[1]*y+c[2];
-      float srcy = c[3]*x+c[4]*y+c[5];
-      T value = getpixel_bilinear(srcx, srcy, default_value);
-      //printf("dst=(%d,%d) --- src = (%f, %f) value=%f\n", x, y, srcx, srcy, value);
-      (*result)(x-xmin,y-ymin) = value;
-    }
-  }
+  ImageAffineTransform<T> transform;
+  transform.img           = this;
+  transform.source        = row_ptr(0);
+  transform.source_stride = row_stride();
+  transform.dest          = result->row_ptr(0);
+  transform.dest_stride   = result->row_stride();
+  transform.c             = c;
+  transform.xmin          = xmin;
+  transform.xmax          = xmax;
+  transform.ymin          = ymin;
+  transform.default_value = default_value;
+  imageForEachRowBand(dst_width, dst_height, transform);
 
   if (offset_x != 0) *offset_x = xmin;
   if (offset_y != 0) *offset_y = ymin;
@@ -50,6 +50,17 @@ class Image : public Referenced {
     return matrix->getRawDataAccess()->getPPALForRead()[offset+x+y*matrix_width()];
   }
 
+  // Row access: row_ptr(y)[x] is the pixel (x,y), and consecutive rows are
+  // separated by row_stride() elements. Loops over pixels should take the
+  // pointer once and use it instead of operator() or getpixel.
+  T *row_ptr(int y) {
+    return matrix->getRawDataAccess()->getPPALForReadAndWrite() + offset + y*row_stride();
+  }
+  const T *row_ptr(int y) const {
+    return matrix->getRawDataAccess()->getPPALForRead() + offset + y*row_stride();
+  }
+  int row_stride() const { return matrix_width(); }
+
   // Bound-checking version of operator()
   T getpixel(int x, int y, T default_value) const {
     if (x>=0 && y>=0 && x<width && y<height) return (*this)(x,y);
@@ -57,12 +68,24 @@ class Image : public Referenced {
   }
 
   T getpixel_bilinear(float x, float y, T default_value) const {
+    return getpixel_bilinear(row_ptr(0), row_stride(), x, y, default_value);
+  }
+
+  // Versions of getpixel and getpixel_bilinear which receive the pointer to
+  // pixel (0,0) and the row stride, as given by row_ptr(0) and row_stride()
+  T getpixel(const T *data, int stride, int x, int y, T default_value) const {
+    if (x>=0 && y>=0 && x<width && y<height) return data[x+y*stride];
+    else return default_value;
+  }
+
+  T getpixel_bilinear(const T *data, int stride,
+		      float x, float y, T default_value) const {
     float fx = fabsf(x - trunc(x));
     float fy = fabsf(y - trunc(y));
     float dx = (x >= 0.0f ? 1.0f : -1.0f);
     float dy = (y >= 0.0f ? 1.0f : -1.0f);
-    T h1 = (1-fx)*getpixel(int(x), int(y), default_value) + fx*getpixel(int(x+dx), int(y), default_value);
-    T h2 = (1-fx)*getpixel(int(x), int(y+dy), default_value) + fx*getpixel(int(x+dx), int(y+dy), default_value);
+    T h1 = (1-fx)*getpixel(data, stride, int(x), int(y), default_value) + fx*getpixel(data, stride, int(x+dx), int(y), default_value);
+    T h2 = (1-fx)*getpixel(data, stride, int(x), int(y+dy), default_value) + fx*getpixel(data, stride, int(x+dx), int(y+dy), default_value);
     return (1-fy)*h1 + fy*h2;
   }
   
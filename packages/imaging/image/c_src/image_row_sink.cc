@@ -0,0 +1,140 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Jorge Gorbe Moya
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include <cstring>
+#include "image_row_sink.h"
+#include "floatrgb.h"
+#include "maxmin.h"
+
+ImageRowSink::ImageRowSink(int src_width, int src_height, ChannelLayout layout,
+			   int roi_x, int roi_y, int roi_width, int roi_height,
+			   int downscale) :
+  layout(layout), num_channels(layout == GRAY ? 1 : 3),
+  roi_x(roi_x), roi_y(roi_y), roi_width(roi_width), roi_height(roi_height),
+  downscale(downscale), out_width(0), out_height(0),
+  result(0), accum(0), accum_rows(0) {
+  if (this->roi_width  <= 0) this->roi_width  = src_width  - roi_x;
+  if (this->roi_height <= 0) this->roi_height = src_height - roi_y;
+  if (downscale < 1 || roi_x < 0 || roi_y < 0 ||
+      this->roi_width <= 0 || this->roi_height <= 0 ||
+      roi_x + this->roi_width  > src_width ||
+      roi_y + this->roi_height > src_height) return;
+  out_width  = (this->roi_width  + downscale - 1) / downscale;
+  out_height = (this->roi_height + downscale - 1) / downscale;
+  int dims[3];
+  switch(layout) {
+  case GRAY:
+    dims[0] = out_height; dims[1] = out_width;
+    result  = new MatrixFloat(2, dims);
+    break;
+  case RGB:
+    dims[0] = out_height; dims[1] = out_width; dims[2] = 3;
+    result  = new MatrixFloat(3, dims);
+    break;
+  case RGB_PLANAR:
+    dims[0] = 3; dims[1] = out_height; dims[2] = out_width;
+    result  = new MatrixFloat(3, dims);
+    break;
+  }
+  accum = new float[out_width*num_channels];
+  for (int i=0; i<out_width*num_channels; ++i) accum[i] = 0.0f;
+  for (int i=0; i<256; ++i) {
+    byte_value[i] = i/255.0f;
+    FloatRGB c(byte_value[i], byte_value[i], byte_value[i]);
+    gray_value[i] = c.to_grayscale();
+  }
+}
+
+ImageRowSink::~ImageRowSink() {
+  delete result;
+  delete[] accum;
+}
+
+void ImageRowSink::addRow(int y, const unsigned char *pixels, int channels) {
+  if (result == 0 || y < roi_y || y >= roi_y + roi_height) return;
+  const unsigned char *p = pixels + roi_x*channels;
+  for (int bx=0; bx<out_width; ++bx) {
+    float *a = accum + bx*num_channels;
+    int cols = april_utils::min(downscale, roi_width - bx*downscale);
+    if (num_channels == 1) {
+      if (channels < 3)
+	for (int i=0; i<cols; ++i, p+=channels) a[0] += gray_value[p[0]];
+      else
+	for (int i=0; i<cols; ++i, p+=channels) {
+	  FloatRGB c(byte_value[p[0]], byte_value[p[1]], byte_value[p[2]]);
+	  a[0] += c.to_grayscale();
+	}
+    }
+    else {
+      if (channels < 3)
+	for (int i=0; i<cols; ++i, p+=channels) {
+	  float v = byte_value[p[0]];
+	  a[0] += v; a[1] += v; a[2] += v;
+	}
+      else
+	for (int i=0; i<cols; ++i, p+=channels) {
+	  a[0] += byte_value[p[0]];
+	  a[1] += byte_value[p[1]];
+	  a[2] += byte_value[p[2]];
+	}
+    }
+  }
+  ++accum_rows;
+  int row = y - roi_y;
+  if ((row+1) % downscale == 0 || row == roi_height-1)
+    flushRows(row / downscale);
+}
+
+void ImageRowSink::flushRows(int out_y) {
+  float *data = result->getRawDataAccess()->getPPALForReadAndWrite();
+  for (int bx=0; bx<out_width; ++bx) {
+    int cols = april_utils::min(downscale, roi_width - bx*downscale);
+    float n  = static_cast<float>(cols*accum_rows);
+    float *a = accum + bx*num_channels;
+    switch(layout) {
+    case GRAY:
+      data[out_y*out_width + bx] = a[0]/n;
+      break;
+    case RGB:
+      for (int c=0; c<3; ++c) data[(out_y*out_width + bx)*3 + c] = a[c]/n;
+      break;
+    case RGB_PLANAR:
+      for (int c=0; c<3; ++c)
+	data[(c*out_height + out_y)*out_width + bx] = a[c]/n;
+      break;
+    }
+  }
+  for (int i=0; i<out_width*num_channels; ++i) accum[i] = 0.0f;
+  accum_rows = 0;
+}
+
+MatrixFloat *ImageRowSink::releaseMatrix() {
+  MatrixFloat *m = result;
+  result = 0;
+  return m;
+}
+
+bool ImageRowSink::parseLayout(const char *name, ChannelLayout &layout) {
+  if (strcmp(name, "gray") == 0) layout = GRAY;
+  else if (strcmp(name, "rgb") == 0) layout = RGB;
+  else if (strcmp(name, "rgb_planar") == 0) layout = RGB_PLANAR;
+  else return false;
+  return true;
+}
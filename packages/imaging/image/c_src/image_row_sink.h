@@ -0,0 +1,81 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2012, Jorge Gorbe Moya
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef IMAGE_ROW_SINK_H
+#define IMAGE_ROW_SINK_H
+
+#include "utilMatrixFloat.h"
+
+/// Receives the 8-bit rows of an image decoder (libpng, libtiff), from top to
+/// bottom, and writes them into a MatrixFloat with the requested channel
+/// layout. Only the rows and columns of a region of interest are kept, and
+/// they could be downscaled averaging blocks of downscale x downscale pixels,
+/// so decoders only need one row of the source image besides the result.
+class ImageRowSink {
+ public:
+  enum ChannelLayout {
+    GRAY,       ///< height x width matrix, as RGB_to_grayscale
+    RGB,        ///< height x width x 3 matrix
+    RGB_PLANAR  ///< 3 x height x width matrix
+  };
+
+  /// The region of interest is [roi_x, roi_x+roi_width) x [roi_y,
+  /// roi_y+roi_height), a roi_width or roi_height <= 0 means up to the image
+  /// border. Use isValid() to check the region before adding rows.
+  ImageRowSink(int src_width, int src_height, ChannelLayout layout,
+	       int roi_x=0, int roi_y=0, int roi_width=0, int roi_height=0,
+	       int downscale=1);
+  ~ImageRowSink();
+
+  /// False when the region of interest is empty or outside the image
+  bool isValid() const { return result != 0; }
+  /// The rows [getFirstRow(), getLastRow()) are the only ones needed
+  int getFirstRow() const { return roi_y; }
+  int getLastRow() const { return roi_y + roi_height; }
+  int getOutputWidth() const { return out_width; }
+  int getOutputHeight() const { return out_height; }
+
+  /// Adds the source row y, with src_width pixels of channels bytes each: 1
+  /// (gray), 2 (gray and alpha), 3 (RGB) or 4 (RGBA), alpha is ignored. Rows
+  /// must be added in order, rows out of the region of interest are ignored.
+  void addRow(int y, const unsigned char *pixels, int channels);
+
+  /// Returns the result, once all the rows of the region have been added.
+  /// The caller takes the ownership of the matrix.
+  MatrixFloat *releaseMatrix();
+
+  static bool parseLayout(const char *name, ChannelLayout &layout);
+
+ private:
+  ChannelLayout layout;
+  int num_channels;
+  int roi_x, roi_y, roi_width, roi_height, downscale;
+  int out_width, out_height;
+  MatrixFloat *result;
+  // sums of the current block of rows, out_width*num_channels floats
+  float *accum;
+  int accum_rows;
+  // byte to float, and gray byte to its RGB_to_grayscale value
+  float byte_value[256], gray_value[256];
+
+  void flushRows(int out_y);
+};
+
+#endif // IMAGE_ROW_SINK_H
@@ -0,0 +1,188 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Jorge Gorbe Moya, Joan Pastor Pellicer
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+/*
+ *    Fichero de implementacion (incluido por la cabecera integral_image.h)
+ *
+ */
+
+#ifndef _INTEGRAL_IMAGE_CC_
+#define _INTEGRAL_IMAGE_CC_
+
+#include "integral_image.h"
+#include "error_print.h"
+#include "maxmin.h"
+
+/// Computes the tables by bands of rows (see imageForEachRowBand). The first
+/// pass sums each band independently, and the second one adds to every row
+/// of a band the last row of the previous band, once the last rows have been
+/// accumulated sequentially.
+template<typename T>
+struct IntegralImageBands {
+  const T *data; int data_stride;
+  int width, stride;
+  double *sums, *squares;
+  int pass;
+
+  void addRow(double *dest, const double *src) {
+    for (int x=0; x<width; ++x) dest[x] += src[x];
+  }
+
+  void operator()(int y0, int y1) {
+    if (pass == 0) {
+      for (int y=y0; y<y1; ++y) {
+	const T *src = data + y*data_stride;
+	double *s    = sums + (y+1)*stride + 1;
+	double acc   = 0.0;
+	for (int x=0; x<width; ++x) {
+	  acc += static_cast<double>(src[x]);
+	  s[x] = acc;
+	}
+	if (y > y0) addRow(s, s - stride);
+	if (squares) {
+	  double *s2 = squares + (y+1)*stride + 1;
+	  acc = 0.0;
+	  for (int x=0; x<width; ++x) {
+	    double v = static_cast<double>(src[x]);
+	    acc  += v*v;
+	    s2[x] = acc;
+	  }
+	  if (y > y0) addRow(s2, s2 - stride);
+	}
+      }
+    }
+    else if (y0 > 0) {
+      // the last row of the band has been accumulated before
+      for (int y=y0; y<y1-1; ++y) {
+	addRow(sums + (y+1)*stride + 1, sums + y0*stride + 1);
+	if (squares)
+	  addRow(squares + (y+1)*stride + 1, squares + y0*stride + 1);
+      }
+    }
+  }
+};
+
+template <typename T>
+IntegralImage<T>::IntegralImage(const Image<T> *img, bool with_squares) :
+  width(img->width), height(img->height), stride(img->width+1),
+  squares(0) {
+  int size = stride*(height+1);
+  sums = new double[size];
+  if (with_squares) squares = new double[size];
+  // first row and first column are zero
+  for (int x=0; x<stride; ++x) sums[x] = 0.0;
+  for (int y=1; y<=height; ++y) sums[y*stride] = 0.0;
+  if (squares) {
+    for (int x=0; x<stride; ++x) squares[x] = 0.0;
+    for (int y=1; y<=height; ++y) squares[y*stride] = 0.0;
+  }
+  if (width == 0 || height == 0) return;
+  IntegralImageBands<T> bands;
+  bands.data        = img->row_ptr(0);
+  bands.data_stride = img->row_stride();
+  bands.width       = width;
+  bands.stride      = stride;
+  bands.sums        = sums;
+  bands.squares     = squares;
+  bands.pass        = 0;
+  imageForEachRowBand(width, height, bands);
+  for (int y0=IMAGE_ROWS_PER_BAND; y0<height; y0+=IMAGE_ROWS_PER_BAND) {
+    int y1 = april_utils::min(y0 + IMAGE_ROWS_PER_BAND, height);
+    bands.addRow(sums + y1*stride + 1, sums + y0*stride + 1);
+    if (squares)
+      bands.addRow(squares + y1*stride + 1, squares + y0*stride + 1);
+  }
+  bands.pass = 1;
+  imageForEachRowBand(width, height, bands);
+}
+
+template <typename T>
+IntegralImage<T>::~IntegralImage() {
+  delete[] sums;
+  delete[] squares;
+}
+
+template <typename T>
+void IntegralImage<T>::localMeanVariance(int y, int radius,
+					 float *mean, float *variance,
+					 BorderMode mode,
+					 double border_value) const {
+  if (variance && !squares)
+    ERROR_EXIT(128, "The integral image has been computed without squares\n");
+  int top    = april_utils::max(0, y-radius);
+  int bottom = april_utils::min(height-1, y+radius);
+  int rows   = bottom - top + 1;
+  int side   = 2*radius + 1;
+  double full = double(side)*double(side);
+  const double *A  = sums + top*stride,    *B  = sums + (bottom+1)*stride;
+  const double *A2 = 0, *B2 = 0;
+  if (variance) {
+    A2 = squares + top*stride;
+    B2 = squares + (bottom+1)*stride;
+  }
+  // columns [x0,x1) have their windows inside the image horizontally
+  int x0 = april_utils::min(radius, width);
+  int x1 = april_utils::max(x0, width-radius);
+  // border columns, with a different window size each one
+  for (int x=0; x<width; ++x) {
+    if (x == x0) x = x1;
+    if (x >= width) break;
+    int l = april_utils::max(0, x-radius);
+    int r = april_utils::min(width-1, x+radius) + 1;
+    double area = double(rows)*double(r-l);
+    double den  = area, add = 0.0, add2 = 0.0;
+    if (mode == CONSTANT_BORDER) {
+      den  = full;
+      add  = (full - area)*border_value;
+      add2 = add*border_value;
+    }
+    double m = (B[r] - B[l] - A[r] + A[l] + add)/den;
+    mean[x] = static_cast<float>(m);
+    if (variance) {
+      double v = (B2[r] - B2[l] - A2[r] + A2[l] + add2)/den - m*m;
+      variance[x] = static_cast<float>(v < 0.0 ? 0.0 : v);
+    }
+  }
+  // inner columns, all of them with the same window size, vectorizable loops
+  double area = double(rows)*double(side);
+  double inv  = 1.0/area, add = 0.0, add2 = 0.0;
+  if (mode == CONSTANT_BORDER) {
+    inv  = 1.0/full;
+    add  = (full - area)*border_value;
+    add2 = add*border_value;
+  }
+  if (!variance) {
+    for (int x=x0; x<x1; ++x) {
+      int l = x - radius, r = x + radius + 1;
+      mean[x] = static_cast<float>((B[r] - B[l] - A[r] + A[l] + add)*inv);
+    }
+  }
+  else {
+    for (int x=x0; x<x1; ++x) {
+      int l = x - radius, r = x + radius + 1;
+      double m = (B[r] - B[l] - A[r] + A[l] + add)*inv;
+      double v = (B2[r] - B2[l] - A2[r] + A2[l] + add2)*inv - m*m;
+      mean[x]     = static_cast<float>(m);
+      variance[x] = static_cast<float>(v < 0.0 ? 0.0 : v);
+    }
+  }
+}
+
+#endif // _INTEGRAL_IMAGE_CC_
@@ -0,0 +1,82 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Jorge Gorbe Moya, Joan Pastor Pellicer
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef INTEGRAL_IMAGE_H
+#define INTEGRAL_IMAGE_H
+
+#include "referenced.h"
+#include "image.h"
+
+/// Integral image (summed-area table) of an Image<T>, and optionally of its
+/// squared pixels. Sums are accumulated in double precision, so the sums of
+/// large pages don't drift, and computed by bands of rows in worker threads.
+/// The tables have a row and a column of zeros before the image, so every
+/// window sum is computed with four reads and without border checks.
+template <typename T>
+class IntegralImage : public Referenced {
+ public:
+  /// How the windows which go beyond the image borders are summarized
+  enum BorderMode {
+    /// only the pixels inside the image are used
+    CLIP_WINDOW,
+    /// the pixels outside the image take the value border_value
+    CONSTANT_BORDER
+  };
+
+  IntegralImage(const Image<T> *img, bool with_squares=true);
+  virtual ~IntegralImage();
+
+  int getWidth() const { return width; }
+  int getHeight() const { return height; }
+  bool hasSquares() const { return squares != 0; }
+
+  /// Sum of the pixels in the rectangle [x0,x1]x[y0,y1] (included), which
+  /// must be inside the image
+  double sum(int x0, int y0, int x1, int y1) const {
+    return rectangle(sums, x0, y0, x1, y1);
+  }
+  /// Sum of the squared pixels in the rectangle [x0,x1]x[y0,y1]
+  double sumOfSquares(int x0, int y0, int x1, int y1) const {
+    return rectangle(squares, x0, y0, x1, y1);
+  }
+
+  /// Mean and variance of the (2*radius+1)x(2*radius+1) windows centered at
+  /// every pixel of row y. mean and variance are vectors of getWidth()
+  /// components, variance could be 0 when only the means are needed.
+  void localMeanVariance(int y, int radius, float *mean, float *variance,
+			 BorderMode mode=CLIP_WINDOW,
+			 double border_value=0.0) const;
+
+ private:
+  int width, height, stride;
+  double *sums, *squares;
+
+  double rectangle(const double *table,
+		   int x0, int y0, int x1, int y1) const {
+    const double *top    = table + y0*stride;
+    const double *bottom = table + (y1+1)*stride;
+    return bottom[x1+1] - bottom[x0] - top[x1+1] + top[x0];
+  }
+};
+
+/*** Implementacion ***/
+#include "integral_image.cc"
+
+#endif // INTEGRAL_IMAGE_H
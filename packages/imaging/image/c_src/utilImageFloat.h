@@ -24,10 +24,12 @@
 #include "utilMatrixFloat.h"
 #include "matrix.h"
 #include "image.h"
+#include "integral_image.h"
 #include "floatrgb.h"
 
 typedef Image<float> ImageFloat;
 typedef Image<FloatRGB> ImageFloatRGB;
+typedef IntegralImage<float> IntegralImageFloat;
 
 ImageFloat *RGB_to_grayscale(ImageFloatRGB *src);
 ImageFloatRGB *grayscale_to_RGB(ImageFloat *src);
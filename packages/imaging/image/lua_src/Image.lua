@@ -13,9 +13,8 @@ end
 function Image.load_pgm_gz(filename)
 	fprintf(io.stderr, "WARNING: Image.load_pgm_gz() is deprecated!\n"..
 	                   "Use ImageIO instead.\n")
-	local f=io.popen("zcat "..filename)
-	local s=f:read("*a")
-	f:close()
+	-- gzip files are decompressed whatever their name is, as zcat did
+	local s=util.read_file(filename, true) or error("Unable to open "..filename)
 	return Image(matrix.fromPNM(s))
 end
 
@@ -18,6 +18,7 @@
      depends = "init",
      copy{ file= "c_src/*.h", dest_dir = "include" },
      copy{ file= "c_src/image.cc", dest_dir = "include" },
+     copy{ file= "c_src/integral_image.cc", dest_dir = "include" },
      provide_bind{ file = "binding/bind_image.lua.cc", dest_dir = "include" },
      provide_bind{ file = "binding/bind_image_RGB.lua.cc", dest_dir = "include" },
    },
@@ -31,6 +32,16 @@
        dest_dir = "build",
        --debug = "yes",
      },
+     object{ 
+       file = "c_src/integral_image.cc",
+       include_dirs = "${include_dirs}",
+       dest_dir = "build",
+     },
+     object{ 
+       file = "c_src/image_row_sink.cc",
+       include_dirs = "${include_dirs}",
+       dest_dir = "build",
+     },
      object{ 
        file = "c_src/utilImageFloat.cc",
        include_dirs = "${include_dirs}",
@@ -0,0 +1,62 @@
+-- Checks image.integral_image sums and local means/variances against a naive
+-- computation over the windows
+local rnd = random(4321)
+
+local function random_image(w, h)
+  local m = matrix(h, w)
+  for y=1,h do for x=1,w do m:set(y,x, rnd:rand()) end end
+  return Image(m)
+end
+
+local function naive(img, x0, y0, x1, y1, border_value)
+  local w,h = img:geometry()
+  local s, s2, n = 0, 0, 0
+  for y=y0,y1 do
+    for x=x0,x1 do
+      local v
+      if x >= 0 and y >= 0 and x < w and y < h then v = img:getpixel(x,y)
+      else v = border_value end
+      if v then s, s2, n = s + v, s2 + v*v, n + 1 end
+    end
+  end
+  return s, s2, n
+end
+
+local function check_windows(img, radius, border_value, step)
+  local w,h = img:geometry()
+  local mean, variance = image.integral_image(img):local_mean_variance(radius,
+								     border_value)
+  for y=0,h-1,step do
+    for x=0,w-1,step do
+      local s, s2, n = naive(img, x-radius, y-radius, x+radius, y+radius,
+			     border_value)
+      local m = s/n
+      assert(math.abs(mean:get(y+1,x+1) - m) < 1e-5)
+      assert(math.abs(variance:get(y+1,x+1) - math.max(0, s2/n - m*m)) < 1e-5)
+    end
+  end
+end
+
+-- small image, windows larger than the image
+local img = random_image(7, 5)
+local integral = image.integral_image(img)
+for _,r in ipairs{ {0,0,6,4}, {2,1,3,3}, {4,4,4,4} } do
+  local s, s2 = naive(img, r[1], r[2], r[3], r[4])
+  assert(math.abs(integral:sum(r[1], r[2], r[3], r[4]) - s) < 1e-6)
+  assert(math.abs(integral:sum_of_squares(r[1], r[2], r[3], r[4]) - s2) < 1e-6)
+end
+for _,radius in ipairs{ 0, 1, 3, 8 } do
+  check_windows(img, radius, nil, 1)
+  check_windows(img, radius, 1.0, 1)
+end
+
+-- a large image, computed by bands of rows in worker threads, and a crop of it
+local img = random_image(310, 230)
+local integral = image.integral_image(img)
+local s = naive(img, 0, 0, 309, 229)
+assert(math.abs(integral:sum(0, 0, 309, 229) - s) < 1e-6)
+local s = naive(img, 17, 31, 250, 200)
+assert(math.abs(integral:sum(17, 31, 250, 200) - s) < 1e-6)
+check_windows(img, 5, 1.0, 23)
+check_windows(img:crop(100, 90, 40, 33), 4, nil, 7)
+print("OK")
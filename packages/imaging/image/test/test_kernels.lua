@@ -0,0 +1,37 @@
+-- convolution5x5 and rotate90 over a cropped image, compared with the
+-- pixel by pixel definition
+rnd = random(4321)
+m = matrix(90, 120)
+t = {}
+for i=1,90*120 do t[i] = rnd:rand() end
+m:copy_from_table(t)
+img = Image(m, "100x70+7+9")
+w,h = img:geometry()
+
+k = {}
+for i=1,25 do k[i] = rnd:rand() - 0.5 end
+conv = img:convolution5x5(k, 0.25)
+for y=0,h-1,3 do
+  for x=0,w-1,3 do
+    local v = 0
+    for j=0,4 do
+      for i=0,4 do
+	local xx, yy = x+i-2, y+j-2
+	local p = 0.25
+	if xx >= 0 and yy >= 0 and xx < w and yy < h then p = img:getpixel(xx,yy) end
+	v = v + p*k[j*5+i+1]
+      end
+    end
+    assert(math.abs(v - conv:getpixel(x,y)) < 1e-5)
+  end
+end
+
+cw  = img:rotate90cw(1)
+ccw = img:rotate90cw(-1)
+for y=0,h-1 do
+  for x=0,w-1 do
+    assert(cw:getpixel(h-1-y, x) == img:getpixel(x,y))
+    assert(ccw:getpixel(y, w-1-x) == img:getpixel(x,y))
+  end
+end
+print("OK")
@@ -24,9 +24,13 @@
 #include <errno.h>
 #include <stdio.h>
 #include "image_cleaning.h"
+#include "neural_filter.h"
+#include "bind_ann_base.h"
 #include "bind_dataset.h"
 #include "bind_image.h"
 #include "bind_matrix.h"
+
+using namespace ANN;
 //BIND_END
 
 
@@ -119,12 +123,13 @@
     
     LUABIND_CHECK_ARGN(==,2);
     LUABIND_GET_PARAMETER(1, int, gray_levels);
-    LUABIND_GET_PARAMETER(1, int, radius);
+    LUABIND_GET_PARAMETER(2, int, radius);
 
-    ImageHistogram *hist = new ImageHistogram(obj, gray_levels);
-    MatrixFloat *mHist = hist->generateWindowHistogram(radius);
+    WindowHistogramStream *hist = new WindowHistogramStream(obj, gray_levels, radius);
+    IncRef(hist);
+    MatrixFloat *mHist = hist->generateWindowHistogram();
 
-    delete hist;
+    DecRef(hist);
     LUABIND_RETURN(MatrixFloat, mHist);
 }
 //BIND_END
@@ -184,3 +189,94 @@
 //BIND_END
 //////////////////////////////////////////////////////////////////////
 
+//BIND_LUACLASSNAME WindowHistogramStream image.window_histogram
+//BIND_CPP_CLASS    WindowHistogramStream
+
+//BIND_CONSTRUCTOR WindowHistogramStream
+//DOC_BEGIN
+// window_histogram(img, gray_levels, radius)
+/// Streaming computation of the window histograms of img, row by row, which
+/// only keeps one histogram per column
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 3);
+  ImageFloat *img;
+  int gray_levels, radius;
+  LUABIND_GET_PARAMETER(1, ImageFloat, img);
+  LUABIND_GET_PARAMETER(2, int, gray_levels);
+  LUABIND_GET_PARAMETER(3, int, radius);
+  obj = new WindowHistogramStream(img, gray_levels, radius);
+  LUABIND_RETURN(WindowHistogramStream, obj);
+}
+//BIND_END
+
+//BIND_METHOD WindowHistogramStream reset
+//DOC_BEGIN
+// Restarts the stream at the first row
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 0);
+  obj->reset();
+}
+//BIND_END
+
+//BIND_METHOD WindowHistogramStream next_rows
+//DOC_BEGIN
+// Returns a num_rows x width x gray_levels matrix with the window histograms
+// of the next num_rows rows (1 by default), or nil when the image is finished
+//DOC_END
+{
+  int num_rows;
+  LUABIND_CHECK_ARGN(<=, 1);
+  LUABIND_GET_OPTIONAL_PARAMETER(1, int, num_rows, 1);
+  if (num_rows > obj->getHeight() - obj->getCurrentRow())
+    num_rows = obj->getHeight() - obj->getCurrentRow();
+  if (num_rows <= 0) LUABIND_RETURN_NIL();
+  else {
+    int dims[3] = { num_rows, obj->getWidth(), obj->grayLevels() };
+    MatrixFloat *m = new MatrixFloat(3, dims);
+    obj->nextRows(num_rows, m->getRawDataAccess()->getPPALForWrite());
+    LUABIND_RETURN(MatrixFloat, m);
+  }
+}
+//BIND_END
+
+//BIND_METHOD WindowHistogramStream get_current_row
+//DOC_BEGIN
+// Returns the next row (0-based) which next_rows will compute
+//DOC_END
+{
+  LUABIND_RETURN(int, obj->getCurrentRow());
+}
+//BIND_END
+
+//BIND_FUNCTION image.image_cleaning.apply_neural_filter
+//DOC_BEGIN
+// apply_neural_filter(img, neighbors, component, histogram, bunch_size, num_threads=1)
+/// Applies the component as a sliding-window filter over img, returning the
+/// filtered image. The input of each pixel is its window of
+/// (2*neighbors+1)^2 pixels (1 outside the image), followed by its window
+/// histogram when histogram is a image.window_histogram of img (or nil).
+/// The windows are copied directly into the bunches, which are computed in
+/// parallel by num_threads clones of the component.
+//DOC_END
+{
+  ImageFloat   *img;
+  int           neighbors;
+  ANNComponent *component;
+  WindowHistogramStream *histogram = 0;
+  unsigned int  bunch_size, num_threads;
+  LUABIND_CHECK_ARGN(>=, 5);
+  LUABIND_CHECK_ARGN(<=, 6);
+  LUABIND_GET_PARAMETER(1, ImageFloat, img);
+  LUABIND_GET_PARAMETER(2, int, neighbors);
+  LUABIND_GET_PARAMETER(3, ANNComponent, component);
+  if (!lua_isnil(L, 4))
+    LUABIND_GET_PARAMETER(4, WindowHistogramStream, histogram);
+  LUABIND_GET_PARAMETER(5, uint, bunch_size);
+  LUABIND_GET_OPTIONAL_PARAMETER(6, uint, num_threads, 1);
+  ImageFloat *result = NeuralFilter::apply(img, neighbors, component, histogram,
+					   bunch_size, num_threads);
+  LUABIND_RETURN(ImageFloat, result);
+}
+//BIND_END
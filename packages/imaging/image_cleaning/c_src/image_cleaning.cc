@@ -253,3 +253,78 @@ Matrix<float> * ImageHistogram::getIntegralHistogram(){
     return matrix;
 }
 
+WindowHistogramStream::WindowHistogramStream(ImageFloat *img, int gray_levels,
+                                             int radius) :
+    img(img), gray_levels(gray_levels), radius(radius) {
+    if (gray_levels <= 0)
+        ERROR_EXIT(128, "Incorrect number of gray levels\n");
+    if (radius < 0)
+        ERROR_EXIT(128, "Incorrect negative radius\n");
+    IncRef(img);
+    width  = img->width;
+    height = img->height;
+    column_histogram = new int[width*gray_levels];
+    window_histogram = new int[gray_levels];
+    reset();
+}
+
+WindowHistogramStream::~WindowHistogramStream() {
+    DecRef(img);
+    delete[] column_histogram;
+    delete[] window_histogram;
+}
+
+void WindowHistogramStream::reset() {
+    current_row = 0;
+    memset(column_histogram, 0, width*gray_levels*sizeof(int));
+    for (int y = 0; y < height && y <= radius; ++y)
+        updateColumns(y, 1);
+}
+
+void WindowHistogramStream::updateColumns(int y, int sign) {
+    const float *row = img->row_ptr(y);
+    for (int x = 0; x < width; ++x)
+        column_histogram[x*gray_levels + getIndex(row[x], gray_levels)] += sign;
+}
+
+void WindowHistogramStream::nextRows(int num_rows, float *dest) {
+    using april_utils::max;
+    using april_utils::min;
+    if (current_row + num_rows > height)
+        ERROR_EXIT2(128, "Row %d out of the image height %d\n",
+                    current_row + num_rows - 1, height);
+    for (int r = 0; r < num_rows; ++r, ++current_row) {
+        const int i = current_row;
+        // the column histograms of the first row are computed at reset
+        if (i > 0) {
+            if (i + radius < height) updateColumns(i + radius, 1);
+            if (i - radius - 1 >= 0) updateColumns(i - radius - 1, -1);
+        }
+        const int rows = min(height - 1, i + radius) - max(0, i - radius) + 1;
+        memset(window_histogram, 0, gray_levels*sizeof(int));
+        for (int x = 0; x < width && x <= radius; ++x)
+            updateWindow(x, 1);
+        for (int j = 0; j < width; ++j, dest += gray_levels) {
+            if (j > 0) {
+                if (j + radius < width) updateWindow(j + radius, 1);
+                if (j - radius - 1 >= 0) updateWindow(j - radius - 1, -1);
+            }
+            // Normalize by size
+            const int cols = min(width - 1, j + radius) - max(0, j - radius) + 1;
+            const int size = rows*cols;
+            for (int h = 0; h < gray_levels; ++h)
+                dest[h] = (float)window_histogram[h]/size;
+        }
+    }
+}
+
+Matrix<float> *WindowHistogramStream::generateWindowHistogram() {
+    int dims[3];
+    dims[0] = height;
+    dims[1] = width;
+    dims[2] = gray_levels;
+    Matrix<float> *matrix = new Matrix<float>(3, dims);
+    reset();
+    nextRows(height, matrix->getRawDataAccess()->getPPALForWrite());
+    return matrix;
+}
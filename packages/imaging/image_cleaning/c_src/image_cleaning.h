@@ -128,4 +128,51 @@ class ImageHistogram : public Referenced {
         // ImageHistogram* clone();
 };
 
+/**
+  Computes the window histograms of an image row by row, in the same way as
+  ImageHistogram::generateWindowHistogram (windows are clipped to the image
+  and normalized by their size). Following Perreault and Hebert, it keeps
+  one histogram per column over the rows of the current window, which are
+  updated incrementally, so it needs O(width*levels) memory instead of the
+  O(width*height*levels) of the integral histogram.
+ **/
+class WindowHistogramStream : public Referenced {
+    ImageFloat *img;
+    int gray_levels, radius;
+    int width, height;
+    /// Next row to be computed
+    int current_row;
+    /// Counters of the window rows at each column, width x gray_levels
+    int *column_histogram;
+    /// Counters of the current window, gray_levels
+    int *window_histogram;
+
+    /// Adds (sign=1) or removes (sign=-1) the pixels of row y to the column
+    /// histograms
+    void updateColumns(int y, int sign);
+    inline void updateWindow(int x, int sign) {
+        const int *col = column_histogram + x*gray_levels;
+        for (int h = 0; h < gray_levels; ++h)
+            window_histogram[h] += sign*col[h];
+    }
+
+    public:
+        WindowHistogramStream(ImageFloat *img, int gray_levels, int radius);
+        ~WindowHistogramStream();
+
+        int grayLevels() const { return gray_levels; }
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+        /// Returns the next row which nextRows will compute
+        int getCurrentRow() const { return current_row; }
+        /// Restarts the stream at the first row
+        void reset();
+        /// Writes at dest the window histograms of the next num_rows rows,
+        /// width*gray_levels floats by row
+        void nextRows(int num_rows, float *dest);
+        /// Returns a height x width x gray_levels matrix with all the window
+        /// histograms, as ImageHistogram::generateWindowHistogram
+        Matrix<float> *generateWindowHistogram();
+};
+
 #endif
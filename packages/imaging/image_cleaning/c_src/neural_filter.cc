@@ -0,0 +1,201 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Joan Pastor- Pellicer, Salvador España-Boquera, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include <cstring>
+#include "neural_filter.h"
+#include "component_replicas.h"
+#include "token_memory_block.h"
+#include "parallel_for.h"
+#include "error_print.h"
+
+using namespace ANN;
+
+/// Value of the pixels outside the image (white)
+#define NEURAL_FILTER_DEFAULT_VALUE 1.0f
+/// Number of bunches of each worker in a stripe of rows, when the window
+/// histograms are computed stripe by stripe
+#define NEURAL_FILTER_BUNCHES_PER_WORKER 16
+
+namespace NeuralFilterInternal {
+
+  /// Fills value in dest[0..n-1]
+  static inline void fill(float *dest, unsigned int n, float value) {
+    for (unsigned int i=0; i<n; ++i) dest[i] = value;
+  }
+
+  /// Forward of the bunches of consecutive pixels of a stripe, distributed in
+  /// contiguous blocks among the replicas. Every worker writes disjoint pixels
+  /// of the result, so no synchronization is needed.
+  struct FilterRound {
+    ComponentReplicas *replicas;
+    const float  *src;      // pixel (0,0) of the source image
+    float        *dest;     // pixel (0,0) of the result (contiguous)
+    const float  *features; // stripe pixels x num_features, or NULL
+    int           src_stride, width, height, neighbors;
+    unsigned int  num_features, bunch_size;
+    unsigned int  first_pixel, num_pixels; // the stripe
+    
+    /// Copies into mem (pattern_size x n, pattern-major as expected by the
+    /// components) the input of the n pixels starting at pixel p
+    void im2col(unsigned int p, unsigned int n, float *mem) const {
+      const int side = 2*neighbors + 1;
+      unsigned int pos = 0;
+      while (pos < n) {
+	const int y  = static_cast<int>((p + pos) / width);
+	const int x0 = static_cast<int>((p + pos) % width);
+	unsigned int len = static_cast<unsigned int>(width - x0);
+	if (len > n - pos) len = n - pos;
+	float *col = mem + pos;
+	for (int dy=-neighbors; dy<=neighbors; ++dy) {
+	  const int yy = y + dy;
+	  for (int dx=-neighbors; dx<=neighbors; ++dx, col += n) {
+	    if (yy < 0 || yy >= height) {
+	      fill(col, len, NEURAL_FILTER_DEFAULT_VALUE);
+	      continue;
+	    }
+	    // columns [x0+dx, x0+dx+len) of row yy, splitted in the left
+	    // outside part, the inside part and the right outside part
+	    const int first = x0 + dx;
+	    const int last  = first + static_cast<int>(len);
+	    unsigned int left  = (first < 0) ? static_cast<unsigned int>(-first) : 0;
+	    unsigned int right = (last > width) ? static_cast<unsigned int>(last - width) : 0;
+	    if (left > len)  left  = len;
+	    if (right > len - left) right = len - left;
+	    fill(col, left, NEURAL_FILTER_DEFAULT_VALUE);
+	    memcpy(col + left, src + yy*src_stride + first + left,
+		   sizeof(float)*(len - left - right));
+	    fill(col + len - right, right, NEURAL_FILTER_DEFAULT_VALUE);
+	  }
+	}
+	if (features != 0) {
+	  const float *f = features +
+	    static_cast<size_t>(p + pos - first_pixel)*num_features;
+	  float *fcol = mem + static_cast<size_t>(side*side)*n + pos;
+	  for (unsigned int k=0; k<num_features; ++k, fcol += n)
+	    for (unsigned int i=0; i<len; ++i)
+	      fcol[i] = f[i*num_features + k];
+	}
+	pos += len;
+      }
+    }
+    
+    void operator()(unsigned int w) {
+      ANNComponent *component = replicas->get(w);
+      const unsigned int num_bunches = (num_pixels + bunch_size - 1) / bunch_size;
+      const unsigned int first = (num_bunches * w) / replicas->size();
+      const unsigned int last  = (num_bunches * (w+1)) / replicas->size();
+      const unsigned int pattern_size = component->getInputSize();
+      TokenMemoryBlock *input = new TokenMemoryBlock(bunch_size*pattern_size);
+      IncRef(input);
+      for (unsigned int b=first; b<last; ++b) {
+	const unsigned int p = first_pixel + b*bunch_size;
+	unsigned int n = first_pixel + num_pixels - p;
+	if (n > bunch_size) n = bunch_size;
+	// the component releases the previous input before it is overwritten
+	component->reset();
+	input->resize(n*pattern_size);
+	im2col(p, n, input->getMemBlock()->getPPALForWrite());
+	Token *output = component->doForward(input, false);
+	if (output->getTokenCode() != table_of_token_codes::token_mem_block)
+	  ERROR_EXIT(128, "Incorrect token type, expected token memory block\n");
+	TokenMemoryBlock *output_mem_block = output->convertTo<TokenMemoryBlock*>();
+	// only one output, so the bunch is contiguous
+	memcpy(dest + p, output_mem_block->getMemBlock()->getPPALForRead(),
+	       sizeof(float)*n);
+      }
+      component->reset();
+      DecRef(input);
+    }
+  };
+
+}
+
+ImageFloat *NeuralFilter::apply(ImageFloat *img, int neighbors,
+				ANNComponent *component,
+				WindowHistogramStream *histogram,
+				unsigned int bunch_size,
+				unsigned int num_threads) {
+  if (bunch_size == 0)
+    ERROR_EXIT(128, "Impossible to use ZERO bunch_size\n");
+  if (neighbors < 0)
+    ERROR_EXIT(128, "Incorrect negative number of neighbors\n");
+  if (!component->getIsBuilt())
+    ERROR_EXIT(128, "The neural filter needs a built component\n");
+  const int side = 2*neighbors + 1;
+  unsigned int num_features = 0;
+  if (histogram != 0) {
+    if (histogram->getWidth() != img->width ||
+	histogram->getHeight() != img->height)
+      ERROR_EXIT2(128, "Window histogram must be of a %dx%d image\n",
+		  img->width, img->height);
+    num_features = static_cast<unsigned int>(histogram->grayLevels());
+  }
+  if (component->getInputSize() != static_cast<unsigned int>(side*side) + num_features)
+    ERROR_EXIT2(128, "Incorrect component input size, expected %u, found %u\n",
+		static_cast<unsigned int>(side*side) + num_features,
+		component->getInputSize());
+  if (component->getOutputSize() != 1)
+    ERROR_EXIT1(128, "Incorrect component output size, expected 1, found %u\n",
+		component->getOutputSize());
+  ImageFloat *result = new ImageFloat(img->width, img->height, 0.0f);
+  // more replicas than bunches are useless, and quantized weights are not
+  // shared among replicas
+  unsigned int num_pixels  = static_cast<unsigned int>(img->width*img->height);
+  unsigned int num_bunches = (num_pixels + bunch_size - 1) / bunch_size;
+  if (num_threads > num_bunches) num_threads = num_bunches;
+  if (num_threads == 0 || ComponentReplicas::isQuantized(component))
+    num_threads = 1;
+  ComponentReplicas replicas(component, num_threads);
+  // without histograms all the image is one stripe
+  int stripe_rows = img->height;
+  float *features = 0;
+  if (histogram != 0) {
+    stripe_rows = static_cast<int>((num_threads*NEURAL_FILTER_BUNCHES_PER_WORKER*
+				    bunch_size) / img->width);
+    if (stripe_rows < 1) stripe_rows = 1;
+    if (stripe_rows > img->height) stripe_rows = img->height;
+    features = new float[static_cast<size_t>(stripe_rows)*img->width*num_features];
+    histogram->reset();
+  }
+  NeuralFilterInternal::FilterRound round;
+  round.replicas     = &replicas;
+  round.src          = img->row_ptr(0);
+  round.src_stride   = img->row_stride();
+  round.dest         = result->row_ptr(0);
+  round.features     = features;
+  round.width        = img->width;
+  round.height       = img->height;
+  round.neighbors    = neighbors;
+  round.num_features = num_features;
+  round.bunch_size   = bunch_size;
+  // the same threads compute all the stripes
+  april_utils::WorkerThreads threads(replicas.size());
+  for (int y=0; y<img->height; y+=stripe_rows) {
+    int num_rows = img->height - y;
+    if (num_rows > stripe_rows) num_rows = stripe_rows;
+    if (histogram != 0) histogram->nextRows(num_rows, features);
+    round.first_pixel = static_cast<unsigned int>(y*img->width);
+    round.num_pixels  = static_cast<unsigned int>(num_rows*img->width);
+    threads.run(round);
+  }
+  delete[] features;
+  return result;
+}
@@ -0,0 +1,54 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Joan Pastor- Pellicer, Salvador España-Boquera, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef NEURAL_FILTER_H
+#define NEURAL_FILTER_H
+
+#include "utilImageFloat.h"
+#include "image_cleaning.h"
+#include "ann_component.h"
+
+/**
+   Applies an ANN component as a sliding-window filter over an image. The
+   input of each pixel is its (2*neighbors+1)x(2*neighbors+1) window (row
+   major, pixels outside the image are 1, the white value), followed by the
+   optional window histogram of the pixel. The component must have one
+   output, which is the value of the pixel in the result.
+
+   It computes the same as applying the component with use_dataset over a
+   dataset.matrix of windows, but windows are copied directly from image
+   rows into the bunch memory (im2col), bunches are formed by consecutive
+   pixels in row-major order, and they are distributed among num_threads
+   replicas of the component. Each replica has its own thread during all the
+   image, num_threads is not limited by util.set_num_threads. The image is
+   processed in stripes of rows, so only the window histograms of one stripe
+   are in memory.
+ **/
+class NeuralFilter {
+public:
+  static ImageFloat *apply(ImageFloat *img, int neighbors,
+			   ANN::ANNComponent *component,
+			   WindowHistogramStream *histogram,
+			   unsigned int bunch_size,
+			   unsigned int num_threads=1);
+};
+
+#endif // NEURAL_FILTER_H
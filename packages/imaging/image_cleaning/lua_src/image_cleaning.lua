@@ -1,11 +1,26 @@
 image = image or {}
 image.image_cleaning = image.image_cleaning or {}
 
+local DEFAULT_BUNCH_SIZE = 256
+
+-- Returns the C++ component of clean_net (a trainer, a ann.mlp.all_all
+-- wrapper or a component), which image.image_cleaning.apply_neural_filter
+-- needs, or nil if it is not a C++ object
+local function get_native_component(clean_net)
+  local component = clean_net
+  if type(component) == "table" and
+  type(component.get_component) == "function" then
+    component = component:get_component()
+  end
+  if type(component) == "table" then component = component.thenet end
+  if isa(component, ann.components.base) then return component end
+end
 
--- Apply neural filter to an image
-function image.image_cleaning.apply_filter_std(img, neighbors, clean_net)
-  
-
+-- Applies clean_net over the windows dataset (and the features dataset, if
+-- given), when it couldn't be applied by image.image_cleaning.apply_neural_filter.
+-- The num_threads, if given, is passed to clean_net:use_dataset
+local function apply_filter_dataset(img, neighbors, clean_net, mFeatures,
+				    bunch_size, num_threads)
   -- Generate the dataset
   local mImg = img:matrix()
   local tDim = mImg:dim()
@@ -22,6 +37,18 @@ function image.image_cleaning.apply_filter_std(img, neighbors, clean_net)
   }
 
   local dsInput = dataset.matrix(mImg, dsParams)
+  if mFeatures then
+    local levels = mFeatures:dim()[3]
+    local dsFeatures = dataset.matrix(mFeatures, {
+					patternSize  = {1, 1, levels},
+					stepSize     = {1, 1, levels},
+					numSteps     = { mFeatures:dim()[1],
+							 mFeatures:dim()[2], 1 },
+					defaultValue = 0,
+					circular     = {false, false, false}
+				      })
+    dsInput = dataset.join{dsInput, dsFeatures}
+  end
 
   -- Generate output dataset
   local mClean = matrix(tDim[1], tDim[2])
@@ -38,7 +65,9 @@ function image.image_cleaning.apply_filter_std(img, neighbors, clean_net)
   --
   clean_net:use_dataset {
       input_dataset  = dsInput,
-      output_dataset = dsClean
+      output_dataset = dsClean,
+      bunch_size     = bunch_size,
+      num_threads    = num_threads,
   }
 
   local imgClean = Image(mClean)
@@ -46,56 +75,39 @@ function image.image_cleaning.apply_filter_std(img, neighbors, clean_net)
   return imgClean
 end
 
--- Apply neural filter to an image
-function image.image_cleaning.apply_filter_histogram(img, neighbors, levels, radius, clean_net)
-  local mImg = img:matrix()
-  local tDim = mImg:dim()
-
-  -- Compute image histogram
-  local side  = neighbors*2 + 1
-  local mHist = img:get_window_histogram(levels, radius)
-  
-  -- Generate the dataset
-  local dsParams = {
-     patternSize  = { side, side },
-     offset       = { -neighbors, -neighbors },
-     stepSize     = { 1,1 },
-     numSteps     = tDim,
-     defaultValue = 1,
-     circular     = { false, false }
-  }
-
-  local dsHist = {
-     patternSize  = {1, 1, levels},
-     stepSize     = {1, 1, levels},
-     numSteps     = { mHist:dim()[1], mHist:dim()[2],1 },
-     defaultValue = 0,
-     circular     = {false, false, false}
-  }
-
-  local dsDirty = dataset.matrix(mImg, dsParams)
-  local dsHist  = dataset.matrix(mHist, dsHist)
-  
-  local dsInput = dataset.join{dsDirty, dsHist}
-
-  -- Generate output dataset
-  local mClean = matrix(tDim[1], tDim[2])
-  local paramsClean = {
-     patternSize  = {1, 1},
-     stepSize     = {1, 1},
-     numSteps     = { tDim[1], tDim[2] },
-     defaultValue = 0,
-  }
-
-  local dsClean = dataset.matrix(mClean, paramsClean)
-  --Apply the net to the dataset
-  --
-  clean_net:use_dataset {
-      input_dataset  = dsInput,
-      output_dataset = dsClean
-  }
+-- Applies clean_net natively when it is a C++ component, otherwise through
+-- datasets. The window histograms are used when levels is given, the native
+-- filter computes them by stripes of rows with a image.window_histogram
+local function apply_filter(img, neighbors, clean_net, levels, radius,
+			    bunch_size, num_threads)
+  local component = get_native_component(clean_net)
+  if component then
+    local histogram = levels and image.window_histogram(img, levels, radius)
+    bunch_size = bunch_size or clean_net.bunch_size or DEFAULT_BUNCH_SIZE
+    return image.image_cleaning.apply_neural_filter(img, neighbors, component,
+						    histogram or nil, bunch_size,
+						    num_threads or util.get_num_threads())
+  end
+  local mHist = levels and img:get_window_histogram(levels, radius)
+  return apply_filter_dataset(img, neighbors, clean_net, mHist or nil,
+			      bunch_size, num_threads)
+end
 
-  local imgClean = Image(mClean)
+-- Apply neural filter to an image. The optional bunch_size and num_threads
+-- are used when clean_net is a C++ component (or a trainer of it), which is
+-- applied natively by image.image_cleaning.apply_neural_filter. Otherwise
+-- they are given to clean_net:use_dataset
+function image.image_cleaning.apply_filter_std(img, neighbors, clean_net,
+					       bunch_size, num_threads)
+  return apply_filter(img, neighbors, clean_net, nil, nil,
+		      bunch_size, num_threads)
+end
 
-  return imgClean
+-- Apply neural filter to an image, using as additional input the window
+-- histogram of each pixel
+function image.image_cleaning.apply_filter_histogram(img, neighbors, levels, radius,
+						     clean_net,
+						     bunch_size, num_threads)
+  return apply_filter(img, neighbors, clean_net, levels, radius,
+		      bunch_size, num_threads)
 end
@@ -0,0 +1,58 @@
+-- Checks that image.image_cleaning.apply_neural_filter (native sliding-window
+-- filter) computes the same image than the use_dataset filter
+local width, height, neighbors = 17, 13, 1
+local side = 2*neighbors + 1
+local rnd  = random(1234)
+local m    = matrix(height, width)
+for i=1,height do for j=1,width do m:set(i,j, rnd:rand()) end end
+local img  = Image(m)
+
+local function new_trainer(isz)
+  local net = ann.mlp.all_all.generate(isz.." inputs 5 tanh 1 logistic")
+  local tr  = trainable.supervised_trainer(net, nil, 16)
+  tr:build()
+  tr:randomize_weights{ random=random(52), inf=-0.5, sup=0.5 }
+  return tr
+end
+
+-- a pure Lua object which forces the use_dataset filter
+local function lua_wrapper(tr)
+  return { use_dataset = function(self, t) return tr:use_dataset(t) end }
+end
+
+local function check(a, b)
+  local ma, mb = a:matrix(), b:matrix()
+  for i=1,height do
+    for j=1,width do
+      assert(math.abs(ma:get(i,j) - mb:get(i,j)) < 1e-5)
+    end
+  end
+end
+
+local tr  = new_trainer(side*side)
+local ref = image.image_cleaning.apply_filter_std(img, neighbors, lua_wrapper(tr))
+-- the use_dataset filter receives num_threads too
+local num_threads_given
+local wrapper = lua_wrapper(tr)
+function wrapper:use_dataset(t)
+  num_threads_given = t.num_threads
+  return tr:use_dataset(t)
+end
+check(ref, image.image_cleaning.apply_filter_std(img, neighbors, wrapper, nil, 3))
+assert(num_threads_given == 3)
+for _,bunch_size in ipairs{ 1, 5, 16, width*height + 3 } do
+  for _,num_threads in ipairs{ 1, 3 } do
+    check(ref, image.image_cleaning.apply_filter_std(img, neighbors, tr,
+						     bunch_size, num_threads))
+  end
+end
+
+local levels = 4
+local tr  = new_trainer(side*side + levels)
+local ref = image.image_cleaning.apply_filter_histogram(img, neighbors, levels, 2,
+							lua_wrapper(tr))
+for _,num_threads in ipairs{ 1, 3 } do
+  check(ref, image.image_cleaning.apply_filter_histogram(img, neighbors, levels, 2,
+							 tr, 7, num_threads))
+end
+print("OK")
@@ -0,0 +1,36 @@
+-- Checks that the streaming window histograms (image.window_histogram) are
+-- equal to the ones computed with the integral histogram
+local width, height, levels = 11, 9, 4
+local rnd = random(825)
+local m   = matrix(height, width)
+for i=1,height do for j=1,width do m:set(i,j, rnd:rand()) end end
+m:set(1,1, 1.0)
+local img = Image(m)
+
+local function check(a, b, first_row)
+  for i=1,a:dim()[1] do
+    for j=1,width do
+      for h=1,levels do
+	assert(a:get(i,j,h) == b:get(first_row + i - 1,j,h))
+      end
+    end
+  end
+end
+
+for _,radius in ipairs{ 0, 1, 3 } do
+  local ref = image.image_histogram(img, levels):generate_window_histogram(radius)
+  check(img:get_window_histogram(levels, radius), ref, 1)
+  local stream = image.window_histogram(img, levels, radius)
+  local row = 1
+  for _,n in ipairs{ 1, 3, 5 } do
+    assert(stream:get_current_row() == row - 1)
+    local rows = stream:next_rows(n)
+    check(rows, ref, row)
+    row = row + rows:dim()[1]
+  end
+  assert(row == height + 1)
+  assert(stream:next_rows() == nil)
+  stream:reset()
+  check(stream:next_rows(height), ref, 1)
+end
+print("OK")
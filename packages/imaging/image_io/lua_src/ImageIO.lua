@@ -25,6 +25,36 @@ function ImageIO.read(filename, img_format)
   end
 end
 
+-- ImageIO.read_gray: Reads a grayscale image from a file, decoded directly
+-- to gray when the format handler has a read_gray function.
+--
+-- params:
+--   filename: name of the image file to be read
+--   params[optional]: table with the region of interest (x, y, width,
+--                     height) and the downscale factor, only for handlers
+--                     with read_gray
+--   img_format[optional, defaults to the file extension]: image format
+--
+-- return value: a Image, the same as ImageIO.read(filename):to_grayscale()
+--
+function ImageIO.read_gray(filename, params, img_format)
+  img_format = img_format or string.get_extension(filename)
+  img_format = string.lower(img_format)
+
+  local format_handler = ImageIO.handlers[img_format]
+
+  if format_handler == nil then
+    error(string.format("Image format '%s' not supported", img_format))
+  elseif format_handler.read_gray ~= nil then
+    return format_handler.read_gray(filename, params)
+  elseif params ~= nil then
+    error(string.format("Image format '%s' can't be read with params",
+			img_format))
+  else
+    return format_handler.read(filename):to_grayscale()
+  end
+end
+
 -- ImageIO.write: Writes a image to a file.
 --
 -- params:
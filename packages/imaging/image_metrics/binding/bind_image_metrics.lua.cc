@@ -25,6 +25,8 @@
 #include <stdio.h>
 #include "image_metrics.h"
 #include "bind_dataset.h"
+#include "bind_matrix.h"
+#include "bind_image.h"
 //BIND_END
 
 
@@ -68,6 +70,53 @@
 }
 //BIND_END
 
+//BIND_METHOD ImageMetrics process_matrix
+//DOC_BEGIN
+//Compute the comparition of two matrices (extracted from images) in one
+//vectorized and parallel pass, as process_dataset over dataset.matrix
+//
+//@param predicted matrix with the predicted values
+//@param ground_truth matrix with the ground_truth values
+//@param binary (optional) if enabled perform true/false comparision given a threshold
+//@param threshold Necessary for binary classification
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==,1);
+  check_table_fields(L, 1, "predicted", "ground_truth", "binary", "threshold", 0);
+  MatrixFloat *pred, *GT;
+  bool binary;
+  float threshold;
+  LUABIND_GET_TABLE_PARAMETER(1, predicted, MatrixFloat, pred);
+  LUABIND_GET_TABLE_PARAMETER(1, ground_truth, MatrixFloat, GT);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, binary, bool, binary, false);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, threshold, float, threshold, 0.5);
+  obj->processMatrix(pred,GT,binary,threshold);
+}
+//BIND_END
+
+//BIND_METHOD ImageMetrics process_image
+//DOC_BEGIN
+//Compute the comparition of two images in one vectorized and parallel pass
+//
+//@param predicted image with the predicted values
+//@param ground_truth image with the ground_truth values
+//@param binary (optional) if enabled perform true/false comparision given a threshold
+//@param threshold Necessary for binary classification
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==,1);
+  check_table_fields(L, 1, "predicted", "ground_truth", "binary", "threshold", 0);
+  ImageFloat *pred, *GT;
+  bool binary;
+  float threshold;
+  LUABIND_GET_TABLE_PARAMETER(1, predicted, ImageFloat, pred);
+  LUABIND_GET_TABLE_PARAMETER(1, ground_truth, ImageFloat, GT);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, binary, bool, binary, false);
+  LUABIND_GET_TABLE_OPTIONAL_PARAMETER(1, threshold, float, threshold, 0.5);
+  obj->processImage(pred,GT,binary,threshold);
+}
+//BIND_END
+
 //BIND_METHOD ImageMetrics process_sample
 //DOC_BEGIN
 //compute only one sample
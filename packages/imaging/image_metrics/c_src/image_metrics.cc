@@ -22,7 +22,14 @@
 
 #include "error_print.h"
 #include "image_metrics.h"
+#include "parallel_for.h"
 #include <cmath>
+
+/// Number of independent accumulators of processBuffer, which allows the
+/// compiler to vectorize the loop
+#define IMAGE_METRICS_LANES 8
+/// Minimum number of samples of each parallel chunk
+#define IMAGE_METRICS_MIN_CHUNK 65536
 void ImageMetrics::processSample(float pred, float ref){
 
   double act_tp;
@@ -184,3 +191,160 @@ ImageMetrics* ImageMetrics::clone() {
             SSE, n_samples);
 }
 
+namespace ImageMetricsInternal {
+
+    /// Clamps v to [0,1], and binarizes it if needed
+    static inline float normalizeSample(float v, bool binary, float threshold) {
+        v = (v > 1.0f) ? 1.0f : v;
+        v = (v < 0.0f) ? 0.0f : v;
+        if (binary) v = (v <= threshold) ? 0.0f : 1.0f;
+        return v;
+    }
+
+    /// Sums over the n samples of p, r, p*r and (p-r)^2. The four
+    /// counters of processSample are linear combinations of these sums
+    template<bool binary>
+    static void accumulate(const float *pred, const float *ref, long int n,
+                           float threshold, double sums[4]) {
+        double sp[IMAGE_METRICS_LANES], sr[IMAGE_METRICS_LANES];
+        double spr[IMAGE_METRICS_LANES], sse[IMAGE_METRICS_LANES];
+        for (int j = 0; j < IMAGE_METRICS_LANES; ++j)
+            sp[j] = sr[j] = spr[j] = sse[j] = 0.0;
+        long int i = 0;
+        for (; i + IMAGE_METRICS_LANES <= n; i += IMAGE_METRICS_LANES) {
+            for (int j = 0; j < IMAGE_METRICS_LANES; ++j) {
+                double p = normalizeSample(pred[i+j], binary, threshold);
+                double r = normalizeSample(ref[i+j],  binary, threshold);
+                sp[j]  += p;
+                sr[j]  += r;
+                spr[j] += p*r;
+                sse[j] += (p-r)*(p-r);
+            }
+        }
+        for (; i < n; ++i) {
+            double p = normalizeSample(pred[i], binary, threshold);
+            double r = normalizeSample(ref[i],  binary, threshold);
+            sp[0]  += p;
+            sr[0]  += r;
+            spr[0] += p*r;
+            sse[0] += (p-r)*(p-r);
+        }
+        for (int j = 0; j < IMAGE_METRICS_LANES; ++j) {
+            sums[0] += sp[j];
+            sums[1] += sr[j];
+            sums[2] += spr[j];
+            sums[3] += sse[j];
+        }
+    }
+
+    /// Partial counters of a chunk of samples of two buffers
+    struct BufferChunks {
+        const float *pred, *ref;
+        long int n;
+        unsigned int num_chunks;
+        bool binary;
+        float threshold;
+        ImageMetrics *partials;
+        void operator()(unsigned int c) {
+            long int first = (n * c) / num_chunks;
+            long int last  = (n * (c+1)) / num_chunks;
+            partials[c].processBuffer(pred + first, ref + first, last - first,
+                                      binary, threshold);
+        }
+    };
+
+    /// Partial counters of a band of rows of two images
+    struct ImageBands {
+        const ImageFloat *pred, *ref;
+        unsigned int num_bands;
+        bool binary;
+        float threshold;
+        ImageMetrics *partials;
+        void operator()(unsigned int b) {
+            int first = static_cast<int>((static_cast<long int>(pred->height) * b) / num_bands);
+            int last  = static_cast<int>((static_cast<long int>(pred->height) * (b+1)) / num_bands);
+            for (int y = first; y < last; ++y)
+                partials[b].processBuffer(pred->row_ptr(y), ref->row_ptr(y),
+                                          pred->width, binary, threshold);
+        }
+    };
+
+    /// Returns m if it is contiguous and row-major, otherwise a copy of it
+    static MatrixFloat *getSimpleMatrix(MatrixFloat *m) {
+        if (m->isSimple()) return m;
+        if (m->getMajorOrder() == CblasColMajor) return m->clone(CblasRowMajor);
+        return m->clone();
+    }
+
+    /// Number of parallel chunks for n samples
+    static unsigned int numChunks(long int n) {
+        long int k = n / IMAGE_METRICS_MIN_CHUNK;
+        long int num_threads = april_utils::getNumWorkerThreads();
+        if (k > num_threads) k = num_threads;
+        return (k > 1) ? static_cast<unsigned int>(k) : 1;
+    }
+}
+
+void ImageMetrics::processBuffer(const float *pred, const float *ref, long int n,
+                                 bool binary, float threshold) {
+    double sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+    if (binary)
+        ImageMetricsInternal::accumulate<true>(pred, ref, n, threshold, sums);
+    else
+        ImageMetricsInternal::accumulate<false>(pred, ref, n, threshold, sums);
+    const double sp = sums[0], sr = sums[1], spr = sums[2];
+    //tp  (1-pred)*(1-ref)
+    true_positives  += static_cast<double>(n) - sp - sr + spr;
+    //fp  (1-pred)*ref
+    false_positives += sr - spr;
+    //tn  pred*ref
+    true_negatives  += spr;
+    //fn  pred*(1-ref)
+    false_negatives += sp - spr;
+    SSE += sums[3];
+    n_samples += n;
+}
+
+void ImageMetrics::processMatrix(MatrixFloat *pred, MatrixFloat *ref,
+                                 bool binary, float threshold) {
+    if (!pred->sameDim(ref))
+        ERROR_EXIT(128, "Image metrics: different matrix dimensions\n");
+    MatrixFloat *cpred = ImageMetricsInternal::getSimpleMatrix(pred);
+    MatrixFloat *cref  = ImageMetricsInternal::getSimpleMatrix(ref);
+    IncRef(cpred);
+    IncRef(cref);
+    ImageMetricsInternal::BufferChunks chunks;
+    chunks.pred       = cpred->getRawDataAccess()->getPPALForRead();
+    chunks.ref        = cref->getRawDataAccess()->getPPALForRead();
+    chunks.n          = cpred->size();
+    chunks.num_chunks = ImageMetricsInternal::numChunks(chunks.n);
+    chunks.binary     = binary;
+    chunks.threshold  = threshold;
+    chunks.partials   = new ImageMetrics[chunks.num_chunks];
+    april_utils::parallelFor(chunks.num_chunks, chunks);
+    for (unsigned int c = 0; c < chunks.num_chunks; ++c)
+        combine(chunks.partials[c]);
+    delete[] chunks.partials;
+    DecRef(cpred);
+    DecRef(cref);
+}
+
+void ImageMetrics::processImage(ImageFloat *pred, ImageFloat *ref,
+                                bool binary, float threshold) {
+    if (pred->width != ref->width || pred->height != ref->height)
+        ERROR_EXIT4(128, "Image metrics: different image sizes: %dx%d != %dx%d\n",
+                    pred->width, pred->height, ref->width, ref->height);
+    ImageMetricsInternal::ImageBands bands;
+    bands.pred      = pred;
+    bands.ref       = ref;
+    bands.num_bands = ImageMetricsInternal::numChunks(static_cast<long int>(pred->width)*pred->height);
+    if (bands.num_bands > static_cast<unsigned int>(pred->height))
+        bands.num_bands = (pred->height > 0) ? pred->height : 1;
+    bands.binary    = binary;
+    bands.threshold = threshold;
+    bands.partials  = new ImageMetrics[bands.num_bands];
+    april_utils::parallelFor(bands.num_bands, bands);
+    for (unsigned int b = 0; b < bands.num_bands; ++b)
+        combine(bands.partials[b]);
+    delete[] bands.partials;
+}
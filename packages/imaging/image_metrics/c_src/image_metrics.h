@@ -24,6 +24,8 @@
 
 #include "referenced.h"
 #include "datasetFloat.h"
+#include "matrixFloat.h"
+#include "utilImageFloat.h"
 
 /**
  Class that contains the counters for calculate the metrics on two different
@@ -60,6 +62,20 @@ public:
 
   //// Takes two datasets and add the information to the counters
   void processDataset(DataSetFloat *ds, DataSetFloat *GT, bool binary, float threshold);
+
+  //// Adds n samples of two contiguous buffers to the counters, computing
+  //// all of them in one pass
+  void processBuffer(const float *pred, const float *ref, long int n,
+                     bool binary, float threshold);
+
+  //// Takes two matrices with the same size and add the information to the
+  //// counters. The matrices are processed by chunks in parallel, and the
+  //// partial counters are combined
+  void processMatrix(MatrixFloat *pred, MatrixFloat *ref, bool binary, float threshold);
+
+  //// Takes two images with the same size and add the information to the
+  //// counters, processing bands of rows in parallel
+  void processImage(ImageFloat *pred, ImageFloat *ref, bool binary, float threshold);
             
   /** Returns differents measures
     FM   - Fmeasure
@@ -0,0 +1,42 @@
+-- Checks that process_matrix and process_image compute the same metrics
+-- than process_dataset
+local rnd = random(4567)
+local h, w = 301, 257
+local pred, ref = matrix(h, w), matrix(h, w)
+for i=1,h do
+  for j=1,w do
+    pred:set(i,j, rnd:rand(1.4) - 0.2)
+    ref:set(i,j, rnd:rand())
+  end
+end
+
+local function check(a, b)
+  for _,k in ipairs{ "FM", "PR", "RC", "GA", "MSE", "TNR", "ACC", "PSNR", "BRP", "FNR" } do
+    assert(math.abs(a[k] - b[k]) < 1e-6, k)
+  end
+end
+
+for _,binary in ipairs{ false, true } do
+  local m1 = image.image_metrics()
+  local params = { patternSize = {1, 1}, stepSize = {1, 1}, numSteps = {h, w} }
+  m1:process_dataset{ predicted = dataset.matrix(pred, params),
+		      ground_truth = dataset.matrix(ref, params),
+		      binary = binary, threshold = 0.4 }
+  local m2 = image.image_metrics()
+  m2:process_matrix{ predicted = pred, ground_truth = ref,
+		     binary = binary, threshold = 0.4 }
+  local m3 = image.image_metrics()
+  m3:process_image{ predicted = Image(pred), ground_truth = Image(ref),
+		    binary = binary, threshold = 0.4 }
+  assert(m1:nSamples() == m2:nSamples() and m1:nSamples() == m3:nSamples())
+  check(m1:get_metrics(), m2:get_metrics())
+  check(m1:get_metrics(), m3:get_metrics())
+end
+
+-- sub-images are compared row by row
+local m1, m2 = image.image_metrics(), image.image_metrics()
+local sub_pred, sub_ref = Image(pred):crop(100, 50, 10, 20), Image(ref):crop(100, 50, 10, 20)
+m1:process_image{ predicted = sub_pred, ground_truth = sub_ref }
+m2:process_matrix{ predicted = sub_pred:clone():matrix(), ground_truth = sub_ref:clone():matrix() }
+check(m1:get_metrics(), m2:get_metrics())
+print("OK")
@@ -0,0 +1,228 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+//BIND_HEADER_C
+#include "parallel_for.h"
+
+/// Pushes a table with the images, seconds and images_per_second of a stage.
+/// The seconds are summed over all the threads, so the throughput is computed
+/// with the wall time of the run
+static void pushStageStats(lua_State *L, const ImagePipeline::StageStats &s,
+			   double wall_time) {
+  lua_newtable(L);
+  lua_pushnumber(L, s.images);
+  lua_setfield(L, -2, "images");
+  lua_pushnumber(L, s.seconds);
+  lua_setfield(L, -2, "seconds");
+  lua_pushnumber(L, (wall_time > 0.0) ? s.images/wall_time : 0.0);
+  lua_setfield(L, -2, "images_per_second");
+}
+//BIND_END
+
+//BIND_HEADER_H
+#include "image_pipeline.h"
+#include "bind_image.h"
+//BIND_END
+
+//BIND_LUACLASSNAME ImagePipeline image.pipeline
+//BIND_CPP_CLASS    ImagePipeline
+
+//BIND_CONSTRUCTOR ImagePipeline
+//DOC_BEGIN
+// pipeline()
+/// Batch processing of PNG files with several threads. The operations
+/// (binarize_niblack, binarize_niblack_simple, binarize_otsus,
+/// binarize_threshold, remove_blank_columns, resize, invert_colors) are
+/// appended to the chain with the same arguments as the Image methods, and
+/// they return the pipeline.
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 0);
+  obj = new ImagePipeline();
+  LUABIND_RETURN(ImagePipeline, obj);
+}
+//BIND_END
+
+//BIND_METHOD ImagePipeline binarize_niblack
+{
+  int radius;
+  float k, minThreshold, maxThreshold;
+  LUABIND_CHECK_ARGN(==, 4);
+  LUABIND_GET_PARAMETER(1, int, radius);
+  LUABIND_GET_PARAMETER(2, float, k);
+  LUABIND_GET_PARAMETER(3, float, minThreshold);
+  LUABIND_GET_PARAMETER(4, float, maxThreshold);
+  if (radius < 1)
+    LUABIND_ERROR("median filter, radius must be > 0");
+  obj->addOperation(new NiblackOperation(radius, k, minThreshold, maxThreshold));
+  LUABIND_RETURN(ImagePipeline, obj);
+}
+//BIND_END
+
+//BIND_METHOD ImagePipeline binarize_niblack_simple
+{
+  int radius;
+  float k;
+  LUABIND_CHECK_ARGN(>=, 1);
+  LUABIND_GET_PARAMETER(1, int, radius);
+  LUABIND_GET_OPTIONAL_PARAMETER(2,float, k, 0.2);
+  if (radius < 1)
+    LUABIND_ERROR("median filter, radius must be > 0");
+  obj->addOperation(new NiblackSimpleOperation(radius, k));
+  LUABIND_RETURN(ImagePipeline, obj);
+}
+//BIND_END
+
+//BIND_METHOD ImagePipeline binarize_otsus
+{
+  LUABIND_CHECK_ARGN(==, 0);
+  obj->addOperation(new OtsusOperation());
+  LUABIND_RETURN(ImagePipeline, obj);
+}
+//BIND_END
+
+//BIND_METHOD ImagePipeline binarize_threshold
+{
+  double threshold;
+  LUABIND_CHECK_ARGN(==, 1);
+  LUABIND_GET_PARAMETER(1, double, threshold);
+  obj->addOperation(new ThresholdOperation(threshold));
+  LUABIND_RETURN(ImagePipeline, obj);
+}
+//BIND_END
+
+//BIND_METHOD ImagePipeline remove_blank_columns
+{
+  LUABIND_CHECK_ARGN(==, 0);
+  obj->addOperation(new RemoveBlankColumnsOperation());
+  LUABIND_RETURN(ImagePipeline, obj);
+}
+//BIND_END
+
+//BIND_METHOD ImagePipeline resize
+{
+  int x, y;
+  LUABIND_CHECK_ARGN(==, 2);
+  LUABIND_GET_PARAMETER(1, int, x);
+  LUABIND_GET_PARAMETER(2, int, y);
+  obj->addOperation(new ResizeOperation(x, y));
+  LUABIND_RETURN(ImagePipeline, obj);
+}
+//BIND_END
+
+//BIND_METHOD ImagePipeline invert_colors
+{
+  LUABIND_CHECK_ARGN(==, 0);
+  obj->addOperation(new InvertColorsOperation());
+  LUABIND_RETURN(ImagePipeline, obj);
+}
+//BIND_END
+
+//BIND_METHOD ImagePipeline size
+//DOC_BEGIN
+// Returns the number of operations of the chain
+//DOC_END
+{
+  LUABIND_CHECK_ARGN(==, 0);
+  LUABIND_RETURN(uint, obj->getNumOperations());
+}
+//BIND_END
+
+//BIND_METHOD ImagePipeline apply
+//DOC_BEGIN
+// Returns a new Image, result of the chain of operations over the given one
+//DOC_END
+{
+  ImageFloat *img;
+  LUABIND_CHECK_ARGN(==, 1);
+  LUABIND_GET_PARAMETER(1, ImageFloat, img);
+  ImageFloat *result = obj->transform(img);
+  LUABIND_RETURN(ImageFloat, result);
+  // transform returns the image referenced
+  DecRef(result);
+}
+//BIND_END
+
+//BIND_METHOD ImagePipeline run
+//DOC_BEGIN
+// table run(input_files, output_files, num_threads=util.get_num_threads())
+/// Decodes each PNG input file to grayscale, applies the chain of operations
+/// and encodes the result at the corresponding output file. The files are
+/// processed by a pool of num_threads threads. Returns a table with the
+/// stats of each stage (decode, transform and encode fields), the wall_time,
+/// and the list of failed input files. The seconds of a stage are summed over
+/// all the threads, its images_per_second is the aggregate throughput, the
+/// images of the stage divided by the wall_time.
+//DOC_END
+{
+  unsigned int n, num_threads;
+  LUABIND_CHECK_ARGN(>=, 2);
+  LUABIND_CHECK_ARGN(<=, 3);
+  LUABIND_CHECK_PARAMETER(1, table);
+  LUABIND_CHECK_PARAMETER(2, table);
+  LUABIND_TABLE_GETN(1, n);
+  unsigned int n2;
+  LUABIND_TABLE_GETN(2, n2);
+  if (n != n2)
+    LUABIND_FERROR2("Different number of input and output files: %d != %d",
+		    n, n2);
+  LUABIND_GET_OPTIONAL_PARAMETER(3, uint, num_threads,
+				 april_utils::getNumWorkerThreads());
+  // the strings are kept alive by the tables at the stack
+  const char **input_files  = new const char*[n];
+  const char **output_files = new const char*[n];
+  for (unsigned int i=0; i<n; ++i) {
+    lua_rawgeti(L, 1, i+1);
+    lua_rawgeti(L, 2, i+1);
+    if (!lua_isstring(L, -2) || !lua_isstring(L, -1)) {
+      delete[] input_files;
+      delete[] output_files;
+      LUABIND_FERROR1("Expected a string at position %d of files tables", i+1);
+    }
+    input_files[i]  = lua_tostring(L, -2);
+    output_files[i] = lua_tostring(L, -1);
+    lua_pop(L, 2);
+  }
+  ImagePipeline::RunStats stats;
+  obj->run(input_files, output_files, n, num_threads, stats);
+  lua_newtable(L);
+  pushStageStats(L, stats.stages[ImagePipeline::DECODE_STAGE],
+		 stats.wall_time);
+  lua_setfield(L, -2, "decode");
+  pushStageStats(L, stats.stages[ImagePipeline::TRANSFORM_STAGE],
+		 stats.wall_time);
+  lua_setfield(L, -2, "transform");
+  pushStageStats(L, stats.stages[ImagePipeline::ENCODE_STAGE],
+		 stats.wall_time);
+  lua_setfield(L, -2, "encode");
+  lua_pushnumber(L, stats.wall_time);
+  lua_setfield(L, -2, "wall_time");
+  lua_newtable(L);
+  for (unsigned int i=0; i<stats.failed.size(); ++i) {
+    lua_pushstring(L, input_files[stats.failed[i]]);
+    lua_rawseti(L, -2, i+1);
+  }
+  lua_setfield(L, -2, "failed");
+  delete[] input_files;
+  delete[] output_files;
+  LUABIND_RETURN_FROM_STACK(-1);
+}
+//BIND_END
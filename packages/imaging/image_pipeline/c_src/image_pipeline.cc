@@ -0,0 +1,192 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#include <pthread.h>
+#include "image_pipeline.h"
+#include "binarization.h"
+#include "libpng.h"
+#include "stopwatch.h"
+#include "qsort.h"
+
+ImageFloat *NiblackOperation::apply(const ImageFloat *img) const {
+  return binarize_niblack(img, radius, k, min_threshold, max_threshold);
+}
+
+ImageFloat *NiblackSimpleOperation::apply(const ImageFloat *img) const {
+  return binarize_niblack_simple(img, radius, k);
+}
+
+ImageFloat *OtsusOperation::apply(const ImageFloat *img) const {
+  return binarize_otsus(img);
+}
+
+ImageFloat *ThresholdOperation::apply(const ImageFloat *img) const {
+  return binarize_threshold(img, threshold);
+}
+
+ImageFloat *RemoveBlankColumnsOperation::apply(const ImageFloat *img) const {
+  return img->remove_blank_columns();
+}
+
+ImageFloat *ResizeOperation::apply(const ImageFloat *img) const {
+  return img->resize(width, height);
+}
+
+ImageFloat *InvertColorsOperation::apply(const ImageFloat *img) const {
+  return img->invert_colors();
+}
+
+ImagePipeline::~ImagePipeline() {
+  for (unsigned int i=0; i<operations.size(); ++i) DecRef(operations[i]);
+}
+
+void ImagePipeline::addOperation(ImageOperation *op) {
+  IncRef(op);
+  operations.push_back(op);
+}
+
+ImageFloat *ImagePipeline::transform(ImageFloat *img) const {
+  IncRef(img);
+  for (unsigned int i=0; i<operations.size(); ++i) {
+    ImageFloat *next = operations[i]->apply(img);
+    IncRef(next);
+    DecRef(img);
+    img = next;
+  }
+  return img;
+}
+
+namespace ImagePipelineInternal {
+
+  /// State shared by all the workers, the next file is taken under mutex
+  struct SharedState {
+    const ImagePipeline *pipeline;
+    const char **input_files, **output_files;
+    unsigned int n, next;
+    pthread_mutex_t mutex;
+  };
+
+  struct Worker {
+    SharedState *shared;
+    april_utils::stopwatch clocks[ImagePipeline::NUM_STAGES];
+    ImagePipeline::StageStats stages[ImagePipeline::NUM_STAGES];
+    april_utils::vector<unsigned int> failed;
+    
+    /// Returns the next file index, or n when all the files are taken
+    unsigned int nextFile() {
+      pthread_mutex_lock(&shared->mutex);
+      unsigned int i = shared->next;
+      if (i < shared->n) ++shared->next;
+      pthread_mutex_unlock(&shared->mutex);
+      return i;
+    }
+    
+    void process() {
+      unsigned int i;
+      while ( (i = nextFile()) < shared->n ) {
+	// decode
+	clocks[ImagePipeline::DECODE_STAGE].go();
+	ImageFloat *img = LibPNG::readPNGGray(shared->input_files[i]);
+	if (img != 0) IncRef(img);
+	clocks[ImagePipeline::DECODE_STAGE].stop();
+	if (img == 0) {
+	  failed.push_back(i);
+	  continue;
+	}
+	++stages[ImagePipeline::DECODE_STAGE].images;
+	// transform
+	clocks[ImagePipeline::TRANSFORM_STAGE].go();
+	ImageFloat *result = shared->pipeline->transform(img);
+	DecRef(img);
+	clocks[ImagePipeline::TRANSFORM_STAGE].stop();
+	++stages[ImagePipeline::TRANSFORM_STAGE].images;
+	// encode
+	clocks[ImagePipeline::ENCODE_STAGE].go();
+	ImageFloatRGB *rgb = grayscale_to_RGB(result);
+	IncRef(rgb);
+	DecRef(result);
+	bool ok = LibPNG::writePNG(rgb, shared->output_files[i]);
+	DecRef(rgb);
+	clocks[ImagePipeline::ENCODE_STAGE].stop();
+	if (ok) ++stages[ImagePipeline::ENCODE_STAGE].images;
+	else failed.push_back(i);
+      }
+      for (unsigned int s=0; s<ImagePipeline::NUM_STAGES; ++s)
+	stages[s].seconds = clocks[s].read_wall_time();
+    }
+    
+    static void *run(void *ptr) {
+      reinterpret_cast<Worker*>(ptr)->process();
+      return 0;
+    }
+  };
+
+}
+
+void ImagePipeline::run(const char **input_files, const char **output_files,
+			unsigned int n, unsigned int num_threads,
+			RunStats &stats) const {
+  using namespace ImagePipelineInternal;
+  april_utils::stopwatch wall_clock;
+  wall_clock.go();
+  if (num_threads > n) num_threads = n;
+  if (num_threads == 0) num_threads = 1;
+  SharedState shared;
+  shared.pipeline     = this;
+  shared.input_files  = input_files;
+  shared.output_files = output_files;
+  shared.n            = n;
+  shared.next         = 0;
+  pthread_mutex_init(&shared.mutex, 0);
+  Worker    *workers = new Worker[num_threads];
+  pthread_t *ids     = new pthread_t[num_threads];
+  bool      *joined  = new bool[num_threads];
+  for (unsigned int t=0; t<num_threads; ++t) {
+    workers[t].shared = &shared;
+    joined[t] = false;
+  }
+  // the calling thread is the worker 0, if a thread couldn't be created the
+  // files are processed by the other workers
+  for (unsigned int t=1; t<num_threads; ++t)
+    joined[t] = (pthread_create(&ids[t], 0, Worker::run, &workers[t]) == 0);
+  workers[0].process();
+  for (unsigned int t=1; t<num_threads; ++t)
+    if (joined[t]) pthread_join(ids[t], 0);
+  pthread_mutex_destroy(&shared.mutex);
+  // reduction of the workers stats
+  for (unsigned int s=0; s<NUM_STAGES; ++s) stats.stages[s] = StageStats();
+  stats.failed.clear();
+  for (unsigned int t=0; t<num_threads; ++t) {
+    for (unsigned int s=0; s<NUM_STAGES; ++s) {
+      stats.stages[s].images  += workers[t].stages[s].images;
+      stats.stages[s].seconds += workers[t].stages[s].seconds;
+    }
+    for (unsigned int i=0; i<workers[t].failed.size(); ++i)
+      stats.failed.push_back(workers[t].failed[i]);
+  }
+  if (stats.failed.size() > 1)
+    april_utils::Sort(&stats.failed[0], static_cast<int>(stats.failed.size()));
+  delete[] workers;
+  delete[] ids;
+  delete[] joined;
+  wall_clock.stop();
+  stats.wall_time = wall_clock.read_wall_time();
+}
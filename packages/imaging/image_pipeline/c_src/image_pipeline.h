@@ -0,0 +1,124 @@
+/*
+ * This file is part of APRIL-ANN toolkit (A
+ * Pattern Recognizer In Lua with Artificial Neural Networks).
+ *
+ * Copyright 2013, Salvador España-Boquera, Adrian Palacios Corella, Francisco
+ * Zamora-Martinez
+ *
+ * The APRIL-ANN toolkit is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifndef IMAGE_PIPELINE_H
+#define IMAGE_PIPELINE_H
+
+#include "referenced.h"
+#include "vector.h"
+#include "utilImageFloat.h"
+
+/// An operation of the transform stage of an ImagePipeline. The apply method
+/// returns a new image, and it must be safe to be called concurrently.
+class ImageOperation : public Referenced {
+public:
+  virtual ~ImageOperation() { }
+  virtual ImageFloat *apply(const ImageFloat *img) const = 0;
+};
+
+class NiblackOperation : public ImageOperation {
+  int   radius;
+  float k, min_threshold, max_threshold;
+public:
+  NiblackOperation(int radius, float k, float min_threshold, float max_threshold) :
+    radius(radius), k(k), min_threshold(min_threshold),
+    max_threshold(max_threshold) { }
+  ImageFloat *apply(const ImageFloat *img) const;
+};
+
+class NiblackSimpleOperation : public ImageOperation {
+  int   radius;
+  float k;
+public:
+  NiblackSimpleOperation(int radius, float k) : radius(radius), k(k) { }
+  ImageFloat *apply(const ImageFloat *img) const;
+};
+
+class OtsusOperation : public ImageOperation {
+public:
+  ImageFloat *apply(const ImageFloat *img) const;
+};
+
+class ThresholdOperation : public ImageOperation {
+  double threshold;
+public:
+  ThresholdOperation(double threshold) : threshold(threshold) { }
+  ImageFloat *apply(const ImageFloat *img) const;
+};
+
+class RemoveBlankColumnsOperation : public ImageOperation {
+public:
+  ImageFloat *apply(const ImageFloat *img) const;
+};
+
+class ResizeOperation : public ImageOperation {
+  int width, height;
+public:
+  ResizeOperation(int width, int height) : width(width), height(height) { }
+  ImageFloat *apply(const ImageFloat *img) const;
+};
+
+class InvertColorsOperation : public ImageOperation {
+public:
+  ImageFloat *apply(const ImageFloat *img) const;
+};
+
+/**
+   Batch processing of PNG files: each file is decoded to grayscale,
+   transformed by the chain of operations and encoded to its output file,
+   as the Lua loop over ImageIO.read, the Image methods and ImageIO.write.
+
+   The files are processed by a bounded pool of threads, which take the next
+   file when they finish the previous one, so at most num_threads images are
+   in memory (backpressure) and disk and CPU work of different files
+   overlap. The time spent at each stage is summed over all the threads.
+ **/
+class ImagePipeline : public Referenced {
+public:
+  enum { DECODE_STAGE=0, TRANSFORM_STAGE, ENCODE_STAGE, NUM_STAGES };
+  struct StageStats {
+    unsigned int images;
+    double       seconds;
+    StageStats() : images(0), seconds(0.0) { }
+  };
+  struct RunStats {
+    StageStats stages[NUM_STAGES];
+    double     wall_time;
+    /// indexes of the files which couldn't be decoded or encoded
+    april_utils::vector<unsigned int> failed;
+  };
+  
+private:
+  april_utils::vector<ImageOperation*> operations;
+  
+public:
+  ImagePipeline() { }
+  virtual ~ImagePipeline();
+  void addOperation(ImageOperation *op);
+  unsigned int getNumOperations() const { return operations.size(); }
+  /// Applies the chain of operations to one image
+  ImageFloat *transform(ImageFloat *img) const;
+  /// Processes input_files[i] into output_files[i] for i in [0,n)
+  void run(const char **input_files, const char **output_files,
+	   unsigned int n, unsigned int num_threads, RunStats &stats) const;
+};
+
+#endif // IMAGE_PIPELINE_H
@@ -0,0 +1,40 @@
+ package{ name = "image_pipeline",
+   version = "1.0",
+   depends = { "util", "image", "libpng", "binarization_filter" },
+   keywords = { "image", "pipeline", "batch" },
+   description = "batch processing of image files with several threads",
+   -- targets como en ant
+   target{
+     name = "init",
+     mkdir{ dir = "build" },
+     mkdir{ dir = "include" },
+   },
+   target{ name = "clean",
+     delete{ dir = "build" },
+     delete{ dir = "include" },
+   },
+   target{
+     name = "provide",
+     depends = "init",
+     copy{ file= "c_src/*.h", dest_dir = "include" },
+     provide_bind{ file = "binding/bind_image_pipeline.lua.cc", dest_dir = "include" },
+   },
+   target{
+     name = "build",
+     depends = "provide",
+     use_timestamp=true,
+     object{ 
+       file = "c_src/*.cc",
+       include_dirs = "${include_dirs}",
+       dest_dir = "build",
+     },
+     build_bind{ file = "binding/bind_image_pipeline.lua.cc", dest_dir = "build" },
+   },
+   target{
+     name = "document",
+     document_src{},
+     document_bind{},
+   },
+ }
+ 
+ 
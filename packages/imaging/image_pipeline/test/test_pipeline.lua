@@ -0,0 +1,65 @@
+-- Checks that image.pipeline produces the same files than the Lua loop over
+-- ImageIO.read, the Image methods and ImageIO.write
+local N   = 6
+-- os.tmpname creates the file, only its name is used
+local function tmpname(suffix)
+  local name = os.tmpname()
+  os.remove(name)
+  return name .. suffix
+end
+local rnd = random(1234)
+local inputs, outputs, expected = {}, {}, {}
+for i=1,N do
+  local w,h = 40 + 3*i, 30 + 2*i
+  local m   = matrix(h, w)
+  for y=1,h do for x=1,w do m:set(y,x, rnd:rand()) end end
+  inputs[i]  = tmpname(".png")
+  outputs[i] = tmpname(".png")
+  ImageIO.write(Image(m), inputs[i])
+end
+
+local pipeline = image.pipeline():binarize_niblack_simple(3):resize(20, 10)
+assert(pipeline:size() == 2)
+for i=1,N do
+  expected[i] = ImageIO.read(inputs[i]):to_grayscale():binarize_niblack_simple(3):resize(20, 10)
+end
+
+-- an input which doesn't exist
+table.insert(inputs, tmpname("-missing.png"))
+table.insert(outputs, tmpname(".png"))
+
+local stats = pipeline:run(inputs, outputs, 3)
+assert(stats.decode.images == N)
+assert(stats.transform.images == N)
+assert(stats.encode.images == N)
+assert(#stats.failed == 1 and stats.failed[1] == inputs[N+1])
+assert(stats.wall_time > 0)
+-- aggregate throughput of every stage, and seconds summed over the threads
+for _,stage in ipairs{ "decode", "transform", "encode" } do
+  local st = stats[stage]
+  assert(math.abs(st.images_per_second - st.images/stats.wall_time) <=
+	 1e-6*st.images_per_second)
+  assert(st.seconds >= 0)
+end
+for i=1,N do
+  local a = ImageIO.read(outputs[i]):to_grayscale():matrix()
+  local b = expected[i]:matrix()
+  local ref = ImageIO.read(inputs[i]):to_grayscale()
+  assert(a:dim()[1] == b:dim()[1] and a:dim()[2] == b:dim()[2])
+  for y=1,a:dim()[1] do
+    for x=1,a:dim()[2] do
+      assert(math.abs(a:get(y,x) - b:get(y,x)) < 1/255 + 1e-6)
+    end
+  end
+  -- apply uses the same chain of operations than the sequential stages
+  local c = pipeline:apply(ref):matrix()
+  assert(c:dim()[1] == b:dim()[1] and c:dim()[2] == b:dim()[2])
+  for y=1,c:dim()[1] do
+    for x=1,c:dim()[2] do
+      assert(math.abs(c:get(y,x) - b:get(y,x)) < 1e-6)
+    end
+  end
+  os.remove(inputs[i])
+  os.remove(outputs[i])
+end
+print("OK")
@@ -248,6 +248,135 @@ namespace LibPNG
     return success;
   }
 
+  MatrixFloat *readPNGMatrix(const char *filename,
+			     ImageRowSink::ChannelLayout layout,
+			     int roi_x, int roi_y, int roi_width, int roi_height,
+			     int downscale)
+  {
+    png_structp png_ptr;
+    png_infop   info_ptr;
+
+    png_uint_32 width, height;
+    int bit_depth, color_type;
+
+    FILE *fp = fopen(filename, "rb");
+    if (!fp) {
+      fprintf(stderr, "LibPNG::readPNGMatrix() -> cannot open input file %s\n", filename);
+      return NULL;
+    }
+
+    unsigned char sig[8];
+    if (fread(sig, 1, 8, fp) < 8 || !png_check_sig(sig, 8)) {
+      fprintf(stderr, "LibPNG::readPNGMatrix() -> %s is not a PNG file\n", filename);
+      fclose(fp);
+      return NULL;
+    }
+
+    png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (!png_ptr) {
+      fprintf(stderr, "LibPNG::readPNGMatrix() -> cannot allocate memory for png_struct\n");
+      fclose(fp);
+      return NULL;
+    }
+    info_ptr = png_create_info_struct(png_ptr);
+    if (!info_ptr) {
+      png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+      fprintf(stderr, "LibPNG::readPNGMatrix() -> cannot allocate memory for png_struct\n");
+      fclose(fp);
+      return NULL;
+    }
+
+    if (setjmp(png_jmpbuf(png_ptr))) {
+      png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+      fprintf(stderr, "Error while initializing I/O\n");
+      fclose(fp);
+      return NULL;
+    }
+
+    png_init_io(png_ptr, fp);
+    png_set_sig_bytes(png_ptr, 8);
+    png_read_info(png_ptr, info_ptr);
+    png_get_IHDR(png_ptr, info_ptr, &width, &height, &bit_depth,
+		 &color_type, NULL, NULL, NULL);
+
+    // 8 bits gray or RGB pixels, grayscale images are not expanded to RGB
+    png_set_strip_alpha(png_ptr);
+    if (color_type == PNG_COLOR_TYPE_PALETTE)
+      png_set_palette_to_rgb(png_ptr);
+    if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8)
+      png_set_expand_gray_1_2_4_to_8(png_ptr);
+    if (bit_depth == 16)
+      png_set_strip_16(png_ptr);
+    int passes = png_set_interlace_handling(png_ptr);
+    png_read_update_info(png_ptr, info_ptr);
+    png_uint_32 rowbytes = png_get_rowbytes(png_ptr, info_ptr);
+    int channels = (int)png_get_channels(png_ptr, info_ptr);
+
+    ImageRowSink *sink = new ImageRowSink(static_cast<int>(width),
+					  static_cast<int>(height),
+					  layout, roi_x, roi_y,
+					  roi_width, roi_height, downscale);
+    if (!sink->isValid()) {
+      fprintf(stderr, "LibPNG::readPNGMatrix() -> invalid region or downscale for %s\n",
+	      filename);
+      delete sink;
+      png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+      fclose(fp);
+      return NULL;
+    }
+    // interlaced images are only complete after the last pass, so all their
+    // rows are needed, otherwise rows are decoded one by one into one buffer
+    // and decoding stops after the last row of the region
+    unsigned int buffer_rows = (passes > 1) ? height : 1;
+    unsigned char *image_data = new unsigned char[rowbytes*buffer_rows];
+    png_bytep *row_pointers = new png_bytep[buffer_rows];
+    for (unsigned int i=0; i<buffer_rows; i++)
+      row_pointers[i] = image_data + i*rowbytes;
+
+    if (setjmp(png_jmpbuf(png_ptr))) {
+      png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+      fprintf(stderr, "Error while reading PNG image from %s\n", filename);
+      delete sink;
+      delete[] row_pointers;
+      delete[] image_data;
+      fclose(fp);
+      return NULL;
+    }
+
+    if (passes > 1) {
+      png_read_image(png_ptr, row_pointers);
+      for (int y=sink->getFirstRow(); y<sink->getLastRow(); ++y)
+	sink->addRow(y, row_pointers[y], channels);
+    }
+    else {
+      for (int y=0; y<sink->getLastRow(); ++y) {
+	png_read_row(png_ptr, row_pointers[0], NULL);
+	sink->addRow(y, row_pointers[0], channels);
+      }
+    }
+    MatrixFloat *res = sink->releaseMatrix();
+
+    // cleanup
+    delete sink;
+    delete[] row_pointers;
+    delete[] image_data;
+    png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+    fclose(fp);
+
+    return res;
+  }
+
+  ImageFloat *readPNGGray(const char *filename,
+			  int roi_x, int roi_y, int roi_width, int roi_height,
+			  int downscale)
+  {
+    MatrixFloat *m = readPNGMatrix(filename, ImageRowSink::GRAY,
+				   roi_x, roi_y, roi_width, roi_height,
+				   downscale);
+    if (m == NULL) return NULL;
+    return new ImageFloat(m);
+  }
+
 }
 
 
@@ -22,6 +22,7 @@
 #define LIBPNG_H
 
 #include "utilImageFloat.h"
+#include "image_row_sink.h"
 #include <cstdio>
 
 namespace LibPNG 
@@ -29,6 +30,21 @@ namespace LibPNG
   ImageFloatRGB* readPNG(const char *filename); // returns NULL if error
   bool writePNG(ImageFloatRGB *img, const char *filename);
 
+  // Decodes row by row into a matrix with the given layout, keeping only the
+  // region of interest, downscaled by averaging blocks of downscale x
+  // downscale pixels (see ImageRowSink). Returns NULL if error.
+  MatrixFloat *readPNGMatrix(const char *filename,
+			     ImageRowSink::ChannelLayout layout,
+			     int roi_x=0, int roi_y=0,
+			     int roi_width=0, int roi_height=0,
+			     int downscale=1);
+  // The same as RGB_to_grayscale(readPNG(filename)) when there is no region
+  // of interest nor downscale, without the intermediate RGB image
+  ImageFloat *readPNGGray(const char *filename,
+			  int roi_x=0, int roi_y=0,
+			  int roi_width=0, int roi_height=0,
+			  int downscale=1);
+
 }
 
 #endif
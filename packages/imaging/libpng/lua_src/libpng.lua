@@ -1,2 +1,2 @@
-ImageIO.handlers["png"] = { read=libpng.read, write=libpng.write }
-
+ImageIO.handlers["png"] = { read=libpng.read, write=libpng.write,
+			    read_gray=libpng.read_gray }
@@ -0,0 +1,61 @@
+-- Checks libpng.read_matrix and libpng.read_gray (decoding row by row, with
+-- region of interest and downscale) against libpng.read
+local rnd = random(2468)
+local img = ImageRGB.empty(23, 17)
+local w,h = img:geometry()
+for y=0,h-1 do
+  for x=0,w-1 do img:putpixel(x,y, rnd:rand(), rnd:rand(), rnd:rand()) end
+end
+-- os.tmpname creates the file, only its name is used
+local filename = os.tmpname()
+os.remove(filename)
+filename = filename .. ".png"
+ImageIO.write(img, filename)
+local ref  = libpng.read(filename)
+local gray = ref:to_grayscale()
+
+-- whole image
+local g = ImageIO.read_gray(filename)
+for y=0,h-1 do
+  for x=0,w-1 do assert(g:getpixel(x,y) == gray:getpixel(x,y)) end
+end
+local rgb    = libpng.read_matrix(filename, { layout="rgb" })
+local planar = libpng.read_matrix(filename, { layout="rgb_planar" })
+for y=0,h-1 do
+  for x=0,w-1 do
+    local r,g,b = ref:getpixel(x,y)
+    assert(rgb:get(y+1,x+1,1) == r and rgb:get(y+1,x+1,2) == g and
+	   rgb:get(y+1,x+1,3) == b)
+    assert(planar:get(1,y+1,x+1) == r and planar:get(2,y+1,x+1) == g and
+	   planar:get(3,y+1,x+1) == b)
+  end
+end
+
+-- region of interest and downscale, blocks at the borders are smaller
+for _,ds in ipairs{ 1, 2, 3, 5 } do
+  local rx, ry, rw, rh = 3, 2, 13, 11
+  local m = libpng.read_matrix(filename, { x=rx, y=ry, width=rw, height=rh,
+					   downscale=ds })
+  local ow, oh = math.ceil(rw/ds), math.ceil(rh/ds)
+  assert(m:dim()[1] == oh and m:dim()[2] == ow)
+  for by=0,oh-1 do
+    for bx=0,ow-1 do
+      local s, n = 0, 0
+      for y=ry+by*ds, math.min(ry+rh, ry+(by+1)*ds)-1 do
+	for x=rx+bx*ds, math.min(rx+rw, rx+(bx+1)*ds)-1 do
+	  s, n = s + gray:getpixel(x,y), n + 1
+	end
+      end
+      assert(math.abs(m:get(by+1,bx+1) - s/n) < 1e-5)
+    end
+  end
+end
+
+-- up to the image border by default, and errors
+local g = libpng.read_gray(filename, { x=w-3, y=h-7 })
+assert(g:geometry() == 3 and select(2, g:geometry()) == 7)
+assert(not pcall(libpng.read_gray, filename, { x=w-3, width=4 }))
+assert(not pcall(libpng.read_matrix, filename, { layout="cmyk" }))
+assert(not pcall(libpng.read_gray, filename, { downscale=0 }))
+os.remove(filename)
+print("OK")
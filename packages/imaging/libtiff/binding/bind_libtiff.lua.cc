@@ -24,7 +24,9 @@
 //BIND_HEADER_H
 #include "libtiff.h"
 #include "constString.h"
+#include "bind_image.h"
 #include "bind_image_RGB.h"
+#include "bind_matrix.h"
 //BIND_END
 
 //BIND_FUNCTION libtiff.read
@@ -61,3 +63,64 @@
     LUABIND_ERROR("libtiff.write failed");
 }
 //BIND_END
+
+//BIND_FUNCTION libtiff.read_matrix
+//DOC_BEGIN
+// read_matrix(filename, { layout="gray", x=0, y=0, width, height, downscale=1 })
+/// Decodes a TIFF file strip by strip into a matrix: height x width for the
+/// "gray" layout, height x width x 3 for "rgb" and 3 x height x width for
+/// "rgb_planar". Only the region of interest (x,y,width,height, by default
+/// the whole image) is kept, and it is downscaled averaging blocks of
+/// downscale x downscale pixels.
+//DOC_END
+{
+  constString cs;
+  LUABIND_CHECK_ARGN(>=, 1);
+  LUABIND_CHECK_ARGN(<=, 2);
+  LUABIND_CHECK_PARAMETER(1, string);
+  LUABIND_GET_PARAMETER(1,constString,cs);
+  const char *filename = (const char *)cs;
+  int x, y, width, height, downscale;
+  getImageReadParams(L, 2, x, y, width, height, downscale);
+  const char *layout_name = "gray";
+  if (lua_gettop(L) == 2 && !lua_isnil(L, 2))
+    LUABIND_GET_TABLE_OPTIONAL_PARAMETER(2, layout, string, layout_name, "gray");
+  ImageRowSink::ChannelLayout layout;
+  if (!ImageRowSink::parseLayout(layout_name, layout))
+    LUABIND_FERROR1("Unknown layout %s", layout_name);
+
+  MatrixFloat *res = LibTIFF::readTIFFMatrix(filename, layout, x, y,
+					    width, height, downscale);
+
+  if (res == NULL)
+    LUABIND_ERROR("libtiff.read_matrix failed");
+
+  LUABIND_RETURN(MatrixFloat, res);
+}
+//BIND_END
+
+//BIND_FUNCTION libtiff.read_gray
+//DOC_BEGIN
+// read_gray(filename, { x=0, y=0, width, height, downscale=1 })
+/// Decodes a TIFF file into a grayscale Image, as read():to_grayscale() but
+/// without the RGB image, see libtiff.read_matrix for the optional fields
+//DOC_END
+{
+  constString cs;
+  LUABIND_CHECK_ARGN(>=, 1);
+  LUABIND_CHECK_ARGN(<=, 2);
+  LUABIND_CHECK_PARAMETER(1, string);
+  LUABIND_GET_PARAMETER(1,constString,cs);
+  const char *filename = (const char *)cs;
+  int x, y, width, height, downscale;
+  getImageReadParams(L, 2, x, y, width, height, downscale);
+
+  ImageFloat *res = LibTIFF::readTIFFGray(filename, x, y, width, height,
+					 downscale);
+
+  if (res == NULL)
+    LUABIND_ERROR("libtiff.read_gray failed");
+
+  LUABIND_RETURN(ImageFloat, res);
+}
+//BIND_END
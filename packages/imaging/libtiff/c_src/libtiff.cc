@@ -137,6 +137,110 @@ namespace LibTIFF
     return result;
   }
 
+  // Adds to sink the rows [y0,y0+num_rows) of raster, whose first row is
+  // the top one when top_down, the bottom one otherwise
+  static void addTIFFRows(ImageRowSink *sink, const uint32_t *raster,
+			  int width, int y0, int num_rows, bool top_down,
+			  unsigned char *row) {
+    for (int i=0; i<num_rows; i++) {
+      int y = y0 + i;
+      if (y < sink->getFirstRow() || y >= sink->getLastRow()) continue;
+      const uint32_t *p = raster + (top_down ? i : num_rows-1-i)*width;
+      for (int x=0; x<width; x++) {
+        row[3*x]   = TIFFGetR(p[x]);
+        row[3*x+1] = TIFFGetG(p[x]);
+        row[3*x+2] = TIFFGetB(p[x]);
+      }
+      sink->addRow(y, row, 3);
+    }
+  }
+
+  MatrixFloat *readTIFFMatrix(const char *filename,
+			      ImageRowSink::ChannelLayout layout,
+			      int roi_x, int roi_y, int roi_width, int roi_height,
+			      int downscale)
+  {
+    TIFF* tif = TIFFOpen(filename, "r");
+    if (tif == NULL) {
+      fprintf(stderr, "LibTIFF::readTIFFMatrix() -> TIFFOpen failed on %s\n", filename);
+      return NULL;
+    }
+
+    uint32_t width, height, rows_per_strip;
+    TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width);
+    TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height);
+
+    MatrixFloat *res = NULL;
+    uint32_t *raster = NULL;
+    unsigned char *row = NULL;
+    ImageRowSink sink(width, height, layout, roi_x, roi_y,
+                      roi_width, roi_height, downscale);
+    if (!sink.isValid()) {
+      fprintf(stderr, "LibTIFF::readTIFFMatrix() -> invalid region or downscale for %s\n",
+              filename);
+      goto close_file;
+    }
+
+    row = new unsigned char[3*width];
+    if (TIFFIsTiled(tif)) {
+      raster = (uint32_t*) _TIFFmalloc(width * height * sizeof (uint32_t));
+      if (raster == NULL) {
+        fprintf(stderr, "LibTIFF::readTIFFMatrix() -> _TIFFMalloc failed on %s\n", filename);
+        goto free_row;
+      }
+      if (!TIFFReadRGBAImageOriented(tif, width, height, raster,
+                                     ORIENTATION_TOPLEFT, 0)) {
+        fprintf(stderr, "LibTIFF::readTIFFMatrix() -> TIFFReadRGBAImage failed on %s\n", filename);
+        goto free_image_data;
+      }
+      addTIFFRows(&sink, raster, width, 0, height, true, row);
+    }
+    else {
+      // strips are decoded bottom-up, one by one, until the last row of the
+      // region of interest
+      if (!TIFFGetFieldDefaulted(tif, TIFFTAG_ROWSPERSTRIP, &rows_per_strip) ||
+          rows_per_strip > height)
+        rows_per_strip = height;
+      raster = (uint32_t*) _TIFFmalloc(width * rows_per_strip * sizeof (uint32_t));
+      if (raster == NULL) {
+        fprintf(stderr, "LibTIFF::readTIFFMatrix() -> _TIFFMalloc failed on %s\n", filename);
+        goto free_row;
+      }
+      uint32_t first = (sink.getFirstRow() / rows_per_strip) * rows_per_strip;
+      for (uint32_t y = first; y < uint32_t(sink.getLastRow()); y += rows_per_strip) {
+        if (!TIFFReadRGBAStrip(tif, y, raster)) {
+          fprintf(stderr, "LibTIFF::readTIFFMatrix() -> TIFFReadRGBAStrip failed on %s\n", filename);
+          goto free_image_data;
+        }
+        int num_rows = (y + rows_per_strip > height) ? height - y : rows_per_strip;
+        addTIFFRows(&sink, raster, width, y, num_rows, false, row);
+      }
+    }
+    res = sink.releaseMatrix();
+
+    free_image_data:
+    _TIFFfree(raster);
+
+    free_row:
+    delete[] row;
+
+    close_file:
+    TIFFClose(tif);
+
+    return res;
+  }
+
+  ImageFloat *readTIFFGray(const char *filename,
+			   int roi_x, int roi_y, int roi_width, int roi_height,
+			   int downscale)
+  {
+    MatrixFloat *m = readTIFFMatrix(filename, ImageRowSink::GRAY,
+				    roi_x, roi_y, roi_width, roi_height,
+				    downscale);
+    if (m == NULL) return NULL;
+    return new ImageFloat(m);
+  }
+
 }
 
 
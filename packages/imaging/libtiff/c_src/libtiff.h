@@ -22,6 +22,7 @@
 #define LIBTIFF_H
 
 #include "utilImageFloat.h"
+#include "image_row_sink.h"
 #include <cstdio>
 
 namespace LibTIFF
@@ -29,6 +30,20 @@ namespace LibTIFF
   ImageFloatRGB* readTIFF(const char *filename); // returns NULL if error
   bool writeTIFF(ImageFloatRGB *img, const char *filename);
 
+  // Decodes strip by strip into a matrix with the given layout, keeping only
+  // the region of interest, downscaled by averaging blocks of downscale x
+  // downscale pixels (see ImageRowSink). Tiled images are decoded at once.
+  // Returns NULL if error.
+  MatrixFloat *readTIFFMatrix(const char *filename,
+			      ImageRowSink::ChannelLayout layout,
+			      int roi_x=0, int roi_y=0,
+			      int roi_width=0, int roi_height=0,
+			      int downscale=1);
+  ImageFloat *readTIFFGray(const char *filename,
+			   int roi_x=0, int roi_y=0,
+			   int roi_width=0, int roi_height=0,
+			   int downscale=1);
+
 }
 
 #endif
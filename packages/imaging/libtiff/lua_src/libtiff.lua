@@ -1,4 +1,5 @@
-local libtiff_handlers = { read=libtiff.read, write=libtiff.write }
+local libtiff_handlers = { read=libtiff.read, write=libtiff.write,
+			   read_gray=libtiff.read_gray }
 ImageIO.handlers["tif"] = libtiff_handlers
 ImageIO.handlers["tiff"] = libtiff_handlers
 